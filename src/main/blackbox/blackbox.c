@@ -379,6 +379,9 @@ STATIC_UNIT_TESTED int32_t blackboxSInterval = 0;
 STATIC_UNIT_TESTED int32_t blackboxSlowFrameIterationTimer;
 static bool blackboxLoggedAnyFrames;
 
+// Dropped frame count at the last FLIGHT_LOG_EVENT_DROPPED_FRAMES
+static uint32_t blackboxLoggedDroppedFrames;
+
 /*
  * We store voltages in I-frames relative to this, which was the voltage when the blackbox was activated.
  * This helps out since the voltage is only expected to fall from that point and we can reduce our diffs
@@ -551,6 +554,7 @@ static void writeIntraframe(void)
 {
     blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
 
+    blackboxFrameBegin();
     blackboxWrite('I');
 
     blackboxWriteUnsignedVB(blackboxIteration);
@@ -651,6 +655,8 @@ static void writeIntraframe(void)
         }
     }
 
+    blackboxFrameCommit();
+
     //Rotate our history buffers:
 
     //The current state becomes the new "before" state
@@ -682,6 +688,7 @@ static void writeInterframe(void)
     blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
     blackboxMainState_t *blackboxLast = blackboxHistory[1];
 
+    blackboxFrameBegin();
     blackboxWrite('P');
 
     //No need to store iteration count since its delta is always 1
@@ -792,6 +799,8 @@ static void writeInterframe(void)
         }
     }
 
+    blackboxFrameCommit();
+
     //Rotate our history buffers
     blackboxHistory[2] = blackboxHistory[1];
     blackboxHistory[1] = blackboxHistory[0];
@@ -806,6 +815,7 @@ static void writeSlowFrame(void)
 {
     int32_t values[3];
 
+    blackboxFrameBegin();
     blackboxWrite('S');
 
     blackboxWriteUnsignedVB(slowHistory.flightModeFlags);
@@ -819,6 +829,8 @@ static void writeSlowFrame(void)
     values[2] = slowHistory.rxFlightChannelsValid ? 1 : 0;
     blackboxWriteTag2_3S32(values);
 
+    blackboxFrameCommit();
+
     blackboxSlowFrameIterationTimer = 0;
 }
 
@@ -933,10 +945,24 @@ static void blackboxStart(void)
      */
     blackboxLastArmingBeep = getArmingBeepTimeMicros();
     memcpy(&blackboxLastFlightModeFlags, &rcModeActivationMask, sizeof(blackboxLastFlightModeFlags)); // record startup status
+    blackboxLoggedDroppedFrames = 0;
 
     blackboxSetState(BLACKBOX_STATE_PREPARE_LOG_FILE);
 }
 
+/* If frames were dropped since the last report, log the new totals so the decoder knows the log has gaps */
+static void blackboxCheckAndLogDroppedFrames(void)
+{
+    const uint32_t droppedFrames = blackboxGetDroppedFrameCount();
+    if (droppedFrames != blackboxLoggedDroppedFrames) {
+        blackboxLoggedDroppedFrames = droppedFrames;
+        flightLogEvent_droppedFrames_t eventData;
+        eventData.frames = droppedFrames;
+        eventData.bytes = blackboxGetDroppedByteCount();
+        blackboxLogEvent(FLIGHT_LOG_EVENT_DROPPED_FRAMES, (flightLogEventData_t *)&eventData);
+    }
+}
+
 /**
  * Begin Blackbox shutdown.
  */
@@ -950,6 +976,7 @@ void blackboxFinish(void)
         break;
     case BLACKBOX_STATE_RUNNING:
     case BLACKBOX_STATE_PAUSED:
+        blackboxCheckAndLogDroppedFrames();
         blackboxLogEvent(FLIGHT_LOG_EVENT_LOG_END, NULL);
         FALLTHROUGH;
     default:
@@ -1009,18 +1036,22 @@ static bool inMotorTestMode(void) {
 #ifdef USE_GPS
 static void writeGPSHomeFrame(void)
 {
+    blackboxFrameBegin();
     blackboxWrite('H');
 
     blackboxWriteSignedVB(GPS_home[0]);
     blackboxWriteSignedVB(GPS_home[1]);
     //TODO it'd be great if we could grab the GPS current time and write that too
 
+    blackboxFrameCommit();
+
     gpsHistory.GPS_home[0] = GPS_home[0];
     gpsHistory.GPS_home[1] = GPS_home[1];
 }
 
 static void writeGPSFrame(timeUs_t currentTimeUs)
 {
+    blackboxFrameBegin();
     blackboxWrite('G');
 
     /*
@@ -1041,6 +1072,8 @@ static void writeGPSFrame(timeUs_t currentTimeUs)
     blackboxWriteUnsignedVB(gpsSol.groundSpeed);
     blackboxWriteUnsignedVB(gpsSol.groundCourse);
 
+    blackboxFrameCommit();
+
     gpsHistory.GPS_numSat = gpsSol.numSat;
     gpsHistory.GPS_coord[LAT] = gpsSol.llh.lat;
     gpsHistory.GPS_coord[LON] = gpsSol.llh.lon;
@@ -1052,7 +1085,7 @@ static void writeGPSFrame(timeUs_t currentTimeUs)
  */
 static void loadMainState(timeUs_t currentTimeUs)
 {
-#ifndef UNIT_TEST
+#if !defined(UNIT_TEST) || defined(BLACKBOX_BENCHMARK)
     blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
 
     blackboxCurrent->time = currentTimeUs;
@@ -1422,6 +1455,7 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("dyn_notch_width_percent", "%d",         gyroConfig()->dyn_notch_width_percent);
         BLACKBOX_PRINT_HEADER_LINE("dyn_notch_q", "%d",                     gyroConfig()->dyn_notch_q);
         BLACKBOX_PRINT_HEADER_LINE("dyn_notch_min_hz", "%d",                gyroConfig()->dyn_notch_min_hz);
+        BLACKBOX_PRINT_HEADER_LINE("dyn_notch_count", "%d",                 gyroConfig()->dyn_notch_count);
 #endif
 #ifdef USE_DSHOT_TELEMETRY
         BLACKBOX_PRINT_HEADER_LINE("dshot_bidir", "%d",                     motorConfig()->dev.useDshotTelemetry);
@@ -1484,6 +1518,8 @@ static bool blackboxWriteSysinfo(void)
     }
 
     xmitState.headerIndex++;
+#elif defined(BLACKBOX_BENCHMARK)
+    return true; // the benchmark only times the data frames
 #endif // UNIT_TEST
     return false;
 }
@@ -1499,6 +1535,7 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
     }
 
     //Shared header for event frames
+    blackboxFrameBegin();
     blackboxWrite('E');
     blackboxWrite(event);
 
@@ -1527,6 +1564,10 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
         blackboxWriteUnsignedVB(data->loggingResume.logIteration);
         blackboxWriteUnsignedVB(data->loggingResume.currentTime);
         break;
+    case FLIGHT_LOG_EVENT_DROPPED_FRAMES:
+        blackboxWriteUnsignedVB(data->droppedFrames.frames);
+        blackboxWriteUnsignedVB(data->droppedFrames.bytes);
+        break;
     case FLIGHT_LOG_EVENT_LOG_END:
         blackboxWriteString("End of log");
         blackboxWrite(0);
@@ -1534,6 +1575,8 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
     default:
         break;
     }
+
+    blackboxFrameCommit();
 }
 
 /* If an arming beep has played since it was last logged, write the time of the arming beep to the log as a synchronization point */
@@ -1619,6 +1662,9 @@ STATIC_UNIT_TESTED void blackboxLogIteration(timeUs_t currentTimeUs)
 
         loadMainState(currentTimeUs);
         writeIntraframe();
+
+        // At most once per I frame, so a device that can't keep up isn't also handed an event every iteration
+        blackboxCheckAndLogDroppedFrames();
     } else {
         blackboxCheckAndLogArmingBeep();
         blackboxCheckAndLogFlightMode(); // Check for FlightMode status change event
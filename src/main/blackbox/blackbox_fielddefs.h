@@ -155,6 +155,11 @@ typedef struct flightLogEvent_loggingResume_s {
     uint32_t currentTime;
 } flightLogEvent_loggingResume_t;
 
+typedef struct flightLogEvent_droppedFrames_s {
+    uint32_t frames;    // totals since the log was started
+    uint32_t bytes;
+} flightLogEvent_droppedFrames_t;
+
 #define FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT_FUNCTION_FLOAT_VALUE_FLAG 128
 
 typedef union flightLogEventData_u {
@@ -163,6 +168,7 @@ typedef union flightLogEventData_u {
     flightLogEvent_disarm_t disarm;
     flightLogEvent_inflightAdjustment_t inflightAdjustment;
     flightLogEvent_loggingResume_t loggingResume;
+    flightLogEvent_droppedFrames_t droppedFrames;
 } flightLogEventData_t;
 
 typedef struct flightLogEvent_s {
@@ -105,24 +105,43 @@ void blackboxOpen(void)
 static uint32_t bbBits;
 static timeMs_t bbLastclearMs;
 static uint16_t bbRateMax;
-static uint32_t bbDrops;
 #endif
 
-void blackboxWrite(uint8_t value)
+// Output lost since the device was opened because it could not keep up, reported in the log by an event
+static uint32_t blackboxDroppedFrameCount;
+static uint32_t blackboxDroppedByteCount;
+
+// Frames are assembled here and handed to the device in one write, rather than a byte at a time
+static struct {
+    uint8_t data[BLACKBOX_FRAME_BUFFER_SIZE];
+    int length;
+    bool open;
+    bool dropped;
+} blackboxFrame;
+
+// Returns false if the device had no room and dropped (some of) the data
+static bool blackboxDeviceWrite(const uint8_t *data, int length)
 {
+    bool written = true;
+
 #ifdef DEBUG_BB_OUTPUT
-    bbBits += 8;
+    bbBits += length * 8;
 #endif
 
     switch (blackboxConfig()->device) {
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
-        flashfsWriteByte(value); // Write byte asynchronously
+        {
+            // flashfs silently discards an asynchronous write it can't buffer, the offset then doesn't move
+            const uint32_t offset = flashfsGetOffset();
+            flashfsWrite(data, length, false); // Write asynchronously
+            written = flashfsGetOffset() == offset + length;
+        }
         break;
 #endif
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
-        afatfs_fputc(blackboxSDCard.logFile, value);
+        written = afatfs_fwrite(blackboxSDCard.logFile, data, length) == (uint32_t)length;
         break;
 #endif
     case BLACKBOX_DEVICE_SERIAL:
@@ -131,22 +150,27 @@ void blackboxWrite(uint8_t value)
             int txBytesFree = serialTxBytesFree(blackboxPort);
 
 #ifdef DEBUG_BB_OUTPUT
-            bbBits += 2;
+            bbBits += length * 2;
             DEBUG_SET(DEBUG_BLACKBOX_OUTPUT, 3, txBytesFree);
 #endif
 
-            if (txBytesFree == 0) {
-#ifdef DEBUG_BB_OUTPUT
-                ++bbDrops;
-                DEBUG_SET(DEBUG_BLACKBOX_OUTPUT, 2, bbDrops);
-#endif
-                return;
+            // Drop the whole frame rather than its tail, the decoder resynchronises on the next frame
+            if (txBytesFree < length) {
+                written = false;
+            } else {
+                serialWriteBuf(blackboxPort, data, length);
             }
-            serialWrite(blackboxPort, value);
         }
         break;
     }
 
+    if (!written) {
+        blackboxDroppedByteCount += length;
+#ifdef DEBUG_BB_OUTPUT
+        DEBUG_SET(DEBUG_BLACKBOX_OUTPUT, 2, blackboxDroppedByteCount);
+#endif
+    }
+
 #ifdef DEBUG_BB_OUTPUT
     timeMs_t now = millis();
 
@@ -161,42 +185,89 @@ void blackboxWrite(uint8_t value)
         bbBits = 0;
     }
 #endif
+
+    return written;
 }
 
-// Print the null-terminated string 's' to the blackbox device and return the number of bytes written
-int blackboxWriteString(const char *s)
+/**
+ * Start staging a frame, everything written until blackboxFrameCommit() reaches the device in one piece.
+ */
+void blackboxFrameBegin(void)
 {
-    int length;
-    const uint8_t *pos;
+    blackboxFrame.length = 0;
+    blackboxFrame.open = true;
+    blackboxFrame.dropped = false;
+}
 
-    switch (blackboxConfig()->device) {
+static void blackboxFrameWritePending(void)
+{
+    if (!blackboxDeviceWrite(blackboxFrame.data, blackboxFrame.length)) {
+        blackboxFrame.dropped = true;
+    }
+    blackboxFrame.length = 0;
+}
 
-#ifdef USE_FLASHFS
-    case BLACKBOX_DEVICE_FLASH:
-        length = strlen(s);
-        flashfsWrite((const uint8_t*) s, length, false); // Write asynchronously
-        break;
-#endif // USE_FLASHFS
+void blackboxFrameCommit(void)
+{
+    if (blackboxFrame.length) {
+        blackboxFrameWritePending();
+    }
+    if (blackboxFrame.dropped) {
+        blackboxDroppedFrameCount++;
+    }
+    blackboxFrame.open = false;
+}
 
-#ifdef USE_SDCARD
-    case BLACKBOX_DEVICE_SDCARD:
-        length = strlen(s);
-        afatfs_fwrite(blackboxSDCard.logFile, (const uint8_t*) s, length); // Ignore failures due to buffers filling up
-        break;
-#endif // USE_SDCARD
+uint32_t blackboxGetDroppedFrameCount(void)
+{
+    return blackboxDroppedFrameCount;
+}
 
-    case BLACKBOX_DEVICE_SERIAL:
-    default:
-        pos = (uint8_t*) s;
-        while (*pos) {
-            blackboxWrite(*pos);
-            pos++;
-        }
+uint32_t blackboxGetDroppedByteCount(void)
+{
+    return blackboxDroppedByteCount;
+}
 
-        length = pos - (uint8_t*) s;
-        break;
+void blackboxWrite(uint8_t value)
+{
+    if (!blackboxFrame.open) {
+        blackboxDeviceWrite(&value, 1);
+        return;
     }
 
+    if (blackboxFrame.length == BLACKBOX_FRAME_BUFFER_SIZE) {
+        // Larger than the staging buffer, pass on what we have so far
+        blackboxFrameWritePending();
+    }
+    blackboxFrame.data[blackboxFrame.length++] = value;
+}
+
+void blackboxWriteBuf(const uint8_t *data, int length)
+{
+    if (!blackboxFrame.open) {
+        blackboxDeviceWrite(data, length);
+        return;
+    }
+
+    while (length > 0) {
+        if (blackboxFrame.length == BLACKBOX_FRAME_BUFFER_SIZE) {
+            blackboxFrameWritePending();
+        }
+        const int chunk = MIN(length, BLACKBOX_FRAME_BUFFER_SIZE - blackboxFrame.length);
+        memcpy(&blackboxFrame.data[blackboxFrame.length], data, chunk);
+        blackboxFrame.length += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+// Print the null-terminated string 's' to the blackbox device and return the number of bytes written
+int blackboxWriteString(const char *s)
+{
+    const int length = strlen(s);
+
+    blackboxWriteBuf((const uint8_t*) s, length);
+
     return length;
 }
 
@@ -214,7 +285,7 @@ void blackboxDeviceFlush(void)
          * devices will progressively write in the background without Blackbox calling anything.
          */
     case BLACKBOX_DEVICE_FLASH:
-        flashfsFlushAsync();
+        flashfsFlushAsync(false);
         break;
 #endif // USE_FLASHFS
 
@@ -237,7 +308,7 @@ bool blackboxDeviceFlushForce(void)
 
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
-        return flashfsFlushAsync();
+        return flashfsFlushAsync(true);
 #endif // USE_FLASHFS
 
 #ifdef USE_SDCARD
@@ -280,6 +351,9 @@ bool blackboxDeviceFlushForceComplete(void)
  */
 bool blackboxDeviceOpen(void)
 {
+    blackboxDroppedFrameCount = 0;
+    blackboxDroppedByteCount = 0;
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         {
@@ -730,7 +804,7 @@ blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t bytes)
              * that the Blackbox header writing code doesn't have to guess about the best time to ask flashfs to
              * flush, and doesn't stall waiting for a flush that would otherwise not automatically be called.
              */
-            flashfsFlushAsync();
+            flashfsFlushAsync(true);
         }
         return BLACKBOX_RESERVE_TEMPORARY_FAILURE;
 #endif // USE_FLASHFS
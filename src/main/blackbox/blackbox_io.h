@@ -38,12 +38,25 @@ typedef enum {
  */
 #define BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION 64
 
+/*
+ * Staging buffer for a single frame. A main frame with every field enabled usually fits, one that doesn't is
+ * passed on to the device in pieces.
+ */
+#define BLACKBOX_FRAME_BUFFER_SIZE 256
+
 extern int32_t blackboxHeaderBudget;
 
 void blackboxOpen(void);
 void blackboxWrite(uint8_t value);
+void blackboxWriteBuf(const uint8_t *data, int length);
 int blackboxWriteString(const char *s);
 
+void blackboxFrameBegin(void);
+void blackboxFrameCommit(void);
+
+uint32_t blackboxGetDroppedFrameCount(void);
+uint32_t blackboxGetDroppedByteCount(void);
+
 void blackboxDeviceFlush(void);
 bool blackboxDeviceFlushForce(void);
 bool blackboxDeviceFlushForceComplete(void);
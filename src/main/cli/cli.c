@@ -41,6 +41,7 @@ bool cliMode = false;
 #include "build/version.h"
 
 #include "cli/settings.h"
+#include "cli/settings_index.h"
 
 #include "cms/cms.h"
 
@@ -187,6 +188,9 @@ static bufWriter_t *cliWriter = NULL;
 static bufWriter_t *cliErrorWriter = NULL;
 static uint8_t cliWriteBuffer[sizeof(*cliWriter) + CLI_OUT_BUFFER_SIZE];
 
+// Set while a dump or diff is printed, output then goes out whenever the buffer is full instead of after every print
+static bool cliOutputDeferred = false;
+
 static char cliBuffer[CLI_IN_BUFFER_SIZE];
 static uint32_t bufferIndex = 0;
 
@@ -351,7 +355,9 @@ static void cliPrintInternal(bufWriter_t *writer, const char *str)
         while (*str) {
             bufWriterAppend(writer, *str++);
         }
-        cliWriterFlushInternal(writer);
+        if (!cliOutputDeferred) {
+            cliWriterFlushInternal(writer);
+        }
     }
 }
 
@@ -395,7 +401,9 @@ static void cliPrintfva(const char *format, va_list va)
 {
     if (cliWriter) {
         tfp_format(cliWriter, cliPutp, format, va);
-        cliWriterFlush();
+        if (!cliOutputDeferred) {
+            cliWriterFlush();
+        }
     }
 }
 
@@ -772,9 +780,20 @@ static uint16_t getValueOffset(const clivalue_t *value)
     return 0;
 }
 
+// Settings of one parameter group mostly follow each other in valueTable
+static const pgRegistry_t *cliFindPg(pgn_t pgn)
+{
+    static const pgRegistry_t *lastPg = NULL;
+
+    if (!lastPg || pgN(lastPg) != pgn) {
+        lastPg = pgFind(pgn);
+    }
+    return lastPg;
+}
+
 STATIC_UNIT_TESTED void *cliGetValuePointer(const clivalue_t *value)
 {
-    const pgRegistry_t* rec = pgFind(value->pgn);
+    const pgRegistry_t* rec = cliFindPg(value->pgn);
     if (isWritingConfigToCopy()) {
         return CONST_CAST(void *, rec->copy + getValueOffset(value));
     } else {
@@ -784,7 +803,7 @@ STATIC_UNIT_TESTED void *cliGetValuePointer(const clivalue_t *value)
 
 static const char *dumpPgValue(const char *cmdName, const clivalue_t *value, dumpFlags_t dumpMask, const char *headingStr)
 {
-    const pgRegistry_t *pg = pgFind(value->pgn);
+    const pgRegistry_t *pg = cliFindPg(value->pgn);
 #ifdef DEBUG
     if (!pg) {
         cliPrintLinef("VALUE %s ERROR", value->name);
@@ -817,7 +836,6 @@ static void dumpAllValues(const char *cmdName, uint16_t valueSection, dumpFlags_
 
     for (uint32_t i = 0; i < valueTableEntryCount; i++) {
         const clivalue_t *value = &valueTable[i];
-        cliWriterFlush();
         if ((value->type & VALUE_SECTION_MASK) == valueSection || ((valueSection == MASTER_VALUE) && (value->type & VALUE_SECTION_MASK) == HARDWARE_VALUE)) {
             headingStr = dumpPgValue(cmdName, value, dumpMask, headingStr);
         }
@@ -2483,6 +2501,14 @@ static void cliFlashInfo(const char *cmdName, char *cmdline)
             FLASH_PARTITION_SECTOR_COUNT(flashPartition) * layout->sectorSize,
             flashfsGetOffset()
     );
+
+    const flashfsStats_t *stats = flashfsGetStats();
+    cliPrintLinef("FlashFS buffer=%u, highWater=%u, stalls=%u, dropped=%u",
+            flashfsGetWriteBufferSize(),
+            stats->bufferHighWater,
+            stats->stalls,
+            stats->droppedBytes
+    );
 #endif
 }
 
@@ -4383,7 +4409,7 @@ static void cliDefaults(const char *cmdName, char *cmdline)
 
 static void cliPrintVarDefault(const char *cmdName, const clivalue_t *value)
 {
-    const pgRegistry_t *pg = pgFind(value->pgn);
+    const pgRegistry_t *pg = cliFindPg(value->pgn);
     if (pg) {
         const char *defaultFormat = "Default value: ";
         const int valueOffset = getValueOffset(value);
@@ -4456,15 +4482,7 @@ static uint8_t getWordLength(char *bufBegin, char *bufEnd)
 
 uint16_t cliGetSettingIndex(char *name, uint8_t length)
 {
-    for (uint32_t i = 0; i < valueTableEntryCount; i++) {
-        const char *settingName = valueTable[i].name;
-
-        // ensure exact match when setting to prevent setting variables with shorter names
-        if (strncasecmp(name, settingName, strlen(settingName)) == 0 && length == strlen(settingName)) {
-            return i;
-        }
-    }
-    return valueTableEntryCount;
+    return settingIndexByName(name, length);
 }
 
 STATIC_UNIT_TESTED void cliSet(const char *cmdName, char *cmdline)
@@ -4824,8 +4842,73 @@ static void cliStatus(const char *cmdName, char *cmdline)
 }
 
 #if defined(USE_TASK_STATISTICS)
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+static void cliTasksHistogram(const char *cmdName, const char *cmdline)
+{
+    if (!systemConfig()->task_statistics) {
+        cliPrintErrorLinef(cmdName, "TASK STATISTICS DISABLED");
+
+        return;
+    }
+
+    taskHistogram_t executionTimeHistogram;
+    taskHistogram_t startLatenessHistogram;
+
+    if (!isEmpty(cmdline)) {
+        const int taskId = atoi(cmdline);
+        if (taskId < 0 || taskId >= TASK_COUNT) {
+            cliShowArgumentRangeError(cmdName, "TASK", 0, TASK_COUNT - 1);
+
+            return;
+        }
+
+        getTaskHistograms(taskId, &executionTimeHistogram, &startLatenessHistogram);
+        cliPrintLine("Bucket/us         exec     start");
+        for (unsigned bucket = 0; bucket < TASK_HISTOGRAM_BUCKET_COUNT; bucket++) {
+            const uint32_t lowerUs = taskHistogramBucketLowerBoundUs(bucket);
+            if (bucket == TASK_HISTOGRAM_BUCKET_COUNT - 1) {
+                cliPrintf("%5d+      ", lowerUs);
+            } else {
+                cliPrintf("%5d-%-5d ", lowerUs, taskHistogramBucketLowerBoundUs(bucket + 1) - 1);
+            }
+            cliPrintLinef("%9d %9d", executionTimeHistogram.count[bucket], startLatenessHistogram.count[bucket]);
+        }
+
+        return;
+    }
+
+    cliPrintLine("Task histogram         samples  exec p50/p99/p999 us  start p50/p99/p999 us");
+    for (taskId_e taskId = 0; taskId < TASK_COUNT; taskId++) {
+        taskInfo_t taskInfo;
+        getTaskInfo(taskId, &taskInfo);
+        if (taskInfo.isEnabled) {
+            getTaskHistograms(taskId, &executionTimeHistogram, &startLatenessHistogram);
+            cliPrintLinef("%02d - (%15s) %7d %6d %6d %6d %6d %6d %6d", taskId, taskInfo.taskName,
+                    taskHistogramTotalCount(&executionTimeHistogram),
+                    taskHistogramPercentileUs(&executionTimeHistogram, 500),
+                    taskHistogramPercentileUs(&executionTimeHistogram, 990),
+                    taskHistogramPercentileUs(&executionTimeHistogram, 999),
+                    taskHistogramPercentileUs(&startLatenessHistogram, 500),
+                    taskHistogramPercentileUs(&startLatenessHistogram, 990),
+                    taskHistogramPercentileUs(&startLatenessHistogram, 999));
+        }
+    }
+
+    gyroLateStartInfo_t gyroLateStartInfo;
+    getGyroLateStartInfo(&gyroLateStartInfo);
+    cliPrintLinef("Gyro late starts %d of %d, max late %dus", gyroLateStartInfo.lateStartCount, gyroLateStartInfo.startCount, gyroLateStartInfo.maxLateUs);
+}
+#endif
+
 static void cliTasks(const char *cmdName, char *cmdline)
 {
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+    if (strncasecmp(cmdline, "histogram", 9) == 0) {
+        cliTasksHistogram(cmdName, nextArg(cmdline));
+
+        return;
+    }
+#endif
     UNUSED(cmdName);
     UNUSED(cmdline);
     int maxLoadSum = 0;
@@ -4867,6 +4950,11 @@ static void cliTasks(const char *cmdName, char *cmdline)
         cliPrintLinef("RX Check Function %19d %7d %25d", checkFuncInfo.maxExecutionTimeUs, checkFuncInfo.averageExecutionTimeUs, checkFuncInfo.totalExecutionTimeUs / 1000);
         cliPrintLinef("Total (excluding SERIAL) %25d.%1d%% %4d.%1d%%", maxLoadSum/10, maxLoadSum%10, averageLoadSum/10, averageLoadSum%10);
         schedulerResetCheckFunctionMaxExecutionTime();
+#ifdef USE_OSD
+        osdDrawSliceInfo_t osdDrawSliceInfo;
+        osdGetDrawSliceInfo(&osdDrawSliceInfo);
+        cliPrintLinef("OSD draw budget %dus, %d of %d calls over budget", osdDrawSliceInfo.budgetUs, osdDrawSliceInfo.overBudgetCount, osdDrawSliceInfo.sliceCount);
+#endif
     }
 }
 #endif
@@ -6145,6 +6233,8 @@ static void printConfig(const char *cmdName, char *cmdline, bool doDiff)
 
     backupAndResetConfigs((dumpMask & BARE) == 0);
 
+    cliOutputDeferred = true;
+
 #ifdef USE_CLI_BATCH
     bool batchModeEnabled = false;
 #endif
@@ -6315,6 +6405,9 @@ static void printConfig(const char *cmdName, char *cmdline, bool doDiff)
     }
 #endif
 
+    cliOutputDeferred = false;
+    cliWriterFlush();
+
     // restore configs from copies
     restoreConfigs();
 }
@@ -6529,8 +6622,12 @@ const clicmd_t cmdTable[] = {
 #endif
     CLI_COMMAND_DEF("status", "show status", NULL, cliStatus),
 #if defined(USE_TASK_STATISTICS)
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+    CLI_COMMAND_DEF("tasks", "show task stats", "[histogram [<task id>]]", cliTasks),
+#else
     CLI_COMMAND_DEF("tasks", "show task stats", NULL, cliTasks),
 #endif
+#endif
 #ifdef USE_TIMER_MGMT
     CLI_COMMAND_DEF("timer", "show/set timers", "<> | <pin> list | <pin> [af<alternate function>|none|<option(deprecated)>] | list | show", cliTimer),
 #endif
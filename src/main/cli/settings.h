@@ -141,6 +141,9 @@ typedef enum {
 #ifdef USE_OSD
     TABLE_OSD_LOGO_ON_ARMING,
 #endif
+#ifdef USE_GYRO_DATA_ANALYSE
+    TABLE_DYN_NOTCH_ANALYSER,
+#endif
 
     LOOKUP_TABLE_COUNT
 } lookupTableIndex_e;
@@ -0,0 +1,182 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "platform.h"
+
+#include "cli/settings.h"
+
+#include "settings_index.h"
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+#ifndef MINIMAL_CLI
+// settingIndex (settings.c) is an open addressed index of valueTable by name hash,
+// so that a lookup does not compare against every name
+#define SETTING_INDEX_EMPTY 0xffff
+
+static bool settingIndexBuilt = false;
+static bool settingIndexUsable = false;
+#endif
+
+static uint32_t fnvHash(uint32_t hash, const void *data, unsigned length)
+{
+    const uint8_t *p = data;
+    for (unsigned i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// FNV-1a of the lower case name, also used by MSP clients to address a setting without knowing its index
+uint32_t settingNameHash(const char *name, unsigned length)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (unsigned i = 0; i < length; i++) {
+        hash ^= (uint8_t)tolower((unsigned char)name[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint32_t valueNameHash(uint16_t index)
+{
+    return settingNameHash(valueTable[index].name, strlen(valueTable[index].name));
+}
+
+#ifndef MINIMAL_CLI
+static void buildSettingIndex(void)
+{
+    memset(settingIndex, 0xff, settingIndexSize * sizeof(settingIndex[0]));
+
+    // a full index would never terminate a probe, fall back to the linear search instead
+    settingIndexUsable = valueTableEntryCount < settingIndexSize;
+    if (settingIndexUsable) {
+        for (uint32_t i = 0; i < valueTableEntryCount; i++) {
+            uint32_t slot = valueNameHash(i) & (settingIndexSize - 1);
+            while (settingIndex[slot] != SETTING_INDEX_EMPTY) {
+                slot = (slot + 1) & (settingIndexSize - 1);
+            }
+            settingIndex[slot] = i;
+        }
+    }
+    settingIndexBuilt = true;
+}
+
+static bool isSettingIndexUsable(void)
+{
+    if (!settingIndexBuilt) {
+        buildSettingIndex();
+    }
+    return settingIndexUsable;
+}
+#endif
+
+static bool settingNameMatches(uint16_t index, const char *name, unsigned length)
+{
+    const char *settingName = valueTable[index].name;
+
+    // ensure exact match to prevent matching settings with shorter names
+    return strncasecmp(name, settingName, length) == 0 && settingName[length] == '\0';
+}
+
+// Returns valueTableEntryCount if there is no such setting
+uint16_t settingIndexByName(const char *name, unsigned length)
+{
+#ifndef MINIMAL_CLI
+    if (isSettingIndexUsable()) {
+        uint32_t slot = settingNameHash(name, length) & (settingIndexSize - 1);
+        while (settingIndex[slot] != SETTING_INDEX_EMPTY) {
+            if (settingNameMatches(settingIndex[slot], name, length)) {
+                return settingIndex[slot];
+            }
+            slot = (slot + 1) & (settingIndexSize - 1);
+        }
+        return valueTableEntryCount;
+    }
+#endif
+
+    for (uint32_t i = 0; i < valueTableEntryCount; i++) {
+        if (settingNameMatches(i, name, length)) {
+            return i;
+        }
+    }
+    return valueTableEntryCount;
+}
+
+// Returns valueTableEntryCount if no setting has this name hash, the first one if several have
+uint16_t settingIndexByHash(uint32_t hash)
+{
+#ifndef MINIMAL_CLI
+    if (isSettingIndexUsable()) {
+        uint16_t found = valueTableEntryCount;
+        uint32_t slot = hash & (settingIndexSize - 1);
+        while (settingIndex[slot] != SETTING_INDEX_EMPTY) {
+            if (settingIndex[slot] < found && valueNameHash(settingIndex[slot]) == hash) {
+                found = settingIndex[slot];
+            }
+            slot = (slot + 1) & (settingIndexSize - 1);
+        }
+        return found;
+    }
+#endif
+
+    for (uint32_t i = 0; i < valueTableEntryCount; i++) {
+        if (valueNameHash(i) == hash) {
+            return i;
+        }
+    }
+    return valueTableEntryCount;
+}
+
+// Changes whenever the order, names, types or limits of the settings do, so that a client
+// can keep what it learned about the table for as long as this stays the same
+uint32_t settingsSchemaHash(void)
+{
+    static uint32_t schemaHash = 0;
+
+    if (schemaHash == 0) {
+        uint32_t hash = FNV_OFFSET_BASIS;
+        for (uint32_t i = 0; i < valueTableEntryCount; i++) {
+            const clivalue_t *value = &valueTable[i];
+            hash = fnvHash(hash, value->name, strlen(value->name) + 1);
+            hash = fnvHash(hash, &value->type, sizeof(value->type));
+            hash = fnvHash(hash, &value->config, sizeof(value->config));
+        }
+        for (uint32_t i = 0; i < LOOKUP_TABLE_COUNT; i++) {
+            const lookupTableEntry_t *table = &lookupTables[i];
+            hash = fnvHash(hash, &table->valueCount, sizeof(table->valueCount));
+            for (unsigned j = 0; j < table->valueCount; j++) {
+                if (table->values[j]) {
+                    hash = fnvHash(hash, table->values[j], strlen(table->values[j]));
+                }
+                hash = fnvHash(hash, "", 1);
+            }
+        }
+        schemaHash = hash ? hash : 1;
+    }
+    return schemaHash;
+}
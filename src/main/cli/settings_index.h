@@ -0,0 +1,39 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "common/utils.h"
+
+// Lookup of valueTable entries by name or by name hash, shared by the CLI and MSP
+
+// Slots in the name hash index, the next power of two above 1.5 times the number of settings
+#define SETTING_INDEX_SIZE(entryCount) (1 << (LOG2((entryCount) * 3 / 2) + 1))
+
+// Storage for the index, defined next to valueTable so that it can be sized at compile time
+extern uint16_t settingIndex[];
+extern const uint16_t settingIndexSize;
+
+uint32_t settingNameHash(const char *name, unsigned length);
+uint16_t settingIndexByName(const char *name, unsigned length);
+uint16_t settingIndexByHash(uint32_t hash);
+uint32_t settingsSchemaHash(void);
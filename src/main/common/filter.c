@@ -31,7 +31,6 @@
 
 #define M_LN2_FLOAT 0.69314718055994530942f
 #define M_PI_FLOAT  3.14159265358979323846f
-#define BIQUAD_Q 1.0f / sqrtf(2.0f)     /* quality factor - 2nd order butterworth*/
 
 // NULL filter
 
@@ -203,6 +202,169 @@ FAST_CODE float biquadFilterApply(biquadFilter_t *filter, float input)
     return result;
 }
 
+// Filter bank
+
+void filterBankInit(filterBank_t *bank)
+{
+    memset(bank, 0, sizeof(*bank));
+}
+
+static void filterBankSetBiquadCoefficients(filterBankStage_t *stage, int lane, const biquadFilter_t *filter)
+{
+    stage->b0[lane] = filter->b0;
+    stage->b1[lane] = filter->b1;
+    stage->b2[lane] = filter->b2;
+    stage->a1[lane] = filter->a1;
+    stage->a2[lane] = filter->a2;
+}
+
+// returns the index of the new stage, or -1 if the bank is full
+int filterBankAddBiquad(filterBank_t *bank, filterBankStageType_e stageType, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType)
+{
+    if (bank->stageCount >= FILTER_BANK_MAX_STAGES || stageType == FILTER_BANK_PT1) {
+        return -1;
+    }
+    const int index = bank->stageCount++;
+    filterBankStage_t *stage = &bank->stage[index];
+    memset(stage, 0, sizeof(*stage));
+    bank->stageType[index] = stageType;
+
+    biquadFilter_t filter;
+    biquadFilterInit(&filter, filterFreq, refreshRate, Q, filterType);
+    for (int lane = 0; lane < FILTER_BANK_LANES; lane++) {
+        filterBankSetBiquadCoefficients(stage, lane, &filter);
+    }
+    return index;
+}
+
+int filterBankAddPt1(filterBank_t *bank, float k)
+{
+    if (bank->stageCount >= FILTER_BANK_MAX_STAGES) {
+        return -1;
+    }
+    const int index = bank->stageCount++;
+    filterBankStage_t *stage = &bank->stage[index];
+    memset(stage, 0, sizeof(*stage));
+    bank->stageType[index] = FILTER_BANK_PT1;
+    filterBankUpdatePt1(bank, index, k);
+    return index;
+}
+
+// recalculates the coefficients of one lane of a biquad stage, keeping its state
+FAST_CODE void filterBankUpdateBiquad(filterBank_t *bank, int stage, int lane, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType)
+{
+    biquadFilter_t filter;
+    biquadFilterInit(&filter, filterFreq, refreshRate, Q, filterType);
+    filterBankSetBiquadCoefficients(&bank->stage[stage], lane, &filter);
+}
+
+FAST_CODE void filterBankUpdatePt1(filterBank_t *bank, int stage, float k)
+{
+    for (int lane = 0; lane < FILTER_BANK_LANES; lane++) {
+        bank->stage[stage].b0[lane] = k;
+    }
+}
+
+#ifdef USE_FILTER_BANK_SIMD
+// GCC vector extensions, all lanes of a stage in one operation
+typedef float filterBankVector_t __attribute__((vector_size(FILTER_BANK_LANES * sizeof(float))));
+
+static inline filterBankVector_t filterBankLoad(const float *lanes)
+{
+    filterBankVector_t v;
+    memcpy(&v, lanes, sizeof(v));
+    return v;
+}
+
+static inline void filterBankStore(float *lanes, filterBankVector_t v)
+{
+    memcpy(lanes, &v, sizeof(v));
+}
+
+FAST_CODE void filterBankApply(filterBank_t *bank, float *values)
+{
+    filterBankVector_t v = filterBankLoad(values);
+
+    for (int i = 0; i < bank->stageCount; i++) {
+        filterBankStage_t *s = &bank->stage[i];
+        const filterBankVector_t b0 = filterBankLoad(s->b0);
+
+        switch (bank->stageType[i]) {
+        case FILTER_BANK_BIQUAD: {
+            const filterBankVector_t result = b0 * v + filterBankLoad(s->x1);
+            filterBankStore(s->x1, filterBankLoad(s->b1) * v - filterBankLoad(s->a1) * result + filterBankLoad(s->x2));
+            filterBankStore(s->x2, filterBankLoad(s->b2) * v - filterBankLoad(s->a2) * result);
+            v = result;
+            break;
+        }
+        case FILTER_BANK_BIQUAD_DF1: {
+            const filterBankVector_t x1 = filterBankLoad(s->x1);
+            const filterBankVector_t y1 = filterBankLoad(s->y1);
+            const filterBankVector_t result = b0 * v + filterBankLoad(s->b1) * x1 + filterBankLoad(s->b2) * filterBankLoad(s->x2) - filterBankLoad(s->a1) * y1 - filterBankLoad(s->a2) * filterBankLoad(s->y2);
+            filterBankStore(s->x2, x1);
+            filterBankStore(s->x1, v);
+            filterBankStore(s->y2, y1);
+            filterBankStore(s->y1, result);
+            v = result;
+            break;
+        }
+        case FILTER_BANK_PT1: {
+            const filterBankVector_t y1 = filterBankLoad(s->y1);
+            v = y1 + b0 * (v - y1);
+            filterBankStore(s->y1, v);
+            break;
+        }
+        }
+    }
+
+    filterBankStore(values, v);
+}
+#else
+/* Runs every stage of the bank over all lanes of values[FILTER_BANK_LANES], in place.
+ * Each lane computes exactly the same expression as the single channel filter it replaces. */
+FAST_CODE void filterBankApply(filterBank_t *bank, float *values)
+{
+    // work on a local copy so the compiler knows the samples do not alias the filter state
+    float v[FILTER_BANK_LANES];
+    memcpy(v, values, sizeof(v));
+
+    for (int i = 0; i < bank->stageCount; i++) {
+        filterBankStage_t *s = &bank->stage[i];
+
+        switch (bank->stageType[i]) {
+        case FILTER_BANK_BIQUAD:
+            for (int lane = 0; lane < FILTER_BANK_LANES; lane++) {
+                const float input = v[lane];
+                const float result = s->b0[lane] * input + s->x1[lane];
+                s->x1[lane] = s->b1[lane] * input - s->a1[lane] * result + s->x2[lane];
+                s->x2[lane] = s->b2[lane] * input - s->a2[lane] * result;
+                v[lane] = result;
+            }
+            break;
+        case FILTER_BANK_BIQUAD_DF1:
+            for (int lane = 0; lane < FILTER_BANK_LANES; lane++) {
+                const float input = v[lane];
+                const float result = s->b0[lane] * input + s->b1[lane] * s->x1[lane] + s->b2[lane] * s->x2[lane] - s->a1[lane] * s->y1[lane] - s->a2[lane] * s->y2[lane];
+                s->x2[lane] = s->x1[lane];
+                s->x1[lane] = input;
+                s->y2[lane] = s->y1[lane];
+                s->y1[lane] = result;
+                v[lane] = result;
+            }
+            break;
+        case FILTER_BANK_PT1:
+            for (int lane = 0; lane < FILTER_BANK_LANES; lane++) {
+                s->y1[lane] = s->y1[lane] + s->b0[lane] * (v[lane] - s->y1[lane]);
+                v[lane] = s->y1[lane];
+            }
+            break;
+        }
+    }
+
+    memcpy(values, v, sizeof(v));
+}
+#endif
+
 void laggedMovingAverageInit(laggedMovingAverage_t *filter, uint16_t windowSize, float *buf)
 {
     filter->movingWindowIndex = 0;
@@ -19,8 +19,11 @@
  */
 
 #pragma once
+#include <math.h>
 #include <stdbool.h>
 
+#define BIQUAD_Q (1.0f / sqrtf(2.0f))   /* quality factor - 2nd order butterworth*/
+
 struct filter_s;
 typedef struct filter_s filter_t;
 
@@ -62,6 +65,41 @@ typedef enum {
 
 typedef float (*filterApplyFnPtr)(filter_t *filter, float input);
 
+// Filter bank: a cascade of filter stages run over several channels (X/Y/Z) in a single pass.
+// Coefficients and state are stored structure-of-arrays, one array element per lane, so each
+// stage is a plain loop over the lanes. With USE_FILTER_BANK_SIMD (SITL) the lanes are padded
+// to a 128 bit vector and each stage runs as vector operations.
+#ifdef USE_FILTER_BANK_SIMD
+#define FILTER_BANK_LANES       4  // X, Y, Z plus one padding lane
+#else
+#define FILTER_BANK_LANES       3  // X, Y, Z
+#endif
+#define FILTER_BANK_MAX_STAGES  5
+
+typedef enum {
+    FILTER_BANK_BIQUAD = 0,    // direct form 2 transposed, same result as biquadFilterApply
+    FILTER_BANK_BIQUAD_DF1,    // direct form 1, same result as biquadFilterApplyDF1
+    FILTER_BANK_PT1,           // same result as pt1FilterApply, gain in b0, state in y1
+} filterBankStageType_e;
+
+typedef struct filterBankStage_s {
+    float b0[FILTER_BANK_LANES];
+    float b1[FILTER_BANK_LANES];
+    float b2[FILTER_BANK_LANES];
+    float a1[FILTER_BANK_LANES];
+    float a2[FILTER_BANK_LANES];
+    float x1[FILTER_BANK_LANES];
+    float x2[FILTER_BANK_LANES];
+    float y1[FILTER_BANK_LANES];
+    float y2[FILTER_BANK_LANES];
+} filterBankStage_t;
+
+typedef struct filterBank_s {
+    filterBankStage_t stage[FILTER_BANK_MAX_STAGES];
+    uint8_t stageType[FILTER_BANK_MAX_STAGES];
+    uint8_t stageCount;
+} filterBank_t;
+
 float nullFilterApply(filter_t *filter, float input);
 
 void biquadFilterInitLPF(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate);
@@ -81,5 +119,12 @@ void pt1FilterInit(pt1Filter_t *filter, float k);
 void pt1FilterUpdateCutoff(pt1Filter_t *filter, float k);
 float pt1FilterApply(pt1Filter_t *filter, float input);
 
+void filterBankInit(filterBank_t *bank);
+int filterBankAddBiquad(filterBank_t *bank, filterBankStageType_e stageType, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType);
+int filterBankAddPt1(filterBank_t *bank, float k);
+void filterBankUpdateBiquad(filterBank_t *bank, int stage, int lane, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType);
+void filterBankUpdatePt1(filterBank_t *bank, int stage, float k);
+void filterBankApply(filterBank_t *bank, float *values);
+
 void slewFilterInit(slewFilter_t *filter, float slewLimit, float threshold);
 float slewFilterApply(slewFilter_t *filter, float input);
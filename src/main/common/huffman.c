@@ -27,6 +27,104 @@
 
 #include "huffman.h"
 
+static void huffmanCodeLengths(uint32_t *a, int n)
+{
+    // Moffat and Katajainen, "In-Place Calculation of Minimum-Redundancy Codes". a[] holds the weights in ascending
+    // order on entry and the code lengths on return, longest first.
+    a[0] += a[1];
+    int root = 0;
+    int leaf = 2;
+    for (int next = 1; next < n - 1; next++) {
+        if (leaf >= n || a[root] < a[leaf]) {
+            a[next] = a[root];
+            a[root++] = next;
+        } else {
+            a[next] = a[leaf++];
+        }
+        if (leaf >= n || (root < next && a[root] < a[leaf])) {
+            a[next] += a[root];
+            a[root++] = next;
+        } else {
+            a[next] += a[leaf++];
+        }
+    }
+
+    a[n - 2] = 0;
+    for (int next = n - 3; next >= 0; next--) {
+        a[next] = a[a[next]] + 1;
+    }
+
+    int available = 1;
+    int used = 0;
+    uint32_t depth = 0;
+    root = n - 2;
+    int next = n - 1;
+    while (available > 0) {
+        while (root >= 0 && a[root] == depth) {
+            used++;
+            root--;
+        }
+        while (available > used) {
+            a[next--] = depth;
+            available--;
+        }
+        available = 2 * used;
+        depth++;
+        used = 0;
+    }
+}
+
+/*
+ * Build a canonical Huffman table from the symbol counts of HUFFMAN_TABLE_SIZE symbols. The decoder rebuilds the
+ * same table from the same counts, so every step is deterministic:
+ *
+ *  - each symbol has weight (count >> shift) + 1, so that every symbol gets a code, with shift starting at 0
+ *  - the symbols are sorted by ascending weight, then ascending symbol
+ *  - code lengths are those of the in-place algorithm of Moffat and Katajainen on the sorted weights
+ *  - while the longest code is over HUFFMAN_MAX_CODE_LEN, shift is incremented and the lengths built again
+ *  - codes are assigned in order of ascending length, then ascending symbol, counting up from zero
+ */
+void huffmanBuildTable(huffmanTable_t *table, const uint16_t *symbolCount)
+{
+    // Too big for the stack of the tasks that build tables
+    static uint32_t codeLen[HUFFMAN_TABLE_SIZE];
+    static uint16_t symbols[HUFFMAN_TABLE_SIZE];
+
+    for (int shift = 0; ; shift++) {
+        // insertion sort, which keeps symbols of equal weight in symbol order
+        for (int i = 0; i < HUFFMAN_TABLE_SIZE; i++) {
+            const uint32_t weight = (symbolCount[i] >> shift) + 1;
+            int j = i;
+            for (; j > 0 && codeLen[j - 1] > weight; j--) {
+                codeLen[j] = codeLen[j - 1];
+                symbols[j] = symbols[j - 1];
+            }
+            codeLen[j] = weight;
+            symbols[j] = i;
+        }
+
+        huffmanCodeLengths(codeLen, HUFFMAN_TABLE_SIZE);
+        if (codeLen[0] <= HUFFMAN_MAX_CODE_LEN) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < HUFFMAN_TABLE_SIZE; i++) {
+        table[symbols[i]].codeLen = codeLen[i];
+    }
+
+    uint16_t code = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_CODE_LEN; len++) {
+        for (int symbol = 0; symbol < HUFFMAN_TABLE_SIZE; symbol++) {
+            if (table[symbol].codeLen == len) {
+                table[symbol].code = code << (HUFFMAN_MAX_CODE_LEN - len);
+                code++;
+            }
+        }
+        code <<= 1;
+    }
+}
+
 
 int huffmanEncodeBuf(uint8_t *outBuf, int outBufLen, const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable)
 {
@@ -23,6 +23,7 @@
 #include <stdint.h>
 
 #define HUFFMAN_TABLE_SIZE 257 // 256 characters plus EOF
+#define HUFFMAN_MAX_CODE_LEN 16 // codes are held left aligned in a uint16_t
 typedef struct huffmanTable_s {
     uint8_t     codeLen;
     uint16_t    code;
@@ -44,4 +45,5 @@ struct huffmanInfo_s {
 #define HUFFMAN_INFO_SIZE sizeof(struct huffmanInfo_s)
 
 int huffmanEncodeBuf(uint8_t *outBuf, int outBufLen, const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable);
+void huffmanBuildTable(huffmanTable_t *table, const uint16_t *symbolCount);
 int huffmanEncodeBufStreaming(huffmanState_t *state, const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable);
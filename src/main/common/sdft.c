@@ -0,0 +1,106 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/maths.h"
+
+#include "sdft.h"
+
+// Each bin is updated with X[k] = (X[k] + newest - r^N * oldest) * r * e^(j*2*pi*k/N).
+// The damping factor r < 1 makes rounding errors decay instead of accumulating forever.
+#define SDFT_R 0.9999f
+
+static FAST_DATA_ZERO_INIT float rPowN;
+static FAST_DATA_ZERO_INIT float twiddleRe[SDFT_BIN_COUNT];
+static FAST_DATA_ZERO_INIT float twiddleIm[SDFT_BIN_COUNT];
+
+void sdftInit(sdft_t *sdft, int startBin, int endBin, int batchCount)
+{
+    if (rPowN == 0.0f) {
+        rPowN = powf(SDFT_R, SDFT_SAMPLE_SIZE);
+        for (int k = 0; k < SDFT_BIN_COUNT; k++) {
+            const float phi = 2.0f * M_PIf * k / SDFT_SAMPLE_SIZE;
+            twiddleRe[k] = SDFT_R * cos_approx(phi);
+            twiddleIm[k] = SDFT_R * sin_approx(phi);
+        }
+    }
+
+    memset(sdft, 0, sizeof(*sdft));
+
+    // the Hann window in sdftWindowedMagSq needs the neighbouring bins too
+    sdft->startBin = constrain(startBin - 1, 0, SDFT_BIN_COUNT - 1);
+    sdft->endBin = constrain(endBin + 1, sdft->startBin, SDFT_BIN_COUNT - 1);
+    sdft->batchCount = constrain(batchCount, 1, sdft->endBin - sdft->startBin + 1);
+    sdft->batchSize = (sdft->endBin - sdft->startBin + sdft->batchCount) / sdft->batchCount;
+}
+
+static FAST_CODE void sdftUpdateBins(sdft_t *sdft, float delta, int startBin, int endBin)
+{
+    for (int k = startBin; k <= endBin; k++) {
+        const float re = sdft->re[k] + delta;
+        const float im = sdft->im[k];
+        sdft->re[k] = re * twiddleRe[k] - im * twiddleIm[k];
+        sdft->im[k] = re * twiddleIm[k] + im * twiddleRe[k];
+    }
+}
+
+// Adds a sample and updates all bins
+FAST_CODE void sdftPush(sdft_t *sdft, float sample)
+{
+    const float delta = sample - rPowN * sdft->samples[sdft->idx];
+
+    sdftUpdateBins(sdft, delta, sdft->startBin, sdft->endBin);
+
+    sdft->samples[sdft->idx] = sample;
+    sdft->idx = (sdft->idx + 1) % SDFT_SAMPLE_SIZE;
+}
+
+// Adds a sample, updating only one batch of bins, to spread the work over several calls.
+// The same sample must be pushed for every batchIdx from 0 to batchCount - 1, the sample
+// enters the window with the last batch.
+FAST_CODE void sdftPushBatch(sdft_t *sdft, float sample, int batchIdx)
+{
+    const float delta = sample - rPowN * sdft->samples[sdft->idx];
+
+    const int startBin = sdft->startBin + batchIdx * sdft->batchSize;
+    const int endBin = MIN(startBin + sdft->batchSize - 1, sdft->endBin);
+    sdftUpdateBins(sdft, delta, startBin, endBin);
+
+    if (batchIdx == sdft->batchCount - 1) {
+        sdft->samples[sdft->idx] = sample;
+        sdft->idx = (sdft->idx + 1) % SDFT_SAMPLE_SIZE;
+    }
+}
+
+// Squared magnitude of the bins with a Hann window applied in the frequency domain,
+// Y[k] = 0.5 * X[k] - 0.25 * (X[k - 1] + X[k + 1]).
+// Only bins startBin + 1 to endBin - 1 of output are valid.
+FAST_CODE void sdftWindowedMagSq(const sdft_t *sdft, float *output)
+{
+    for (int k = sdft->startBin + 1; k < sdft->endBin; k++) {
+        const float re = 0.5f * sdft->re[k] - 0.25f * (sdft->re[k - 1] + sdft->re[k + 1]);
+        const float im = 0.5f * sdft->im[k] - 0.25f * (sdft->im[k - 1] + sdft->im[k + 1]);
+        output[k] = re * re + im * im;
+    }
+}
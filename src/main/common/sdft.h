@@ -0,0 +1,45 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Sliding DFT: the spectrum of the last SDFT_SAMPLE_SIZE samples is updated
+// with every new sample at a cost proportional to the number of bins in use.
+#define SDFT_SAMPLE_SIZE 64
+#define SDFT_BIN_COUNT   (SDFT_SAMPLE_SIZE / 2)
+
+typedef struct sdft_s {
+    uint8_t idx;                        // index of the oldest sample in the window
+    uint8_t startBin;                   // first and last bin updated, includes the neighbours needed for windowing
+    uint8_t endBin;
+    uint8_t batchSize;                  // bins updated per call of sdftPushBatch
+    uint8_t batchCount;
+
+    float samples[SDFT_SAMPLE_SIZE];    // circular buffer of the samples in the window
+    float re[SDFT_BIN_COUNT];
+    float im[SDFT_BIN_COUNT];
+} sdft_t;
+
+void sdftInit(sdft_t *sdft, int startBin, int endBin, int batchCount);
+void sdftPush(sdft_t *sdft, float sample);
+void sdftPushBatch(sdft_t *sdft, float sample, int batchIdx);
+void sdftWindowedMagSq(const sdft_t *sdft, float *output);
@@ -19,6 +19,7 @@
  */
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -43,6 +44,38 @@
 
 static uint16_t eepromConfigSize;
 
+// Offsets of the records seen by the last scan, hashed by PG number, so loading does not need
+// to walk the records once for every PG. Zero marks an empty slot, no record starts at offset zero.
+#define EEPROM_RECORD_INDEX_SIZE 256 // must be a power of two, well above the number of PGs
+
+static uint16_t eepromRecordIndex[EEPROM_RECORD_INDEX_SIZE];
+static bool eepromRecordIndexValid;     // the index matches the EEPROM content
+static bool eepromRecordIndexComplete;  // false if some records did not fit in the index
+
+// Saves only append the PGs that changed, to a journal after the saved copy, until it runs out of space.
+// External flash needs page programming to start on a page boundary, and the copy on the SD card
+// is rewritten as a whole anyway, so those always rewrite everything.
+#if !defined(CONFIG_IN_EXTERNAL_FLASH) && !defined(CONFIG_IN_SDCARD)
+#define CONFIG_JOURNAL_APPEND
+#endif
+
+// A full rewrite puts the new copy in the other half of the config area, and the old copy is only
+// made invalid once the new one checks out. The scan takes the valid copy with the newest generation,
+// so a power loss while rewriting leaves the previous copy in place. This needs each half to be
+// erased on its own, on F4, F7 and most H7 the config area is a single flash sector, so those still
+// rewrite it in place. So does a config too big for half the area.
+#if defined(CONFIG_JOURNAL_APPEND) && (defined(CONFIG_IN_RAM) || defined(CONFIG_IN_FILE) || \
+    (defined(CONFIG_IN_FLASH) && (defined(STM32G4) || defined(STM32H7A3xx) || defined(STM32H7A3xxQ))))
+#define CONFIG_COPY_PAIR
+#endif
+
+static uint16_t eepromCopyStart;        // offset of the saved copy in use
+static uint32_t eepromCopyLimit;        // end of the space for that copy and its journal
+static uint16_t eepromJournalStart;     // offset of the first journal block
+static uint16_t eepromJournalEnd;       // offset for the next journal block
+static uint16_t eepromJournalGeneration;
+static bool eepromJournalUsable;        // the saved copy is valid and has a generation
+
 typedef enum {
     CR_CLASSICATION_SYSTEM   = 0,
     CR_CLASSICATION_PROFILE_LAST = CR_CLASSICATION_SYSTEM,
@@ -71,12 +104,35 @@ typedef struct {
     uint8_t pg[];
 } PG_PACKED configRecord_t;
 
+// The saved copy holds a record with its generation, under a PG number no PG uses. Journal blocks
+// carry the generation they were appended to, so blocks left behind from an older copy are ignored.
+#define CR_PGN_GENERATION 0
+
+typedef struct {
+    uint16_t generation;
+} PG_PACKED configGeneration_t;
+
+// Header for each block appended to the journal. The records follow, then the CRC of the header
+// and records, stored like the CRC of the saved copy. Blocks start at a multiple of the write size.
+typedef struct {
+    uint16_t size;              // header, records and CRC, without the padding
+    uint16_t generation;
+} PG_PACKED configJournalHeader_t;
+
 // Footer for the saved copy.
 typedef struct {
     uint16_t terminator;
 } PG_PACKED configFooter_t;
 // checksum is appended just after footer. It is not included in footer to make checksum calculation consistent
 
+// A saved copy found by the scan
+typedef struct {
+    uint16_t start;
+    uint16_t size;              // header, records, footer and CRC
+    uint16_t generation;
+    bool hasGeneration;
+} configCopy_t;
+
 // Used to check the compiler packing at build time.
 typedef struct {
     uint8_t byte;
@@ -252,6 +308,8 @@ void initEEPROM(void)
     STATIC_ASSERT(sizeof(configFooter_t) == 2, footer_size_failed);
     STATIC_ASSERT(sizeof(configRecord_t) == 6, record_size_failed);
 
+    eepromRecordIndexValid = false;
+
 #if defined(CONFIG_IN_FILE)
     loadEEPROMFromFile();
 #elif defined(CONFIG_IN_EXTERNAL_FLASH)
@@ -271,7 +329,7 @@ void initEEPROM(void)
 
 bool isEEPROMVersionValid(void)
 {
-    const uint8_t *p = &__config_start;
+    const uint8_t *p = &__config_start + eepromCopyStart;
     const configHeader_t *header = (const configHeader_t *)p;
 
     if (header->eepromConfigVersion != EEPROM_CONF_VERSION) {
@@ -281,16 +339,104 @@ bool isEEPROMVersionValid(void)
     return true;
 }
 
-// Scan the EEPROM config. Returns true if the config is valid.
-bool isEEPROMStructureValid(void)
+static unsigned eepromRecordIndexSlot(uint16_t pgn)
+{
+    // PG numbers come in runs, spread them over the index
+    return (pgn * 2654435761u) >> 16 & (EEPROM_RECORD_INDEX_SIZE - 1);
+}
+
+static uint32_t journalAlign(uint32_t offset)
+{
+    return (offset + CONFIG_STREAMER_BUFFER_SIZE - 1) & ~(CONFIG_STREAMER_BUFFER_SIZE - 1);
+}
+
+static uint32_t eepromAreaSize(void)
+{
+    return &__config_end - &__config_start;
+}
+
+#ifdef CONFIG_COPY_PAIR
+// offset of the second copy, half way through the config area
+static uint16_t eepromPairOffset(void)
+{
+    return (eepromAreaSize() / 2) & ~(CONFIG_STREAMER_BUFFER_SIZE - 1);
+}
+#endif
+
+// Returns the journal block at offset if it is complete, intact and belongs to the saved copy
+static const configJournalHeader_t *journalBlockAt(uint16_t offset)
+{
+    const uint8_t *p = &__config_start + offset;
+    const uint8_t *limit = &__config_start + eepromCopyLimit;
+    const configJournalHeader_t *block = (const configJournalHeader_t *)p;
+
+    if (p + sizeof(*block) > limit
+        || block->size < sizeof(*block) + sizeof(uint16_t)
+        || p + block->size > limit
+        || block->generation != eepromJournalGeneration) {
+        // erased, or an interrupted write
+        return NULL;
+    }
+
+    // the records must fill the block exactly
+    const uint8_t *recordsEnd = p + block->size - sizeof(uint16_t);
+    for (const uint8_t *r = p + sizeof(*block); r < recordsEnd; ) {
+        const configRecord_t *record = (const configRecord_t *)r;
+        if (record->size < sizeof(*record) || r + record->size > recordsEnd) {
+            return NULL;
+        }
+        r += record->size;
+    }
+
+    if (crc16_ccitt_update(CRC_START_VALUE, p, block->size) != CRC_CHECK_VALUE) {
+        return NULL;
+    }
+
+    return block;
+}
+
+// A later record of a PG replaces an earlier one when replace is set, otherwise the first one is kept
+static void eepromRecordIndexAdd(const configRecord_t *record, bool replace)
+{
+    const ptrdiff_t offset = (const uint8_t *)record - &__config_start;
+    if (offset > UINT16_MAX) {
+        eepromRecordIndexComplete = false;
+        return;
+    }
+
+    unsigned slot = eepromRecordIndexSlot(record->pgn);
+    for (int probe = 0; probe < EEPROM_RECORD_INDEX_SIZE; probe++) {
+        if (!eepromRecordIndex[slot]) {
+            eepromRecordIndex[slot] = offset;
+            return;
+        }
+        const configRecord_t *indexed = (const configRecord_t *)(&__config_start + eepromRecordIndex[slot]);
+        if (indexed->pgn == record->pgn) {
+            if (replace) {
+                eepromRecordIndex[slot] = offset;
+            }
+            return;
+        }
+        slot = (slot + 1) & (EEPROM_RECORD_INDEX_SIZE - 1);
+    }
+
+    eepromRecordIndexComplete = false;
+}
+
+// Checks the saved copy at offset start, which must end before limit. Returns true if it is valid.
+static bool findConfigCopy(uint16_t start, uint32_t limit, configCopy_t *copy)
 {
-    const uint8_t *p = &__config_start;
+    const uint8_t *p = &__config_start + start;
+    const uint8_t *end = &__config_start + limit;
     const configHeader_t *header = (const configHeader_t *)p;
 
-    if (header->magic_be != 0xBE) {
+    if (p + sizeof(*header) > end || header->magic_be != 0xBE) {
         return false;
     }
 
+    copy->start = start;
+    copy->hasGeneration = false;
+
     uint16_t crc = CRC_START_VALUE;
     crc = crc16_ccitt_update(crc, header, sizeof(*header));
     p += sizeof(*header);
@@ -302,17 +448,26 @@ bool isEEPROMStructureValid(void)
             // Found the end.  Stop scanning.
             break;
         }
-        if (p + record->size >= &__config_end
+        if (p + record->size >= end
             || record->size < sizeof(*record)) {
             // Too big or too small.
             return false;
         }
 
+        if (record->pgn == CR_PGN_GENERATION && record->size == sizeof(*record) + sizeof(configGeneration_t)) {
+            copy->generation = ((const configGeneration_t *)record->pg)->generation;
+            copy->hasGeneration = true;
+        }
+
         crc = crc16_ccitt_update(crc, p, record->size);
 
         p += record->size;
     }
 
+    if (p + sizeof(configFooter_t) + sizeof(uint16_t) > end) {
+        return false;
+    }
+
     const configFooter_t *footer = (const configFooter_t *)p;
     crc = crc16_ccitt_update(crc, footer, sizeof(*footer));
     p += sizeof(*footer);
@@ -320,14 +475,96 @@ bool isEEPROMStructureValid(void)
     // include stored CRC in the CRC calculation
     const uint16_t *storedCrc = (const uint16_t *)p;
     crc = crc16_ccitt_update(crc, storedCrc, sizeof(*storedCrc));
-    p += sizeof(storedCrc);
+    p += sizeof(*storedCrc);
 
-    eepromConfigSize = p - &__config_start;
+    copy->size = p - (&__config_start + start);
 
     // CRC has the property that if the CRC itself is included in the calculation the resulting CRC will have constant value
     return crc == CRC_CHECK_VALUE;
 }
 
+// Scan the EEPROM config. Returns true if the config is valid.
+// The scan also indexes the records, including those in the journal, for loadEEPROM().
+bool isEEPROMStructureValid(void)
+{
+    eepromRecordIndexValid = false;
+    eepromJournalUsable = false;
+    eepromJournalStart = 0;
+    eepromJournalEnd = 0;
+    eepromConfigSize = 0;
+
+    configCopy_t copy;
+    bool valid = findConfigCopy(0, eepromAreaSize(), &copy);
+    uint32_t limit = eepromAreaSize();
+
+#ifdef CONFIG_COPY_PAIR
+    // a copy too big for half the area is written over the second one
+    const uint16_t pairOffset = eepromPairOffset();
+    if (!valid || copy.size <= pairOffset) {
+        limit = pairOffset;
+
+        // a copy without a generation was written before the pair, so it is older
+        configCopy_t second;
+        if (findConfigCopy(pairOffset, eepromAreaSize(), &second)
+            && second.hasGeneration
+            && (!valid || !copy.hasGeneration || (int16_t)(second.generation - copy.generation) > 0)) {
+            copy = second;
+            valid = true;
+            limit = eepromAreaSize();
+        }
+    }
+#endif
+
+    if (!valid) {
+        return false;
+    }
+
+    eepromCopyStart = copy.start;
+    eepromCopyLimit = limit;
+    eepromConfigSize = copy.size;
+
+    memset(eepromRecordIndex, 0, sizeof(eepromRecordIndex));
+    eepromRecordIndexComplete = true;
+    eepromRecordIndexValid = true;
+
+    const uint8_t *p = &__config_start + copy.start + sizeof(configHeader_t);
+    for (const configRecord_t *record = (const configRecord_t *)p; record->size; record = (const configRecord_t *)p) {
+        if (record->pgn != CR_PGN_GENERATION && (record->flags & CR_CLASSIFICATION_MASK) == CR_CLASSICATION_SYSTEM) {
+            eepromRecordIndexAdd(record, false);
+        }
+        p += record->size;
+    }
+
+    if (copy.hasGeneration) {
+        // apply the journal, its records replace the saved ones and those of earlier blocks
+        eepromJournalGeneration = copy.generation;
+        eepromJournalStart = journalAlign(copy.start + copy.size);
+        eepromJournalEnd = eepromJournalStart;
+
+        const configJournalHeader_t *block;
+        while ((block = journalBlockAt(eepromJournalEnd))) {
+            const uint32_t next = journalAlign(eepromJournalEnd + block->size);
+            if (next > UINT16_MAX) {
+                // not written by appendSettingsToEEPROM()
+                break;
+            }
+            const uint8_t *recordsEnd = (const uint8_t *)block + block->size - sizeof(uint16_t);
+            for (const uint8_t *r = (const uint8_t *)(block + 1); r < recordsEnd; r += ((const configRecord_t *)r)->size) {
+                const configRecord_t *record = (const configRecord_t *)r;
+                if ((record->flags & CR_CLASSIFICATION_MASK) == CR_CLASSICATION_SYSTEM) {
+                    eepromRecordIndexAdd(record, true);
+                }
+            }
+            eepromJournalEnd = next;
+        }
+
+        eepromConfigSize = eepromJournalEnd - copy.start;
+        eepromJournalUsable = true;
+    }
+
+    return true;
+}
+
 uint16_t getEEPROMConfigSize(void)
 {
     return eepromConfigSize;
@@ -352,7 +589,8 @@ size_t getEEPROMStorageSize(void)
 // this function assumes that EEPROM content is valid
 static const configRecord_t *findEEPROM(const pgRegistry_t *reg, configRecordFlags_e classification)
 {
-    const uint8_t *p = &__config_start;
+    const configRecord_t *found = NULL;
+    const uint8_t *p = &__config_start + eepromCopyStart;
     p += sizeof(configHeader_t);             // skip header
     while (true) {
         const configRecord_t *record = (const configRecord_t *)p;
@@ -361,23 +599,59 @@ static const configRecord_t *findEEPROM(const pgRegistry_t *reg, configRecordFla
             || record->size < sizeof(*record))
             break;
         if (pgN(reg) == record->pgn
-            && (record->flags & CR_CLASSIFICATION_MASK) == classification)
-            return record;
+            && (record->flags & CR_CLASSIFICATION_MASK) == classification) {
+            found = record;
+            break;
+        }
         p += record->size;
     }
-    // record not found
-    return NULL;
+
+    // the last record in the journal wins, the blocks up to eepromJournalEnd have been checked by the scan
+    for (uint16_t offset = eepromJournalStart; offset < eepromJournalEnd; ) {
+        const configJournalHeader_t *block = (const configJournalHeader_t *)(&__config_start + offset);
+        const uint8_t *recordsEnd = (const uint8_t *)block + block->size - sizeof(uint16_t);
+        for (const uint8_t *r = (const uint8_t *)(block + 1); r < recordsEnd; r += ((const configRecord_t *)r)->size) {
+            const configRecord_t *record = (const configRecord_t *)r;
+            if (pgN(reg) == record->pgn
+                && (record->flags & CR_CLASSIFICATION_MASK) == classification) {
+                found = record;
+            }
+        }
+        offset = journalAlign(offset + block->size);
+    }
+
+    return found;
+}
+
+// find system config record for reg using the index built by isEEPROMStructureValid()
+static const configRecord_t *findEEPROMIndexed(const pgRegistry_t *reg)
+{
+    unsigned slot = eepromRecordIndexSlot(pgN(reg));
+    for (int probe = 0; probe < EEPROM_RECORD_INDEX_SIZE && eepromRecordIndex[slot]; probe++) {
+        const configRecord_t *record = (const configRecord_t *)(&__config_start + eepromRecordIndex[slot]);
+        if (record->pgn == pgN(reg)) {
+            return record;
+        }
+        slot = (slot + 1) & (EEPROM_RECORD_INDEX_SIZE - 1);
+    }
+
+    return eepromRecordIndexComplete ? NULL : findEEPROM(reg, CR_CLASSICATION_SYSTEM);
 }
 
 // Initialize all PG records from EEPROM.
-// This functions processes all PGs sequentially, scanning EEPROM for each one. This is suboptimal,
-//   but each PG is loaded/initialized exactly once and in defined order.
+// This functions processes all PGs sequentially, each PG is loaded/initialized exactly once and in defined order.
+// Records are looked up in the index built while validating the EEPROM, the EEPROM is only scanned
+//   here when that has not happened since the last write.
 bool loadEEPROM(void)
 {
     bool success = true;
 
+    if (!eepromRecordIndexValid) {
+        isEEPROMStructureValid();
+    }
+
     PG_FOREACH(reg) {
-        const configRecord_t *rec = findEEPROM(reg, CR_CLASSICATION_SYSTEM);
+        const configRecord_t *rec = eepromRecordIndexValid ? findEEPROMIndexed(reg) : findEEPROM(reg, CR_CLASSICATION_SYSTEM);
         if (rec) {
             // config from EEPROM is available, use it to initialize PG. pgLoad will handle version mismatch
             if (!pgLoad(reg, rec->pg, rec->size - offsetof(configRecord_t, pg), rec->version)) {
@@ -393,12 +667,58 @@ bool loadEEPROM(void)
     return success;
 }
 
+#ifdef CONFIG_COPY_PAIR
+static uint32_t configCopySize(void)
+{
+    uint32_t size = sizeof(configHeader_t) + sizeof(configRecord_t) + sizeof(configGeneration_t) + sizeof(configFooter_t) + sizeof(uint16_t);
+    PG_FOREACH(reg) {
+        size += sizeof(configRecord_t) + pgSize(reg);
+    }
+    return size;
+}
+
+// Once the new copy checks out the one it replaced is made invalid, so it is never taken for the
+// current one. If that fails the new copy still wins, it has the newer generation.
+static void invalidateReplacedCopy(void)
+{
+    if (eepromCopyStart == 0 && eepromCopyLimit > eepromPairOffset()) {
+        // rewritten in place, there is no other copy
+        return;
+    }
+    const uint16_t replaced = eepromCopyStart ? 0 : eepromPairOffset();
+
+    config_streamer_t streamer;
+    config_streamer_init(&streamer);
+
+    config_streamer_start(&streamer, (uintptr_t)&__config_start + replaced, CONFIG_STREAMER_BUFFER_SIZE);
+
+    // clears the magic number of the header
+    const uint8_t invalidHeader[CONFIG_STREAMER_BUFFER_SIZE] = { 0 };
+    config_streamer_write(&streamer, invalidHeader, sizeof(invalidHeader));
+
+    config_streamer_flush(&streamer);
+    config_streamer_finish(&streamer);
+}
+#endif
+
 static bool writeSettingsToEEPROM(void)
 {
+    eepromRecordIndexValid = false;
+
+    uint16_t start = 0;
+    uint32_t size = eepromAreaSize();
+#ifdef CONFIG_COPY_PAIR
+    // the copy in use stays intact until the new one is complete, unless both don't fit
+    if (configCopySize() <= eepromPairOffset()) {
+        start = eepromCopyStart ? 0 : eepromPairOffset();
+        size = start ? eepromAreaSize() - start : eepromPairOffset();
+    }
+#endif
+
     config_streamer_t streamer;
     config_streamer_init(&streamer);
 
-    config_streamer_start(&streamer, (uintptr_t)&__config_start, &__config_end - &__config_start);
+    config_streamer_start(&streamer, (uintptr_t)&__config_start + start, size);
 
     configHeader_t header = {
         .eepromConfigVersion =  EEPROM_CONF_VERSION,
@@ -408,6 +728,22 @@ static bool writeSettingsToEEPROM(void)
     config_streamer_write(&streamer, (uint8_t *)&header, sizeof(header));
     uint16_t crc = CRC_START_VALUE;
     crc = crc16_ccitt_update(crc, (uint8_t *)&header, sizeof(header));
+
+    // a new generation, so no journal block of the copy being replaced is taken for one of this copy
+    const configGeneration_t generation = {
+        .generation = eepromJournalGeneration + 1,
+    };
+    const configRecord_t generationRecord = {
+        .size = sizeof(configRecord_t) + sizeof(generation),
+        .pgn = CR_PGN_GENERATION,
+        .version = 0,
+        .flags = 0,
+    };
+    config_streamer_write(&streamer, (uint8_t *)&generationRecord, sizeof(generationRecord));
+    crc = crc16_ccitt_update(crc, (uint8_t *)&generationRecord, sizeof(generationRecord));
+    config_streamer_write(&streamer, (uint8_t *)&generation, sizeof(generation));
+    crc = crc16_ccitt_update(crc, (uint8_t *)&generation, sizeof(generation));
+
     PG_FOREACH(reg) {
         const uint16_t regSize = pgSize(reg);
         configRecord_t record = {
@@ -439,11 +775,123 @@ static bool writeSettingsToEEPROM(void)
 
     const bool success = config_streamer_finish(&streamer) == 0;
 
+    if (success) {
+        eepromCopyStart = start;
+    }
+
     return success;
 }
 
+#ifdef CONFIG_JOURNAL_APPEND
+// Returns true if the saved copy, with the journal, holds reg as it is in RAM
+static bool isEEPROMRecordCurrent(const pgRegistry_t *reg)
+{
+    const configRecord_t *record = findEEPROMIndexed(reg);
+
+    return record
+        && record->version == pgVersion(reg)
+        && record->size == sizeof(*record) + pgSize(reg)
+        && memcmp(record->pg, reg->address, pgSize(reg)) == 0;
+}
+
+static bool isEEPROMCurrent(void)
+{
+    PG_FOREACH(reg) {
+        if (!isEEPROMRecordCurrent(reg)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Append the PGs that changed since the last save to the journal, in a single block.
+// Returns false if that is not possible, then the whole config has to be rewritten.
+static bool appendSettingsToEEPROM(void)
+{
+    if (!eepromRecordIndexValid) {
+        isEEPROMStructureValid();
+    }
+    if (!eepromJournalUsable || !eepromRecordIndexComplete || !isEEPROMVersionValid()) {
+        return false;
+    }
+
+    uint32_t size = sizeof(configJournalHeader_t) + sizeof(uint16_t);
+    PG_FOREACH(reg) {
+        if (!isEEPROMRecordCurrent(reg)) {
+            size += sizeof(configRecord_t) + pgSize(reg);
+        }
+    }
+    if (size == sizeof(configJournalHeader_t) + sizeof(uint16_t)) {
+        // nothing changed
+        return true;
+    }
+
+    // the index holds 16 bit offsets, so the journal stays in the first 64k
+    const uint8_t *start = &__config_start + eepromJournalEnd;
+    const uint8_t *end = start + journalAlign(size);
+    if (end > &__config_start + eepromCopyLimit || end - &__config_start > UINT16_MAX) {
+        return false;
+    }
+#ifdef CONFIG_IN_FLASH
+    // flash can only be programmed once after an erase, whatever an interrupted save left there needs a rewrite
+    for (const uint8_t *p = start; p < end; p++) {
+        if (*p != 0xFF) {
+            return false;
+        }
+    }
+#endif
+
+    config_streamer_t streamer;
+    config_streamer_init(&streamer);
+
+    config_streamer_start(&streamer, (uintptr_t)start, end - start);
+
+    const configJournalHeader_t header = {
+        .size = size,
+        .generation = eepromJournalGeneration,
+    };
+    config_streamer_write(&streamer, (uint8_t *)&header, sizeof(header));
+    uint16_t crc = CRC_START_VALUE;
+    crc = crc16_ccitt_update(crc, (uint8_t *)&header, sizeof(header));
+
+    PG_FOREACH(reg) {
+        if (isEEPROMRecordCurrent(reg)) {
+            continue;
+        }
+        const uint16_t regSize = pgSize(reg);
+        const configRecord_t record = {
+            .size = sizeof(configRecord_t) + regSize,
+            .pgn = pgN(reg),
+            .version = pgVersion(reg),
+            .flags = CR_CLASSICATION_SYSTEM,
+        };
+        config_streamer_write(&streamer, (uint8_t *)&record, sizeof(record));
+        crc = crc16_ccitt_update(crc, (uint8_t *)&record, sizeof(record));
+        config_streamer_write(&streamer, reg->address, regSize);
+        crc = crc16_ccitt_update(crc, reg->address, regSize);
+    }
+
+    // the CRC goes in last, a block cut short by a power loss is never taken as valid
+    const uint16_t invertedBigEndianCrc = ~(((crc & 0xFF) << 8) | (crc >> 8));
+    config_streamer_write(&streamer, (uint8_t *)&invertedBigEndianCrc, sizeof(crc));
+
+    config_streamer_flush(&streamer);
+
+    eepromRecordIndexValid = false;
+
+    return config_streamer_finish(&streamer) == 0;
+}
+#endif
+
 void writeConfigToEEPROM(void)
 {
+#ifdef CONFIG_JOURNAL_APPEND
+    // usually only a few PGs have changed, append those instead of erasing and rewriting everything
+    if (appendSettingsToEEPROM() && isEEPROMVersionValid() && isEEPROMStructureValid() && isEEPROMCurrent()) {
+        return;
+    }
+#endif
+
     bool success = false;
     // write it
     for (int attempt = 0; attempt < 3 && !success; attempt++) {
@@ -463,9 +911,19 @@ void writeConfigToEEPROM(void)
 
 
     if (success && isEEPROMVersionValid() && isEEPROMStructureValid()) {
+#ifdef CONFIG_COPY_PAIR
+        invalidateReplacedCopy();
+#endif
         return;
     }
 
     // Flash write failed - just die now
     failureMode(FAILURE_CONFIG_STORE_FAILURE);
 }
+
+#ifdef UNIT_TEST
+uint16_t getEEPROMCopyOffset(void)
+{
+    return eepromCopyStart;
+}
+#endif
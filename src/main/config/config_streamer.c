@@ -92,7 +92,7 @@ void config_streamer_init(config_streamer_t *c)
 
 void config_streamer_start(config_streamer_t *c, uintptr_t base, int size)
 {
-    // base must start at FLASH_PAGE_SIZE boundary when using embedded flash.
+    // base must start at FLASH_PAGE_SIZE boundary when using embedded flash, unless it is in flash that is already erased.
     c->address = base;
     c->size = size;
     if (!c->unlocked) {
@@ -128,6 +128,11 @@ void config_streamer_start(config_streamer_t *c, uintptr_t base, int size)
 #else
 # error "Unsupported CPU"
 #endif
+#endif
+
+#if defined(CONFIG_IN_RAM) || defined(CONFIG_IN_SDCARD)
+    // clear the range being written, as erasing does on flash
+    memset((void *)base, 0, size);
 #endif
     c->err = 0;
 }
@@ -408,18 +413,8 @@ static int write_word(config_streamer_t *c, config_streamer_buffer_align_type_t
     flashPageProgramContinue((uint8_t *)buffer, CONFIG_STREAMER_BUFFER_SIZE);
 
 #elif defined(CONFIG_IN_RAM) || defined(CONFIG_IN_SDCARD)
-    if (c->address == (uintptr_t)&eepromData[0]) {
-        memset(eepromData, 0, sizeof(eepromData));
-    }
-
-    uint64_t *dest_addr = (uint64_t *)c->address;
-    uint64_t *src_addr = (uint64_t*)buffer;
-    uint8_t row_index = 4;
-    /* copy the 256 bits flash word */
-    do
-    {
-      *dest_addr++ = *src_addr++;
-    } while (--row_index != 0);
+    // only the buffer, a save appending to the journal may end right at the end of eepromData
+    memcpy((void *)c->address, buffer, CONFIG_STREAMER_BUFFER_SIZE);
 
 #elif defined(CONFIG_IN_FILE)
 
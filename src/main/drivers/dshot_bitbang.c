@@ -28,6 +28,8 @@
 
 #include "build/debug.h"
 
+#include "common/utils.h"
+
 #include "drivers/io.h"
 #include "drivers/io_impl.h"
 #include "drivers/dma.h"
@@ -91,6 +93,11 @@ dshotBitbangStatus_e bbStatus;
 BB_OUTPUT_BUFFER_ATTRIBUTE uint32_t bbOutputBuffer[MOTOR_DSHOT_BUF_CACHE_ALIGN_LENGTH * MAX_SUPPORTED_MOTOR_PORTS];
 BB_INPUT_BUFFER_ATTRIBUTE uint16_t bbInputBuffer[DSHOT_BB_PORT_IP_BUF_CACHE_ALIGN_LENGTH * MAX_SUPPORTED_MOTOR_PORTS];
 
+#ifdef USE_DSHOT_TELEMETRY
+// decode_bb_port() would ignore the samples past BB_MAX_PORT_SAMPLES
+STATIC_ASSERT(DSHOT_BB_PORT_IP_BUF_LENGTH <= BB_MAX_PORT_SAMPLES, bb_port_input_buffer_too_long);
+#endif
+
 uint8_t bbPuPdMode;
 FAST_DATA_ZERO_INIT timeUs_t dshotFrameUs;
 
@@ -448,6 +455,7 @@ static bool bbMotorConfig(IO_t io, uint8_t motorIndex, motorPwmProtocolTypes_e p
     bbMotors[motorIndex].io = io;
     bbMotors[motorIndex].output = output;
     bbMotors[motorIndex].bbPort = bbPort;
+    bbPort->inputPinMask |= 1 << pinIndex;
 
     IOInit(io, OWNER_MOTOR, RESOURCE_INDEX(motorIndex));
 
@@ -484,49 +492,49 @@ static bool bbUpdateStart(void)
             return false;
         }
 
-        for (int motorIndex = 0; motorIndex < MAX_SUPPORTED_MOTORS && motorIndex < motorCount; motorIndex++) {
+        for (int i = 0; i < usedMotorPorts; i++) {
+            bbPort_t *bbPort = &bbPorts[i];
 #ifdef USE_DSHOT_CACHE_MGMT
-            // Only invalidate the buffer once. If all motors are on a common port they'll share a buffer.
-            bool invalidated = false;
-            for (int i = 0; i < motorIndex; i++) {
-                if (bbMotors[motorIndex].bbPort->portInputBuffer == bbMotors[i].bbPort->portInputBuffer) {
-                    invalidated = true;
-                }
-            }
-            if (!invalidated) {
-                SCB_InvalidateDCache_by_Addr((uint32_t *)bbMotors[motorIndex].bbPort->portInputBuffer,
-                                             DSHOT_BB_PORT_IP_BUF_CACHE_ALIGN_BYTES);
-            }
+            SCB_InvalidateDCache_by_Addr((uint32_t *)bbPort->portInputBuffer, DSHOT_BB_PORT_IP_BUF_CACHE_ALIGN_BYTES);
+#endif
+            const uint32_t inputCount = bbPort->portInputCount - bbDMA_Count(bbPort);
+#if !defined(STM32F4) && !defined(DEBUG_BBDECODE)
+            // all motors on a port are decoded in a single pass over its samples
+            uint32_t pinValues[16];
+            decode_bb_port(bbPort->portInputBuffer, inputCount, bbPort->inputPinMask, pinValues);
 #endif
 
-#ifdef STM32F4
-            uint32_t value = decode_bb_bitband(
-                bbMotors[motorIndex].bbPort->portInputBuffer,
-                bbMotors[motorIndex].bbPort->portInputCount - bbDMA_Count(bbMotors[motorIndex].bbPort),
-                bbMotors[motorIndex].pinIndex);
+            for (int motorIndex = 0; motorIndex < MAX_SUPPORTED_MOTORS && motorIndex < motorCount; motorIndex++) {
+                if (bbMotors[motorIndex].bbPort != bbPort) {
+                    continue;
+                }
+#if defined(STM32F4)
+                // the bitband decoder stays until decode_bb_port() has been measured against it on an F4
+                uint32_t value = decode_bb_bitband(bbPort->portInputBuffer, inputCount, bbMotors[motorIndex].pinIndex);
+#elif defined(DEBUG_BBDECODE)
+                // decode_bb() records the edges that dshot_telemetry_info shows
+                uint32_t value = decode_bb(bbPort->portInputBuffer, inputCount, bbMotors[motorIndex].pinIndex);
 #else
-            uint32_t value = decode_bb(
-                bbMotors[motorIndex].bbPort->portInputBuffer,
-                bbMotors[motorIndex].bbPort->portInputCount - bbDMA_Count(bbMotors[motorIndex].bbPort),
-                bbMotors[motorIndex].pinIndex);
+                uint32_t value = pinValues[bbMotors[motorIndex].pinIndex];
 #endif
-            if (value == BB_NOEDGE) {
-                continue;
-            }
-            dshotTelemetryState.readCount++;
-
-            if (value != BB_INVALID) {
-                dshotTelemetryState.motorState[motorIndex].telemetryValue = value;
-                dshotTelemetryState.motorState[motorIndex].telemetryActive = true;
-                if (motorIndex < 4) {
-                    DEBUG_SET(DEBUG_DSHOT_RPM_TELEMETRY, motorIndex, value);
+                if (value == BB_NOEDGE) {
+                    continue;
+                }
+                dshotTelemetryState.readCount++;
+
+                if (value != BB_INVALID) {
+                    dshotTelemetryState.motorState[motorIndex].telemetryValue = value;
+                    dshotTelemetryState.motorState[motorIndex].telemetryActive = true;
+                    if (motorIndex < 4) {
+                        DEBUG_SET(DEBUG_DSHOT_RPM_TELEMETRY, motorIndex, value);
+                    }
+                } else {
+                    dshotTelemetryState.invalidPacketCount++;
                 }
-            } else {
-                dshotTelemetryState.invalidPacketCount++;
-            }
 #ifdef USE_DSHOT_TELEMETRY_STATS
-            updateDshotTelemetryQuality(&dshotTelemetryQuality[motorIndex], value != BB_INVALID, currentTimeMs);
+                updateDshotTelemetryQuality(&dshotTelemetryQuality[motorIndex], value != BB_INVALID, currentTimeMs);
 #endif
+            }
         }
     }
 #endif
@@ -23,6 +23,7 @@ uint16_t bbBuffer[134];
 #endif
 
 
+#ifdef STM32F4
 /* Bit band SRAM definitions */
 #define BITBAND_SRAM_REF   0x20000000
 #define BITBAND_SRAM_BASE  0x22000000
@@ -32,6 +33,7 @@ typedef struct bitBandWord_s {
     uint32_t value;
     uint32_t junk[15];
 } bitBandWord_t;
+#endif
 
 #ifdef DEBUG_BBDECODE
 uint32_t sequence[MAX_GCR_EDGES];
@@ -88,6 +90,7 @@ static uint32_t decode_bb_value(uint32_t value, uint16_t buffer[], uint32_t coun
 }
 
 
+#ifdef STM32F4
 uint32_t decode_bb_bitband( uint16_t buffer[], uint32_t count, uint32_t bit)
 {
 #ifdef DEBUG_BBDECODE
@@ -200,6 +203,7 @@ uint32_t decode_bb_bitband( uint16_t buffer[], uint32_t count, uint32_t bit)
     }
     return decode_bb_value(value, buffer, count, bit);
 }
+#endif
 
 FAST_CODE uint32_t decode_bb( uint16_t buffer[], uint32_t count, uint32_t bit)
 {
@@ -292,4 +296,144 @@ FAST_CODE uint32_t decode_bb( uint16_t buffer[], uint32_t count, uint32_t bit)
     return decode_bb_value(value, buffer, count, bit);
 }
 
+#define BB_EDGE_WORDS (BB_MAX_PORT_SAMPLES / 32)
+
+// Number of GCR bits for a level of length n: a sequence of the form 1000 with a
+// length of (n+1) / 3 to account for 3x oversampling. 0 marks lengths that GCR,
+// which never has more than two zeros in a row, can't produce.
+static const uint8_t bbRunBits[16] = {
+    0, 1, 1, 1, 1, 2, 2, 2, 3, 3, 3, 0, 0, 0, 0, 0 };
+
+// Transposes two 16x16 bit matrices side by side, the low and high halves of the
+// words. Row k bit n ends up as row n bit k.
+static void bbTranspose(uint32_t a[16])
+{
+    uint32_t m = 0x00ff00ff;
+    for (int j = 8; j; j >>= 1, m ^= m << j) {
+        for (int k = 0; k < 16; k = (k + j + 1) & ~j) {
+            const uint32_t t = ((a[k] >> j) ^ a[k + j]) & m;
+            a[k] ^= t << j;
+            a[k + j] ^= t;
+        }
+    }
+}
+
+// Sample index of the next edge in a pin's edge bitmap, count once there are no more
+static uint32_t bbNextEdge(const uint32_t edges[], uint32_t count, int *word, uint32_t *remaining)
+{
+    while (!*remaining) {
+        if (++*word >= (int)((count + 31) / 32)) {
+            return count;
+        }
+        *remaining = edges[*word];
+    }
+    const uint32_t edge = *word * 32 + __builtin_ctz(*remaining);
+    *remaining &= *remaining - 1;
+    return edge;
+}
+
+// Same result as decode_bb() for a pin, from a bitmap with a bit set for every sample
+// where the pin changed level.
+static uint32_t decode_bb_edges(const uint32_t edges[], uint16_t buffer[], uint32_t count, uint32_t bit)
+{
+    int word = 0;
+    uint32_t remaining = edges[0];
+
+    // the first edge is the first low sample, inverted dshot idles high
+    const uint32_t start = bbNextEdge(edges, count, &word, &remaining);
+    if (start + MIN_VALID_BBSAMPLES >= count) {
+        return BB_NOEDGE;
+    }
+    const uint32_t end = MIN(start + MAX_VALID_BBSAMPLES, count - 1);
+
+    uint32_t edge = bbNextEdge(edges, count, &word, &remaining);
+    if (edge == start + 1) {
+        // a start that is a single sample long is a glitch
+        return BB_NOEDGE;
+    }
+
+    uint32_t value = 0;
+    uint32_t bits = 0;
+    uint32_t lastEdge = start;
+    for (; edge < end; edge = bbNextEdge(edges, count, &word, &remaining)) {
+        const uint32_t runLength = edge - lastEdge;
+        const uint32_t len = runLength < ARRAYLEN(bbRunBits) ? bbRunBits[runLength] : 0;
+        if (!len) {
+            break;
+        }
+        bits += len;
+        value = (value << len) | (1 << (len - 1));
+        lastEdge = edge;
+    }
+
+    if (edge < end) {
+        // Corrupt frame, all that is left to find out is whether it spans enough
+        // bits to be reported as invalid rather than as no edge.
+        for (; edge < end; edge = bbNextEdge(edges, count, &word, &remaining)) {
+            bits += MAX((edge - lastEdge + 1) / 3, 1U);
+            lastEdge = edge;
+        }
+        return bits < 18 ? BB_NOEDGE : BB_INVALID;
+    }
+
+    // length of last sequence has to be inferred since the last bit with inverted dshot is high
+    if (bits < 18) {
+        return BB_NOEDGE;
+    }
+    if (bits > 21) {
+        return BB_INVALID;
+    }
+    const int nlen = 21 - bits;
+    if (nlen > 0) {
+        value <<= nlen;
+        value |= 1 << (nlen - 1);
+    }
+    return decode_bb_value(value, buffer, count, bit);
+}
+
+// Decodes the frames of all pins in pinMask from the samples of a port.
+// XORing each sample with the one before gives the edges of every pin at once. Bit
+// slicing 32 of those edge words at a time turns them into one word per pin with a
+// bit for each of its edges, so every pin is decoded from its ~20 edges found with
+// ctz instead of from every sample. values[pin] receives what decode_bb() returns.
+FAST_CODE void decode_bb_port(uint16_t buffer[], uint32_t count, uint16_t pinMask, uint32_t values[])
+{
+    uint32_t edges[16][BB_EDGE_WORDS];
+
+    count = MIN(count, (uint32_t)BB_MAX_PORT_SAMPLES);
+    if (count <= MIN_VALID_BBSAMPLES) {
+        for (uint32_t pins = pinMask; pins; pins &= pins - 1) {
+            values[__builtin_ctz(pins)] = BB_NOEDGE;
+        }
+        return;
+    }
+
+    // inverted dshot idles high, so the first low sample of a pin is an edge too
+    uint16_t changed[BB_MAX_PORT_SAMPLES];
+    changed[0] = buffer[0] ^ 0xffff;
+    for (uint32_t i = 1; i < count; i++) {
+        changed[i] = buffer[i] ^ buffer[i - 1];
+    }
+    for (uint32_t i = count; i < ((count + 31) & ~31U); i++) {
+        changed[i] = 0;
+    }
+
+    for (uint32_t first = 0; first < count; first += 32) {
+        uint32_t slice[16];
+        for (int k = 0; k < 16; k++) {
+            slice[k] = changed[first + k] | (uint32_t)changed[first + 16 + k] << 16;
+        }
+        bbTranspose(slice);
+        for (int pin = 0; pin < 16; pin++) {
+            edges[pin][first / 32] = slice[pin];
+        }
+    }
+
+    for (uint32_t pins = pinMask; pins; ) {
+        const int pin = 31 - __builtin_clz(pins);
+        pins &= ~(1 << pin);
+        values[pin] = decode_bb_edges(edges[pin], buffer, count, pin);
+    }
+}
+
 #endif
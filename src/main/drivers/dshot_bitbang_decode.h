@@ -23,7 +23,13 @@
 #define BB_NOEDGE 0xfffe
 #define BB_INVALID 0xffff
 
+// Samples decode_bb_port() looks at, a multiple of 32 no smaller than the port input buffer
+#define BB_MAX_PORT_SAMPLES 160
+
 uint32_t decode_bb(uint16_t buffer[], uint32_t count, uint32_t mask);
+#ifdef STM32F4
 uint32_t decode_bb_bitband( uint16_t buffer[], uint32_t count, uint32_t bit);
+#endif
+void decode_bb_port(uint16_t buffer[], uint32_t count, uint16_t pinMask, uint32_t values[]);
 
 #endif
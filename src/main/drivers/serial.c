@@ -20,9 +20,12 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
+#include "common/maths.h"
+
 #include "serial.h"
 
 void serialPrint(serialPort_t *instance, const char *str)
@@ -74,6 +77,28 @@ uint8_t serialRead(serialPort_t *instance)
     return instance->vTable->serialRead(instance);
 }
 
+uint32_t serialReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+    if (instance->vTable->readBuf) {
+        return instance->vTable->readBuf(instance, data, count);
+    }
+
+    count = MIN(count, serialRxBytesWaiting(instance));
+    for (uint32_t i = 0; i < count; i++) {
+        data[i] = serialRead(instance);
+    }
+    return count;
+}
+
+// Returns 0 from drivers that can't give received bytes without taking them
+uint32_t serialPeekBuf(const serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+    if (instance->vTable->peekBuf) {
+        return instance->vTable->peekBuf(instance, data, count);
+    }
+    return 0;
+}
+
 void serialSetBaudRate(serialPort_t *instance, uint32_t baudRate)
 {
     instance->vTable->serialSetBaudRate(instance, baudRate);
@@ -123,3 +148,45 @@ void serialEndWrite(serialPort_t *instance)
     if (instance->vTable->endWrite)
         instance->vTable->endWrite(instance);
 }
+
+uint32_t serialRxBufferPeek(const serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+    // the head is moved on by the receive interrupt, so read it once
+    const uint32_t head = instance->rxBufferHead;
+    const uint32_t tail = instance->rxBufferTail;
+    const uint32_t waiting = head >= tail ? head - tail : instance->rxBufferSize + head - tail;
+
+    count = MIN(count, waiting);
+    const uint32_t toEnd = MIN(count, instance->rxBufferSize - tail);
+    memcpy(data, (const uint8_t *)&instance->rxBuffer[tail], toEnd);
+    memcpy(data + toEnd, (const uint8_t *)instance->rxBuffer, count - toEnd);
+
+    return count;
+}
+
+uint32_t serialRxBufferRead(serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+    count = serialRxBufferPeek(instance, data, count);
+    instance->rxBufferTail = (instance->rxBufferTail + count) % instance->rxBufferSize;
+
+    return count;
+}
+
+// Called by the driver once the line goes idle. Passes the bytes received since the last call to rxFrameCallback,
+// in two slices where they wrap around the end of the buffer.
+void serialRxBufferFrameComplete(serialPort_t *instance)
+{
+    const uint32_t head = instance->rxBufferHead;
+    const uint32_t tail = instance->rxBufferTail;
+
+    if (head < tail) {
+        instance->rxFrameCallback((const uint8_t *)&instance->rxBuffer[tail], instance->rxBufferSize - tail, instance->rxCallbackData);
+        if (head > 0) {
+            instance->rxFrameCallback((const uint8_t *)instance->rxBuffer, head, instance->rxCallbackData);
+        }
+    } else if (head > tail) {
+        instance->rxFrameCallback((const uint8_t *)&instance->rxBuffer[tail], head - tail, instance->rxCallbackData);
+    }
+
+    instance->rxBufferTail = head;
+}
@@ -59,6 +59,7 @@ typedef enum {
 #define CTRL_LINE_STATE_RTS (1 << 1)
 
 typedef void (*serialReceiveCallbackPtr)(uint16_t data, void *rxCallbackData);   // used by serial drivers to return frames to app
+typedef void (*serialReceiveFrameCallbackPtr)(const uint8_t *data, int count, void *rxCallbackData); // used by serial drivers to return the bytes received up to an idle line
 typedef void (*serialIdleCallbackPtr)();
 
 typedef struct serialPort_s {
@@ -82,6 +83,9 @@ typedef struct serialPort_s {
     serialReceiveCallbackPtr rxCallback;
     void *rxCallbackData;
 
+    // Set instead of rxCallback to have received bytes buffered and passed on together once the line goes idle
+    serialReceiveFrameCallbackPtr rxFrameCallback;
+
     serialIdleCallbackPtr idleCallback;
 
     uint8_t identifier;
@@ -112,6 +116,9 @@ struct serialPortVTable {
     uint32_t (*serialTotalTxFree)(const serialPort_t *instance);
 
     uint8_t (*serialRead)(serialPort_t *instance);
+    // Optional functions used to read received bytes in bulk, and to look at them without taking them.
+    uint32_t (*readBuf)(serialPort_t *instance, uint8_t *data, uint32_t count);
+    uint32_t (*peekBuf)(const serialPort_t *instance, uint8_t *data, uint32_t count);
 
     // Specified baud rate may not be allowed by an implementation, use serialGetBaudRate to determine actual baud rate in use.
     void (*serialSetBaudRate)(serialPort_t *instance, uint32_t baudRate);
@@ -133,6 +140,8 @@ uint32_t serialRxBytesWaiting(const serialPort_t *instance);
 uint32_t serialTxBytesFree(const serialPort_t *instance);
 void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count);
 uint8_t serialRead(serialPort_t *instance);
+uint32_t serialReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count);
+uint32_t serialPeekBuf(const serialPort_t *instance, uint8_t *data, uint32_t count);
 void serialSetBaudRate(serialPort_t *instance, uint32_t baudRate);
 void serialSetMode(serialPort_t *instance, portMode_e mode);
 void serialSetCtrlLineStateCb(serialPort_t *instance, void (*cb)(void *context, uint16_t ctrlLineState), void *context);
@@ -145,3 +154,8 @@ uint32_t serialGetBaudRate(serialPort_t *instance);
 void serialWriteBufShim(void *instance, const uint8_t *data, int count);
 void serialBeginWrite(serialPort_t *instance);
 void serialEndWrite(serialPort_t *instance);
+
+// For drivers that receive into rxBuffer between rxBufferTail and rxBufferHead
+uint32_t serialRxBufferPeek(const serialPort_t *instance, uint8_t *data, uint32_t count);
+uint32_t serialRxBufferRead(serialPort_t *instance, uint8_t *data, uint32_t count);
+void serialRxBufferFrameComplete(serialPort_t *instance);
@@ -859,6 +859,8 @@ const struct serialPortVTable escSerialVTable[] = {
         .serialTotalRxWaiting = escSerialTotalBytesWaiting,
         .serialTotalTxFree = escSerialTxBytesFree,
         .serialRead = escSerialReadByte,
+        .readBuf = NULL,
+        .peekBuf = NULL,
         .serialSetBaudRate = escSerialSetBaudRate,
         .isSerialTransmitBufferEmpty = isEscSerialTransmitBufferEmpty,
         .setMode = escSerialSetMode,
@@ -298,6 +298,7 @@ serialPort_t *openSoftSerial(softSerialPortIndex_e portIndex, serialReceiveCallb
     softSerial->port.options = options;
     softSerial->port.rxCallback = rxCallback;
     softSerial->port.rxCallbackData = rxCallbackData;
+    softSerial->port.rxFrameCallback = NULL;
 
     resetBuffers(softSerial);
 
@@ -455,6 +456,10 @@ void extractAndStoreRxByte(softSerial_t *softSerial)
     } else {
         softSerial->port.rxBuffer[softSerial->port.rxBufferHead] = rxByte;
         softSerial->port.rxBufferHead = (softSerial->port.rxBufferHead + 1) % softSerial->port.rxBufferSize;
+        if (softSerial->port.rxFrameCallback) {
+            // there is no idle line detection, so pass each byte on as it arrives
+            serialRxBufferFrameComplete(&softSerial->port);
+        }
     }
 }
 
@@ -635,6 +640,8 @@ static const struct serialPortVTable softSerialVTable = {
     .serialTotalRxWaiting = softSerialRxBytesWaiting,
     .serialTotalTxFree = softSerialTxBytesFree,
     .serialRead = softSerialReadByte,
+    .readBuf = serialRxBufferRead,
+    .peekBuf = serialRxBufferPeek,
     .serialSetBaudRate = softSerialSetBaudRate,
     .isSerialTransmitBufferEmpty = isSoftSerialTransmitBufferEmpty,
     .setMode = softSerialSetMode,
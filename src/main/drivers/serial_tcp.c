@@ -106,6 +106,16 @@ static tcpPort_t* tcpReconfigure(tcpPort_t *s, int id)
     dyad_setNoDelay(s->serv, 1);
     dyad_addListener(s->serv, DYAD_EVENT_ACCEPT, onAccept, s);
 
+    // SITL_UART<n>_FILE=<filename> saves the output of UARTn, a serial blackbox log for example
+    char captureEnv[32];
+    snprintf(captureEnv, sizeof(captureEnv), "SITL_UART%d_FILE", id + 1);
+    const char *captureFilename = getenv(captureEnv);
+    s->captureFile = NULL;
+    if (captureFilename) {
+        s->captureFile = fopen(captureFilename, "wb");
+        fprintf(stderr, "UART%u output to '%s'%s\n", (unsigned)id + 1, captureFilename, s->captureFile ? "" : " failed!!");
+    }
+
     if (dyad_listenEx(s->serv, NULL, BASE_PORT + id + 1, 10) == 0) {
         fprintf(stderr, "bind port %u for UART%u\n", (unsigned)BASE_PORT + id + 1, (unsigned)id + 1);
     } else {
@@ -139,6 +149,7 @@ serialPort_t *serTcpOpen(int id, serialReceiveCallbackPtr rxCallback, void *rxCa
     // callback works for IRQ-based RX ONLY
     s->port.rxCallback = rxCallback;
     s->port.rxCallbackData = rxCallbackData;
+    s->port.rxFrameCallback = NULL;
     s->port.mode = mode;
     s->port.baudRate = baudRate;
     s->port.options = options;
@@ -204,6 +215,26 @@ uint8_t tcpRead(serialPort_t *instance)
     return ch;
 }
 
+uint32_t tcpReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+    tcpPort_t *s = (tcpPort_t *)instance;
+    pthread_mutex_lock(&s->rxLock);
+    count = serialRxBufferRead(instance, data, count);
+    pthread_mutex_unlock(&s->rxLock);
+
+    return count;
+}
+
+uint32_t tcpPeekBuf(const serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+    tcpPort_t *s = (tcpPort_t *)instance;
+    pthread_mutex_lock(&s->rxLock);
+    count = serialRxBufferPeek(instance, data, count);
+    pthread_mutex_unlock(&s->rxLock);
+
+    return count;
+}
+
 void tcpWrite(serialPort_t *instance, uint8_t ch)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
@@ -220,21 +251,30 @@ void tcpWrite(serialPort_t *instance, uint8_t ch)
     tcpDataOut(s);
 }
 
+static void tcpPortWrite(tcpPort_t *s, const void *data, int size)
+{
+    if (s->captureFile) {
+        fwrite(data, 1, size, s->captureFile);
+    } else {
+        dyad_write(s->conn, data, size);
+    }
+}
+
 void tcpDataOut(tcpPort_t *instance)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
-    if (s->conn == NULL) return;
+    if (s->conn == NULL && s->captureFile == NULL) return;
     pthread_mutex_lock(&s->txLock);
 
     if (s->port.txBufferHead < s->port.txBufferTail) {
         // send data till end of buffer
         int chunk = s->port.txBufferSize - s->port.txBufferTail;
-        dyad_write(s->conn, (const void *)&s->port.txBuffer[s->port.txBufferTail], chunk);
+        tcpPortWrite(s, (const void *)&s->port.txBuffer[s->port.txBufferTail], chunk);
         s->port.txBufferTail = 0;
     }
     int chunk = s->port.txBufferHead - s->port.txBufferTail;
     if (chunk)
-        dyad_write(s->conn, (const void*)&s->port.txBuffer[s->port.txBufferTail], chunk);
+        tcpPortWrite(s, (const void*)&s->port.txBuffer[s->port.txBufferTail], chunk);
     s->port.txBufferTail = s->port.txBufferHead;
 
     pthread_mutex_unlock(&s->txLock);
@@ -243,6 +283,13 @@ void tcpDataOut(tcpPort_t *instance)
 void tcpDataIn(tcpPort_t *instance, uint8_t* ch, int size)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
+
+    if (s->port.rxFrameCallback) {
+        // each read from the socket stands in for the bytes up to an idle line
+        s->port.rxFrameCallback(ch, size, s->port.rxCallbackData);
+        return;
+    }
+
     pthread_mutex_lock(&s->rxLock);
 
     while (size--) {
@@ -263,6 +310,8 @@ static const struct serialPortVTable tcpVTable = {
         .serialTotalRxWaiting = tcpTotalRxBytesWaiting,
         .serialTotalTxFree = tcpTotalTxBytesFree,
         .serialRead = tcpRead,
+        .readBuf = tcpReadBuf,
+        .peekBuf = tcpPeekBuf,
         .serialSetBaudRate = NULL,
         .isSerialTransmitBufferEmpty = isTcpTransmitBufferEmpty,
         .setMode = NULL,
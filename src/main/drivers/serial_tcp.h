@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <stdio.h>
+
 #include <netinet/in.h>
 #include <pthread.h>
 #include "dyad.h"
@@ -39,6 +41,7 @@ typedef struct {
     bool connected;
     uint16_t clientCount;
     uint8_t id;
+    FILE *captureFile;  // receives everything written to the port instead of the TCP client
 } tcpPort_t;
 
 serialPort_t *serTcpOpen(int id, serialReceiveCallbackPtr rxCallback, void *rxCallbackData, uint32_t baudRate, portMode_e mode, portOptions_e options);
@@ -27,6 +27,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -34,6 +35,7 @@
 
 #include "build/build_config.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/dma.h"
@@ -120,6 +122,7 @@ serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr rxCallback,
     // callback works for IRQ-based RX ONLY
     s->port.rxCallback = rxCallback;
     s->port.rxCallbackData = rxCallbackData;
+    s->port.rxFrameCallback = NULL;
     s->port.mode = mode;
     s->port.baudRate = baudRate;
     s->port.options = options;
@@ -251,6 +254,50 @@ static uint8_t uartRead(serialPort_t *instance)
     return ch;
 }
 
+#ifdef USE_DMA
+// rxDMAPos counts down from the end of the buffer as bytes are read, as the DMA counter does as they arrive
+static uint32_t uartRxDmaPeek(const uartPort_t *s, uint8_t *data, uint32_t count)
+{
+    count = MIN(count, uartTotalRxBytesWaiting(&s->port));
+    const uint32_t tail = s->port.rxBufferSize - s->rxDMAPos;
+    const uint32_t toEnd = MIN(count, s->rxDMAPos);
+    memcpy(data, (const uint8_t *)&s->port.rxBuffer[tail], toEnd);
+    memcpy(data + toEnd, (const uint8_t *)s->port.rxBuffer, count - toEnd);
+
+    return count;
+}
+#endif
+
+static uint32_t uartPeekBuf(const serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+#ifdef USE_DMA
+    const uartPort_t *s = (const uartPort_t *)instance;
+
+    if (s->rxDMAResource) {
+        return uartRxDmaPeek(s, data, count);
+    }
+#endif
+    return serialRxBufferPeek(instance, data, count);
+}
+
+static uint32_t uartReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+#ifdef USE_DMA
+    uartPort_t *s = (uartPort_t *)instance;
+
+    if (s->rxDMAResource) {
+        count = uartRxDmaPeek(s, data, count);
+        s->rxDMAPos -= count;
+        if (s->rxDMAPos == 0 || s->rxDMAPos > s->port.rxBufferSize) {
+            // wrapped
+            s->rxDMAPos += s->port.rxBufferSize;
+        }
+        return count;
+    }
+#endif
+    return serialRxBufferRead(instance, data, count);
+}
+
 static void uartWrite(serialPort_t *instance, uint8_t ch)
 {
     uartPort_t *s = (uartPort_t *)instance;
@@ -283,6 +330,8 @@ const struct serialPortVTable uartVTable[] = {
         .serialTotalRxWaiting = uartTotalRxBytesWaiting,
         .serialTotalTxFree = uartTotalTxBytesFree,
         .serialRead = uartRead,
+        .readBuf = uartReadBuf,
+        .peekBuf = uartPeekBuf,
         .serialSetBaudRate = uartSetBaudRate,
         .isSerialTransmitBufferEmpty = isUartTransmitBufferEmpty,
         .setMode = uartSetMode,
@@ -350,6 +350,9 @@ void uartIrqHandler(uartPort_t *s)
     // UART reception idle detected
 
     if (__HAL_UART_GET_IT(huart, UART_IT_IDLE)) {
+        if (s->port.rxFrameCallback) {
+            serialRxBufferFrameComplete(&s->port);
+        }
         if (s->port.idleCallback) {
             s->port.idleCallback();
         }
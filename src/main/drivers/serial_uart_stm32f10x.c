@@ -215,6 +215,9 @@ void uartIrqHandler(uartPort_t *s)
         }
     }
     if (SR & USART_FLAG_IDLE) {
+        if (s->port.rxFrameCallback) {
+            serialRxBufferFrameComplete(&s->port);
+        }
         if (s->port.idleCallback) {
             s->port.idleCallback();
         }
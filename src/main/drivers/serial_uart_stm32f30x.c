@@ -310,6 +310,9 @@ void uartIrqHandler(uartPort_t *s)
     }
 
     if (ISR & USART_FLAG_IDLE) {
+        if (s->port.rxFrameCallback) {
+            serialRxBufferFrameComplete(&s->port);
+        }
         if (s->port.idleCallback) {
             s->port.idleCallback();
         }
@@ -334,6 +334,9 @@ void uartIrqHandler(uartPort_t *s)
     }
 
     if (USART_GetITStatus(s->USARTx, USART_IT_IDLE) == SET) {
+        if (s->port.rxFrameCallback) {
+            serialRxBufferFrameComplete(&s->port);
+        }
         if (s->port.idleCallback) {
             s->port.idleCallback();
         }
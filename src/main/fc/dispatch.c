@@ -24,13 +24,33 @@
 
 #include "platform.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/time.h"
 
 #include "fc/dispatch.h"
 
-static dispatchEntry_t *head = NULL;
+// Entries are kept in a hierarchical timer wheel. Time is counted in ticks of
+// 1 << DISPATCH_TICK_SHIFT us, and each level of the wheel resolves the next
+// DISPATCH_SLOT_BITS bits of the tick an entry is due on. Entries due within
+// DISPATCH_SLOT_COUNT ticks sit in level 0 and are dispatched when their slot comes
+// round; the others are cascaded down a level each time the level below wraps.
+// Adding and cancelling are O(1), and entries due on the same tick are dispatched
+// in no particular order.
+#define DISPATCH_TICK_SHIFT     8       // 256us
+#define DISPATCH_TICK_BITS      (32 - DISPATCH_TICK_SHIFT)
+#define DISPATCH_TICK_MASK      ((1U << DISPATCH_TICK_BITS) - 1)
+#define DISPATCH_SLOT_BITS      6
+#define DISPATCH_SLOT_COUNT     (1 << DISPATCH_SLOT_BITS)
+#define DISPATCH_SLOT_MASK      (DISPATCH_SLOT_COUNT - 1)
+#define DISPATCH_LEVEL_COUNT    (DISPATCH_TICK_BITS / DISPATCH_SLOT_BITS)
+
+STATIC_ASSERT(DISPATCH_LEVEL_COUNT * DISPATCH_SLOT_BITS == DISPATCH_TICK_BITS, dispatch_wheel_must_cover_all_ticks);
+
+static dispatchEntry_t *dispatchWheel[DISPATCH_LEVEL_COUNT][DISPATCH_SLOT_COUNT];
+static uint32_t dispatchNextTick;       // first tick not yet processed
+static unsigned dispatchQueued;
 static bool dispatchEnabled = false;
 
 bool dispatchIsEnabled(void)
@@ -43,33 +63,168 @@ void dispatchEnable(void)
     dispatchEnabled = true;
 }
 
-void dispatchProcess(uint32_t currentTime)
+// signed distance between two ticks, which wrap at DISPATCH_TICK_BITS
+static int32_t dispatchTickDelta(uint32_t a, uint32_t b)
+{
+    return (int32_t)((a - b) << DISPATCH_TICK_SHIFT) >> DISPATCH_TICK_SHIFT;
+}
+
+static void dispatchLink(dispatchEntry_t *entry)
+{
+    // round up, an entry must never be dispatched before delayedUntil
+    uint32_t dueTick = ((entry->delayedUntil + (1U << DISPATCH_TICK_SHIFT) - 1) >> DISPATCH_TICK_SHIFT) & DISPATCH_TICK_MASK;
+    const int32_t delta = dispatchTickDelta(dueTick, dispatchNextTick);
+    int level = 0;
+
+    if (delta <= 0) {
+        dueTick = dispatchNextTick;
+    } else {
+        while (level < DISPATCH_LEVEL_COUNT - 1 && delta >= (1 << (DISPATCH_SLOT_BITS * (level + 1)))) {
+            level++;
+        }
+    }
+
+    dispatchEntry_t **slot = &dispatchWheel[level][(dueTick >> (DISPATCH_SLOT_BITS * level)) & DISPATCH_SLOT_MASK];
+    entry->next = *slot;
+    if (entry->next) {
+        entry->next->pprev = &entry->next;
+    }
+    entry->pprev = slot;
+    *slot = entry;
+}
+
+static void dispatchUnlink(dispatchEntry_t *entry)
 {
-    for (dispatchEntry_t **p = &head; *p; ) {
-        if (cmp32(currentTime, (*p)->delayedUntil) < 0)
+    *entry->pprev = entry->next;
+    if (entry->next) {
+        entry->next->pprev = entry->pprev;
+    }
+    entry->next = NULL;
+    entry->pprev = NULL;
+}
+
+static void dispatchQueue(dispatchEntry_t *entry, uint32_t delayedUntil, uint32_t currentTime)
+{
+    if (!dispatchQueued) {
+        // nothing to catch up on, so the wheel can jump straight to the present
+        dispatchNextTick = ((currentTime >> DISPATCH_TICK_SHIFT) + 1) & DISPATCH_TICK_MASK;
+    }
+
+    entry->delayedUntil = delayedUntil;
+    entry->inQue = true;
+    dispatchLink(entry);
+    dispatchQueued++;
+}
+
+// Moves a slot onto a list of its own, so that its entries can be unlinked one
+// at a time while handlers add or cancel others.
+static void dispatchTakeSlot(dispatchEntry_t **slot, dispatchEntry_t **list)
+{
+    *list = *slot;
+    *slot = NULL;
+    if (*list) {
+        (*list)->pprev = list;
+    }
+}
+
+static void dispatchCascade(uint32_t tick)
+{
+    for (int level = 1; level < DISPATCH_LEVEL_COUNT; level++) {
+        const uint32_t index = (tick >> (DISPATCH_SLOT_BITS * level)) & DISPATCH_SLOT_MASK;
+
+        // everything in this slot is now due within the span of the levels below
+        dispatchEntry_t *list;
+        dispatchTakeSlot(&dispatchWheel[level][index], &list);
+        while (list) {
+            dispatchEntry_t *entry = list;
+            dispatchUnlink(entry);
+            dispatchLink(entry);
+        }
+
+        if (index) {
             break;
-        // unlink entry first, so handler can replan self
-        dispatchEntry_t *current = *p;
-        *p = (*p)->next;
-        current->inQue = false;
-        (*current->dispatch)(current);
+        }
     }
 }
 
-void dispatchAdd(dispatchEntry_t *entry, int delayUs)
+static void dispatchRun(dispatchEntry_t *entry, uint32_t currentTime)
 {
-    uint32_t delayedUntil = micros() + delayUs;
-    dispatchEntry_t **p = &head;
+    entry->lastLatenessUs = currentTime - entry->delayedUntil;
+    entry->maxLatenessUs = MAX(entry->maxLatenessUs, entry->lastLatenessUs);
+    entry->dispatchCount++;
 
+    (*entry->dispatch)(entry);
+
+    // the handler may have replanned or cancelled itself
+    if (entry->periodUs && !entry->inQue) {
+        uint32_t delayedUntil = entry->delayedUntil + entry->periodUs;
+        if (cmp32(currentTime, delayedUntil) >= 0) {
+            // skip the periods that were missed entirely, keeping the phase
+            delayedUntil += ((currentTime - delayedUntil) / entry->periodUs + 1) * entry->periodUs;
+        }
+        dispatchQueue(entry, delayedUntil, currentTime);
+    }
+}
+
+void dispatchProcess(uint32_t currentTime)
+{
+    const uint32_t currentTick = (currentTime >> DISPATCH_TICK_SHIFT) & DISPATCH_TICK_MASK;
+
+    while (dispatchQueued && dispatchTickDelta(currentTick, dispatchNextTick) >= 0) {
+        const uint32_t tick = dispatchNextTick;
+
+        if (!(tick & DISPATCH_SLOT_MASK)) {
+            dispatchCascade(tick);
+        }
+
+        dispatchEntry_t *list;
+        dispatchTakeSlot(&dispatchWheel[0][tick & DISPATCH_SLOT_MASK], &list);
+        // anything added from here on that is already due goes into the next tick
+        dispatchNextTick = (tick + 1) & DISPATCH_TICK_MASK;
+
+        while (list) {
+            // unlink entry first, so handler can replan self
+            dispatchEntry_t *current = list;
+            dispatchUnlink(current);
+            current->inQue = false;
+            dispatchQueued--;
+            dispatchRun(current, currentTime);
+        }
+    }
+
+    if (!dispatchQueued) {
+        dispatchNextTick = (currentTick + 1) & DISPATCH_TICK_MASK;
+    }
+}
+
+void dispatchAdd(dispatchEntry_t *entry, int delayUs)
+{
     if (entry->inQue) {
       return;    // Allready in Queue, abort
     }
 
-    while (*p && cmp32((*p)->delayedUntil, delayedUntil) < 0)
-        p = &(*p)->next;
+    const uint32_t currentTime = micros();
+    dispatchQueue(entry, currentTime + delayUs, currentTime);
+}
 
-    entry->next = *p;
-    entry->delayedUntil = delayedUntil;
-    entry->inQue = true;
-    *p = entry;
+void dispatchAddPeriodic(dispatchEntry_t *entry, int delayUs, uint32_t periodUs)
+{
+    if (entry->inQue) {
+        return;
+    }
+
+    entry->periodUs = periodUs;
+    dispatchAdd(entry, delayUs);
+}
+
+void dispatchCancel(dispatchEntry_t *entry)
+{
+    // also stops a periodic entry that cancels itself from its handler
+    entry->periodUs = 0;
+
+    if (entry->inQue) {
+        dispatchUnlink(entry);
+        entry->inQue = false;
+        dispatchQueued--;
+    }
 }
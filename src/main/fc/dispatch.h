@@ -28,9 +28,16 @@ typedef struct dispatchEntry_s {
     uint32_t delayedUntil;
     struct dispatchEntry_s *next;
     bool inQue;
+    struct dispatchEntry_s **pprev;     // link pointing at this entry, for O(1) cancel
+    uint32_t periodUs;                  // re-armed this long after each due time, 0 for one-shot entries
+    uint32_t dispatchCount;
+    uint32_t lastLatenessUs;            // how long after delayedUntil the entry was dispatched
+    uint32_t maxLatenessUs;
 } dispatchEntry_t;
 
 bool dispatchIsEnabled(void);
 void dispatchEnable(void);
 void dispatchProcess(uint32_t currentTime);
 void dispatchAdd(dispatchEntry_t *entry, int delayUs);
+void dispatchAddPeriodic(dispatchEntry_t *entry, int delayUs, uint32_t periodUs);
+void dispatchCancel(dispatchEntry_t *entry);
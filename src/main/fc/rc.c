@@ -24,6 +24,7 @@
 
 #include "platform.h"
 
+#include "build/build_config.h"
 #include "build/debug.h"
 
 #include "common/axis.h"
@@ -235,9 +236,142 @@ float applyCurve(int axis, float deflection)
     return applyRates(axis, deflection, fabsf(deflection));
 }
 
+// All rates curves are odd in the deflection, so each axis is tabulated over
+// |deflection| in [0, 1] as cubic Hermite segments (value and slope at every knot).
+// Segments the cubic can't follow within tolerance, typically those holding a kink
+// from one of the constrainf() limits in the curves, fall back to the exact curve.
+#define RC_RATES_TABLE_SEGMENTS         32
+#define RC_RATES_TABLE_CHECKS           4       // interior points validated per segment
+#define RC_RATES_TABLE_TOLERANCE        0.25f   // deg/s
+#define RC_RATES_TABLE_SLOPE_TOLERANCE  0.01f   // relative, with a floor of RC_RATES_TABLE_SLOPE_MIN
+#define RC_RATES_TABLE_SLOPE_MIN        5.0f    // deg/s per full deflection
+#define RC_RATES_TABLE_SLOPE_STEP       (1.0f / 1024)
+
+STATIC_ASSERT(RC_RATES_TABLE_SEGMENTS <= 32, RC_RATES_TABLE_SEGMENTS_too_large);
+
+typedef struct rcRatesTable_s {
+    float value[RC_RATES_TABLE_SEGMENTS + 1];
+    float slope[RC_RATES_TABLE_SEGMENTS + 1];   // per segment width
+    uint32_t exactSegments;                     // bit n set: segment n uses the exact curve
+} rcRatesTable_t;
+
+static FAST_DATA_ZERO_INIT rcRatesTable_t rcRatesTable[XYZ_AXIS_COUNT];
+
+static float applyCurveSlope(int axis, float deflection)
+{
+    return (applyCurve(axis, deflection + RC_RATES_TABLE_SLOPE_STEP) - applyCurve(axis, deflection - RC_RATES_TABLE_SLOPE_STEP)) / (2.0f * RC_RATES_TABLE_SLOPE_STEP);
+}
+
+static FAST_CODE float rcRatesTableSegment(const rcRatesTable_t *table, int segment, float t, float *slope)
+{
+    const float y0 = table->value[segment];
+    const float m0 = table->slope[segment];
+    const float m1 = table->slope[segment + 1];
+    const float dy = table->value[segment + 1] - y0;
+    const float c2 = 3.0f * dy - 2.0f * m0 - m1;
+    const float c3 = m0 + m1 - 2.0f * dy;
+
+    if (slope) {
+        *slope = (m0 + t * (2.0f * c2 + 3.0f * t * c3)) * RC_RATES_TABLE_SEGMENTS;
+    }
+    return y0 + t * (m0 + t * (c2 + t * c3));
+}
+
+static void rcRatesTableBuild(int axis)
+{
+    rcRatesTable_t *table = &rcRatesTable[axis];
+    const float width = 1.0f / RC_RATES_TABLE_SEGMENTS;
+
+    for (int i = 0; i <= RC_RATES_TABLE_SEGMENTS; i++) {
+        const float deflection = i * width;
+        table->value[i] = applyCurve(axis, deflection);
+        if (i < RC_RATES_TABLE_SEGMENTS) {
+            table->slope[i] = applyCurveSlope(axis, deflection) * width;
+        } else {
+            // one-sided at full deflection, the curves aren't defined past it
+            table->slope[i] = (table->value[i] - applyCurve(axis, deflection - RC_RATES_TABLE_SLOPE_STEP)) / RC_RATES_TABLE_SLOPE_STEP * width;
+        }
+    }
+
+    // Fritsch-Carlson: limit the knot slopes so that every segment stays monotone
+    for (int i = 0; i < RC_RATES_TABLE_SEGMENTS; i++) {
+        const float dy = table->value[i + 1] - table->value[i];
+        if (dy <= 0.0f) {
+            table->slope[i] = 0.0f;
+            table->slope[i + 1] = 0.0f;
+            continue;
+        }
+        const float a = MAX(table->slope[i] / dy, 0.0f);
+        const float b = MAX(table->slope[i + 1] / dy, 0.0f);
+        const float magnitude = a * a + b * b;
+        const float scale = magnitude > 9.0f ? 3.0f / sqrtf(magnitude) : 1.0f;
+        table->slope[i] = scale * a * dy;
+        table->slope[i + 1] = scale * b * dy;
+    }
+
+    table->exactSegments = 0;
+    for (int i = 0; i < RC_RATES_TABLE_SEGMENTS; i++) {
+        for (int j = 0; j < RC_RATES_TABLE_CHECKS; j++) {
+            const float t = (j + 0.5f) / RC_RATES_TABLE_CHECKS;
+            const float deflection = (i + t) * width;
+            float slope;
+            const float value = rcRatesTableSegment(table, i, t, &slope);
+            const float exactSlope = applyCurveSlope(axis, deflection);
+            if (fabsf(value - applyCurve(axis, deflection)) > RC_RATES_TABLE_TOLERANCE
+                || fabsf(slope - exactSlope) > MAX(fabsf(exactSlope) * RC_RATES_TABLE_SLOPE_TOLERANCE, RC_RATES_TABLE_SLOPE_MIN)) {
+                table->exactSegments |= 1U << i;
+                break;
+            }
+        }
+    }
+}
+
+// Looks up the curve for |deflection| <= 1, returns false if the exact curve has to be used
+static FAST_CODE bool rcRatesTableLookup(int axis, float rcCommandfAbs, float *value, float *slope)
+{
+    const rcRatesTable_t *table = &rcRatesTable[axis];
+    const float position = rcCommandfAbs * RC_RATES_TABLE_SEGMENTS;
+    const int segment = MIN((int)position, RC_RATES_TABLE_SEGMENTS - 1);
+
+    if (rcCommandfAbs > 1.0f || (table->exactSegments & (1U << segment))) {
+        return false;
+    }
+    *value = rcRatesTableSegment(table, segment, position - segment, slope);
+    return true;
+}
+
+// Re-tabulates the curves of the current rate profile, needed after any change to its rates
+void rcRatesTableUpdate(void)
+{
+    for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+        rcRatesTableBuild(axis);
+    }
+}
+
+#ifdef UNIT_TEST
+uint32_t rcRatesTableExactSegments(int axis)
+{
+    return rcRatesTable[axis].exactSegments;
+}
+#endif
+
+STATIC_UNIT_TESTED FAST_CODE float applyRatesTable(const int axis, float rcCommandf, const float rcCommandfAbs)
+{
+    float angleRate;
+    if (!rcRatesTableLookup(axis, rcCommandfAbs, &angleRate, NULL)) {
+        return applyRates(axis, rcCommandf, rcCommandfAbs);
+    }
+    return rcCommandf < 0.0f ? -angleRate : angleRate;
+}
+
 float getRcCurveSlope(int axis, float deflection)
 {
-    return (applyCurve(axis, deflection + 0.01f) - applyCurve(axis, deflection)) * 100.0f;
+    float value;
+    float slope;
+    if (!rcRatesTableLookup(axis, fabsf(deflection), &value, &slope)) {
+        return applyCurveSlope(axis, deflection);
+    }
+    return slope;
 }
 
 static void calculateSetpointRate(int axis)
@@ -268,7 +402,7 @@ static void calculateSetpointRate(int axis)
         const float rcCommandfAbs = fabsf(rcCommandf);
         rcDeflectionAbs[axis] = rcCommandfAbs;
 
-        angleRate = applyRates(axis, rcCommandf, rcCommandfAbs);
+        angleRate = applyRatesTable(axis, rcCommandf, rcCommandfAbs);
     }
     // Rate limit from profile (deg/sec)
     setpointRate[axis] = constrainf(angleRate, -1.0f * currentControlRateProfile->rate_limit[axis], 1.0f * currentControlRateProfile->rate_limit[axis]);
@@ -709,7 +843,7 @@ FAST_CODE void processRcCommand(void)
                 rcCommandf = rcCommand[i] / rcCommandDivider;
             }
             const float rcCommandfAbs = fabsf(rcCommandf);
-            rawSetpoint[i] = applyRates(i, rcCommandf, rcCommandfAbs);
+            rawSetpoint[i] = applyRatesTable(i, rcCommandf, rcCommandfAbs);
             rawDeflection[i] = rcCommandf;
         }
     }
@@ -896,6 +1030,8 @@ void initRcProcessing(void)
         break;
     }
 
+    rcRatesTableUpdate();
+
     interpolationChannels = 0;
     switch (rxConfig()->rcInterpolationChannels) {
     case INTERPOLATION_CHANNELS_RPYT:
@@ -45,6 +45,7 @@ float getThrottlePIDAttenuation(void);
 void updateRcCommands(void);
 void resetYawAxis(void);
 void initRcProcessing(void);
+void rcRatesTableUpdate(void);
 bool isMotorsReversed(void);
 bool rcSmoothingIsEnabled(void);
 rcSmoothingFilter_t *getRcSmoothingData(void);
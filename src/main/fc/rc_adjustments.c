@@ -102,6 +102,28 @@ static void blackboxLogInflightAdjustmentEvent(adjustmentFunction_e adjustmentFu
 #endif
 }
 
+// the setpoint comes from a table of the rates curves, which has to follow these
+static void updateRatesTableIfChanged(adjustmentFunction_e adjustmentFunction)
+{
+    switch (adjustmentFunction) {
+    case ADJUSTMENT_RC_RATE:
+    case ADJUSTMENT_RC_EXPO:
+    case ADJUSTMENT_PITCH_ROLL_RATE:
+    case ADJUSTMENT_YAW_RATE:
+    case ADJUSTMENT_PITCH_RATE:
+    case ADJUSTMENT_ROLL_RATE:
+    case ADJUSTMENT_RC_RATE_YAW:
+    case ADJUSTMENT_ROLL_RC_RATE:
+    case ADJUSTMENT_PITCH_RC_RATE:
+    case ADJUSTMENT_ROLL_RC_EXPO:
+    case ADJUSTMENT_PITCH_RC_EXPO:
+        rcRatesTableUpdate();
+        break;
+    default:
+        break;
+    }
+}
+
 // sync with adjustmentFunction_e
 static const adjustmentConfig_t defaultAdjustmentConfigs[ADJUSTMENT_FUNCTION_COUNT - 1] = {
     {
@@ -426,6 +448,8 @@ static int applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t a
         break;
     };
 
+    updateRatesTableIfChanged(adjustmentFunction);
+
     return newValue;
 }
 
@@ -587,6 +611,8 @@ static int applyAbsoluteAdjustment(controlRateConfig_t *controlRateConfig, adjus
         break;
     };
 
+    updateRatesTableIfChanged(adjustmentFunction);
+
     return newValue;
 }
 
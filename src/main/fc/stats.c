@@ -70,9 +70,8 @@ void writeStats(struct dispatchEntry_s* self)
     }
 }
 
-dispatchEntry_t writeStatsEntry =
-{
-    writeStats, 0, NULL, false
+dispatchEntry_t writeStatsEntry = {
+    .dispatch = writeStats,
 };
 
 
@@ -23,6 +23,7 @@
  * coding assistance and advice from DieHertz, Rav, eTracer
  * test pilots icr4sh, UAV Tech, Flint723
  */
+#include <math.h>
 #include <stdint.h>
 
 #include "platform.h"
@@ -81,10 +82,23 @@
 // Each FFT output bin has width fftSamplingRateHz/32, ie 41.65Hz per bin at 1333Hz
 // Usable bandwidth is half this, ie 666Hz if fftSamplingRateHz is 1333Hz, i.e. bin 1 is 41.65hz, bin 2 83.3hz etc
 
+// With dyn_notch_count > 1 the largest dyn_notch_count peaks of each axis drive one notch each.
+// The peaks are assigned to the notches in order of frequency, and dyn_notch_width_percent is ignored.
+
+// With dyn_notch_analyser = SDFT a sliding DFT of SDFT_SAMPLE_SIZE (64) points replaces the FFT.
+// Every downsampled sample is pushed into the SDFT of each axis, the bins being split in batches
+// over the maxSampleCount gyro loops until the next downsampled sample, so the cost per loop is constant.
+// Each gyro loop also runs the peak search for one axis, so at 8k every axis is updated every 0.375ms
+// from a spectrum that is never more than one downsampled sample old.
+// Bins are twice as narrow as with the FFT, 20.8Hz at 1333Hz, and the peak position is interpolated
+// between bins.
+// The longer window makes the SDFT lag a fast sweep a little more than the FFT.
+
 #define DYN_NOTCH_SMOOTH_HZ       4
 #define FFT_BIN_COUNT             (FFT_WINDOW_SIZE / 2) // 16
 #define DYN_NOTCH_CALC_TICKS      (XYZ_AXIS_COUNT * 4) // 4 steps per axis
 #define DYN_NOTCH_OSD_MIN_THROTTLE 20
+#define DYN_NOTCH_PEAK_MIN_RATIO  0.1f // peaks more than 20dB below the largest are ignored
 
 static uint16_t FAST_DATA_ZERO_INIT   fftSamplingRateHz;
 static float FAST_DATA_ZERO_INIT      fftResolution;
@@ -95,12 +109,19 @@ static float FAST_DATA_ZERO_INIT      dynNotch2Ctr;
 static uint16_t FAST_DATA_ZERO_INIT   dynNotchMinHz;
 static uint16_t FAST_DATA_ZERO_INIT   dynNotchMaxHz;
 static bool FAST_DATA                 dualNotch = true;
+static uint8_t FAST_DATA_ZERO_INIT    dynNotchCount;
 static uint16_t FAST_DATA_ZERO_INIT   dynNotchMaxFFT;
 static float FAST_DATA_ZERO_INIT      smoothFactor;
 static uint8_t FAST_DATA_ZERO_INIT    samples;
 // Hanning window, see https://en.wikipedia.org/wiki/Window_function#Hann_.28Hanning.29_window
 static FAST_DATA_ZERO_INIT float hanningWindow[FFT_WINDOW_SIZE];
 
+static bool FAST_DATA_ZERO_INIT       useSdft;
+static float FAST_DATA_ZERO_INIT      sdftResolution;
+static uint8_t FAST_DATA_ZERO_INIT    sdftStartBin;
+static uint8_t FAST_DATA_ZERO_INIT    sdftEndBin;
+static float FAST_DATA_ZERO_INIT      sdftSmoothFactor;
+
 void gyroDataAnalyseInit(uint32_t targetLooptimeUs)
 {
 #ifdef USE_MULTI_GYRO
@@ -117,7 +138,9 @@ void gyroDataAnalyseInit(uint32_t targetLooptimeUs)
     dynNotchMinHz = gyroConfig()->dyn_notch_min_hz;
     dynNotchMaxHz = MAX(2 * dynNotchMinHz, gyroConfig()->dyn_notch_max_hz);
 
-    if (gyroConfig()->dyn_notch_width_percent == 0) {
+    dynNotchCount = constrain(gyroConfig()->dyn_notch_count, 1, DYN_NOTCH_COUNT_MAX);
+    // the pair of notches either side of the peak is only used when a single peak is tracked
+    if (gyroConfig()->dyn_notch_width_percent == 0 || dynNotchCount > 1) {
         dualNotch = false;
     }
 
@@ -139,6 +162,13 @@ void gyroDataAnalyseInit(uint32_t targetLooptimeUs)
     for (int i = 0; i < FFT_WINDOW_SIZE; i++) {
         hanningWindow[i] = (0.5f - 0.5f * cos_approx(2 * M_PIf * i / (FFT_WINDOW_SIZE - 1)));
     }
+
+    useSdft = gyroConfig()->dyn_notch_analyser == DYN_NOTCH_ANALYSER_SDFT;
+    sdftResolution = (float)fftSamplingRateHz / SDFT_SAMPLE_SIZE;
+    // the peak search looks at one bin either side, the SDFT window one more
+    sdftStartBin = MAX(2, lrintf(dynNotchMinHz / sdftResolution));
+    sdftEndBin = MIN(SDFT_BIN_COUNT - 3, lrintf(dynNotchMaxHz / sdftResolution));
+    sdftSmoothFactor = 2 * M_PIf * DYN_NOTCH_SMOOTH_HZ / (gyroLoopRateHz / XYZ_AXIS_COUNT);
 }
 
 void gyroDataAnalyseStateInit(gyroAnalyseState_t *state, uint32_t targetLooptimeUs)
@@ -151,6 +181,12 @@ void gyroDataAnalyseStateInit(gyroAnalyseState_t *state, uint32_t targetLooptime
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         // any init value
         state->centerFreq[axis] = dynNotchMaxHz;
+        // spread the notches over the range until the peaks are found
+        for (int peak = 0; peak < DYN_NOTCH_COUNT_MAX; peak++) {
+            state->peakFreq[axis][peak] = dynNotchCount > 1 ? dynNotchMinHz + (dynNotchMaxHz - dynNotchMinHz) * (peak + 1) / (dynNotchCount + 1) : dynNotchMaxHz;
+        }
+        // one batch of bins per gyro loop between downsampled samples
+        sdftInit(&state->sdft[axis], sdftStartBin - 1, sdftEndBin + 1, state->maxSampleCount);
     }
 }
 
@@ -159,13 +195,19 @@ void gyroDataAnalysePush(gyroAnalyseState_t *state, const int axis, const float
     state->oversampledGyroAccumulator[axis] += sample;
 }
 
-static void gyroDataAnalyseUpdate(gyroAnalyseState_t *state, biquadFilter_t *notchFilterDyn, biquadFilter_t *notchFilterDyn2);
+static void gyroDataAnalyseUpdate(gyroAnalyseState_t *state, filterBank_t *notchFilterDynBank);
+static void gyroDataAnalyseSdft(gyroAnalyseState_t *state, filterBank_t *notchFilterDynBank);
 
 /*
  * Collect gyro data, to be analysed in gyroDataAnalyseUpdate function
  */
-void gyroDataAnalyse(gyroAnalyseState_t *state, biquadFilter_t *notchFilterDyn, biquadFilter_t *notchFilterDyn2)
+void gyroDataAnalyse(gyroAnalyseState_t *state, filterBank_t *notchFilterDynBank)
 {
+    if (useSdft) {
+        gyroDataAnalyseSdft(state, notchFilterDynBank);
+        return;
+    }
+
     // samples should have been pushed by `gyroDataAnalysePush`
     // if gyro sampling is > 1kHz, accumulate and average multiple gyro samples
     state->sampleCount++;
@@ -195,11 +237,62 @@ void gyroDataAnalyse(gyroAnalyseState_t *state, biquadFilter_t *notchFilterDyn,
 
     // calculate FFT and update filters
     if (state->updateTicks > 0) {
-        gyroDataAnalyseUpdate(state, notchFilterDyn, notchFilterDyn2);
+        gyroDataAnalyseUpdate(state, notchFilterDynBank);
         --state->updateTicks;
     }
 }
 
+// calculate cutoffFreq and notch Q, update notch filter
+static FAST_CODE void gyroDataAnalyseUpdateNotches(gyroAnalyseState_t *state, int axis, filterBank_t *notchFilterDynBank)
+{
+    if (dualNotch) {
+        filterBankUpdateBiquad(notchFilterDynBank, 0, axis, state->centerFreq[axis] * dynNotch1Ctr, gyro.targetLooptime, dynNotchQ, FILTER_NOTCH);
+        filterBankUpdateBiquad(notchFilterDynBank, 1, axis, state->centerFreq[axis] * dynNotch2Ctr, gyro.targetLooptime, dynNotchQ, FILTER_NOTCH);
+    } else {
+        for (int peak = 0; peak < dynNotchCount; peak++) {
+            filterBankUpdateBiquad(notchFilterDynBank, peak, axis, state->peakFreq[axis][peak], gyro.targetLooptime, dynNotchQ, FILTER_NOTCH);
+        }
+    }
+}
+
+// keep the dynNotchCount largest peaks, largest first
+static FAST_CODE void gyroDataAnalyseInsertPeak(float *peakValue, uint8_t *peakBin, float value, int bin)
+{
+    for (int peak = 0; peak < dynNotchCount; peak++) {
+        if (value > peakValue[peak]) {
+            for (int i = dynNotchCount - 1; i > peak; i--) {
+                peakValue[i] = peakValue[i - 1];
+                peakBin[i] = peakBin[i - 1];
+            }
+            peakValue[peak] = value;
+            peakBin[peak] = bin;
+            return;
+        }
+    }
+}
+
+// drop peaks below minValue, such as window sidelobes, and order the rest by frequency so each notch
+// follows the peak in its own part of the spectrum rather than jumping whenever two peaks swap size,
+// returns the number of peaks kept
+static FAST_CODE int gyroDataAnalyseSortPeaks(float *peakValue, uint8_t *peakBin, float minValue)
+{
+    int peakCount = 0;
+    while (peakCount < dynNotchCount && peakBin[peakCount] != 0 && peakValue[peakCount] >= minValue) {
+        peakCount++;
+    }
+    for (int i = 1; i < peakCount; i++) {
+        for (int j = i; j > 0 && peakBin[j - 1] > peakBin[j]; j--) {
+            const uint8_t bin = peakBin[j];
+            peakBin[j] = peakBin[j - 1];
+            peakBin[j - 1] = bin;
+            const float value = peakValue[j];
+            peakValue[j] = peakValue[j - 1];
+            peakValue[j - 1] = value;
+        }
+    }
+    return peakCount;
+}
+
 void stage_rfft_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut);
 void arm_cfft_radix8by2_f32(arm_cfft_instance_f32 *S, float32_t *p1);
 void arm_cfft_radix8by4_f32(arm_cfft_instance_f32 *S, float32_t *p1);
@@ -209,7 +302,7 @@ void arm_bitreversal_32(uint32_t *pSrc, const uint16_t bitRevLen, const uint16_t
 /*
  * Analyse gyro data
  */
-static FAST_CODE_NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state, biquadFilter_t *notchFilterDyn, biquadFilter_t *notchFilterDyn2)
+static FAST_CODE_NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state, filterBank_t *notchFilterDynBank)
 {
     enum {
         STEP_ARM_CFFT_F32,
@@ -278,22 +371,26 @@ static FAST_CODE_NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state,
         }
         case STEP_CALC_FREQUENCIES:
         {
-            // identify max bin and max/min heights
-            float dataMax = 0.0f;
-            float dataMin = 1.0f;
-            uint8_t binMax = 0;
-            float dataMinHi = 1.0f;
+            // identify the tallest bins, ie the bins whose height increased, and their heights
+            float peakValue[DYN_NOTCH_COUNT_MAX] = { 0 };
+            uint8_t peakBin[DYN_NOTCH_COUNT_MAX] = { 0 };
             for (int i = fftStartBin; i < FFT_BIN_COUNT; i++) {
-                if (state->fftData[i] > state->fftData[i - 1]) { // bin height increased
-                    if (state->fftData[i] > dataMax) {
-                        dataMax = state->fftData[i];
-                        binMax = i;  // tallest bin so far
-                    }
+                if (state->fftData[i] > state->fftData[i - 1] && (i == FFT_BIN_COUNT - 1 || state->fftData[i] >= state->fftData[i + 1])) {
+                    gyroDataAnalyseInsertPeak(peakValue, peakBin, state->fftData[i], i);
                 }
             }
-            if (binMax == 0) { // no bin increase, hold prev max bin, dataMin = 1 dataMax = 0, ie move slow
-                binMax = lrintf(state->centerFreq[state->updateAxis] / fftResolution);
-            } else { // there was a max, find min
+            // no bin increase, hold previous frequencies
+            const int peakCount = gyroDataAnalyseSortPeaks(peakValue, peakBin, peakValue[0] * DYN_NOTCH_PEAK_MIN_RATIO);
+
+            float dataMax = 0.0f;
+            float maxDynamicFactor = 1.0f;
+            float maxMeanIndex = 0;
+            for (int peak = 0; peak < peakCount; peak++) {
+                const uint8_t binMax = peakBin[peak];
+
+                // find min either side of max
+                float dataMin = 1.0f;
+                float dataMinHi = 1.0f;
                 for (int i = binMax - 1; i > 1; i--) { // look for min below max
                     dataMin = state->fftData[i];
                     if (state->fftData[i - 1] > state->fftData[i]) { // up step below this one
@@ -306,57 +403,59 @@ static FAST_CODE_NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state,
                         break;
                     }
                 }
-            }
-            dataMin = fminf(dataMin, dataMinHi);
-
-            // accumulate fftSum and fftWeightedSum from peak bin, and shoulder bins either side of peak
-            float squaredData = state->fftData[binMax] * state->fftData[binMax];
-            float fftSum = squaredData;
-            float fftWeightedSum = squaredData * binMax;
-
-            // accumulate upper shoulder unless it would be FFT_BIN_COUNT
-            uint8_t shoulderBin = binMax + 1;
-            if (shoulderBin < FFT_BIN_COUNT) {
-                squaredData = state->fftData[shoulderBin] * state->fftData[shoulderBin];
-                fftSum += squaredData;
-                fftWeightedSum += squaredData * shoulderBin;
-            }
+                dataMin = fminf(dataMin, dataMinHi);
+
+                // accumulate fftSum and fftWeightedSum from peak bin, and shoulder bins either side of peak
+                float squaredData = state->fftData[binMax] * state->fftData[binMax];
+                float fftSum = squaredData;
+                float fftWeightedSum = squaredData * binMax;
+
+                // accumulate upper shoulder unless it would be FFT_BIN_COUNT
+                uint8_t shoulderBin = binMax + 1;
+                if (shoulderBin < FFT_BIN_COUNT) {
+                    squaredData = state->fftData[shoulderBin] * state->fftData[shoulderBin];
+                    fftSum += squaredData;
+                    fftWeightedSum += squaredData * shoulderBin;
+                }
 
-            // accumulate lower shoulder unless lower shoulder would be bin 0 (DC)
-            if (binMax > 1) {
-                shoulderBin = binMax - 1;
-                squaredData = state->fftData[shoulderBin] * state->fftData[shoulderBin];
-                fftSum += squaredData;
-                fftWeightedSum += squaredData * shoulderBin;
-            }
+                // accumulate lower shoulder unless lower shoulder would be bin 0 (DC)
+                if (binMax > 1) {
+                    shoulderBin = binMax - 1;
+                    squaredData = state->fftData[shoulderBin] * state->fftData[shoulderBin];
+                    fftSum += squaredData;
+                    fftWeightedSum += squaredData * shoulderBin;
+                }
 
-            // get centerFreq in Hz from weighted bins
-            float centerFreq = dynNotchMaxHz;
-            float fftMeanIndex = 0;
-            if (fftSum > 0) {
-                fftMeanIndex = (fftWeightedSum / fftSum);
-                centerFreq = fftMeanIndex * fftResolution;
+                // get centerFreq in Hz from weighted bins
                 // In theory, the index points to the centre frequency of the bin.
                 // at 1333hz, bin widths are 41.65Hz, so bin 2 has the range 83,3Hz to 124,95Hz
                 // Rav feels that maybe centerFreq = (fftMeanIndex + 0.5) * fftResolution; is better
                 // empirical checking shows that not adding 0.5 works better
-            } else {
-                centerFreq = state->centerFreq[state->updateAxis];
+                const float fftMeanIndex = fftWeightedSum / fftSum;
+                const float centerFreq = constrainf(fftMeanIndex * fftResolution, dynNotchMinHz, dynNotchMaxHz);
+
+                // PT1 style dynamic smoothing moves rapidly towards big peaks and slowly away, up to 8x faster
+                const float dynamicFactor = constrainf(peakValue[peak] / dataMin, 1.0f, 8.0f);
+                float *peakFreq = &state->peakFreq[state->updateAxis][peak];
+                *peakFreq += smoothFactor * dynamicFactor * (centerFreq - *peakFreq);
+
+                // the largest peak sets centerFreq
+                if (peakValue[peak] > dataMax) {
+                    dataMax = peakValue[peak];
+                    state->centerFreq[state->updateAxis] = *peakFreq;
+                    maxDynamicFactor = dynamicFactor;
+                    maxMeanIndex = fftMeanIndex;
+                }
             }
-            centerFreq = constrainf(centerFreq, dynNotchMinHz, dynNotchMaxHz);
-
-            // PT1 style dynamic smoothing moves rapidly towards big peaks and slowly away, up to 8x faster
-            float dynamicFactor = constrainf(dataMax / dataMin, 1.0f, 8.0f);
-            state->centerFreq[state->updateAxis] = state->centerFreq[state->updateAxis] + smoothFactor * dynamicFactor * (centerFreq - state->centerFreq[state->updateAxis]);
 
             if(calculateThrottlePercentAbs() > DYN_NOTCH_OSD_MIN_THROTTLE) {
                 dynNotchMaxFFT = MAX(dynNotchMaxFFT, state->centerFreq[state->updateAxis]);
             }
 
             if (state->updateAxis == 0) {
-                DEBUG_SET(DEBUG_FFT, 3, lrintf(fftMeanIndex * 100));
+                DEBUG_SET(DEBUG_FFT, 3, lrintf(maxMeanIndex * 100));
                 DEBUG_SET(DEBUG_FFT_FREQ, 0, state->centerFreq[state->updateAxis]);
-                DEBUG_SET(DEBUG_FFT_FREQ, 1, lrintf(dynamicFactor * 100));
+                DEBUG_SET(DEBUG_FFT_FREQ, 1, lrintf(maxDynamicFactor * 100));
                 DEBUG_SET(DEBUG_DYN_LPF, 1, state->centerFreq[state->updateAxis]);
             }
 //            if (state->updateAxis == 1) {
@@ -369,13 +468,7 @@ static FAST_CODE_NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state,
         case STEP_UPDATE_FILTERS:
         {
             // 7us
-            // calculate cutoffFreq and notch Q, update notch filter
-            if (dualNotch) {
-                biquadFilterUpdate(&notchFilterDyn[state->updateAxis], state->centerFreq[state->updateAxis] * dynNotch1Ctr, gyro.targetLooptime, dynNotchQ, FILTER_NOTCH);
-                biquadFilterUpdate(&notchFilterDyn2[state->updateAxis], state->centerFreq[state->updateAxis] * dynNotch2Ctr, gyro.targetLooptime, dynNotchQ, FILTER_NOTCH);
-            } else {
-                biquadFilterUpdate(&notchFilterDyn[state->updateAxis], state->centerFreq[state->updateAxis], gyro.targetLooptime, dynNotchQ, FILTER_NOTCH);
-            }
+            gyroDataAnalyseUpdateNotches(state, state->updateAxis, notchFilterDynBank);
             DEBUG_SET(DEBUG_FFT_TIME, 1, micros() - startTime);
 
             state->updateAxis = (state->updateAxis + 1) % XYZ_AXIS_COUNT;
@@ -399,6 +492,99 @@ static FAST_CODE_NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state,
     state->updateStep = (state->updateStep + 1) % STEP_COUNT;
 }
 
+/*
+ * Find the largest peaks of one axis in the SDFT spectrum and move the tracked peaks towards them
+ */
+static FAST_CODE void gyroDataAnalyseSdftPeaks(gyroAnalyseState_t *state, int axis, filterBank_t *notchFilterDynBank)
+{
+    float *data = state->sdftData;
+    sdftWindowedMagSq(&state->sdft[axis], data);
+
+    float peakValue[DYN_NOTCH_COUNT_MAX] = { 0 };
+    uint8_t peakBin[DYN_NOTCH_COUNT_MAX] = { 0 };
+    float dataMin = data[sdftStartBin];
+
+    for (int bin = sdftStartBin; bin <= sdftEndBin; bin++) {
+        dataMin = fminf(dataMin, data[bin]);
+        if (data[bin] > data[bin - 1] && data[bin] >= data[bin + 1]) {
+            gyroDataAnalyseInsertPeak(peakValue, peakBin, data[bin], bin);
+        }
+    }
+    // fewer peaks than notches, hold the remaining ones, data is squared magnitude
+    const int peakCount = gyroDataAnalyseSortPeaks(peakValue, peakBin, peakValue[0] * DYN_NOTCH_PEAK_MIN_RATIO * DYN_NOTCH_PEAK_MIN_RATIO);
+
+    float dataMax = 0.0f;
+    float maxDynamicFactor = 1.0f;
+    for (int peak = 0; peak < peakCount; peak++) {
+        const int bin = peakBin[peak];
+        // interpolate the peak position from the windowed magnitudes either side,
+        // exact for a single tone with the Hann window
+        const float magLo = sqrtf(data[bin - 1]);
+        const float mag = sqrtf(data[bin]);
+        const float magHi = sqrtf(data[bin + 1]);
+        const float binOffset = 2 * (magHi - magLo) / (magLo + 2 * mag + magHi);
+        const float centerFreq = constrainf((bin + binOffset) * sdftResolution, dynNotchMinHz, dynNotchMaxHz);
+
+        // PT1 style dynamic smoothing moves rapidly towards big peaks and slowly away, up to 8x faster
+        float dynamicFactor = 1.0f;
+        if (dataMin > 0.0f) {
+            dynamicFactor = constrainf(sqrtf(peakValue[peak] / dataMin), 1.0f, 8.0f);
+        }
+        float *peakFreq = &state->peakFreq[axis][peak];
+        *peakFreq += sdftSmoothFactor * dynamicFactor * (centerFreq - *peakFreq);
+
+        // the largest peak sets centerFreq
+        if (peakValue[peak] > dataMax) {
+            dataMax = peakValue[peak];
+            state->centerFreq[axis] = *peakFreq;
+            maxDynamicFactor = dynamicFactor;
+        }
+    }
+
+    if (calculateThrottlePercentAbs() > DYN_NOTCH_OSD_MIN_THROTTLE) {
+        dynNotchMaxFFT = MAX(dynNotchMaxFFT, state->centerFreq[axis]);
+    }
+
+    if (axis == 0) {
+        DEBUG_SET(DEBUG_FFT_FREQ, 0, state->centerFreq[axis]);
+        DEBUG_SET(DEBUG_FFT_FREQ, 1, lrintf(maxDynamicFactor * 100));
+        DEBUG_SET(DEBUG_DYN_LPF, 1, state->centerFreq[axis]);
+    }
+
+    gyroDataAnalyseUpdateNotches(state, axis, notchFilterDynBank);
+}
+
+/*
+ * Sliding DFT analyser, constant work every gyro loop
+ */
+static FAST_CODE_NOINLINE void gyroDataAnalyseSdft(gyroAnalyseState_t *state, filterBank_t *notchFilterDynBank)
+{
+    uint32_t startTime = 0;
+    if (debugMode == (DEBUG_FFT_TIME)) {
+        startTime = micros();
+    }
+
+    // push the last downsampled sample, one batch of bins per gyro loop
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        sdftPushBatch(&state->sdft[axis], state->sdftSample[axis], state->sampleCount);
+    }
+
+    // samples should have been pushed by `gyroDataAnalysePush`
+    state->sampleCount++;
+    if (state->sampleCount == state->maxSampleCount) {
+        state->sampleCount = 0;
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            state->sdftSample[axis] = state->oversampledGyroAccumulator[axis] * state->maxSampleCountRcp;
+            state->oversampledGyroAccumulator[axis] = 0;
+        }
+        DEBUG_SET(DEBUG_FFT, 2, lrintf(state->sdftSample[0]));
+    }
+
+    gyroDataAnalyseSdftPeaks(state, state->sdftAxis, notchFilterDynBank);
+    state->sdftAxis = (state->sdftAxis + 1) % XYZ_AXIS_COUNT;
+
+    DEBUG_SET(DEBUG_FFT_TIME, 1, micros() - startTime);
+}
 
 uint16_t getMaxFFT(void) {
     return dynNotchMaxFFT;
@@ -23,8 +23,10 @@
 #include "arm_math.h"
 
 #include "common/filter.h"
+#include "common/sdft.h"
 
 #define FFT_WINDOW_SIZE 32
+#define DYN_NOTCH_COUNT_MAX 5   // peaks tracked per axis, each with its own notch
 
 typedef struct gyroAnalyseState_s {
     // accumulator for oversampled data => no aliasing and less noise
@@ -46,7 +48,14 @@ typedef struct gyroAnalyseState_s {
     float fftData[FFT_WINDOW_SIZE];
     float rfftData[FFT_WINDOW_SIZE];
 
-    float centerFreq[XYZ_AXIS_COUNT];
+    float centerFreq[XYZ_AXIS_COUNT];                      // frequency of the largest peak
+    float peakFreq[XYZ_AXIS_COUNT][DYN_NOTCH_COUNT_MAX];   // frequency of each notch, lowest first
+
+    // sliding DFT analyser
+    uint8_t sdftAxis;                       // axis whose peaks are tracked in the next call
+    float sdftSample[XYZ_AXIS_COUNT];       // last downsampled sample, pushed into the SDFT over the following calls
+    sdft_t sdft[XYZ_AXIS_COUNT];
+    float sdftData[SDFT_BIN_COUNT];
 
 } gyroAnalyseState_t;
 
@@ -54,6 +63,6 @@ STATIC_ASSERT(FFT_WINDOW_SIZE <= (uint8_t) -1, window_size_greater_than_underlyi
 
 void gyroDataAnalyseStateInit(gyroAnalyseState_t *state, uint32_t targetLooptimeUs);
 void gyroDataAnalysePush(gyroAnalyseState_t *state, const int axis, const float sample);
-void gyroDataAnalyse(gyroAnalyseState_t *state, biquadFilter_t *notchFilterDyn, biquadFilter_t *notchFilterDyn2);
+void gyroDataAnalyse(gyroAnalyseState_t *state, filterBank_t *notchFilterDynBank);
 uint16_t getMaxFFT(void);
 void resetMaxFFT(void);
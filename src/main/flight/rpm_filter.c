@@ -21,6 +21,7 @@
 
 #include <math.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -45,6 +46,7 @@
 #include "rpm_filter.h"
 
 #define RPM_FILTER_MAXHARMONICS 3
+#define RPM_FILTER_MAXNOTCHES   (MAX_SUPPORTED_MOTORS * RPM_FILTER_MAXHARMONICS)
 #define SECONDS_PER_MINUTE      60.0f
 #define ERPM_PER_LSB            100.0f
 #define MIN_UPDATE_T            0.001f
@@ -52,31 +54,38 @@
 
 static pt1Filter_t rpmFilters[MAX_SUPPORTED_MOTORS];
 
+// Notches are stored motor by motor, harmonic by harmonic. The coefficients are
+// shared by all axes, the DF1 state has one lane per axis so each notch is
+// applied to all axes in the same pass.
+// For a notch b2 == b0 and b1 == a1, so only b0, a1 and a2 are stored.
 typedef struct rpmNotchFilter_s
 {
     uint8_t harmonics;
+    uint8_t notchCount;
     float   minHz;
     float   maxHz;
     float   q;
     float   loopTime;
 
-    biquadFilter_t notch[XYZ_AXIS_COUNT][MAX_SUPPORTED_MOTORS][RPM_FILTER_MAXHARMONICS];
+    float b0[RPM_FILTER_MAXNOTCHES];
+    float a1[RPM_FILTER_MAXNOTCHES];
+    float a2[RPM_FILTER_MAXNOTCHES];
+
+    float x1[RPM_FILTER_MAXNOTCHES][FILTER_BANK_LANES];
+    float x2[RPM_FILTER_MAXNOTCHES][FILTER_BANK_LANES];
+    float y1[RPM_FILTER_MAXNOTCHES][FILTER_BANK_LANES];
+    float y2[RPM_FILTER_MAXNOTCHES][FILTER_BANK_LANES];
 } rpmNotchFilter_t;
 
 FAST_DATA_ZERO_INIT static float   erpmToHz;
 FAST_DATA_ZERO_INIT static float   filteredMotorErpm[MAX_SUPPORTED_MOTORS];
 FAST_DATA_ZERO_INIT static float   minMotorFrequency;
-FAST_DATA_ZERO_INIT static uint8_t numberFilters;
-FAST_DATA_ZERO_INIT static uint8_t numberRpmNotchFilters;
-FAST_DATA_ZERO_INIT static uint8_t filterUpdatesPerIteration;
+FAST_DATA_ZERO_INIT static uint8_t motorUpdatesPerIteration;
 FAST_DATA_ZERO_INIT static float   pidLooptime;
-FAST_DATA_ZERO_INIT static rpmNotchFilter_t filters[2];
+FAST_DATA_ZERO_INIT static rpmNotchFilter_t filters;
 FAST_DATA_ZERO_INIT static rpmNotchFilter_t* gyroFilter;
 
 FAST_DATA_ZERO_INIT static uint8_t currentMotor;
-FAST_DATA_ZERO_INIT static uint8_t currentHarmonic;
-FAST_DATA_ZERO_INIT static uint8_t currentFilterNumber;
-FAST_DATA static rpmNotchFilter_t* currentFilter = &filters[0];
 
 
 
@@ -91,29 +100,63 @@ void pgResetFn_rpmFilterConfig(rpmFilterConfig_t *config)
     config->rpm_lpf = 150;
 }
 
+// Recalculates the notch coefficients for all harmonics of a motor.
+// sin/cos are evaluated once for the fundamental, the harmonics follow by angle addition
+// unless their frequency had to be constrained.
+static FAST_CODE_NOINLINE void rpmNotchFilterUpdateMotor(rpmNotchFilter_t* filter, int motor, float motorHz)
+{
+    const float omegaPerHz = 2.0f * M_PIf * filter->loopTime * 0.000001f;
+    const float omega = omegaPerHz * motorHz;
+    const float sn1 = sin_approx(omega);
+    const float cs1 = cos_approx(omega);
+    const float alphaScale = 1.0f / (2.0f * filter->q);
+
+    float sn = sn1;
+    float cs = cs1;
+    for (int harmonic = 0; harmonic < filter->harmonics; harmonic++) {
+        const float frequency = (harmonic + 1) * motorHz;
+        float notchSn = sn;
+        float notchCs = cs;
+        if (frequency < filter->minHz || frequency > filter->maxHz) {
+            const float notchOmega = omegaPerHz * constrainf(frequency, filter->minHz, filter->maxHz);
+            notchSn = sin_approx(notchOmega);
+            notchCs = cos_approx(notchOmega);
+        }
+
+        const float alpha = notchSn * alphaScale;
+        const float a0r = 1.0f / (1.0f + alpha);
+        const int n = motor * filter->harmonics + harmonic;
+        filter->b0[n] = a0r;
+        filter->a1[n] = -2.0f * notchCs * a0r;
+        filter->a2[n] = (1.0f - alpha) * a0r;
+
+        // advance to the next harmonic, sin(a + w) = sin(a)cos(w) + cos(a)sin(w), cos(a + w) = cos(a)cos(w) - sin(a)sin(w)
+        const float snNext = sn * cs1 + cs * sn1;
+        cs = cs * cs1 - sn * sn1;
+        sn = snNext;
+    }
+}
+
 static void rpmNotchFilterInit(rpmNotchFilter_t* filter, int harmonics, int minHz, int q, float looptime)
 {
+    memset(filter, 0, sizeof(*filter));
     filter->harmonics = harmonics;
+    filter->notchCount = getMotorCount() * harmonics;
     filter->minHz = minHz;
+    // don't go quite to nyquist to avoid oscillations
+    filter->maxHz = 0.48f / (looptime * 1e-6f);
     filter->q = q / 100.0f;
     filter->loopTime = looptime;
 
-    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        for (int motor = 0; motor < getMotorCount(); motor++) {
-            for (int i = 0; i < harmonics; i++) {
-                biquadFilterInit(
-                    &filter->notch[axis][motor][i], minHz * i, looptime, filter->q, FILTER_NOTCH);
-            }
-        }
+    for (int motor = 0; motor < getMotorCount(); motor++) {
+        rpmNotchFilterUpdateMotor(filter, motor, 0.0f);
     }
 }
 
 void rpmFilterInit(const rpmFilterConfig_t *config)
 {
-    currentFilter = &filters[0];
-    currentMotor = currentHarmonic = currentFilterNumber = 0;
+    currentMotor = 0;
 
-    numberRpmNotchFilters = 0;
     if (!motorConfig()->dev.useDshotTelemetry) {
         gyroFilter = NULL;
         return;
@@ -121,11 +164,9 @@ void rpmFilterInit(const rpmFilterConfig_t *config)
 
     pidLooptime = gyro.targetLooptime;
     if (config->gyro_rpm_notch_harmonics) {
-        gyroFilter = &filters[numberRpmNotchFilters++];
+        gyroFilter = &filters;
         rpmNotchFilterInit(gyroFilter, config->gyro_rpm_notch_harmonics,
                            config->gyro_rpm_notch_min, config->gyro_rpm_notch_q, gyro.targetLooptime);
-        // don't go quite to nyquist to avoid oscillations
-        gyroFilter->maxHz = 0.48f / (gyro.targetLooptime * 1e-6f);
     } else {
         gyroFilter = NULL;
     }
@@ -136,28 +177,45 @@ void rpmFilterInit(const rpmFilterConfig_t *config)
 
     erpmToHz = ERPM_PER_LSB / SECONDS_PER_MINUTE  / (motorConfig()->motorPoleCount / 2.0f);
 
+    // all harmonics of a motor are updated together, spread the motors so every notch is updated within MIN_UPDATE_T
     const float loopIterationsPerUpdate = MIN_UPDATE_T / (pidLooptime * 1e-6f);
-    numberFilters = getMotorCount() * (filters[0].harmonics + filters[1].harmonics);
-    const float filtersPerLoopIteration = numberFilters / loopIterationsPerUpdate;
-    filterUpdatesPerIteration = rintf(filtersPerLoopIteration + 0.49f);
+    const float motorsPerLoopIteration = getMotorCount() / loopIterationsPerUpdate;
+    motorUpdatesPerIteration = rintf(motorsPerLoopIteration + 0.49f);
 }
 
-static float applyFilter(rpmNotchFilter_t* filter, int axis, float value)
+// values holds one lane per axis, as used by filterBankApply()
+FAST_CODE void rpmFilterGyro(float *values)
 {
-    if (filter == NULL) {
-        return value;
+    if (gyroFilter == NULL) {
+        return;
     }
-    for (int motor = 0; motor < getMotorCount(); motor++) {
-        for (int i = 0; i < filter->harmonics; i++) {
-            value = biquadFilterApplyDF1(&filter->notch[axis][motor][i], value);
+
+    // work on a local copy so the compiler knows the samples do not alias the filter state
+    float v[FILTER_BANK_LANES];
+    memcpy(v, values, sizeof(v));
+
+    for (int n = 0; n < gyroFilter->notchCount; n++) {
+        const float b0 = gyroFilter->b0[n];
+        const float a1 = gyroFilter->a1[n];
+        const float a2 = gyroFilter->a2[n];
+        float *x1 = gyroFilter->x1[n];
+        float *x2 = gyroFilter->x2[n];
+        float *y1 = gyroFilter->y1[n];
+        float *y2 = gyroFilter->y2[n];
+
+        for (int lane = 0; lane < FILTER_BANK_LANES; lane++) {
+            // direct form 1, b0 * in + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2 with b2 == b0 and b1 == a1
+            const float input = v[lane];
+            const float result = b0 * (input + x2[lane]) + a1 * (x1[lane] - y1[lane]) - a2 * y2[lane];
+            x2[lane] = x1[lane];
+            x1[lane] = input;
+            y2[lane] = y1[lane];
+            y1[lane] = result;
+            v[lane] = result;
         }
     }
-    return value;
-}
 
-float rpmFilterGyro(int axis, float value)
-{
-    return applyFilter(gyroFilter, axis, value);
+    memcpy(values, v, sizeof(v));
 }
 
 FAST_DATA_ZERO_INIT static float motorFrequency[MAX_SUPPORTED_MOTORS];
@@ -176,38 +234,13 @@ FAST_CODE_NOINLINE void rpmFilterUpdate()
         motorFrequency[motor] = erpmToHz * filteredMotorErpm[motor];
     }
 
-    for (int i = 0; i < filterUpdatesPerIteration; i++) {
-        float frequency = constrainf(
-            (currentHarmonic + 1) * motorFrequency[currentMotor], currentFilter->minHz, currentFilter->maxHz);
-        biquadFilter_t* template = &currentFilter->notch[0][currentMotor][currentHarmonic];
-        // uncomment below to debug filter stepping. Need to also comment out motor rpm DEBUG_SET above
-        /* DEBUG_SET(DEBUG_RPM_FILTER, 0, harmonic); */
-        /* DEBUG_SET(DEBUG_RPM_FILTER, 1, motor); */
-        /* DEBUG_SET(DEBUG_RPM_FILTER, 2, currentFilter == &gyroFilter); */
-        /* DEBUG_SET(DEBUG_RPM_FILTER, 3, frequency) */
-        biquadFilterUpdate(
-            template, frequency, currentFilter->loopTime, currentFilter->q, FILTER_NOTCH);
-        for (int axis = 1; axis < XYZ_AXIS_COUNT; axis++) {
-            biquadFilter_t* clone = &currentFilter->notch[axis][currentMotor][currentHarmonic];
-            clone->b0 = template->b0;
-            clone->b1 = template->b1;
-            clone->b2 = template->b2;
-            clone->a1 = template->a1;
-            clone->a2 = template->a2;
-        }
+    for (int i = 0; i < motorUpdatesPerIteration; i++) {
+        rpmNotchFilterUpdateMotor(gyroFilter, currentMotor, motorFrequency[currentMotor]);
 
-        if (++currentHarmonic == currentFilter->harmonics) {
-            currentHarmonic = 0;
-            if (++currentFilterNumber == numberRpmNotchFilters) {
-                currentFilterNumber = 0;
-                if (++currentMotor == getMotorCount()) {
-                    currentMotor = 0;
-                }
-                minMotorFrequency = 0.0f;
-            }
-            currentFilter = &filters[currentFilterNumber];
+        if (++currentMotor == getMotorCount()) {
+            currentMotor = 0;
         }
-
+        minMotorFrequency = 0.0f;
     }
 }
 
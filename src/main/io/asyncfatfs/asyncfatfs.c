@@ -77,6 +77,12 @@
  */
 #define AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT 4
 
+/*
+ * How many sectors beyond the cursor will fread() ask the card for while the caller is still consuming the current
+ * one. If this define is omitted, this disables read-ahead.
+ */
+#define AFATFS_READ_AHEAD_SECTORS 2
+
 #define AFATFS_FILES_PER_DIRECTORY_SECTOR (AFATFS_SECTOR_SIZE / sizeof(fatDirectoryEntry_t))
 
 #define AFATFS_FAT32_FAT_ENTRIES_PER_SECTOR  (AFATFS_SECTOR_SIZE / sizeof(uint32_t))
@@ -470,6 +476,15 @@ typedef struct afatfs_t {
     int cacheDirtyEntries; // The number of cache entries in the AFATFS_CACHE_STATE_DIRTY state
     bool cacheFlushInProgress;
 
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+    /*
+     * The sector that would continue the multi-block write we last handed to the card, and how many more sectors the
+     * card was told to expect in it. Flushing that sector next keeps the card streaming instead of ending the write.
+     */
+    uint32_t multiWriteNextSector;
+    uint32_t multiWriteBlocksRemain;
+#endif
+
     afatfsFile_t openFiles[AFATFS_MAX_OPEN_FILES];
 
 #ifdef AFATFS_USE_FREEFILE
@@ -704,10 +719,33 @@ static void afatfs_sdcardWriteComplete(sdcardBlockOperation_e operation, uint32_
     }
 }
 
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+/**
+ * Keep track of the multi-block write the card is in after it accepted the given sector.
+ */
+static void afatfs_cacheTrackMultiWrite(afatfsCacheBlockDescriptor_t *cacheDescriptor)
+{
+    if (cacheDescriptor->consecutiveEraseBlockCount) {
+        afatfs.multiWriteBlocksRemain = cacheDescriptor->consecutiveEraseBlockCount;
+    } else if (cacheDescriptor->sectorIndex != afatfs.multiWriteNextSector) {
+        // A lone sector ends the card's multi-block write
+        afatfs.multiWriteBlocksRemain = 0;
+    }
+
+    if (afatfs.multiWriteBlocksRemain > 0) {
+        afatfs.multiWriteBlocksRemain--;
+        afatfs.multiWriteNextSector = cacheDescriptor->sectorIndex + 1;
+    }
+}
+#endif
+
 /**
  * Attempt to flush the dirty cache entry with the given index to the SDcard.
+ *
+ * Returns the status from the card, SDCARD_OPERATION_SUCCESS means the card took the sector immediately and is ready
+ * for another.
  */
-static void afatfs_cacheFlushSector(int cacheIndex)
+static sdcardOperationStatus_e afatfs_cacheFlushSector(int cacheIndex)
 {
     afatfsCacheBlockDescriptor_t *cacheDescriptor = &afatfs.cacheDescriptor[cacheIndex];
 
@@ -717,7 +755,9 @@ static void afatfs_cacheFlushSector(int cacheIndex)
     }
 #endif
 
-    switch (sdcard_writeBlock(cacheDescriptor->sectorIndex, afatfs_cacheSectorGetMemory(cacheIndex), afatfs_sdcardWriteComplete, 0)) {
+    sdcardOperationStatus_e status = sdcard_writeBlock(cacheDescriptor->sectorIndex, afatfs_cacheSectorGetMemory(cacheIndex), afatfs_sdcardWriteComplete, 0);
+
+    switch (status) {
         case SDCARD_OPERATION_IN_PROGRESS:
             // The card will call us back later when the buffer transmission finishes
             afatfs.cacheDirtyEntries--;
@@ -734,8 +774,14 @@ static void afatfs_cacheFlushSector(int cacheIndex)
         case SDCARD_OPERATION_BUSY:
         case SDCARD_OPERATION_FAILURE:
         default:
-            ;
+            return status;
     }
+
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+    afatfs_cacheTrackMultiWrite(cacheDescriptor);
+#endif
+
+    return status;
 }
 
 // Check whether every sector in the cache that can be flushed has been synchronized
@@ -848,33 +894,55 @@ static int afatfs_allocateCacheSector(uint32_t sectorIndex)
 }
 
 /**
- * Attempt to flush dirty cache pages out to the sdcard, returning true if all flushable data has been flushed.
+ * Choose the dirty cache entry to flush next, or return -1 if none can be flushed right now.
+ *
+ * Sectors are flushed in the order they were first dirtied, except that the sector which continues the card's
+ * multi-block write goes first, so that a streaming append isn't broken up by the FAT and directory sectors it dirties.
  */
-bool afatfs_flush(void)
+static int afatfs_findSectorToFlush(void)
 {
-    if (afatfs.cacheDirtyEntries > 0) {
-        // Flush the oldest flushable sector
-        uint32_t earliestSectorTime = 0xFFFFFFFF;
-        int earliestSectorIndex = -1;
+    uint32_t earliestSectorTime = 0xFFFFFFFF;
+    int earliestSectorIndex = -1;
 
-        for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
-            if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY && !afatfs.cacheDescriptor[i].locked
-                && (earliestSectorIndex == -1 || afatfs.cacheDescriptor[i].writeTimestamp < earliestSectorTime)
-            ) {
+    for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+        if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY && !afatfs.cacheDescriptor[i].locked) {
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+            if (afatfs.multiWriteBlocksRemain > 0 && afatfs.cacheDescriptor[i].sectorIndex == afatfs.multiWriteNextSector) {
+                return i;
+            }
+#endif
+            if (earliestSectorIndex == -1 || afatfs.cacheDescriptor[i].writeTimestamp < earliestSectorTime) {
                 earliestSectorIndex = i;
                 earliestSectorTime = afatfs.cacheDescriptor[i].writeTimestamp;
             }
         }
+    }
+
+    return earliestSectorIndex;
+}
+
+/**
+ * Attempt to flush dirty cache pages out to the sdcard, returning true if all flushable data has been flushed.
+ *
+ * Cards whose driver gathers the blocks of a multi-block write take them without waiting, so we keep handing over
+ * sectors until the card has to go away and write them.
+ */
+bool afatfs_flush(void)
+{
+    for (int flushed = 0; afatfs.cacheDirtyEntries > 0 && flushed < AFATFS_NUM_CACHE_SECTORS; flushed++) {
+        int flushIndex = afatfs_findSectorToFlush();
 
-        if (earliestSectorIndex > -1) {
-            afatfs_cacheFlushSector(earliestSectorIndex);
+        if (flushIndex == -1) {
+            break;
+        }
 
+        if (afatfs_cacheFlushSector(flushIndex) != SDCARD_OPERATION_SUCCESS) {
             // That flush will take time to complete so we may as well tell caller to come back later
             return false;
         }
     }
 
-    return true;
+    return afatfs.cacheDirtyEntries == 0 || afatfs_findSectorToFlush() == -1;
 }
 
 /**
@@ -3146,6 +3214,52 @@ uint32_t afatfs_fwrite(afatfsFilePtr_t file, const uint8_t *buffer, uint32_t len
     return writtenBytes;
 }
 
+#ifdef AFATFS_READ_AHEAD_SECTORS
+/**
+ * Ask the card for the first sector that isn't cached yet out of the one at the file cursor and the
+ * AFATFS_READ_AHEAD_SECTORS that follow it, so that a sequential reader finds the data waiting when it gets there.
+ */
+static void afatfs_fileReadAhead(afatfsFilePtr_t file)
+{
+    // A speculative read would end the multi-block write of sectors that are waiting to be flushed
+    if (file->type != AFATFS_FILE_TYPE_NORMAL || afatfs.cacheDirtyEntries > 0 || afatfs_isEndOfAllocatedFile(file)) {
+        return;
+    }
+
+    uint32_t cluster = file->cursorCluster;
+    uint32_t sectorInCluster = afatfs_sectorIndexInCluster(file->cursorOffset);
+    uint32_t sectorOffset = file->cursorOffset - file->cursorOffset % AFATFS_SECTOR_SIZE;
+    uint8_t *sector;
+
+    for (int i = 0; sectorOffset < file->logicalSize; i++) {
+        uint32_t physicalSector = afatfs_fileClusterToPhysical(cluster, sectorInCluster);
+        afatfsCacheBlockDescriptor_t *descriptor = afatfs_findCacheSector(physicalSector);
+
+        if (descriptor == NULL || descriptor->state == AFATFS_CACHE_STATE_EMPTY) {
+            // The card only fetches one sector at a time, so that's all we can queue
+            afatfs_cacheSector(physicalSector, &sector, AFATFS_CACHE_READ, 0);
+            return;
+        }
+
+        if (i == AFATFS_READ_AHEAD_SECTORS) {
+            return;
+        }
+
+        sectorOffset += AFATFS_SECTOR_SIZE;
+        sectorInCluster++;
+
+        if (sectorInCluster == afatfs.sectorsPerCluster) {
+            // Only follow the chain if its FAT sector is to hand, otherwise this starts reading it in for later
+            if (afatfs_fileGetNextCluster(file, cluster, &cluster) != AFATFS_OPERATION_SUCCESS
+                || cluster == 0 || afatfs_FATIsEndOfChainMarker(cluster)) {
+                return;
+            }
+            sectorInCluster = 0;
+        }
+    }
+}
+#endif
+
 /**
  * Attempt to read `len` bytes from `file` into the `buffer`.
  *
@@ -3196,6 +3310,13 @@ uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len)
 
         readBytes += bytesToReadThisSector;
 
+#ifdef AFATFS_READ_AHEAD_SECTORS
+        if (cursorOffsetInSector + bytesToReadThisSector == AFATFS_SECTOR_SIZE) {
+            // We've finished with this sector, so it makes room for the read-ahead before anything else is evicted
+            afatfs.cacheDescriptor[file->readRetainCacheIndex].discardable = 1;
+        }
+#endif
+
         /*
          * If the seek doesn't complete immediately then we'll break and wait for that seek to complete by waiting for
          * the file to be non-busy on entry again.
@@ -3212,6 +3333,10 @@ uint32_t afatfs_fread(afatfsFilePtr_t file, uint8_t *buffer, uint32_t len)
         cursorOffsetInSector = 0;
     }
 
+#ifdef AFATFS_READ_AHEAD_SECTORS
+    afatfs_fileReadAhead(file);
+#endif
+
     return readBytes;
 }
 
@@ -3281,6 +3406,13 @@ static void afatfs_fileOperationsPoll(void)
 
     for (int i = 0; i < AFATFS_MAX_OPEN_FILES; i++) {
         afatfs_fileOperationContinue(&afatfs.openFiles[i]);
+
+#ifdef AFATFS_READ_AHEAD_SECTORS
+        // Start the next read as soon as the card is free rather than waiting for the reader to come back for it
+        if ((afatfs.openFiles[i].mode & AFATFS_FILE_MODE_READ) != 0 && !afatfs_fileIsBusy(&afatfs.openFiles[i])) {
+            afatfs_fileReadAhead(&afatfs.openFiles[i]);
+        }
+#endif
     }
 }
 
@@ -38,6 +38,7 @@
 
 #include "platform.h"
 
+#include "common/maths.h"
 #include "common/printf.h"
 #include "drivers/flash.h"
 
@@ -55,15 +56,23 @@ static uint8_t flashWriteBuffer[FLASHFS_WRITE_BUFFER_SIZE];
  * oldest byte that has yet to be written to flash.
  *
  * When the circular buffer is empty, head == tail
+ *
+ * The byte destined for a flash address is always kept at that address modulo the buffer size, so a staging slot,
+ * which is aligned in the flash, is never split by the wrap at the end of the buffer and goes out in one transfer.
  */
-static uint8_t bufferHead = 0, bufferTail = 0;
+static uint16_t bufferHead = 0, bufferTail = 0;
 
 // The position of the buffer's tail in the overall flash address space:
 static uint32_t tailAddress = 0;
 
+static flashfsStats_t flashfsStats;
+
+// The pending write has already been counted as a stall, don't count it again each time we poll
+static bool writeStalled = false;
+
 static void flashfsClearBuffer(void)
 {
-    bufferTail = bufferHead = 0;
+    bufferTail = bufferHead = tailAddress % FLASHFS_WRITE_BUFFER_SIZE;
 }
 
 static bool flashfsBufferIsEmpty(void)
@@ -74,6 +83,10 @@ static bool flashfsBufferIsEmpty(void)
 static void flashfsSetTailAddress(uint32_t address)
 {
     tailAddress = address;
+
+    if (flashfsBufferIsEmpty()) {
+        flashfsClearBuffer(); // Keep the buffer aligned with the new address
+    }
 }
 
 void flashfsEraseCompletely(void)
@@ -203,9 +216,15 @@ static uint32_t flashfsWriteBuffers(uint8_t const **buffers, uint32_t *bufferSiz
     }
 
     if (!sync && !flashIsReady()) {
+        if (!writeStalled) {
+            flashfsStats.stalls++;
+            writeStalled = true;
+        }
         return 0;
     }
 
+    writeStalled = false;
+
     uint32_t bytesTotalRemaining = bytesTotal;
 
     uint16_t pageSize = flashGeometry->pageSize;
@@ -325,28 +344,53 @@ static void flashfsAdvanceTailInBuffer(uint32_t delta)
     }
 
     if (flashfsBufferIsEmpty()) {
-        flashfsClearBuffer(); // Bring buffer pointers back to the start to be tidier
+        flashfsClearBuffer();
     }
 }
 
 /**
- * If the flash is ready to accept writes, flush the buffer to it.
+ * The number of bytes from the tail to the end of its staging slot. Slots are aligned in the flash address space
+ * and never larger than a page, so a full slot is written with a single page program.
+ */
+static uint32_t flashfsStagingSlotRemaining(void)
+{
+    const uint32_t slotSize = MIN(flashGeometry->pageSize, FLASHFS_WRITE_BUFFER_SLOT_SIZE);
+
+    return slotSize - tailAddress % slotSize;
+}
+
+/**
+ * If the flash is ready to accept writes, flush the buffer to it. Never waits for the flash.
+ *
+ * Unless force is set, only a full staging slot is written, so that the next slot fills while the flash is busy
+ * programming this one rather than spending a program operation on every few bytes. Set force to drain the buffer
+ * completely, e.g. when the log is being closed.
  *
  * Returns true if all data in the buffer has been flushed to the device, or false if
  * there is still data to be written (call flush again later).
  */
-bool flashfsFlushAsync(void)
+bool flashfsFlushAsync(bool force)
 {
     if (flashfsBufferIsEmpty()) {
         return true; // Nothing to flush
     }
 
+    const uint32_t slotRemaining = flashfsStagingSlotRemaining();
+
+    if (!force && flashfsTransmitBufferUsed() < slotRemaining) {
+        return false; // Keep filling the slot
+    }
+
     uint8_t const * buffers[2];
     uint32_t bufferSizes[2];
     uint32_t bytesWritten;
 
     flashfsGetDirtyDataBuffers(buffers, bufferSizes);
-    bytesWritten = flashfsWriteBuffers(buffers, bufferSizes, 2, false);
+
+    // The slot is contiguous in the buffer, so this is a single transfer that the flash can take without waiting
+    bufferSizes[0] = MIN(bufferSizes[0], slotRemaining);
+
+    bytesWritten = flashfsWriteBuffers(buffers, bufferSizes, 1, false);
     flashfsAdvanceTailInBuffer(bytesWritten);
 
     return flashfsBufferIsEmpty();
@@ -389,85 +433,45 @@ void flashfsSeekRel(int32_t offset)
 }
 
 /**
- * Write the given byte asynchronously to the flash. If the buffer overflows, data is silently discarded.
+ * Write the given byte asynchronously to the flash. If the buffer overflows, data is discarded.
  */
 void flashfsWriteByte(uint8_t byte)
 {
-    flashWriteBuffer[bufferHead++] = byte;
-
-    if (bufferHead >= FLASHFS_WRITE_BUFFER_SIZE) {
-        bufferHead = 0;
-    }
-
-    if (flashfsTransmitBufferUsed() >= FLASHFS_WRITE_BUFFER_AUTO_FLUSH_LEN) {
-        flashfsFlushAsync();
-    }
+    flashfsWrite(&byte, 1, false);
 }
 
 /**
  * Write the given buffer to the flash either synchronously or asynchronously depending on the 'sync' parameter.
  *
- * If writing asynchronously, data will be silently discarded if the buffer overflows.
+ * Data is staged in the buffer and written out a slot at a time as the flash becomes ready.
+ *
+ * If writing asynchronously, the data will be discarded if it doesn't fit in the buffer.
  * If writing synchronously, the routine will block waiting for the flash to become ready so will never drop data.
  */
 void flashfsWrite(const uint8_t *data, unsigned int len, bool sync)
 {
-    uint8_t const * buffers[3];
-    uint32_t bufferSizes[3];
+    if (flashfsTransmitBufferUsed() + len > FLASHFS_WRITE_BUFFER_USABLE) {
+        if (sync) {
+            // Write the buffer and then the user's data through to the flash
+            uint32_t dataSize = len;
 
-    // There could be two dirty buffers to write out already:
-    flashfsGetDirtyDataBuffers(buffers, bufferSizes);
-
-    // Plus the buffer the user supplied:
-    buffers[2] = data;
-    bufferSizes[2] = len;
+            flashfsFlushSync();
+            flashfsWriteBuffers(&data, &dataSize, 1, true);
 
-    /*
-     * Would writing this data to our buffer cause our buffer to reach the flush threshold? If so try to write through
-     * to the flash now
-     */
-    if (bufferSizes[0] + bufferSizes[1] + bufferSizes[2] >= FLASHFS_WRITE_BUFFER_AUTO_FLUSH_LEN) {
-        uint32_t bytesWritten;
-
-        // Attempt to write all three buffers through to the flash asynchronously
-        bytesWritten = flashfsWriteBuffers(buffers, bufferSizes, 3, false);
-
-        if (bufferSizes[0] == 0 && bufferSizes[1] == 0) {
-            // We wrote all the data that was previously buffered
-            flashfsClearBuffer();
-
-            if (bufferSizes[2] == 0) {
-                // And we wrote all the data the user supplied! Job done!
-                return;
-            }
-        } else {
-            // We only wrote a portion of the old data, so advance the tail to remove the bytes we did write from the buffer
-            flashfsAdvanceTailInBuffer(bytesWritten);
+            return;
         }
 
-        // Is the remainder of the data to be written too big to fit in the buffers?
-        if (bufferSizes[0] + bufferSizes[1] + bufferSizes[2] > FLASHFS_WRITE_BUFFER_USABLE) {
-            if (sync) {
-                // Write it through synchronously
-                flashfsWriteBuffers(buffers, bufferSizes, 3, true);
-                flashfsClearBuffer();
-            } else {
-                /*
-                 * Silently drop the data the user asked to write (i.e. no-op) since we can't buffer it and they
-                 * requested async.
-                 */
-            }
+        // Make room by writing out the oldest slot if the flash can take it now
+        flashfsFlushAsync(false);
+
+        if (flashfsTransmitBufferUsed() + len > FLASHFS_WRITE_BUFFER_USABLE) {
+            // Drop the data the user asked to write since we can't buffer it and they requested async
+            flashfsStats.droppedBytes += len;
 
             return;
         }
-
-        // Fall through and add the remainder of the incoming data to our buffer
-        data = buffers[2];
-        len = bufferSizes[2];
     }
 
-    // Buffer up the data the user supplied instead of writing it right away
-
     // First write the portion before we wrap around the end of the circular buffer
     unsigned int bufferBytesBeforeWrap = FLASHFS_WRITE_BUFFER_SIZE - bufferHead;
 
@@ -486,6 +490,11 @@ void flashfsWrite(const uint8_t *data, unsigned int len, bool sync)
 
         bufferHead = len;
     }
+
+    flashfsStats.bufferHighWater = MAX(flashfsStats.bufferHighWater, flashfsTransmitBufferUsed());
+
+    // Start programming the slot as soon as it is full
+    flashfsFlushAsync(false);
 }
 
 /**
@@ -590,6 +599,11 @@ bool flashfsIsEOF(void)
     return tailAddress >= flashfsSize;
 }
 
+const flashfsStats_t *flashfsGetStats(void)
+{
+    return &flashfsStats;
+}
+
 void flashfsClose(void)
 {
     switch(flashGeometry->flashType) {
@@ -613,6 +627,8 @@ void flashfsClose(void)
 void flashfsInit(void)
 {
     flashfsSize = 0;
+    memset(&flashfsStats, 0, sizeof(flashfsStats));
+    writeStalled = false;
 
     flashPartition = flashPartitionFindByType(FLASH_PARTITION_TYPE_FLASHFS);
     flashGeometry = flashGetGeometry();
@@ -20,11 +20,20 @@
 
 #pragma once
 
-#define FLASHFS_WRITE_BUFFER_SIZE 128
+#include <stdint.h>
+
+// Writes are staged in slots of this size, aligned in the flash so that a full slot goes out as one page program
+#define FLASHFS_WRITE_BUFFER_SLOT_SIZE 256
+
+// Two slots, one fills while the flash programs the other
+#define FLASHFS_WRITE_BUFFER_SIZE (2 * FLASHFS_WRITE_BUFFER_SLOT_SIZE)
 #define FLASHFS_WRITE_BUFFER_USABLE (FLASHFS_WRITE_BUFFER_SIZE - 1)
 
-// Automatically trigger a flush when this much data is in the buffer
-#define FLASHFS_WRITE_BUFFER_AUTO_FLUSH_LEN 64
+typedef struct flashfsStats_s {
+    uint32_t bufferHighWater;   // Most bytes ever waiting in the write buffer
+    uint32_t stalls;            // Writes held up because the flash was still busy with the previous one
+    uint32_t droppedBytes;      // Bytes of asynchronous writes discarded because they didn't fit in the buffer
+} flashfsStats_t;
 
 void flashfsEraseCompletely(void);
 void flashfsEraseRange(uint32_t start, uint32_t end);
@@ -45,7 +54,7 @@ void flashfsWrite(const uint8_t *data, unsigned int len, bool sync);
 
 int flashfsReadAbs(uint32_t offset, uint8_t *data, unsigned int len);
 
-bool flashfsFlushAsync(void);
+bool flashfsFlushAsync(bool force);
 void flashfsFlushSync(void);
 
 void flashfsClose(void);
@@ -55,5 +64,7 @@ bool flashfsIsSupported(void);
 bool flashfsIsReady(void);
 bool flashfsIsEOF(void);
 
+const flashfsStats_t *flashfsGetStats(void);
+
 bool flashfsVerifyEntireFlash(void);
 
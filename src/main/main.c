@@ -44,7 +44,7 @@ void FAST_CODE FAST_CODE_NOINLINE run(void)
         scheduler();
         processLoopback();
 #ifdef SIMULATOR_BUILD
-        delayMicroseconds_real(50); // max rate 20kHz
+        simulatorLoopWait(); // paces the loop, or steps the simulator in lockstep
 #endif
     }
 }
@@ -107,6 +107,7 @@
 #include "msp/msp_protocol.h"
 #include "msp/msp_protocol_v2_betaflight.h"
 #include "msp/msp_protocol_v2_common.h"
+#include "msp/msp_settings.h"
 #include "msp/msp_serial.h"
 
 #include "osd/osd.h"
@@ -463,10 +464,45 @@ static void serializeDataflashSummaryReply(sbuf_t *dst)
 #ifdef USE_FLASHFS
 enum compressionType_e {
     NO_COMPRESSION,
-    HUFFMAN
+    HUFFMAN,
+    HUFFMAN_ADAPTIVE
 };
 
-static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uint16_t size, bool useLegacyFormat, bool allowCompression)
+#ifdef USE_HUFFMAN
+// An adaptive table is built from the counts of the bytes in this much flash before the address read
+#define DATAFLASH_HUFFMAN_WINDOW_SIZE 4096
+#define DATAFLASH_HUFFMAN_READ_BUFFER_SIZE 256
+
+static const huffmanTable_t *dataflashHuffmanAdaptiveTable(uint32_t address, uint8_t *readBuffer)
+{
+    static huffmanTable_t adaptiveTable[HUFFMAN_TABLE_SIZE];
+    static uint16_t symbolCount[HUFFMAN_TABLE_SIZE];
+
+    memset(symbolCount, 0, sizeof(symbolCount));
+    for (uint32_t windowAddress = address - DATAFLASH_HUFFMAN_WINDOW_SIZE; windowAddress < address; ) {
+        const int bytesRead = flashfsReadAbs(windowAddress, readBuffer, MIN(DATAFLASH_HUFFMAN_READ_BUFFER_SIZE, address - windowAddress));
+        if (bytesRead <= 0) {
+            break;
+        }
+        for (int i = 0; i < bytesRead; i++) {
+            symbolCount[readBuffer[i]]++;
+        }
+        windowAddress += bytesRead;
+    }
+
+    huffmanBuildTable(adaptiveTable, symbolCount);
+
+    return adaptiveTable;
+}
+#endif
+
+/*
+ * A host that asks for HUFFMAN_ADAPTIVE compression gets flash encoded with a table built by huffmanBuildTable()
+ * from the DATAFLASH_HUFFMAN_WINDOW_SIZE bytes of flash before the address, which a host reading the log in order
+ * already has. Near the start of flash, and in firmware without it, the static table is used instead, and the
+ * compression byte of the reply tells which.
+ */
+static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uint16_t size, bool useLegacyFormat, uint8_t requestedCompression)
 {
     STATIC_ASSERT(MSP_PORT_DATAFLASH_INFO_SIZE >= 16, MSP_PORT_DATAFLASH_INFO_SIZE_invalid);
 
@@ -484,11 +520,13 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
     sbufWriteU32(dst, address);
 
     // legacy format does not support compression
+    uint8_t compressionMethod = NO_COMPRESSION;
 #ifdef USE_HUFFMAN
-    const uint8_t compressionMethod = (!allowCompression || useLegacyFormat) ? NO_COMPRESSION : HUFFMAN;
+    if (requestedCompression != NO_COMPRESSION && !useLegacyFormat) {
+        compressionMethod = (requestedCompression == HUFFMAN_ADAPTIVE && address >= DATAFLASH_HUFFMAN_WINDOW_SIZE) ? HUFFMAN_ADAPTIVE : HUFFMAN;
+    }
 #else
-    const uint8_t compressionMethod = NO_COMPRESSION;
-    UNUSED(allowCompression);
+    UNUSED(requestedCompression);
 #endif
 
     if (compressionMethod == NO_COMPRESSION) {
@@ -518,8 +556,8 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
     } else {
 #ifdef USE_HUFFMAN
         // compress in 256-byte chunks
-        const uint16_t READ_BUFFER_SIZE = 256;
-        uint8_t readBuffer[READ_BUFFER_SIZE];
+        uint8_t readBuffer[DATAFLASH_HUFFMAN_READ_BUFFER_SIZE];
+        const huffmanTable_t *table = (compressionMethod == HUFFMAN_ADAPTIVE) ? dataflashHuffmanAdaptiveTable(address, readBuffer) : huffmanTable;
 
         huffmanState_t state = {
             .bytesWritten = 0,
@@ -530,12 +568,13 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
         *state.outByte = 0;
 
         uint16_t bytesReadTotal = 0;
-        // read until output buffer overflows or flash is exhausted
-        while (state.bytesWritten < state.outBufLen && address + bytesReadTotal < flashfsSize) {
+        // read until output buffer overflows, flash is exhausted or the count of bytes read would overflow
+        while (state.bytesWritten < state.outBufLen && address + bytesReadTotal < flashfsSize
+            && bytesReadTotal <= UINT16_MAX - sizeof(readBuffer)) {
             const int bytesRead = flashfsReadAbs(address + bytesReadTotal, readBuffer,
                 MIN(sizeof(readBuffer), flashfsSize - address - bytesReadTotal));
 
-            const int status = huffmanEncodeBufStreaming(&state, readBuffer, bytesRead, huffmanTable);
+            const int status = huffmanEncodeBufStreaming(&state, readBuffer, bytesRead, table);
             if (status == -1) {
                 // overflow
                 break;
@@ -1766,6 +1805,12 @@ static bool mspProcessOutCommand(int16_t cmdMSP, sbuf_t *dst)
 #else
         sbufWriteU8(dst, 0);
 #endif
+#if defined(USE_GYRO_DATA_ANALYSE)
+        // Added in MSP API 1.44
+        sbufWriteU8(dst, gyroConfig()->dyn_notch_count);
+#else
+        sbufWriteU8(dst, 0);
+#endif
 
         break;
     case MSP_PID_ADVANCED:
@@ -2048,6 +2093,55 @@ static mspResult_e mspFcProcessOutCommandWithArg(mspDescriptor_t srcDesc, int16_
         }
         break;
 
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+    case MSP2_TASK_HISTOGRAM:
+        {
+            const uint8_t taskId = sbufBytesRemaining(src) ? sbufReadU8(src) : TASK_GYRO;
+            if (taskId >= TASK_COUNT) {
+                return MSP_RESULT_ERROR;
+            }
+
+            taskInfo_t taskInfo;
+            taskHistogram_t executionTimeHistogram;
+            taskHistogram_t startLatenessHistogram;
+            getTaskInfo(taskId, &taskInfo);
+            getTaskHistograms(taskId, &executionTimeHistogram, &startLatenessHistogram);
+
+            sbufWriteU8(dst, taskId);
+            sbufWriteU8(dst, taskInfo.isEnabled);
+            sbufWriteU8(dst, TASK_HISTOGRAM_BUCKET_COUNT);
+            for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT; i++) {
+                sbufWriteU16(dst, executionTimeHistogram.count[i]);
+            }
+            for (int i = 0; i < TASK_HISTOGRAM_BUCKET_COUNT; i++) {
+                sbufWriteU16(dst, startLatenessHistogram.count[i]);
+            }
+            // p50, p99 and p999 in us
+            sbufWriteU32(dst, taskHistogramPercentileUs(&executionTimeHistogram, 500));
+            sbufWriteU32(dst, taskHistogramPercentileUs(&executionTimeHistogram, 990));
+            sbufWriteU32(dst, taskHistogramPercentileUs(&executionTimeHistogram, 999));
+            sbufWriteU32(dst, taskHistogramPercentileUs(&startLatenessHistogram, 500));
+            sbufWriteU32(dst, taskHistogramPercentileUs(&startLatenessHistogram, 990));
+            sbufWriteU32(dst, taskHistogramPercentileUs(&startLatenessHistogram, 999));
+
+            gyroLateStartInfo_t gyroLateStartInfo;
+            getGyroLateStartInfo(&gyroLateStartInfo);
+            sbufWriteU32(dst, gyroLateStartInfo.startCount);
+            sbufWriteU32(dst, gyroLateStartInfo.lateStartCount);
+            sbufWriteU32(dst, gyroLateStartInfo.maxLateUs);
+        }
+        break;
+#endif
+
+#if defined(USE_MSP_SETTINGS)
+    case MSP2_SETTINGS_INFO:
+        mspSettingsInfo(src, dst);
+        break;
+
+    case MSP2_GET_SETTINGS:
+        return mspSettingsGet(src, dst);
+#endif
+
 #ifdef USE_VTX_TABLE
     case MSP_VTXTABLE_BAND:
         {
@@ -2132,12 +2226,12 @@ static void mspFcDataFlashReadCommand(sbuf_t *dst, sbuf_t *src)
     const unsigned int dataSize = sbufBytesRemaining(src);
     const uint32_t readAddress = sbufReadU32(src);
     uint16_t readLength;
-    bool allowCompression = false;
+    uint8_t requestedCompression = NO_COMPRESSION;
     bool useLegacyFormat;
     if (dataSize >= sizeof(uint32_t) + sizeof(uint16_t)) {
         readLength = sbufReadU16(src);
         if (sbufBytesRemaining(src)) {
-            allowCompression = sbufReadU8(src);
+            requestedCompression = sbufReadU8(src);
         }
         useLegacyFormat = false;
     } else {
@@ -2145,7 +2239,7 @@ static void mspFcDataFlashReadCommand(sbuf_t *dst, sbuf_t *src)
         useLegacyFormat = true;
     }
 
-    serializeDataflashReadReply(dst, readAddress, readLength, useLegacyFormat, allowCompression);
+    serializeDataflashReadReply(dst, readAddress, readLength, useLegacyFormat, requestedCompression);
 }
 #endif
 
@@ -2614,6 +2708,14 @@ static mspResult_e mspProcessInCommand(mspDescriptor_t srcDesc, int16_t cmdMSP,
             sbufReadU8(src);
 #endif
         }
+        if (sbufBytesRemaining(src) >= 1) {
+            // Added in MSP API 1.44
+#if defined(USE_GYRO_DATA_ANALYSE)
+            gyroConfigMutable()->dyn_notch_count = sbufReadU8(src);
+#else
+            sbufReadU8(src);
+#endif
+        }
 
         // reinitialize the gyro filters with the new values
         validateAndFixGyroConfig();
@@ -2987,6 +3089,11 @@ static mspResult_e mspProcessInCommand(mspDescriptor_t srcDesc, int16_t cmdMSP,
         break;
 #endif
 
+#if defined(USE_MSP_SETTINGS)
+    case MSP2_SET_SETTINGS:
+        return mspSettingsSet(src);
+#endif
+
     case MSP2_SET_MOTOR_OUTPUT_REORDERING:
         {
             const uint8_t arraySize = sbufReadU8(src);
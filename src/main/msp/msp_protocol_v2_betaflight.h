@@ -22,4 +22,8 @@
 #define MSP2_MOTOR_OUTPUT_REORDERING        0x3001
 #define MSP2_SET_MOTOR_OUTPUT_REORDERING    0x3002
 #define MSP2_SEND_DSHOT_COMMAND             0x3003
+#define MSP2_TASK_HISTOGRAM                 0x3004
+#define MSP2_SETTINGS_INFO                  0x3005    // out message, layout of the CLI settings, see msp_settings.h
+#define MSP2_GET_SETTINGS                   0x3006    // out message, values of many CLI settings
+#define MSP2_SET_SETTINGS                   0x3007    // in message, sets many CLI settings
 
@@ -98,6 +98,14 @@ void mspSerialReleaseSharedTelemetryPorts(void) {
 }
 #endif
 
+static uint8_t mspSerialChecksumBuf(uint8_t checksum, const uint8_t *data, int len)
+{
+    while (len-- > 0) {
+        checksum ^= *data++;
+    }
+    return checksum;
+}
+
 static bool mspSerialProcessReceivedData(mspPort_t *mspPort, uint8_t c)
 {
     switch (mspPort->c_state) {
@@ -244,11 +252,15 @@ static bool mspSerialProcessReceivedData(mspPort_t *mspPort, uint8_t c)
             mspPort->checksum2 = crc8_dvb_s2(mspPort->checksum2, c);
             if (mspPort->offset == sizeof(mspHeaderV2_t)) {
                 mspHeaderV2_t * hdrv2 = (mspHeaderV2_t *)&mspPort->inBuf[0];
-                mspPort->dataSize = hdrv2->size;
-                mspPort->cmdMSP = hdrv2->cmd;
-                mspPort->cmdFlags = hdrv2->flags;
-                mspPort->offset = 0;                // re-use buffer
-                mspPort->c_state = mspPort->dataSize > 0 ? MSP_PAYLOAD_V2_NATIVE : MSP_CHECKSUM_V2_NATIVE;
+                if (hdrv2->size > MSP_PORT_INBUF_SIZE) {
+                    mspPort->c_state = MSP_IDLE;
+                } else {
+                    mspPort->dataSize = hdrv2->size;
+                    mspPort->cmdMSP = hdrv2->cmd;
+                    mspPort->cmdFlags = hdrv2->flags;
+                    mspPort->offset = 0;                // re-use buffer
+                    mspPort->c_state = mspPort->dataSize > 0 ? MSP_PAYLOAD_V2_NATIVE : MSP_CHECKSUM_V2_NATIVE;
+                }
             }
             break;
 
@@ -273,12 +285,50 @@ static bool mspSerialProcessReceivedData(mspPort_t *mspPort, uint8_t c)
     return true;
 }
 
-static uint8_t mspSerialChecksumBuf(uint8_t checksum, const uint8_t *data, int len)
+// Once the header has been parsed the payload size is known, so take as much of it as has arrived in one read
+static void mspSerialReceivePayload(mspPort_t *mspPort)
 {
-    while (len-- > 0) {
-        checksum ^= *data++;
+    uint8_t *payload = &mspPort->inBuf[mspPort->offset];
+    const uint32_t count = serialReadBuf(mspPort->port, payload, mspPort->dataSize - mspPort->offset);
+
+    switch (mspPort->c_state) {
+        case MSP_PAYLOAD_V1:
+            mspPort->checksum1 = mspSerialChecksumBuf(mspPort->checksum1, payload, count);
+            break;
+
+        case MSP_PAYLOAD_V2_OVER_V1:
+            mspPort->checksum1 = mspSerialChecksumBuf(mspPort->checksum1, payload, count);
+            mspPort->checksum2 = crc8_dvb_s2_update(mspPort->checksum2, payload, count);
+            break;
+
+        default:
+            mspPort->checksum2 = crc8_dvb_s2_update(mspPort->checksum2, payload, count);
+            break;
+    }
+
+    mspPort->offset += count;
+    if (mspPort->offset == mspPort->dataSize) {
+        switch (mspPort->c_state) {
+            case MSP_PAYLOAD_V1:
+                mspPort->c_state = MSP_CHECKSUM_V1;
+                break;
+
+            case MSP_PAYLOAD_V2_OVER_V1:
+                mspPort->c_state = MSP_CHECKSUM_V2_OVER_V1;
+                break;
+
+            default:
+                mspPort->c_state = MSP_CHECKSUM_V2_NATIVE;
+                break;
+        }
     }
-    return checksum;
+}
+
+static bool mspSerialReceivingPayload(const mspPort_t *mspPort)
+{
+    return mspPort->c_state == MSP_PAYLOAD_V1
+        || mspPort->c_state == MSP_PAYLOAD_V2_OVER_V1
+        || mspPort->c_state == MSP_PAYLOAD_V2_NATIVE;
 }
 
 #define JUMBO_FRAME_SIZE_LIMIT 255
@@ -293,6 +343,8 @@ static int mspSerialSendFrame(mspPort_t *msp, const uint8_t * hdr, int hdrLen, c
         return 0;
     }
 
+    msp->jumboFrameSent = totalFrameLength > JUMBO_FRAME_SIZE_LIMIT;
+
     // Transmit frame
     serialBeginWrite(msp->port);
     serialWriteBuf(msp->port, hdr, hdrLen);
@@ -483,6 +535,11 @@ static void mspSerialProcessReceivedReply(mspPort_t *msp, mspProcessReplyFnPtr m
     msp->c_state = MSP_IDLE;
 }
 
+static bool mspSerialTransmitting(mspPort_t *mspPort)
+{
+    return mspPort->jumboFrameSent && !isSerialTransmitBufferEmpty(mspPort->port);
+}
+
 /*
  * Process MSP commands from serial ports configured as MSP ports.
  *
@@ -498,12 +555,23 @@ void mspSerialProcess(mspEvaluateNonMspData_e evaluateNonMspData, mspProcessComm
 
         mspPostProcessFnPtr mspPostProcessFn = NULL;
 
+        if (mspSerialTransmitting(mspPort)) {
+            // Leave the next command waiting until a large reply has gone, as its reply may need the whole transmit
+            // buffer too. This lets a host keep several dataflash reads outstanding without replies being dropped.
+            continue;
+        }
+
         if (serialRxBytesWaiting(mspPort->port)) {
             // There are bytes incoming - abort pending request
             mspPort->lastActivityMs = millis();
             mspPort->pendingRequest = MSP_PENDING_NONE;
 
             while (serialRxBytesWaiting(mspPort->port)) {
+                if (mspSerialReceivingPayload(mspPort)) {
+                    mspSerialReceivePayload(mspPort);
+                    continue;
+                }
+
                 const uint8_t c = serialRead(mspPort->port);
                 const bool consumed = mspSerialProcessReceivedData(mspPort, c);
 
@@ -541,7 +609,7 @@ bool mspSerialWaiting(void)
             continue;
         }
 
-        if (serialRxBytesWaiting(mspPort->port)) {
+        if (serialRxBytesWaiting(mspPort->port) && !mspSerialTransmitting(mspPort)) {
             return true;
         }
     }
@@ -113,6 +113,7 @@ typedef struct mspPort_s {
     uint8_t checksum1;
     uint8_t checksum2;
     bool sharedWithTelemetry;
+    bool jumboFrameSent;        // the last frame was too large to queue behind another one
     mspDescriptor_t descriptor;
 } mspPort_t;
 
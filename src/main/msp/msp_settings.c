@@ -0,0 +1,324 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_MSP_SETTINGS
+
+#include "cli/settings.h"
+#include "cli/settings_index.h"
+
+#include "common/streambuf.h"
+
+#include "config/config.h"
+
+#include "fc/controlrate_profile.h"
+#include "fc/rc.h"
+#include "fc/runtime_config.h"
+
+#include "flight/pid.h"
+
+#include "pg/pg.h"
+
+#include "msp_settings.h"
+
+static uint8_t settingTypeSize(const clivalue_t *value)
+{
+    switch (value->type & VALUE_TYPE_MASK) {
+    case VAR_UINT16:
+    case VAR_INT16:
+        return 2;
+    case VAR_UINT32:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+static uint8_t settingValueSize(const clivalue_t *value)
+{
+    switch (value->type & VALUE_MODE_MASK) {
+    case MODE_ARRAY:
+        return settingTypeSize(value) * value->config.array.length;
+    case MODE_STRING:
+        return value->config.string.maxlength;
+    case MODE_BITSET:
+        return 1;
+    default:
+        return settingTypeSize(value);
+    }
+}
+
+static uint8_t *settingPointer(const clivalue_t *value)
+{
+    const pgRegistry_t *pg = pgFind(value->pgn);
+    if (!pg) {
+        return NULL;
+    }
+
+    unsigned offset = value->offset;
+    switch (value->type & VALUE_SECTION_MASK) {
+    case PROFILE_VALUE:
+        offset += sizeof(pidProfile_t) * getCurrentPidProfileIndex();
+        break;
+    case PROFILE_RATE_VALUE:
+        offset += sizeof(controlRateConfig_t) * getCurrentControlRateProfileIndex();
+        break;
+    }
+    return pg->address + offset;
+}
+
+static uint32_t settingBitMask(const clivalue_t *value)
+{
+    return 1u << value->config.bitpos;
+}
+
+static uint32_t readUnsigned(const uint8_t *data, uint8_t size)
+{
+    uint32_t result = 0;
+    for (int i = size - 1; i >= 0; i--) {
+        result = (result << 8) | data[i];
+    }
+    return result;
+}
+
+static int32_t readSigned(const uint8_t *data, uint8_t size)
+{
+    const uint32_t shift = 32 - 8 * size;
+    return (int32_t)(readUnsigned(data, size) << shift) >> shift;
+}
+
+static void writeSetting(sbuf_t *dst, const clivalue_t *value, const uint8_t *ptr)
+{
+    if ((value->type & VALUE_MODE_MASK) == MODE_BITSET) {
+        sbufWriteU8(dst, (readUnsigned(ptr, settingTypeSize(value)) & settingBitMask(value)) ? 1 : 0);
+    } else {
+        sbufWriteData(dst, ptr, settingValueSize(value));
+    }
+}
+
+static unsigned stringLength(const uint8_t *data, unsigned maxLength)
+{
+    unsigned length = 0;
+    while (length < maxLength && data[length]) {
+        length++;
+    }
+    return length;
+}
+
+static bool isSettingValueValid(const clivalue_t *value, const uint8_t *ptr, const uint8_t *data)
+{
+    const uint8_t size = settingTypeSize(value);
+
+    switch (value->type & VALUE_MODE_MASK) {
+    case MODE_DIRECT:
+        switch (value->type & VALUE_TYPE_MASK) {
+        case VAR_UINT32:
+            return readUnsigned(data, size) <= value->config.u32Max;
+        case VAR_UINT8:
+        case VAR_UINT16:
+            return readUnsigned(data, size) >= value->config.minmaxUnsigned.min && readUnsigned(data, size) <= value->config.minmaxUnsigned.max;
+        default:
+            return readSigned(data, size) >= value->config.minmax.min && readSigned(data, size) <= value->config.minmax.max;
+        }
+    case MODE_LOOKUP: {
+            const int32_t index = (value->type & VALUE_TYPE_MASK) == VAR_INT8 ? readSigned(data, size) : (int32_t)readUnsigned(data, size);
+            return index >= 0 && index < lookupTables[value->config.lookup.tableIndex].valueCount;
+        }
+    case MODE_BITSET:
+        return data[0] <= 1;
+    case MODE_STRING: {
+            const uint8_t maxLength = value->config.string.maxlength;
+            const unsigned length = stringLength(data, maxLength);
+            const bool updatable = (value->config.string.flags & STRING_FLAGS_WRITEONCE) == 0
+                || stringLength(ptr, maxLength) == 0
+                || strncmp((const char *)data, (const char *)ptr, maxLength) == 0;
+            return updatable && (length == 0 || length >= value->config.string.minlength);
+        }
+    default:
+        return true;
+    }
+}
+
+static void storeSetting(const clivalue_t *value, uint8_t *ptr, const uint8_t *data)
+{
+    switch (value->type & VALUE_MODE_MASK) {
+    case MODE_BITSET: {
+            const uint8_t size = settingTypeSize(value);
+            uint32_t bits = readUnsigned(ptr, size);
+            if (data[0]) {
+                bits |= settingBitMask(value);
+            } else {
+                bits &= ~settingBitMask(value);
+            }
+            memcpy(ptr, &bits, size);
+        }
+        break;
+    case MODE_STRING: {
+            const uint8_t maxLength = value->config.string.maxlength;
+            memset(ptr, 0, maxLength);
+            strncpy((char *)ptr, (const char *)data, maxLength);
+        }
+        break;
+    default:
+        memcpy(ptr, data, settingValueSize(value));
+        break;
+    }
+}
+
+// Reads the schema hash and addressing of a request, fails if the client's picture of the table is out of date
+static bool readSettingsHeader(sbuf_t *src, uint8_t *addressing)
+{
+    if (sbufBytesRemaining(src) < 5) {
+        return false;
+    }
+    const uint32_t schemaHash = sbufReadU32(src);
+    *addressing = sbufReadU8(src);
+
+    return (schemaHash == 0 || schemaHash == settingsSchemaHash())
+        && (*addressing == MSP_SETTINGS_BY_INDEX || *addressing == MSP_SETTINGS_BY_HASH);
+}
+
+// Returns valueTableEntryCount when the setting is unknown or the request is cut short
+static uint16_t readSettingIndex(sbuf_t *src, uint8_t addressing)
+{
+    uint16_t index = valueTableEntryCount;
+    if (addressing == MSP_SETTINGS_BY_INDEX && sbufBytesRemaining(src) >= 2) {
+        index = sbufReadU16(src);
+    } else if (addressing == MSP_SETTINGS_BY_HASH && sbufBytesRemaining(src) >= 4) {
+        index = settingIndexByHash(sbufReadU32(src));
+    }
+    return index < valueTableEntryCount ? index : valueTableEntryCount;
+}
+
+void mspSettingsInfo(sbuf_t *src, sbuf_t *dst)
+{
+    const uint16_t firstIndex = sbufBytesRemaining(src) >= 2 ? sbufReadU16(src) : 0;
+
+    sbufWriteU32(dst, settingsSchemaHash());
+    sbufWriteU16(dst, valueTableEntryCount);
+    sbufWriteU16(dst, firstIndex);
+    uint8_t *countPtr = sbufPtr(dst);
+    sbufWriteU8(dst, 0);
+
+    uint8_t count = 0;
+    for (uint32_t i = firstIndex; i < valueTableEntryCount && count < UINT8_MAX; i++) {
+        const clivalue_t *value = &valueTable[i];
+        const uint8_t nameLength = strlen(value->name);
+        if (sbufBytesRemaining(dst) < 3 + nameLength) {
+            break;
+        }
+        sbufWriteU8(dst, value->type);
+        sbufWriteU8(dst, settingValueSize(value));
+        sbufWriteU8(dst, nameLength);
+        sbufWriteData(dst, value->name, nameLength);
+        count++;
+    }
+    *countPtr = count;
+}
+
+mspResult_e mspSettingsGet(sbuf_t *src, sbuf_t *dst)
+{
+    uint8_t addressing;
+    if (!readSettingsHeader(src, &addressing)) {
+        return MSP_RESULT_ERROR;
+    }
+
+    sbufWriteU32(dst, settingsSchemaHash());
+    uint8_t *countPtr = sbufPtr(dst);
+    sbufWriteU8(dst, 0);
+
+    uint8_t count = 0;
+    while (sbufBytesRemaining(src) && count < UINT8_MAX) {
+        // only consume the request once the reply has room for it, the client asks again for the rest
+        sbuf_t item = *src;
+        const uint16_t index = readSettingIndex(&item, addressing);
+        const clivalue_t *value = index < valueTableEntryCount ? &valueTable[index] : NULL;
+        const uint8_t *ptr = value ? settingPointer(value) : NULL;
+        const uint8_t size = ptr ? settingValueSize(value) : 0;
+
+        if (sbufBytesRemaining(dst) < 3 + size) {
+            break;
+        }
+        *src = item;
+        sbufWriteU16(dst, ptr ? index : MSP_SETTING_UNKNOWN);
+        sbufWriteU8(dst, size);
+        if (ptr) {
+            writeSetting(dst, value, ptr);
+        }
+        count++;
+    }
+    *countPtr = count;
+
+    return MSP_RESULT_ACK;
+}
+
+mspResult_e mspSettingsSet(sbuf_t *src)
+{
+    // the values are written to the live configuration, which the flight code may be using
+    if (ARMING_FLAG(ARMED)) {
+        return MSP_RESULT_ERROR;
+    }
+
+    uint8_t addressing;
+    if (!readSettingsHeader(src, &addressing)) {
+        return MSP_RESULT_ERROR;
+    }
+
+    // check everything before changing anything, so that a rejected frame leaves the configuration as it was
+    bool rateProfileChanged = false;
+    for (int pass = 0; pass < 2; pass++) {
+        sbuf_t items = *src;
+        while (sbufBytesRemaining(&items)) {
+            const uint16_t index = readSettingIndex(&items, addressing);
+            if (index >= valueTableEntryCount || sbufBytesRemaining(&items) < 1) {
+                return MSP_RESULT_ERROR;
+            }
+            const clivalue_t *value = &valueTable[index];
+            uint8_t *ptr = settingPointer(value);
+            const uint8_t size = sbufReadU8(&items);
+            if (!ptr || size != settingValueSize(value) || sbufBytesRemaining(&items) < size) {
+                return MSP_RESULT_ERROR;
+            }
+
+            const uint8_t *data = sbufPtr(&items);
+            if (pass == 0 && !isSettingValueValid(value, ptr, data)) {
+                return MSP_RESULT_ERROR;
+            }
+            if (pass == 1) {
+                storeSetting(value, ptr, data);
+                rateProfileChanged |= (value->type & VALUE_SECTION_MASK) == PROFILE_RATE_VALUE;
+            }
+            sbufAdvance(&items, size);
+        }
+    }
+
+    // the rates curves are tabulated, as for MSP_SET_RC_TUNING they follow the new values straight away
+    if (rateProfileChanged) {
+        initRcProcessing();
+    }
+
+    return MSP_RESULT_ACK;
+}
+#endif
@@ -0,0 +1,60 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/streambuf.h"
+
+#include "msp/msp.h"
+
+// Binary access to the CLI settings (valueTable), many settings per frame.
+//
+// A setting is addressed by its index in valueTable or by settingNameHash() of its name. Indices
+// change between firmware builds, every request and reply carries settingsSchemaHash() so that a
+// client can tell whether the indices, types and sizes it cached still apply. Requests with a
+// schema hash of 0 skip the check. Settings of the pid and rate profiles refer to the current profile.
+//
+// Values are little endian in the size of their type, arrays are sent element by element,
+// strings as their maximum length padded with 0, bits of a bitset as a byte of 0 or 1.
+
+#define MSP_SETTINGS_BY_INDEX 0     // settings addressed by uint16 valueTable index
+#define MSP_SETTINGS_BY_HASH  1     // settings addressed by uint32 name hash
+
+#define MSP_SETTING_UNKNOWN   0xffff
+
+// MSP2_SETTINGS_INFO
+//  in:  [uint16 first index]
+//  out: uint32 schema hash, uint16 setting count, uint16 first index, uint8 n,
+//       n * { uint8 type, uint8 value size, uint8 name length, name }
+void mspSettingsInfo(sbuf_t *src, sbuf_t *dst);
+
+// MSP2_GET_SETTINGS
+//  in:  uint32 schema hash, uint8 addressing, index or hash of each setting
+//  out: uint32 schema hash, uint8 n, n * { uint16 index, uint8 value size, value }
+//       n is less than asked for when the reply is full, unknown settings have index MSP_SETTING_UNKNOWN
+mspResult_e mspSettingsGet(sbuf_t *src, sbuf_t *dst);
+
+// MSP2_SET_SETTINGS
+//  in:  uint32 schema hash, uint8 addressing, n * { index or hash, uint8 value size, value }
+//  Sets all of them, or none when any is unknown or out of range, and fails while armed.
+//  Rate profile settings take effect straight away, as with MSP_SET_RC_TUNING. For the others,
+//  like CLI set, the inits that use a setting are not re-run: save with MSP_EEPROM_WRITE and
+//  reboot for the new values to take effect.
+mspResult_e mspSettingsSet(sbuf_t *src);
@@ -87,6 +87,8 @@
 #include "rx/crsf.h"
 #include "rx/rx.h"
 
+#include "scheduler/scheduler.h"
+
 #include "sensors/acceleration.h"
 #include "sensors/battery.h"
 #include "sensors/esc_sensor.h"
@@ -139,6 +141,18 @@ static uint8_t osdStatsRowCount = 0;
 
 static bool backgroundLayerSupported = false;
 
+// Without a background layer the elements only write what changed since the last pass, so the screen is
+// cleared when something else has been drawn on it, and now and then in case the display lost what it had
+#define OSD_FULL_REDRAW_INTERVAL_US REFRESH_1S
+static bool osdElementsOnScreen = false;
+static timeUs_t osdFullRedrawAtUs = 0;
+
+STATIC_UNIT_TESTED osdDrawState_e osdDrawState = OSD_DRAW_IDLE;
+static timeUs_t osdDrawStopAtUs;
+static osdDrawSliceInfo_t osdDrawSliceInfo;
+static int osdStatsDrawIndex;
+static uint8_t osdStatsDrawRow;
+
 #ifdef USE_ESC_SENSOR
 escSensorData_t *osdEscDataCombined;
 #endif
@@ -250,25 +264,56 @@ void osdAnalyzeActiveElements(void)
     osdDrawActiveElementsBackground(osdDisplayPort);
 }
 
-static void osdDrawElements(timeUs_t currentTimeUs)
+static void osdDrawSliceStart(timeUs_t currentTimeUs)
+{
+    const timeDelta_t budgetUs = getTaskTimeBudgetUs();
+
+    osdDrawStopAtUs = currentTimeUs + budgetUs;
+    osdDrawSliceInfo.budgetUs = budgetUs;
+    osdDrawSliceInfo.sliceCount++;
+}
+
+static void osdDrawSliceEnd(void)
+{
+    if (cmpTimeUs(micros(), osdDrawStopAtUs) > 0) {
+        osdDrawSliceInfo.overBudgetCount++;
+    }
+}
+
+void osdGetDrawSliceInfo(osdDrawSliceInfo_t *info)
+{
+    *info = osdDrawSliceInfo;
+}
+
+// Returns true once all the elements have been drawn
+static bool osdDrawElements(timeUs_t currentTimeUs)
 {
     // Hide OSD when OSDSW mode is active
     if (IS_RC_MODE_ACTIVE(BOXOSD)) {
         displayClearScreen(osdDisplayPort);
-        return;
+        osdElementsOnScreen = false;
+        return true;
     }
 
     if (backgroundLayerSupported) {
         // Background layer is supported, overlay it onto the foreground
         // so that we only need to draw the active parts of the elements.
         displayLayerCopy(osdDisplayPort, DISPLAYPORT_LAYER_FOREGROUND, DISPLAYPORT_LAYER_BACKGROUND);
-    } else {
-        // Background layer not supported, just clear the foreground in preparation
-        // for drawing the elements including their backgrounds.
+    } else if (!osdElementsOnScreen || !osdElementsOnlyWriteChanges(osdDisplayPort) || cmpTimeUs(currentTimeUs, osdFullRedrawAtUs) >= 0) {
+        // Background layer not supported, clear the foreground so that the elements
+        // including their backgrounds are all drawn again.
         displayClearScreen(osdDisplayPort);
+        osdFullRedrawAtUs = currentTimeUs + OSD_FULL_REDRAW_INTERVAL_US;
+    }
+
+    osdStartDrawActiveElements(osdDisplayPort, currentTimeUs);
+    if (!osdDrawActiveElements(osdDisplayPort, osdDrawStopAtUs)) {
+        osdDrawState = OSD_DRAW_ELEMENTS;
+        return false;
     }
+    osdElementsOnScreen = true;
 
-    osdDrawActiveElements(osdDisplayPort, currentTimeUs);
+    return true;
 }
 
 const uint16_t osdTimerDefault[OSD_TIMER_COUNT] = {
@@ -824,7 +869,7 @@ static bool osdDisplayStat(int statistic, uint8_t displayRow)
     return false;
 }
 
-static uint8_t osdShowStats(int statsRowCount)
+static void osdStartShowStats(int statsRowCount)
 {
     uint8_t top = 0;
     bool displayLabel = false;
@@ -844,28 +889,55 @@ static uint8_t osdShowStats(int statsRowCount)
         displayWrite(osdDisplayPort, 2, top++, DISPLAYPORT_ATTR_NONE, "  --- STATS ---");
     }
 
-    for (int i = 0; i < OSD_STAT_COUNT; i++) {
-        if (osdStatGetState(osdStatsDisplayOrder[i])) {
-            if (osdDisplayStat(osdStatsDisplayOrder[i], top)) {
-                top++;
+    osdStatsDrawIndex = 0;
+    osdStatsDrawRow = top;
+}
+
+// Draws the stats from where the last call stopped, until the time for this call runs out.
+// Returns true once all the stats have been drawn, osdStatsDrawRow is then the row after the last one.
+static bool osdShowStats(void)
+{
+    while (osdStatsDrawIndex < OSD_STAT_COUNT) {
+        const int statistic = osdStatsDisplayOrder[osdStatsDrawIndex++];
+        if (osdStatGetState(statistic) && osdDisplayStat(statistic, osdStatsDrawRow)) {
+            osdStatsDrawRow++;
+            if (osdStatsDrawIndex < OSD_STAT_COUNT && cmpTimeUs(micros(), osdDrawStopAtUs) >= 0) {
+                return false;
             }
         }
     }
-    return top;
+
+    return true;
 }
 
-static void osdRefreshStats(void)
+static void osdDrawStats(void)
 {
-    displayClearScreen(osdDisplayPort);
+    if (!osdShowStats()) {
+        return;
+    }
+
     if (osdStatsRowCount == 0) {
-        // No stats row count has been set yet.
-        // Go through the logic one time to determine how many stats are actually displayed.
-        osdStatsRowCount = osdShowStats(0);
+        // That was the pass to determine how many stats are actually displayed.
         // Then clear the screen and commence with normal stats display which will
         // determine if the heading should be displayed and also center the content vertically.
+        osdStatsRowCount = osdStatsDrawRow;
         displayClearScreen(osdDisplayPort);
+        osdStartShowStats(osdStatsRowCount);
+        if (!osdShowStats()) {
+            return;
+        }
     }
-    osdShowStats(osdStatsRowCount);
+
+    osdDrawState = OSD_DRAW_IDLE;
+}
+
+static void osdRefreshStats(void)
+{
+    displayClearScreen(osdDisplayPort);
+    // If no stats row count has been set yet, go through the logic one time to determine it first
+    osdStartShowStats(osdStatsRowCount);
+    osdDrawState = OSD_DRAW_STATS;
+    osdDrawStats();
 }
 
 static timeDelta_t osdShowArmed(void)
@@ -892,6 +964,8 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
     static bool osdStatsVisible = false;
     static timeUs_t osdStatsRefreshTimeUs;
 
+    osdDrawSliceStart(currentTimeUs);
+
     // detect arm/disarm
     if (armState != ARMING_FLAG(ARMED)) {
         if (ARMING_FLAG(ARMED)) {
@@ -950,6 +1024,7 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
                 resumeRefreshAt = currentTimeUs;
             }
             displayHeartbeat(osdDisplayPort);
+            osdElementsOnScreen = false;
             return;
         } else {
             displayClearScreen(osdDisplayPort);
@@ -978,16 +1053,54 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
 #endif
 
 #ifdef USE_CMS
-    if (!displayIsGrabbed(osdDisplayPort))
+    if (displayIsGrabbed(osdDisplayPort)) {
+        osdElementsOnScreen = false;
+    } else
 #endif
     {
         osdUpdateAlarms();
-        osdDrawElements(currentTimeUs);
+        if (!osdDrawElements(currentTimeUs)) {
+            // The rest of the elements are drawn and the transaction committed by osdDrawContinue()
+            return;
+        }
         displayHeartbeat(osdDisplayPort);
     }
     displayCommitTransaction(osdDisplayPort);
 }
 
+static void osdDrawContinue(void)
+{
+#ifdef USE_CMS
+    if (displayIsGrabbed(osdDisplayPort)) {
+        // The CMS has taken the display over part way through
+        if (osdDrawState == OSD_DRAW_ELEMENTS) {
+            osdElementsOnScreen = false;
+            displayCommitTransaction(osdDisplayPort);
+        }
+        osdDrawState = OSD_DRAW_IDLE;
+        return;
+    }
+#endif
+
+    switch (osdDrawState) {
+    case OSD_DRAW_ELEMENTS:
+        if (osdDrawActiveElements(osdDisplayPort, osdDrawStopAtUs)) {
+            osdDrawState = OSD_DRAW_IDLE;
+            osdElementsOnScreen = true;
+            displayHeartbeat(osdDisplayPort);
+            displayCommitTransaction(osdDisplayPort);
+        }
+        break;
+
+    case OSD_DRAW_STATS:
+        osdDrawStats();
+        break;
+
+    default:
+        break;
+    }
+}
+
 /*
  * Called periodically by the scheduler
  */
@@ -1030,8 +1143,14 @@ void osdUpdate(timeUs_t currentTimeUs)
 #define DRAW_FREQ_DENOM 10 // MWOSD @ 115200 baud (
 #endif
 
-    if (counter % DRAW_FREQ_DENOM == 0) {
+    if (osdDrawState != OSD_DRAW_IDLE) {
+        // Carry on from where the last call ran out of time, the screen isn't drawn until everything is there
+        osdDrawSliceStart(currentTimeUs);
+        osdDrawContinue();
+        osdDrawSliceEnd();
+    } else if (counter % DRAW_FREQ_DENOM == 0) {
         osdRefresh(currentTimeUs);
+        osdDrawSliceEnd();
         showVisualBeeper = false;
     } else {
         bool doDrawScreen = true;
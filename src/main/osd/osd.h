@@ -324,6 +324,20 @@ extern float osdGForce;
 extern escSensorData_t *osdEscDataCombined;
 #endif
 
+// Drawing the elements or the stats can be split across several calls, each stopping once the time
+// the scheduler has before the next gyro sample runs out, and carrying on from there on the next call
+typedef enum {
+    OSD_DRAW_IDLE,
+    OSD_DRAW_ELEMENTS,
+    OSD_DRAW_STATS,
+} osdDrawState_e;
+
+typedef struct osdDrawSliceInfo_s {
+    timeDelta_t budgetUs;       // time the scheduler gave the last call that drew something
+    uint32_t sliceCount;        // calls that drew something
+    uint32_t overBudgetCount;   // calls that took longer than they were given
+} osdDrawSliceInfo_t;
+
 void osdInit(displayPort_t *osdDisplayPort, osdDisplayPortDevice_e displayPortDevice);
 void osdUpdate(timeUs_t currentTimeUs);
 
@@ -341,3 +355,4 @@ bool osdElementVisible(uint16_t value);
 bool osdGetVisualBeeperState(void);
 statistic_t *osdGetStats(void);
 bool osdNeedsAccelerometer(void);
+void osdGetDrawSliceInfo(osdDrawSliceInfo_t *info);
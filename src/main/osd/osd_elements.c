@@ -175,6 +175,7 @@ static const char compassBar[] = {
 
 static unsigned activeOsdElementCount = 0;
 static uint8_t activeOsdElementArray[OSD_ITEM_COUNT];
+static unsigned activeOsdElementDrawIndex = 0;   // next element to draw when a pass is split across several calls
 static bool backgroundLayerSupported = false;
 
 // Blink control
@@ -185,12 +186,137 @@ static uint32_t blinkBits[(OSD_ITEM_COUNT + 31) / 32];
 #define IS_BLINK(item) (blinkBits[(item) / 32] & (1 << ((item) % 32)))
 #define BLINK(item) (IS_BLINK(item) && blinkState)
 
+// Only the OSD displays without a background layer, MSP displayport and FrSky OSD, draw through osdScreen
+#if defined(USE_MSP_DISPLAYPORT) || defined(USE_FRSKYOSD)
+#define USE_OSD_SCREEN_BUFFER
+#endif
+
+#ifdef USE_OSD_SCREEN_BUFFER
+// Without a background layer the elements are drawn into osdScreen, and only the characters that differ from
+// what was drawn on the last pass are written to the display. Each write is sent on as a message by displays
+// such as MSP, and the values shown by most elements change far less often than the OSD is refreshed.
+// Cells for the PAL grid, a display reporting a larger grid has its elements written directly
+#define OSD_SCREEN_CELLS (16 * 30)
+// Unchanged characters between two changes are written again rather than starting a new write when the gap
+// is shorter than the overhead of a write
+#define OSD_SCREEN_WRITE_GAP 4
+
+typedef struct osdScreenCell_s {
+    uint8_t c;
+    uint8_t attr;
+} osdScreenCell_t;
+
+// Row major, osdScreenCols wide
+static osdScreenCell_t osdScreen[OSD_SCREEN_CELLS];
+static osdScreenCell_t osdScreenDrawn[OSD_SCREEN_CELLS];
+static uint8_t osdScreenRows;
+static uint8_t osdScreenCols;
+#endif
+static bool osdScreenBuffered = false;
+
+#ifdef USE_OSD_SCREEN_BUFFER
+static void osdScreenClear(osdScreenCell_t *screen)
+{
+    for (unsigned i = 0; i < OSD_SCREEN_CELLS; i++) {
+        screen[i].c = ' ';
+        screen[i].attr = DISPLAYPORT_ATTR_NONE;
+    }
+}
+
+static void osdScreenBegin(displayPort_t *osdDisplayPort)
+{
+    if (osdDisplayPort->rows != osdScreenRows || osdDisplayPort->cols != osdScreenCols) {
+        // The grid has changed, as when a FrSky OSD reports its size, so the cells no longer line up
+        osdScreenRows = osdDisplayPort->rows;
+        osdScreenCols = osdDisplayPort->cols;
+        displayClearScreen(osdDisplayPort);
+    }
+    if (osdDisplayPort->cleared) {
+        // Cleared since the last pass, so everything drawn must be written again
+        osdScreenClear(osdScreenDrawn);
+        osdDisplayPort->cleared = false;
+    }
+    osdScreenClear(osdScreen);
+}
+
+static int osdScreenWrite(uint8_t x, uint8_t y, uint8_t attr, const char *s)
+{
+    if (y < osdScreenRows) {
+        for (; *s && x < osdScreenCols; s++, x++) {
+            osdScreen[y * osdScreenCols + x].c = *s;
+            osdScreen[y * osdScreenCols + x].attr = attr;
+        }
+    }
+
+    return 0;
+}
+
+static bool osdScreenCellChanged(unsigned i)
+{
+    return osdScreen[i].c != osdScreenDrawn[i].c || osdScreen[i].attr != osdScreenDrawn[i].attr;
+}
+
+static void osdScreenFlush(displayPort_t *osdDisplayPort)
+{
+    char buff[OSD_ELEMENT_BUFFER_LENGTH];
+
+    for (unsigned y = 0; y < osdScreenRows; y++) {
+        const unsigned rowStart = y * osdScreenCols;
+        const osdScreenCell_t *row = &osdScreen[rowStart];
+        unsigned x = 0;
+        while (x < osdScreenCols) {
+            if (!osdScreenCellChanged(rowStart + x)) {
+                x++;
+                continue;
+            }
+
+            // Write a run of changes with the same attributes at once
+            const unsigned start = x;
+            const uint8_t attr = row[start].attr;
+            const unsigned maxEnd = MIN(osdScreenCols, start + sizeof(buff) - 1);
+            unsigned end = start + 1;
+            for (unsigned next = end; next < maxEnd && next - end < OSD_SCREEN_WRITE_GAP && row[next].attr == attr; next++) {
+                if (osdScreenCellChanged(rowStart + next)) {
+                    end = next + 1;
+                }
+            }
+
+            for (x = start; x < end; x++) {
+                buff[x - start] = row[x].c;
+                osdScreenDrawn[rowStart + x] = row[x];
+            }
+            buff[end - start] = '\0';
+
+            displayWrite(osdDisplayPort, start, y, attr, buff);
+        }
+    }
+}
+#endif // USE_OSD_SCREEN_BUFFER
+
+// True when the elements are drawn through osdScreen, which only writes the characters that changed since
+// the last pass, so the caller need not clear the screen before each pass
+bool osdElementsOnlyWriteChanges(const displayPort_t *osdDisplayPort)
+{
+#ifdef USE_OSD_SCREEN_BUFFER
+    return !backgroundLayerSupported && osdDisplayPort->rows * osdDisplayPort->cols <= OSD_SCREEN_CELLS;
+#else
+    UNUSED(osdDisplayPort);
+    return false;
+#endif
+}
+
 static int osdDisplayWrite(osdElementParms_t *element, uint8_t x, uint8_t y, uint8_t attr, const char *s)
 {
     if (IS_BLINK(element->item)) {
         attr |= DISPLAYPORT_ATTR_BLINK;
     }
 
+#ifdef USE_OSD_SCREEN_BUFFER
+    if (osdScreenBuffered) {
+        return osdScreenWrite(x, y, attr, s);
+    }
+#endif
+
     return displayWrite(element->osdDisplayPort, x, y, attr, s);
 }
 
@@ -1779,6 +1905,13 @@ static void osdAddActiveElement(osd_items_e element)
 void osdAddActiveElements(void)
 {
     activeOsdElementCount = 0;
+    activeOsdElementDrawIndex = 0;
+#ifdef USE_OSD_SCREEN_BUFFER
+    if (osdScreenBuffered) {
+        // Part way through a pass, which now starts again with the new elements
+        osdScreenClear(osdScreen);
+    }
+#endif
 
 #ifdef USE_ACC
     if (sensors(SENSOR_ACC)) {
@@ -1877,7 +2010,7 @@ static void osdDrawSingleElementBackground(displayPort_t *osdDisplayPort, uint8_
     }
 }
 
-void osdDrawActiveElements(displayPort_t *osdDisplayPort, timeUs_t currentTimeUs)
+void osdStartDrawActiveElements(displayPort_t *osdDisplayPort, timeUs_t currentTimeUs)
 {
 #ifdef USE_GPS
     static bool lastGpsSensorState;
@@ -1891,15 +2024,43 @@ void osdDrawActiveElements(displayPort_t *osdDisplayPort, timeUs_t currentTimeUs
 #endif // USE_GPS
 
     blinkState = (currentTimeUs / 200000) % 2;
+    activeOsdElementDrawIndex = 0;
 
-    for (unsigned i = 0; i < activeOsdElementCount; i++) {
+    // The screen is only cleared before this when something else has drawn on it, see osdDrawElements()
+    osdScreenBuffered = osdElementsOnlyWriteChanges(osdDisplayPort);
+#ifdef USE_OSD_SCREEN_BUFFER
+    if (osdScreenBuffered) {
+        osdScreenBegin(osdDisplayPort);
+    }
+#endif
+}
+
+// Draws the active elements from where the last call stopped, until at least one has been drawn and the time
+// reaches stopAtUs. Returns true once all the elements have been drawn.
+bool osdDrawActiveElements(displayPort_t *osdDisplayPort, timeUs_t stopAtUs)
+{
+    while (activeOsdElementDrawIndex < activeOsdElementCount) {
+        const uint8_t item = activeOsdElementArray[activeOsdElementDrawIndex++];
         if (!backgroundLayerSupported) {
             // If the background layer isn't supported then we
             // have to draw the element's static layer as well.
-            osdDrawSingleElementBackground(osdDisplayPort, activeOsdElementArray[i]);
+            osdDrawSingleElementBackground(osdDisplayPort, item);
         }
-        osdDrawSingleElement(osdDisplayPort, activeOsdElementArray[i]);
+        osdDrawSingleElement(osdDisplayPort, item);
+
+        if (activeOsdElementDrawIndex < activeOsdElementCount && cmpTimeUs(micros(), stopAtUs) >= 0) {
+            return false;
+        }
+    }
+
+#ifdef USE_OSD_SCREEN_BUFFER
+    if (osdScreenBuffered) {
+        osdScreenFlush(osdDisplayPort);
+        osdScreenBuffered = false;
     }
+#endif
+
+    return true;
 }
 
 void osdDrawActiveElementsBackground(displayPort_t *osdDisplayPort)
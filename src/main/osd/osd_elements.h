@@ -47,7 +47,9 @@ int32_t osdGetSpeedToSelectedUnit(int32_t value);
 char osdGetSpeedToSelectedUnitSymbol(void);
 char osdGetTemperatureSymbolForSelectedUnit(void);
 void osdAddActiveElements(void);
-void osdDrawActiveElements(displayPort_t *osdDisplayPort, timeUs_t currentTimeUs);
+bool osdElementsOnlyWriteChanges(const displayPort_t *osdDisplayPort);
+void osdStartDrawActiveElements(displayPort_t *osdDisplayPort, timeUs_t currentTimeUs);
+bool osdDrawActiveElements(displayPort_t *osdDisplayPort, timeUs_t stopAtUs);
 void osdDrawActiveElementsBackground(displayPort_t *osdDisplayPort);
 void osdElementsInit(bool backgroundLayerFlag);
 void osdResetAlarms(void);
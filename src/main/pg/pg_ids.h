@@ -20,6 +20,8 @@
 
 #pragma once
 
+// 0 is not used, the saved config keeps a record of its own under that number, see config_eeprom.c
+
 // FC configuration (defined by cleanflight v1)
 #define PG_FAILSAFE_CONFIG 1 // struct OK
 #define PG_BOARD_ALIGNMENT 2 // struct OK
@@ -69,6 +69,8 @@ static uint8_t telemetryBuf[CRSF_FRAME_SIZE_MAX];
 static uint8_t telemetryBufLen = 0;
 
 static timeUs_t lastRcFrameTimeUs = 0;
+static uint16_t rcFrameCount;       // since the last link statistics frame
+static uint16_t linkRateHz;
 
 /*
  * CRSF protocol
@@ -152,6 +154,20 @@ typedef struct crsfPayloadLinkstatistics_s {
 
 static timeUs_t lastLinkStatisticsFrameUs;
 
+// The RC frames come at the packet rate of the link. rf_Mode can't be used for that,
+// links other than Crossfire that speak CRSF number their modes differently.
+static void crsfUpdateLinkRate(timeUs_t currentTimeUs)
+{
+    static timeUs_t lastLinkRateUpdateUs;
+
+    const timeDelta_t statisticsIntervalUs = cmpTimeUs(currentTimeUs, lastLinkRateUpdateUs);
+    if (lastLinkRateUpdateUs && statisticsIntervalUs > 0) {
+        linkRateHz = ((uint32_t)rcFrameCount * 1000000 + statisticsIntervalUs / 2) / statisticsIntervalUs;
+    }
+    rcFrameCount = 0;
+    lastLinkRateUpdateUs = currentTimeUs;
+}
+
 static void handleCrsfLinkStatisticsFrame(const crsfLinkStatistics_t* statsPtr, timeUs_t currentTimeUs)
 {
     const crsfLinkStatistics_t stats = *statsPtr;
@@ -230,10 +246,66 @@ STATIC_UNIT_TESTED uint8_t crsfFrameCRC(void)
     return crc;
 }
 
-// Receive ISR callback, called back from serial port
-STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
+static void crsfProcessFrame(int fullFrameLength, timeUs_t currentTimeUs)
 {
-    UNUSED(data);
+    const uint8_t crc = crsfFrameCRC();
+    if (crc == crsfFrame.bytes[fullFrameLength - 1]) {
+        switch (crsfFrame.frame.type)
+        {
+            case CRSF_FRAMETYPE_RC_CHANNELS_PACKED:
+                if (crsfFrame.frame.deviceAddress == CRSF_ADDRESS_FLIGHT_CONTROLLER) {
+                    lastRcFrameTimeUs = currentTimeUs;
+                    rcFrameCount++;
+                    crsfFrameDone = true;
+                    memcpy(&crsfChannelDataFrame, &crsfFrame, sizeof(crsfFrame));
+                }
+                break;
+
+#if defined(USE_TELEMETRY_CRSF) && defined(USE_MSP_OVER_TELEMETRY)
+            case CRSF_FRAMETYPE_MSP_REQ:
+            case CRSF_FRAMETYPE_MSP_WRITE: {
+                uint8_t *frameStart = (uint8_t *)&crsfFrame.frame.payload + CRSF_FRAME_ORIGIN_DEST_SIZE;
+                if (bufferCrsfMspFrame(frameStart, CRSF_FRAME_RX_MSP_FRAME_SIZE)) {
+                    crsfScheduleMspResponse();
+                }
+                break;
+            }
+#endif
+#if defined(USE_CRSF_CMS_TELEMETRY)
+            case CRSF_FRAMETYPE_DEVICE_PING:
+                crsfScheduleDeviceInfoResponse();
+                break;
+            case CRSF_FRAMETYPE_DISPLAYPORT_CMD: {
+                uint8_t *frameStart = (uint8_t *)&crsfFrame.frame.payload + CRSF_FRAME_ORIGIN_DEST_SIZE;
+                crsfProcessDisplayPortCmd(frameStart);
+                break;
+            }
+#endif
+#if defined(USE_CRSF_LINK_STATISTICS)
+
+            case CRSF_FRAMETYPE_LINK_STATISTICS: {
+                 // if to FC and 10 bytes + CRSF_FRAME_ORIGIN_DEST_SIZE
+                 if ((crsfFrame.frame.deviceAddress == CRSF_ADDRESS_FLIGHT_CONTROLLER) &&
+                     (crsfFrame.frame.frameLength == CRSF_FRAME_ORIGIN_DEST_SIZE + CRSF_FRAME_LINK_STATISTICS_PAYLOAD_SIZE)) {
+                     crsfUpdateLinkRate(currentTimeUs);
+                     if (rssiSource == RSSI_SOURCE_RX_PROTOCOL_CRSF) {
+                         const crsfLinkStatistics_t* statsFrame = (const crsfLinkStatistics_t*)&crsfFrame.frame.payload;
+                         handleCrsfLinkStatisticsFrame(statsFrame, currentTimeUs);
+                     }
+                 }
+                break;
+            }
+#endif
+            default:
+                break;
+        }
+    }
+}
+
+// Receive ISR callback, called back from serial port with the bytes received up to an idle line
+STATIC_UNIT_TESTED void crsfFrameReceive(const uint8_t *data, int count, void *callbackData)
+{
+    UNUSED(callbackData);
 
     static uint8_t crsfFramePosition = 0;
     const timeUs_t currentTimeUs = microsISR();
@@ -243,71 +315,34 @@ STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
 #endif
 
     if (cmpTimeUs(currentTimeUs, crsfFrameStartAtUs) > CRSF_TIME_NEEDED_PER_FRAME_US) {
-        // We've received a character after max time needed to complete a frame,
+        // We've received data after max time needed to complete a frame,
         // so this must be the start of a new frame.
         crsfFramePosition = 0;
     }
 
-    if (crsfFramePosition == 0) {
-        crsfFrameStartAtUs = currentTimeUs;
-    }
-    // assume frame is 5 bytes long until we have received the frame length
-    // full frame length includes the length of the address and framelength fields
-    const int fullFrameLength = crsfFramePosition < 3 ? 5 : crsfFrame.frame.frameLength + CRSF_FRAME_LENGTH_ADDRESS + CRSF_FRAME_LENGTH_FRAMELENGTH;
-
-    if (crsfFramePosition < fullFrameLength) {
-        crsfFrame.bytes[crsfFramePosition++] = (uint8_t)c;
-        if (crsfFramePosition >= fullFrameLength) {
+    while (count > 0) {
+        if (crsfFramePosition == 0) {
+            crsfFrameStartAtUs = currentTimeUs;
+        }
+        // take the address, frame length and type first, the frame length then gives the length of the whole frame
+        // full frame length includes the length of the address and framelength fields
+        const bool haveHeader = crsfFramePosition >= 3;
+        const int fullFrameLength = haveHeader ? crsfFrame.frame.frameLength + CRSF_FRAME_LENGTH_ADDRESS + CRSF_FRAME_LENGTH_FRAMELENGTH : 3;
+        if (fullFrameLength <= crsfFramePosition || fullFrameLength > (int)sizeof(crsfFrame.bytes)) {
+            // not a frame that fits, look for the next one
             crsfFramePosition = 0;
-            const uint8_t crc = crsfFrameCRC();
-            if (crc == crsfFrame.bytes[fullFrameLength - 1]) {
-                switch (crsfFrame.frame.type)
-                {
-                    case CRSF_FRAMETYPE_RC_CHANNELS_PACKED:
-                        if (crsfFrame.frame.deviceAddress == CRSF_ADDRESS_FLIGHT_CONTROLLER) {
-                            lastRcFrameTimeUs = currentTimeUs;
-                            crsfFrameDone = true;
-                            memcpy(&crsfChannelDataFrame, &crsfFrame, sizeof(crsfFrame));
-                        }
-                        break;
+            continue;
+        }
 
-#if defined(USE_TELEMETRY_CRSF) && defined(USE_MSP_OVER_TELEMETRY)
-                    case CRSF_FRAMETYPE_MSP_REQ:
-                    case CRSF_FRAMETYPE_MSP_WRITE: {
-                        uint8_t *frameStart = (uint8_t *)&crsfFrame.frame.payload + CRSF_FRAME_ORIGIN_DEST_SIZE;
-                        if (bufferCrsfMspFrame(frameStart, CRSF_FRAME_RX_MSP_FRAME_SIZE)) {
-                            crsfScheduleMspResponse();
-                        }
-                        break;
-                    }
-#endif
-#if defined(USE_CRSF_CMS_TELEMETRY)
-                    case CRSF_FRAMETYPE_DEVICE_PING:
-                        crsfScheduleDeviceInfoResponse();
-                        break;
-                    case CRSF_FRAMETYPE_DISPLAYPORT_CMD: {
-                        uint8_t *frameStart = (uint8_t *)&crsfFrame.frame.payload + CRSF_FRAME_ORIGIN_DEST_SIZE;
-                        crsfProcessDisplayPortCmd(frameStart);
-                        break;
-                    }
-#endif
-#if defined(USE_CRSF_LINK_STATISTICS)
+        const int length = MIN(count, fullFrameLength - crsfFramePosition);
+        memcpy(&crsfFrame.bytes[crsfFramePosition], data, length);
+        crsfFramePosition += length;
+        data += length;
+        count -= length;
 
-                    case CRSF_FRAMETYPE_LINK_STATISTICS: {
-                         // if to FC and 10 bytes + CRSF_FRAME_ORIGIN_DEST_SIZE
-                         if ((rssiSource == RSSI_SOURCE_RX_PROTOCOL_CRSF) &&
-                             (crsfFrame.frame.deviceAddress == CRSF_ADDRESS_FLIGHT_CONTROLLER) &&
-                             (crsfFrame.frame.frameLength == CRSF_FRAME_ORIGIN_DEST_SIZE + CRSF_FRAME_LINK_STATISTICS_PAYLOAD_SIZE)) {
-                             const crsfLinkStatistics_t* statsFrame = (const crsfLinkStatistics_t*)&crsfFrame.frame.payload;
-                             handleCrsfLinkStatisticsFrame(statsFrame, currentTimeUs);
-                         }
-                        break;
-                    }
-#endif
-                    default:
-                        break;
-                }
-            }
+        if (haveHeader && crsfFramePosition == fullFrameLength) {
+            crsfFramePosition = 0;
+            crsfProcessFrame(fullFrameLength, currentTimeUs);
         }
     }
 }
@@ -400,12 +435,15 @@ bool crsfRxInit(const rxConfig_t *rxConfig, rxRuntimeState_t *rxRuntimeState)
 
     serialPort = openSerialPort(portConfig->identifier,
         FUNCTION_RX_SERIAL,
-        crsfDataReceive,
+        NULL,
         NULL,
         CRSF_BAUDRATE,
         CRSF_PORT_MODE,
         CRSF_PORT_OPTIONS | (rxConfig->serialrx_inverted ? SERIAL_INVERTED : 0)
         );
+    if (serialPort) {
+        serialPort->rxFrameCallback = crsfFrameReceive;
+    }
 
         if (rssiSource == RSSI_SOURCE_NONE) {
             rssiSource = RSSI_SOURCE_RX_PROTOCOL_CRSF;
@@ -423,4 +461,9 @@ bool crsfRxIsActive(void)
 {
     return serialPort != NULL;
 }
+
+uint16_t crsfRxGetLinkRateHz(void)
+{
+    return linkRateHz;
+}
 #endif
@@ -60,3 +60,5 @@ struct rxConfig_s;
 struct rxRuntimeState_s;
 bool crsfRxInit(const struct rxConfig_s *initialRxConfig, struct rxRuntimeState_s *rxRuntimeState);
 bool crsfRxIsActive(void);
+// packet rate of the link as measured between link statistics frames, 0 until known
+uint16_t crsfRxGetLinkRateHz(void);
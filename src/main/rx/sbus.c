@@ -21,6 +21,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -28,6 +29,7 @@
 
 #include "build/debug.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/time.h"
@@ -110,10 +112,10 @@ typedef struct sbusFrameData_s {
 
 static timeUs_t lastRcFrameTimeUs = 0;
 
-// Receive ISR callback
-static void sbusDataReceive(uint16_t c, void *data)
+// Receive ISR callback, called back from serial port with the bytes received up to an idle line
+static void sbusFrameReceive(const uint8_t *data, int count, void *callbackData)
 {
-    sbusFrameData_t *sbusFrameData = data;
+    sbusFrameData_t *sbusFrameData = callbackData;
 
     const timeUs_t nowUs = microsISR();
 
@@ -124,14 +126,20 @@ static void sbusDataReceive(uint16_t c, void *data)
     }
 
     if (sbusFrameData->position == 0) {
-        if (c != SBUS_FRAME_BEGIN_BYTE) {
+        const uint8_t *frameStart = memchr(data, SBUS_FRAME_BEGIN_BYTE, count);
+        if (!frameStart) {
             return;
         }
+        count -= frameStart - data;
+        data = frameStart;
         sbusFrameData->startAtUs = nowUs;
     }
 
-    if (sbusFrameData->position < SBUS_FRAME_SIZE) {
-        sbusFrameData->frame.bytes[sbusFrameData->position++] = (uint8_t)c;
+    // bytes after a whole frame are ignored until the gap before the next one
+    const int length = MIN(count, SBUS_FRAME_SIZE - sbusFrameData->position);
+    if (length > 0) {
+        memcpy(&sbusFrameData->frame.bytes[sbusFrameData->position], data, length);
+        sbusFrameData->position += length;
         if (sbusFrameData->position < SBUS_FRAME_SIZE) {
             sbusFrameData->done = false;
         } else {
@@ -201,12 +209,15 @@ bool sbusInit(const rxConfig_t *rxConfig, rxRuntimeState_t *rxRuntimeState)
 
     serialPort_t *sBusPort = openSerialPort(portConfig->identifier,
         FUNCTION_RX_SERIAL,
-        sbusDataReceive,
+        NULL,
         &sbusFrameData,
         sbusBaudRate,
         portShared ? MODE_RXTX : MODE_RX,
         SBUS_PORT_OPTIONS | (rxConfig->serialrx_inverted ? 0 : SERIAL_INVERTED) | (rxConfig->halfDuplex ? SERIAL_BIDIR : 0)
         );
+    if (sBusPort) {
+        sBusPort->rxFrameCallback = sbusFrameReceive;
+    }
 
     if (rxConfig->rssi_src_frame_errors) {
         rssiSource = RSSI_SOURCE_FRAME_ERRORS;
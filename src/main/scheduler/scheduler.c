@@ -62,16 +62,34 @@ STATIC_UNIT_TESTED FAST_DATA_ZERO_INIT int taskQueueSize = 0;
 
 static FAST_DATA int periodCalculationBasisOffset = offsetof(task_t, lastExecutedAtUs);
 static FAST_DATA_ZERO_INIT bool gyroEnabled;
+static FAST_DATA timeDelta_t taskTimeBudgetUs = TASK_TIME_BUDGET_UNLIMITED_US;
+
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+static FAST_DATA_ZERO_INIT gyroLateStartInfo_t gyroLateStart;
+#endif
 
 // No need for a linked list for the queue, since items are only inserted at startup
 
 STATIC_UNIT_TESTED FAST_DATA_ZERO_INIT task_t* taskQueueArray[TASK_COUNT + 1]; // extra item for NULL pointer at end of queue
 
+// Deadline ordered view of the task queue, used instead of the linear scan when enabled.
+// Time driven tasks are held in a binary min-heap keyed on their next due time so tasks that
+// are not yet due are never touched; event driven tasks still have their checkFunc polled every pass.
+// Entries are positions in taskQueueArray, so ties in dynamic priority resolve in queue order
+// exactly as they do in the linear scan. Both views are rebuilt lazily whenever the queue changes.
+static FAST_DATA_ZERO_INIT bool deadlineQueueEnabled;
+static FAST_DATA_ZERO_INIT bool deadlineQueueDirty;
+STATIC_UNIT_TESTED FAST_DATA_ZERO_INIT uint8_t deadlineHeap[TASK_COUNT];
+STATIC_UNIT_TESTED FAST_DATA_ZERO_INIT int deadlineHeapSize;
+static FAST_DATA_ZERO_INIT uint8_t eventTaskQueuePos[TASK_COUNT];
+static FAST_DATA_ZERO_INIT int eventTaskCount;
+
 void queueClear(void)
 {
     memset(taskQueueArray, 0, sizeof(taskQueueArray));
     taskQueuePos = 0;
     taskQueueSize = 0;
+    deadlineQueueDirty = true;
 }
 
 bool queueContains(task_t *task)
@@ -94,6 +112,7 @@ bool queueAdd(task_t *task)
             memmove(&taskQueueArray[ii+1], &taskQueueArray[ii], sizeof(task) * (taskQueueSize - ii));
             taskQueueArray[ii] = task;
             ++taskQueueSize;
+            deadlineQueueDirty = true;
             return true;
         }
     }
@@ -106,6 +125,7 @@ bool queueRemove(task_t *task)
         if (taskQueueArray[ii] == task) {
             memmove(&taskQueueArray[ii], &taskQueueArray[ii+1], sizeof(task) * (taskQueueSize - ii));
             --taskQueueSize;
+            deadlineQueueDirty = true;
             return true;
         }
     }
@@ -129,6 +149,76 @@ FAST_CODE task_t *queueNext(void)
     return taskQueueArray[++taskQueuePos]; // guaranteed to be NULL at end of queue
 }
 
+inline static timeUs_t getPeriodCalculationBasis(const task_t* task)
+{
+    if (task->staticPriority == TASK_PRIORITY_REALTIME) {
+        return *(timeUs_t*)((uint8_t*)task + periodCalculationBasisOffset);
+    } else {
+        return task->lastExecutedAtUs;
+    }
+}
+
+// Same due time as the linear scan uses
+static FAST_CODE timeUs_t deadlineOf(uint8_t queuePos)
+{
+    const task_t *task = taskQueueArray[queuePos];
+    return getPeriodCalculationBasis(task) + task->desiredPeriodUs;
+}
+
+static FAST_CODE bool deadlineBefore(uint8_t queuePosA, uint8_t queuePosB)
+{
+    const timeDelta_t delta = cmpTimeUs(deadlineOf(queuePosA), deadlineOf(queuePosB));
+    return delta < 0 || (delta == 0 && queuePosA < queuePosB);
+}
+
+static FAST_CODE void deadlineHeapSiftDown(int heapIndex)
+{
+    while (true) {
+        const int left = 2 * heapIndex + 1;
+        const int right = left + 1;
+        int earliest = heapIndex;
+
+        if (left < deadlineHeapSize && deadlineBefore(deadlineHeap[left], deadlineHeap[earliest])) {
+            earliest = left;
+        }
+        if (right < deadlineHeapSize && deadlineBefore(deadlineHeap[right], deadlineHeap[earliest])) {
+            earliest = right;
+        }
+        if (earliest == heapIndex) {
+            return;
+        }
+
+        const uint8_t queuePos = deadlineHeap[heapIndex];
+        deadlineHeap[heapIndex] = deadlineHeap[earliest];
+        deadlineHeap[earliest] = queuePos;
+        heapIndex = earliest;
+    }
+}
+
+STATIC_UNIT_TESTED void deadlineQueueRebuild(void)
+{
+    deadlineHeapSize = 0;
+    eventTaskCount = 0;
+
+    for (int ii = 0; ii < taskQueueSize; ++ii) {
+        const task_t *task = taskQueueArray[ii];
+        if (task->staticPriority == TASK_PRIORITY_REALTIME) {
+            continue;
+        }
+        if (task->checkFunc) {
+            eventTaskQueuePos[eventTaskCount++] = ii;
+        } else {
+            deadlineHeap[deadlineHeapSize++] = ii;
+        }
+    }
+
+    for (int ii = deadlineHeapSize / 2 - 1; ii >= 0; --ii) {
+        deadlineHeapSiftDown(ii);
+    }
+
+    deadlineQueueDirty = false;
+}
+
 void taskSystemLoad(timeUs_t currentTimeUs)
 {
     UNUSED(currentTimeUs);
@@ -159,6 +249,71 @@ void getCheckFuncInfo(cfCheckFuncInfo_t *checkFuncInfo)
 }
 #endif
 
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+static FAST_CODE void taskHistogramAdd(taskHistogram_t *histogram, timeDelta_t timeUs)
+{
+    const unsigned bucket = timeUs <= 0 ? 0 : MIN(32 - __builtin_clz(timeUs), TASK_HISTOGRAM_BUCKET_COUNT - 1);
+
+    if (histogram->count[bucket] == UINT16_MAX) {
+        // Age the whole histogram rather than letting one bucket saturate, this keeps the shape intact
+        for (int ii = 0; ii < TASK_HISTOGRAM_BUCKET_COUNT; ++ii) {
+            histogram->count[ii] >>= 1;
+        }
+    }
+    histogram->count[bucket]++;
+}
+
+uint32_t taskHistogramBucketLowerBoundUs(unsigned bucket)
+{
+    return bucket == 0 ? 0 : 1 << (bucket - 1);
+}
+
+uint32_t taskHistogramTotalCount(const taskHistogram_t *histogram)
+{
+    uint32_t total = 0;
+    for (int ii = 0; ii < TASK_HISTOGRAM_BUCKET_COUNT; ++ii) {
+        total += histogram->count[ii];
+    }
+    return total;
+}
+
+// Percentile in parts per thousand, interpolated linearly within the bucket it falls into
+uint32_t taskHistogramPercentileUs(const taskHistogram_t *histogram, unsigned permille)
+{
+    const uint32_t total = taskHistogramTotalCount(histogram);
+    if (total == 0) {
+        return 0;
+    }
+
+    const uint32_t rank = MAX((total * permille + 999) / 1000, 1U);
+    uint32_t cumulative = 0;
+    for (int ii = 0; ii < TASK_HISTOGRAM_BUCKET_COUNT; ++ii) {
+        const uint32_t count = histogram->count[ii];
+        if (cumulative + count >= rank) {
+            const uint32_t lowerUs = taskHistogramBucketLowerBoundUs(ii);
+            if (ii == 0 || ii == TASK_HISTOGRAM_BUCKET_COUNT - 1) {
+                return lowerUs;
+            }
+            return lowerUs + (lowerUs * (rank - cumulative)) / count;
+        }
+        cumulative += count;
+    }
+    return taskHistogramBucketLowerBoundUs(TASK_HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+void getTaskHistograms(taskId_e taskId, taskHistogram_t *executionTimeHistogram, taskHistogram_t *startLatenessHistogram)
+{
+    const task_t *task = getTask(taskId);
+    *executionTimeHistogram = task->executionTimeHistogram;
+    *startLatenessHistogram = task->startLatenessHistogram;
+}
+
+void getGyroLateStartInfo(gyroLateStartInfo_t *gyroLateStartInfo)
+{
+    *gyroLateStartInfo = gyroLateStart;
+}
+#endif
+
 void getTaskInfo(taskId_e taskId, taskInfo_t * taskInfo)
 {
     taskInfo->isEnabled = queueContains(getTask(taskId));
@@ -185,6 +340,7 @@ void rescheduleTask(taskId_e taskId, timeDelta_t newPeriodUs)
         task_t *task = getTask(taskId);
         task->desiredPeriodUs = MAX(SCHEDULER_DELAY_LIMIT, newPeriodUs);  // Limit delay to 100us (10 kHz) to prevent scheduler clogging
     }
+    deadlineQueueDirty = true;
 }
 
 void setTaskEnabled(taskId_e taskId, bool enabled)
@@ -210,6 +366,12 @@ timeDelta_t getTaskDeltaTimeUs(taskId_e taskId)
     }
 }
 
+// Time the running task can take before the gyro task is next due, for tasks that can split their work up
+timeDelta_t getTaskTimeBudgetUs(void)
+{
+    return taskTimeBudgetUs;
+}
+
 void schedulerSetCalulateTaskStatistics(bool calculateTaskStatisticsToUse)
 {
     calculateTaskStatistics = calculateTaskStatisticsToUse;
@@ -218,16 +380,19 @@ void schedulerSetCalulateTaskStatistics(bool calculateTaskStatisticsToUse)
 void schedulerResetTaskStatistics(taskId_e taskId)
 {
 #if defined(USE_TASK_STATISTICS)
-    if (taskId == TASK_SELF) {
-        currentTask->movingSumExecutionTimeUs = 0;
-        currentTask->movingSumDeltaTimeUs = 0;
-        currentTask->totalExecutionTimeUs = 0;
-        currentTask->maxExecutionTimeUs = 0;
-    } else if (taskId < TASK_COUNT) {
-        getTask(taskId)->movingSumExecutionTimeUs = 0;
-        getTask(taskId)->movingSumDeltaTimeUs = 0;
-        getTask(taskId)->totalExecutionTimeUs = 0;
-        getTask(taskId)->maxExecutionTimeUs = 0;
+    if (taskId == TASK_SELF || taskId < TASK_COUNT) {
+        task_t *task = taskId == TASK_SELF ? currentTask : getTask(taskId);
+        task->movingSumExecutionTimeUs = 0;
+        task->movingSumDeltaTimeUs = 0;
+        task->totalExecutionTimeUs = 0;
+        task->maxExecutionTimeUs = 0;
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+        memset(&task->executionTimeHistogram, 0, sizeof(task->executionTimeHistogram));
+        memset(&task->startLatenessHistogram, 0, sizeof(task->startLatenessHistogram));
+        if (task == getTask(TASK_GYRO)) {
+            memset(&gyroLateStart, 0, sizeof(gyroLateStart));
+        }
+#endif
     }
 #else
     UNUSED(taskId);
@@ -264,15 +429,14 @@ void schedulerInit(void)
 void schedulerOptimizeRate(bool optimizeRate)
 {
     periodCalculationBasisOffset = optimizeRate ? offsetof(task_t, lastDesiredAt) : offsetof(task_t, lastExecutedAtUs);
+    // due times are keyed on the period calculation basis
+    deadlineQueueDirty = true;
 }
 
-inline static timeUs_t getPeriodCalculationBasis(const task_t* task)
+void schedulerUseDeadlineQueue(bool useDeadlineQueue)
 {
-    if (task->staticPriority == TASK_PRIORITY_REALTIME) {
-        return *(timeUs_t*)((uint8_t*)task + periodCalculationBasisOffset);
-    } else {
-        return task->lastExecutedAtUs;
-    }
+    deadlineQueueEnabled = useDeadlineQueue;
+    deadlineQueueDirty = true;
 }
 
 FAST_CODE timeUs_t schedulerExecuteTask(task_t *selectedTask, timeUs_t currentTimeUs)
@@ -284,6 +448,10 @@ FAST_CODE timeUs_t schedulerExecuteTask(task_t *selectedTask, timeUs_t currentTi
         selectedTask->taskLatestDeltaTimeUs = cmpTimeUs(currentTimeUs, selectedTask->lastExecutedAtUs);
 #if defined(USE_TASK_STATISTICS)
         float period = currentTimeUs - selectedTask->lastExecutedAtUs;
+#endif
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+        const timeUs_t dueAtUs = selectedTask->checkFunc ? selectedTask->lastSignaledAtUs : getPeriodCalculationBasis(selectedTask) + selectedTask->desiredPeriodUs;
+        const timeDelta_t startLatenessUs = cmpTimeUs(currentTimeUs, dueAtUs);
 #endif
         selectedTask->lastExecutedAtUs = currentTimeUs;
         selectedTask->lastDesiredAt += (cmpTimeUs(currentTimeUs, selectedTask->lastDesiredAt) / selectedTask->desiredPeriodUs) * selectedTask->desiredPeriodUs;
@@ -300,6 +468,10 @@ FAST_CODE timeUs_t schedulerExecuteTask(task_t *selectedTask, timeUs_t currentTi
             selectedTask->totalExecutionTimeUs += taskExecutionTimeUs;   // time consumed by scheduler + task
             selectedTask->maxExecutionTimeUs = MAX(selectedTask->maxExecutionTimeUs, taskExecutionTimeUs);
             selectedTask->movingAverageCycleTimeUs += 0.05f * (period - selectedTask->movingAverageCycleTimeUs);
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+            taskHistogramAdd(&selectedTask->executionTimeHistogram, taskExecutionTimeUs);
+            taskHistogramAdd(&selectedTask->startLatenessHistogram, startLatenessUs);
+#endif
         } else
 #endif
         {
@@ -310,6 +482,106 @@ FAST_CODE timeUs_t schedulerExecuteTask(task_t *selectedTask, timeUs_t currentTi
     return taskExecutionTimeUs;
 }
 
+// Task has checkFunc - event driven
+// Returns 1 if the task is waiting to be executed
+static FAST_CODE uint16_t updateEventTaskPriority(task_t *task, timeUs_t currentTimeUs)
+{
+#if defined(SCHEDULER_DEBUG)
+    const timeUs_t currentTimeBeforeCheckFuncCallUs = micros();
+#else
+    const timeUs_t currentTimeBeforeCheckFuncCallUs = currentTimeUs;
+#endif
+    // Increase priority for event driven tasks
+    if (task->dynamicPriority > 0) {
+        task->taskAgeCycles = 1 + ((currentTimeUs - task->lastSignaledAtUs) / task->desiredPeriodUs);
+        task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+        return 1;
+    } else if (task->checkFunc(currentTimeBeforeCheckFuncCallUs, cmpTimeUs(currentTimeBeforeCheckFuncCallUs, task->lastExecutedAtUs))) {
+#if defined(SCHEDULER_DEBUG)
+        DEBUG_SET(DEBUG_SCHEDULER, 3, micros() - currentTimeBeforeCheckFuncCallUs);
+#endif
+#if defined(USE_TASK_STATISTICS)
+        if (calculateTaskStatistics) {
+            const uint32_t checkFuncExecutionTimeUs = micros() - currentTimeBeforeCheckFuncCallUs;
+            checkFuncMovingSumExecutionTimeUs += checkFuncExecutionTimeUs - checkFuncMovingSumExecutionTimeUs / TASK_STATS_MOVING_SUM_COUNT;
+            checkFuncMovingSumDeltaTimeUs += task->taskLatestDeltaTimeUs - checkFuncMovingSumDeltaTimeUs / TASK_STATS_MOVING_SUM_COUNT;
+            checkFuncTotalExecutionTimeUs += checkFuncExecutionTimeUs;   // time consumed by scheduler + task
+            checkFuncMaxExecutionTimeUs = MAX(checkFuncMaxExecutionTimeUs, checkFuncExecutionTimeUs);
+        }
+#endif
+        task->lastSignaledAtUs = currentTimeBeforeCheckFuncCallUs;
+        task->taskAgeCycles = 1;
+        task->dynamicPriority = 1 + task->staticPriority;
+        return 1;
+    } else {
+        task->taskAgeCycles = 0;
+        return 0;
+    }
+}
+
+// Task is time-driven, dynamicPriority is last execution age (measured in desiredPeriods)
+// Returns 1 if the task is waiting to be executed
+static FAST_CODE uint16_t updateTimedTaskPriority(task_t *task, timeUs_t currentTimeUs)
+{
+    // Task age is calculated from last execution
+    task->taskAgeCycles = ((currentTimeUs - getPeriodCalculationBasis(task)) / task->desiredPeriodUs);
+    if (task->taskAgeCycles > 0) {
+        task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+        return 1;
+    }
+    return 0;
+}
+
+// Select the task to run using the deadline ordered queue. Only time driven tasks that are due are
+// visited, found by walking the heap from the root and pruning every subtree whose root is not yet due.
+// Ties in dynamic priority go to the task earliest in the queue, matching the linear scan.
+static FAST_CODE task_t *deadlineQueueSelect(timeUs_t currentTimeUs, uint16_t *selectedTaskDynamicPriority, uint16_t *waitingTasks, int *selectedHeapIndex)
+{
+    int selectedQueuePos = taskQueueSize;
+
+    for (int ii = 0; ii < eventTaskCount; ++ii) {
+        const uint8_t queuePos = eventTaskQueuePos[ii];
+        task_t *task = taskQueueArray[queuePos];
+        *waitingTasks += updateEventTaskPriority(task, currentTimeUs);
+        if (task->dynamicPriority > *selectedTaskDynamicPriority) {
+            *selectedTaskDynamicPriority = task->dynamicPriority;
+            selectedQueuePos = queuePos;
+        }
+    }
+
+    uint8_t pending[TASK_COUNT];
+    int pendingCount = 0;
+    if (deadlineHeapSize > 0) {
+        pending[pendingCount++] = 0;
+    }
+    while (pendingCount > 0) {
+        const int heapIndex = pending[--pendingCount];
+        const uint8_t queuePos = deadlineHeap[heapIndex];
+        if (cmpTimeUs(currentTimeUs, deadlineOf(queuePos)) < 0) {
+            continue;
+        }
+
+        task_t *task = taskQueueArray[queuePos];
+        *waitingTasks += updateTimedTaskPriority(task, currentTimeUs);
+        if (task->dynamicPriority > *selectedTaskDynamicPriority
+            || (task->dynamicPriority == *selectedTaskDynamicPriority && task->dynamicPriority > 0 && queuePos < selectedQueuePos)) {
+            *selectedTaskDynamicPriority = task->dynamicPriority;
+            selectedQueuePos = queuePos;
+            *selectedHeapIndex = heapIndex;
+        }
+
+        const int left = 2 * heapIndex + 1;
+        if (left < deadlineHeapSize) {
+            pending[pendingCount++] = left;
+        }
+        if (left + 1 < deadlineHeapSize) {
+            pending[pendingCount++] = left + 1;
+        }
+    }
+
+    return selectedQueuePos < taskQueueSize ? taskQueueArray[selectedQueuePos] : NULL;
+}
+
 #if defined(UNIT_TEST)
 task_t *unittest_scheduler_selectedTask;
 uint8_t unittest_scheduler_selectedTaskDynamicPriority;
@@ -334,6 +606,7 @@ FAST_CODE void scheduler(void)
     uint16_t waitingTasks = 0;
     bool realtimeTaskRan = false;
     timeDelta_t gyroTaskDelayUs = 0;
+    int selectedHeapIndex = -1;
 
     if (gyroEnabled) {
         // Realtime gyro/filtering/PID tasks get complete priority
@@ -341,6 +614,13 @@ FAST_CODE void scheduler(void)
         const timeUs_t gyroExecuteTimeUs = getPeriodCalculationBasis(gyroTask) + gyroTask->desiredPeriodUs;
         gyroTaskDelayUs = cmpTimeUs(gyroExecuteTimeUs, currentTimeUs);  // time until the next expected gyro sample
         if (cmpTimeUs(currentTimeUs, gyroExecuteTimeUs) >= 0) {
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+            gyroLateStart.startCount++;
+            if (-gyroTaskDelayUs > GYRO_TASK_GUARD_INTERVAL_US) {
+                gyroLateStart.lateStartCount++;
+            }
+            gyroLateStart.maxLateUs = MAX(gyroLateStart.maxLateUs, -gyroTaskDelayUs);
+#endif
             taskExecutionTimeUs = schedulerExecuteTask(gyroTask, currentTimeUs);
             if (gyroFilterReady()) {
                 taskExecutionTimeUs += schedulerExecuteTask(getTask(TASK_FILTER), currentTimeUs);
@@ -356,54 +636,25 @@ FAST_CODE void scheduler(void)
     if (!gyroEnabled || realtimeTaskRan || (gyroTaskDelayUs > GYRO_TASK_GUARD_INTERVAL_US)) {
         // The task to be invoked
 
-        // Update task dynamic priorities
-        for (task_t *task = queueFirst(); task != NULL; task = queueNext()) {
-            if (task->staticPriority != TASK_PRIORITY_REALTIME) {
-                // Task has checkFunc - event driven
-                if (task->checkFunc) {
-#if defined(SCHEDULER_DEBUG)
-                    const timeUs_t currentTimeBeforeCheckFuncCallUs = micros();
-#else
-                    const timeUs_t currentTimeBeforeCheckFuncCallUs = currentTimeUs;
-#endif
-                    // Increase priority for event driven tasks
-                    if (task->dynamicPriority > 0) {
-                        task->taskAgeCycles = 1 + ((currentTimeUs - task->lastSignaledAtUs) / task->desiredPeriodUs);
-                        task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
-                        waitingTasks++;
-                    } else if (task->checkFunc(currentTimeBeforeCheckFuncCallUs, cmpTimeUs(currentTimeBeforeCheckFuncCallUs, task->lastExecutedAtUs))) {
-#if defined(SCHEDULER_DEBUG)
-                        DEBUG_SET(DEBUG_SCHEDULER, 3, micros() - currentTimeBeforeCheckFuncCallUs);
-#endif
-#if defined(USE_TASK_STATISTICS)
-                        if (calculateTaskStatistics) {
-                            const uint32_t checkFuncExecutionTimeUs = micros() - currentTimeBeforeCheckFuncCallUs;
-                            checkFuncMovingSumExecutionTimeUs += checkFuncExecutionTimeUs - checkFuncMovingSumExecutionTimeUs / TASK_STATS_MOVING_SUM_COUNT;
-                            checkFuncMovingSumDeltaTimeUs += task->taskLatestDeltaTimeUs - checkFuncMovingSumDeltaTimeUs / TASK_STATS_MOVING_SUM_COUNT;
-                            checkFuncTotalExecutionTimeUs += checkFuncExecutionTimeUs;   // time consumed by scheduler + task
-                            checkFuncMaxExecutionTimeUs = MAX(checkFuncMaxExecutionTimeUs, checkFuncExecutionTimeUs);
-                        }
-#endif
-                        task->lastSignaledAtUs = currentTimeBeforeCheckFuncCallUs;
-                        task->taskAgeCycles = 1;
-                        task->dynamicPriority = 1 + task->staticPriority;
-                        waitingTasks++;
+        if (deadlineQueueEnabled) {
+            if (deadlineQueueDirty) {
+                deadlineQueueRebuild();
+            }
+            selectedTask = deadlineQueueSelect(currentTimeUs, &selectedTaskDynamicPriority, &waitingTasks, &selectedHeapIndex);
+        } else {
+            // Update task dynamic priorities
+            for (task_t *task = queueFirst(); task != NULL; task = queueNext()) {
+                if (task->staticPriority != TASK_PRIORITY_REALTIME) {
+                    if (task->checkFunc) {
+                        waitingTasks += updateEventTaskPriority(task, currentTimeUs);
                     } else {
-                        task->taskAgeCycles = 0;
-                    }
-                } else {
-                    // Task is time-driven, dynamicPriority is last execution age (measured in desiredPeriods)
-                    // Task age is calculated from last execution
-                    task->taskAgeCycles = ((currentTimeUs - getPeriodCalculationBasis(task)) / task->desiredPeriodUs);
-                    if (task->taskAgeCycles > 0) {
-                        task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
-                        waitingTasks++;
+                        waitingTasks += updateTimedTaskPriority(task, currentTimeUs);
                     }
-                }
 
-                if (task->dynamicPriority > selectedTaskDynamicPriority) {
-                    selectedTaskDynamicPriority = task->dynamicPriority;
-                    selectedTask = task;
+                    if (task->dynamicPriority > selectedTaskDynamicPriority) {
+                        selectedTaskDynamicPriority = task->dynamicPriority;
+                        selectedTask = task;
+                    }
                 }
             }
         }
@@ -421,7 +672,16 @@ FAST_CODE void scheduler(void)
             // Add in the time spent so far in check functions and the scheduler logic
             taskRequiredTimeUs += cmpTimeUs(micros(), currentTimeUs);
             if (!gyroEnabled || realtimeTaskRan || (taskRequiredTimeUs < gyroTaskDelayUs)) {
+                if (gyroEnabled) {
+                    const task_t *gyroTask = getTask(TASK_GYRO);
+                    const timeUs_t gyroExecuteTimeUs = getPeriodCalculationBasis(gyroTask) + gyroTask->desiredPeriodUs;
+                    taskTimeBudgetUs = cmpTimeUs(gyroExecuteTimeUs, micros()) - GYRO_TASK_GUARD_INTERVAL_US;
+                }
                 taskExecutionTimeUs += schedulerExecuteTask(selectedTask, currentTimeUs);
+                if (selectedHeapIndex >= 0 && !deadlineQueueDirty) {
+                    // The task's next due time has moved on, restore the heap order
+                    deadlineHeapSiftDown(selectedHeapIndex);
+                }
             } else {
                 selectedTask = NULL;
             }
@@ -28,11 +28,16 @@
 #define TASK_PERIOD_US(us) (us)
 
 #define GYRO_TASK_GUARD_INTERVAL_US 10  // Don't run any other tasks if gyro task will be run soon
+#define TASK_TIME_BUDGET_UNLIMITED_US INT32_MAX // Budget given to tasks while the gyro task isn't running
 
 #if defined(USE_TASK_STATISTICS)
 #define TASK_STATS_MOVING_SUM_COUNT 32
 #endif
 
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+#define TASK_HISTOGRAM_BUCKET_COUNT 16  // log2 buckets, bucket n counts [2^(n-1), 2^n) us, the last bucket is open ended
+#endif
+
 #define LOAD_PERCENTAGE_ONE 100
 
 typedef enum {
@@ -66,6 +71,18 @@ typedef struct {
     float        movingAverageCycleTimeUs;
 } taskInfo_t;
 
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+typedef struct {
+    uint16_t count[TASK_HISTOGRAM_BUCKET_COUNT];    // all buckets are halved when one saturates
+} taskHistogram_t;
+
+typedef struct {
+    uint32_t     startCount;
+    uint32_t     lateStartCount;    // started more than GYRO_TASK_GUARD_INTERVAL_US after the sample was due
+    timeDelta_t  maxLateUs;
+} gyroLateStartInfo_t;
+#endif
+
 typedef enum {
     /* Actual tasks */
     TASK_SYSTEM = 0,
@@ -180,6 +197,10 @@ typedef struct {
     timeUs_t maxExecutionTimeUs;
     timeUs_t totalExecutionTimeUs;    // total time consumed by task since boot
 #endif
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+    taskHistogram_t executionTimeHistogram;
+    taskHistogram_t startLatenessHistogram;  // how late the task started relative to when it was due or signaled
+#endif
 } task_t;
 
 void getCheckFuncInfo(cfCheckFuncInfo_t *checkFuncInfo);
@@ -187,15 +208,24 @@ void getTaskInfo(taskId_e taskId, taskInfo_t *taskInfo);
 void rescheduleTask(taskId_e taskId, timeDelta_t newPeriodUs);
 void setTaskEnabled(taskId_e taskId, bool newEnabledState);
 timeDelta_t getTaskDeltaTimeUs(taskId_e taskId);
+timeDelta_t getTaskTimeBudgetUs(void);
 void schedulerSetCalulateTaskStatistics(bool calculateTaskStatistics);
 void schedulerResetTaskStatistics(taskId_e taskId);
 void schedulerResetTaskMaxExecutionTime(taskId_e taskId);
 void schedulerResetCheckFunctionMaxExecutionTime(void);
+#if defined(USE_TASK_LATENCY_HISTOGRAM)
+void getTaskHistograms(taskId_e taskId, taskHistogram_t *executionTimeHistogram, taskHistogram_t *startLatenessHistogram);
+uint32_t taskHistogramPercentileUs(const taskHistogram_t *histogram, unsigned permille);
+uint32_t taskHistogramTotalCount(const taskHistogram_t *histogram);
+uint32_t taskHistogramBucketLowerBoundUs(unsigned bucket);
+void getGyroLateStartInfo(gyroLateStartInfo_t *gyroLateStartInfo);
+#endif
 
 void schedulerInit(void);
 void scheduler(void);
 timeUs_t schedulerExecuteTask(task_t *selectedTask, timeUs_t currentTimeUs);
 void taskSystemLoad(timeUs_t currentTimeUs);
 void schedulerOptimizeRate(bool optimizeRate);
+void schedulerUseDeadlineQueue(bool useDeadlineQueue);
 void schedulerEnableGyro(void);
 uint16_t getAverageSystemLoadPercent(void);
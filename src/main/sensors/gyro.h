@@ -87,25 +87,16 @@ typedef struct gyro_s {
 
     gyroDev_t *rawSensorDev;           // pointer to the sensor providing the raw data for DEBUG_GYRO_RAW
 
-    // lowpass gyro soft filter
-    filterApplyFnPtr lowpassFilterApplyFn;
-    gyroLowpassFilter_t lowpassFilter[XYZ_AXIS_COUNT];
-
     // lowpass2 gyro soft filter
     filterApplyFnPtr lowpass2FilterApplyFn;
     gyroLowpassFilter_t lowpass2Filter[XYZ_AXIS_COUNT];
 
-    // notch filters
-    filterApplyFnPtr notchFilter1ApplyFn;
-    biquadFilter_t notchFilter1[XYZ_AXIS_COUNT];
-
-    filterApplyFnPtr notchFilter2ApplyFn;
-    biquadFilter_t notchFilter2[XYZ_AXIS_COUNT];
+    // static notch 1, static notch 2 and lowpass gyro soft filter, all axes in one pass
+    filterBank_t staticFilterBank;
+    int8_t lowpassFilterStage;         // stage of the lowpass filter in staticFilterBank, -1 if not enabled
 
-    filterApplyFnPtr notchFilterDynApplyFn;
-    filterApplyFnPtr notchFilterDynApplyFn2;
-    biquadFilter_t notchFilterDyn[XYZ_AXIS_COUNT];
-    biquadFilter_t notchFilterDyn2[XYZ_AXIS_COUNT];
+    // dynamic notch filters, one stage per tracked peak, or notch 1 and notch 2 around a single peak
+    filterBank_t notchFilterDynBank;
 
 #ifdef USE_GYRO_DATA_ANALYSE
     gyroAnalyseState_t gyroAnalyseState;
@@ -146,6 +137,11 @@ enum {
     DYN_LPF_BIQUAD
 };
 
+typedef enum {
+    DYN_NOTCH_ANALYSER_FFT = 0,
+    DYN_NOTCH_ANALYSER_SDFT
+} dynNotchAnalyser_e;
+
 typedef enum {
     YAW_SPIN_RECOVERY_OFF,
     YAW_SPIN_RECOVERY_ON,
@@ -156,11 +152,6 @@ typedef enum {
 #define GYRO_CONFIG_USE_GYRO_2      1
 #define GYRO_CONFIG_USE_GYRO_BOTH   2
 
-enum {
-    FILTER_LOWPASS = 0,
-    FILTER_LOWPASS2
-};
-
 typedef struct gyroConfig_s {
     uint8_t  gyroMovementCalibrationThreshold; // people keep forgetting that moving model while init results in wrong gyro offsets. and then they never reset gyro. so this is now on by default.
     uint8_t  gyro_hardware_lpf;                // gyro DLPF setting
@@ -199,6 +190,8 @@ typedef struct gyroConfig_s {
 
     uint8_t gyrosDetected; // What gyros should detection be attempted for on startup. Automatically set on first startup.
     uint8_t dyn_lpf_curve_expo; // set the curve for dynamic gyro lowpass filter
+    uint8_t dyn_notch_analyser; // spectrum estimator used by the dynamic notch, see dynNotchAnalyser_e
+    uint8_t dyn_notch_count; // number of peaks tracked per axis, each with its own notch
 } gyroConfig_t;
 
 PG_DECLARE(gyroConfig_t, gyroConfig);
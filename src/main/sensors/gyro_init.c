@@ -99,76 +99,61 @@ static uint16_t calculateNyquistAdjustedNotchHz(uint16_t notchHz, uint16_t notch
     return notchHz;
 }
 
-static void gyroInitFilterNotch1(uint16_t notchHz, uint16_t notchCutoffHz)
+static void gyroInitFilterNotch(uint16_t notchHz, uint16_t notchCutoffHz)
 {
-    gyro.notchFilter1ApplyFn = nullFilterApply;
-
     notchHz = calculateNyquistAdjustedNotchHz(notchHz, notchCutoffHz);
 
     if (notchHz != 0 && notchCutoffHz != 0) {
-        gyro.notchFilter1ApplyFn = (filterApplyFnPtr)biquadFilterApply;
         const float notchQ = filterGetNotchQ(notchHz, notchCutoffHz);
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            biquadFilterInit(&gyro.notchFilter1[axis], notchHz, gyro.targetLooptime, notchQ, FILTER_NOTCH);
-        }
-    }
-}
-
-static void gyroInitFilterNotch2(uint16_t notchHz, uint16_t notchCutoffHz)
-{
-    gyro.notchFilter2ApplyFn = nullFilterApply;
-
-    notchHz = calculateNyquistAdjustedNotchHz(notchHz, notchCutoffHz);
-
-    if (notchHz != 0 && notchCutoffHz != 0) {
-        gyro.notchFilter2ApplyFn = (filterApplyFnPtr)biquadFilterApply;
-        const float notchQ = filterGetNotchQ(notchHz, notchCutoffHz);
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            biquadFilterInit(&gyro.notchFilter2[axis], notchHz, gyro.targetLooptime, notchQ, FILTER_NOTCH);
-        }
+        filterBankAddBiquad(&gyro.staticFilterBank, FILTER_BANK_BIQUAD, notchHz, gyro.targetLooptime, notchQ, FILTER_NOTCH);
     }
 }
 
 #ifdef USE_GYRO_DATA_ANALYSE
 static void gyroInitFilterDynamicNotch()
 {
-    gyro.notchFilterDynApplyFn = nullFilterApply;
-    gyro.notchFilterDynApplyFn2 = nullFilterApply;
+    filterBankInit(&gyro.notchFilterDynBank);
 
     if (isDynamicFilterActive()) {
-        gyro.notchFilterDynApplyFn = (filterApplyFnPtr)biquadFilterApplyDF1; // must be this function, not DF2
-        if(gyroConfig()->dyn_notch_width_percent != 0) {
-            gyro.notchFilterDynApplyFn2 = (filterApplyFnPtr)biquadFilterApplyDF1; // must be this function, not DF2
-        }
         const float notchQ = filterGetNotchQ(DYNAMIC_NOTCH_DEFAULT_CENTER_HZ, DYNAMIC_NOTCH_DEFAULT_CUTOFF_HZ); // any defaults OK here
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            biquadFilterInit(&gyro.notchFilterDyn[axis], DYNAMIC_NOTCH_DEFAULT_CENTER_HZ, gyro.targetLooptime, notchQ, FILTER_NOTCH);
-            biquadFilterInit(&gyro.notchFilterDyn2[axis], DYNAMIC_NOTCH_DEFAULT_CENTER_HZ, gyro.targetLooptime, notchQ, FILTER_NOTCH);
+        // must be DF1, not DF2, as the coefficients are updated continuously
+        // one notch per peak, or a pair of notches either side of a single peak
+        int notchCount = constrain(gyroConfig()->dyn_notch_count, 1, DYN_NOTCH_COUNT_MAX);
+        if (notchCount == 1 && gyroConfig()->dyn_notch_width_percent != 0) {
+            notchCount = 2;
+        }
+        for (int i = 0; i < notchCount; i++) {
+            filterBankAddBiquad(&gyro.notchFilterDynBank, FILTER_BANK_BIQUAD_DF1, DYNAMIC_NOTCH_DEFAULT_CENTER_HZ, gyro.targetLooptime, notchQ, FILTER_NOTCH);
         }
     }
 }
 #endif
 
-static bool gyroInitLowpassFilterLpf(int slot, int type, uint16_t lpfHz, uint32_t looptime)
+static void gyroInitLowpassFilter(int type, uint16_t lpfHz, uint32_t looptime)
 {
-    filterApplyFnPtr *lowpassFilterApplyFn;
-    gyroLowpassFilter_t *lowpassFilter = NULL;
-
-    switch (slot) {
-    case FILTER_LOWPASS:
-        lowpassFilterApplyFn = &gyro.lowpassFilterApplyFn;
-        lowpassFilter = gyro.lowpassFilter;
-        break;
+    gyro.lowpassFilterStage = -1;
 
-    case FILTER_LOWPASS2:
-        lowpassFilterApplyFn = &gyro.lowpass2FilterApplyFn;
-        lowpassFilter = gyro.lowpass2Filter;
-        break;
+    const uint32_t gyroFrequencyNyquist = 1000000 / 2 / looptime;
 
-    default:
-        return false;
+    // If lowpass cutoff has been specified and is less than the Nyquist frequency
+    if (lpfHz && lpfHz <= gyroFrequencyNyquist) {
+        switch (type) {
+        case FILTER_PT1:
+            gyro.lowpassFilterStage = filterBankAddPt1(&gyro.staticFilterBank, pt1FilterGain(lpfHz, looptime * 1e-6f));
+            break;
+        case FILTER_BIQUAD:
+#ifdef USE_DYN_LPF
+            gyro.lowpassFilterStage = filterBankAddBiquad(&gyro.staticFilterBank, FILTER_BANK_BIQUAD_DF1, lpfHz, looptime, BIQUAD_Q, FILTER_LPF);
+#else
+            gyro.lowpassFilterStage = filterBankAddBiquad(&gyro.staticFilterBank, FILTER_BANK_BIQUAD, lpfHz, looptime, BIQUAD_Q, FILTER_LPF);
+#endif
+            break;
+        }
     }
+}
 
+static bool gyroInitLowpass2Filter(int type, uint16_t lpfHz, uint32_t looptime)
+{
     bool ret = false;
 
     // Establish some common constants
@@ -180,26 +165,26 @@ static bool gyroInitLowpassFilterLpf(int slot, int type, uint16_t lpfHz, uint32_
 
     // Dereference the pointer to null before checking valid cutoff and filter
     // type. It will be overridden for positive cases.
-    *lowpassFilterApplyFn = nullFilterApply;
+    gyro.lowpass2FilterApplyFn = nullFilterApply;
 
     // If lowpass cutoff has been specified and is less than the Nyquist frequency
     if (lpfHz && lpfHz <= gyroFrequencyNyquist) {
         switch (type) {
         case FILTER_PT1:
-            *lowpassFilterApplyFn = (filterApplyFnPtr) pt1FilterApply;
+            gyro.lowpass2FilterApplyFn = (filterApplyFnPtr) pt1FilterApply;
             for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-                pt1FilterInit(&lowpassFilter[axis].pt1FilterState, gain);
+                pt1FilterInit(&gyro.lowpass2Filter[axis].pt1FilterState, gain);
             }
             ret = true;
             break;
         case FILTER_BIQUAD:
 #ifdef USE_DYN_LPF
-            *lowpassFilterApplyFn = (filterApplyFnPtr) biquadFilterApplyDF1;
+            gyro.lowpass2FilterApplyFn = (filterApplyFnPtr) biquadFilterApplyDF1;
 #else
-            *lowpassFilterApplyFn = (filterApplyFnPtr) biquadFilterApply;
+            gyro.lowpass2FilterApplyFn = (filterApplyFnPtr) biquadFilterApply;
 #endif
             for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-                biquadFilterInitLPF(&lowpassFilter[axis].biquadFilterState, lpfHz, looptime);
+                biquadFilterInitLPF(&gyro.lowpass2Filter[axis].biquadFilterState, lpfHz, looptime);
             }
             ret = true;
             break;
@@ -242,22 +227,18 @@ void gyroInitFilters(void)
     }
 #endif
 
-    gyroInitLowpassFilterLpf(
-      FILTER_LOWPASS,
-      gyroConfig()->gyro_lowpass_type,
-      gyro_lowpass_hz,
-      gyro.targetLooptime
-    );
+    // the static filters are run in this order: notch 1, notch 2, lowpass
+    filterBankInit(&gyro.staticFilterBank);
+    gyroInitFilterNotch(gyroConfig()->gyro_soft_notch_hz_1, gyroConfig()->gyro_soft_notch_cutoff_1);
+    gyroInitFilterNotch(gyroConfig()->gyro_soft_notch_hz_2, gyroConfig()->gyro_soft_notch_cutoff_2);
+    gyroInitLowpassFilter(gyroConfig()->gyro_lowpass_type, gyro_lowpass_hz, gyro.targetLooptime);
 
-    gyro.downsampleFilterEnabled = gyroInitLowpassFilterLpf(
-      FILTER_LOWPASS2,
+    gyro.downsampleFilterEnabled = gyroInitLowpass2Filter(
       gyroConfig()->gyro_lowpass2_type,
       gyroConfig()->gyro_lowpass2_hz,
       gyro.sampleLooptime
     );
 
-    gyroInitFilterNotch1(gyroConfig()->gyro_soft_notch_hz_1, gyroConfig()->gyro_soft_notch_cutoff_1);
-    gyroInitFilterNotch2(gyroConfig()->gyro_soft_notch_hz_2, gyroConfig()->gyro_soft_notch_cutoff_2);
 #ifdef USE_GYRO_DATA_ANALYSE
     gyroInitFilterDynamicNotch();
 #endif
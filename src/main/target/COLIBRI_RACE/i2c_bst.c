@@ -31,6 +31,7 @@
 
 #include "fc/controlrate_profile.h"
 #include "fc/core.h"
+#include "fc/rc.h"
 #include "fc/rc_adjustments.h"
 #include "fc/rc_controls.h"
 #include "fc/runtime_config.h"
@@ -470,6 +471,7 @@ static bool bstSlaveProcessWriteCommand(uint8_t bstWriteCommand)
                 if (bstReadDataSize() >= 12) {
                     currentControlRateProfile->rcRates[FD_YAW] = bstRead8();
                 }
+                initRcProcessing();
             } else {
                 ret = BST_FAILED;
             }
@@ -0,0 +1,153 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shmlink.h"
+
+int shmInit(shmLink_t *link, const char *name, bool isServer)
+{
+    memset(link, 0, sizeof(*link));
+    link->fd = -1;
+    link->name = name;
+    link->isServer = isServer;
+
+    if (isServer) {
+        link->fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+        if (link->fd == -1 || ftruncate(link->fd, sizeof(shmRegion_t)) == -1) {
+            return -2;
+        }
+    } else {
+        link->fd = shm_open(name, O_RDWR, 0);
+        if (link->fd == -1) {
+            return -2;
+        }
+    }
+
+    void *region = mmap(NULL, sizeof(shmRegion_t), PROT_READ | PROT_WRITE, MAP_SHARED, link->fd, 0);
+    if (region == MAP_FAILED) {
+        return -1;
+    }
+    link->region = region;
+
+    if (isServer) {
+        // a client left over from a previous run must see the region change under it
+        __atomic_store_n(&link->region->magic, 0, __ATOMIC_RELEASE);
+        memset(&link->region->toServer, 0, sizeof(link->region->toServer));
+        memset(&link->region->toClient, 0, sizeof(link->region->toClient));
+        link->region->version = SHM_LINK_VERSION;
+        link->region->slotCount = SHM_RING_SLOT_COUNT;
+        link->region->slotDataSize = SHM_RING_SLOT_DATA_SIZE;
+        __atomic_store_n(&link->region->magic, SHM_LINK_MAGIC, __ATOMIC_RELEASE);
+    } else if (__atomic_load_n(&link->region->magic, __ATOMIC_ACQUIRE) != SHM_LINK_MAGIC
+        || link->region->version != SHM_LINK_VERSION
+        || link->region->slotCount != SHM_RING_SLOT_COUNT
+        || link->region->slotDataSize != SHM_RING_SLOT_DATA_SIZE) {
+        return -1;
+    }
+
+    link->rxRing = isServer ? &link->region->toServer : &link->region->toClient;
+    link->txRing = isServer ? &link->region->toClient : &link->region->toServer;
+
+    return 0;
+}
+
+void shmClose(shmLink_t *link)
+{
+    if (link->region) {
+        munmap(link->region, sizeof(shmRegion_t));
+        link->region = NULL;
+    }
+    if (link->fd != -1) {
+        close(link->fd);
+        link->fd = -1;
+        if (link->isServer) {
+            shm_unlink(link->name);
+        }
+    }
+}
+
+int shmSend(shmLink_t *link, const void *data, size_t size)
+{
+    shmRing_t *ring = link->txRing;
+
+    if (size > SHM_RING_SLOT_DATA_SIZE) {
+        return -2;
+    }
+
+    const uint32_t head = ring->head;   // only this side writes head
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= SHM_RING_SLOT_COUNT) {
+        link->txDropCount++;
+        return -1;
+    }
+
+    shmSlot_t *slot = &ring->slots[head % SHM_RING_SLOT_COUNT];
+    memcpy(slot->data, data, size);
+    slot->size = size;
+    slot->seq = head;
+
+    // publish the slot contents before the new head
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    return size;
+}
+
+static uint64_t shmNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int shmRecv(shmLink_t *link, void *data, size_t size, uint32_t timeout_ms)
+{
+    shmRing_t *ring = link->rxRing;
+    const uint32_t tail = ring->tail;   // only this side writes tail
+
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+        // yield rather than sleep, in lockstep the peer is usually only a few microseconds away
+        const uint64_t deadline = shmNanos() + timeout_ms * 1000000ULL;
+        do {
+            if (shmNanos() > deadline) {
+                return -1;
+            }
+            sched_yield();
+        } while (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail);
+    }
+
+    const shmSlot_t *slot = &ring->slots[tail % SHM_RING_SLOT_COUNT];
+    int ret = -2;
+    if (slot->seq == tail && slot->size <= SHM_RING_SLOT_DATA_SIZE) {
+        ret = slot->size < size ? slot->size : size;
+        memcpy(data, slot->data, ret);
+    }
+
+    // hand the slot back to the producer once it has been copied out
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return ret;
+}
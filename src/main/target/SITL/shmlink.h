@@ -0,0 +1,86 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Shared memory link between the SITL and a simulator on the same machine.
+//
+// The region holds two single producer, single consumer rings, one per direction,
+// so neither side ever takes a lock. head and tail are free running sequence numbers,
+// the slot of a packet is its sequence number modulo SHM_RING_SLOT_COUNT, and every
+// slot carries the sequence number it was written with.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHM_LINK_MAGIC          0x4d534642  // "BFSM"
+#define SHM_LINK_VERSION        1
+
+#define SHM_RING_SLOT_COUNT     16          // must be a power of two
+#define SHM_RING_SLOT_DATA_SIZE 248
+
+#define SHM_CACHE_LINE_SIZE     64
+
+typedef struct shmSlot_s {
+    uint32_t seq;
+    uint32_t size;
+    uint8_t data[SHM_RING_SLOT_DATA_SIZE];
+} shmSlot_t;
+
+typedef struct shmRing_s {
+    // each index on its own cache line, so producer and consumer don't contend
+    uint32_t head __attribute__((aligned(SHM_CACHE_LINE_SIZE)));    // next sequence number to write, only written by the producer
+    uint32_t tail __attribute__((aligned(SHM_CACHE_LINE_SIZE)));    // next sequence number to read, only written by the consumer
+    shmSlot_t slots[SHM_RING_SLOT_COUNT] __attribute__((aligned(SHM_CACHE_LINE_SIZE)));
+} shmRing_t;
+
+typedef struct shmRegion_s {
+    uint32_t magic;                         // stored last by the server once the region is initialised
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotDataSize;
+    shmRing_t toServer;                     // simulator -> SITL
+    shmRing_t toClient;                     // SITL -> simulator
+} shmRegion_t;
+
+typedef struct {
+    int fd;
+    const char *name;
+    bool isServer;
+    shmRegion_t *region;
+    shmRing_t *rxRing;
+    shmRing_t *txRing;
+    uint32_t txDropCount;                   // packets not sent because the peer was not keeping up
+} shmLink_t;
+
+// The server creates and initialises the region, the client maps an existing one
+int shmInit(shmLink_t *link, const char *name, bool isServer);
+void shmClose(shmLink_t *link);
+int shmRecv(shmLink_t *link, void *data, size_t size, uint32_t timeout_ms);
+int shmSend(shmLink_t *link, const void *data, size_t size);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,211 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/maths.h"
+
+#include "sim_quad.h"
+
+#define GRAVITY 9.80665
+
+// ArduCopter X order, body frame position of each motor in units of armLength / sqrt(2)
+static const double motorX[SIM_QUAD_MOTOR_COUNT] = {  1, -1,  1, -1 };
+static const double motorY[SIM_QUAD_MOTOR_COUNT] = {  1, -1, -1,  1 };
+// reaction torque about body z, a counter-clockwise prop yaws the body clockwise, which is positive in FRD
+static const double motorYaw[SIM_QUAD_MOTOR_COUNT] = { 1, 1, -1, -1 };
+
+void simQuadConfigDefaults(simQuadConfig_t *config)
+{
+    // a 5" freestyle quad on 6S
+    config->mass = 0.65;
+    config->armLength = 0.11;
+    config->inertia[0] = 0.0009;
+    config->inertia[1] = 0.0010;
+    config->inertia[2] = 0.0016;
+    config->maxThrust = 9.0;
+    config->yawTorqueRatio = 0.016;
+    config->motorTimeConstant = 0.01;
+    config->maxMotorHz = 450.0;
+    config->linearDrag = 0.05;
+    config->angularDrag = 0.0005;
+    config->gyroNoise = 0.01;
+    config->accNoise = 0.2;
+    config->gyroVibration = 0.5;
+    config->accVibration = 4.0;
+}
+
+void simQuadInit(simQuad_t *quad, const simQuadConfig_t *config, uint32_t noiseSeed)
+{
+    memset(quad, 0, sizeof(*quad));
+    quad->config = *config;
+    quad->quat[0] = 1;
+    quad->specificForce[2] = -GRAVITY;
+    quad->noiseSeed = noiseSeed ? noiseSeed : 1;
+}
+
+void simQuadSetMotors(simQuad_t *quad, const servo_packet *pkt)
+{
+    for (int i = 0; i < SIM_QUAD_MOTOR_COUNT; i++) {
+        quad->motorCommand[i] = constrainf(pkt->motor_speed[i], 0.0f, 1.0f);
+    }
+}
+
+// Roughly normal, sum of four uniform values, deterministic for a given seed
+static double simQuadNoise(simQuad_t *quad)
+{
+    double sum = 0;
+    for (int i = 0; i < 4; i++) {
+        quad->noiseSeed ^= quad->noiseSeed << 13;
+        quad->noiseSeed ^= quad->noiseSeed >> 17;
+        quad->noiseSeed ^= quad->noiseSeed << 5;
+        sum += (double)quad->noiseSeed / UINT32_MAX - 0.5;
+    }
+    return sum * 1.7320508;   // unit variance
+}
+
+// v_earth = q * v_body * q^-1
+static void rotateToEarth(const double *q, const double *v, double *out)
+{
+    const double w = q[0], x = q[1], y = q[2], z = q[3];
+    out[0] = (1 - 2 * (y * y + z * z)) * v[0] + 2 * (x * y - w * z) * v[1] + 2 * (x * z + w * y) * v[2];
+    out[1] = 2 * (x * y + w * z) * v[0] + (1 - 2 * (x * x + z * z)) * v[1] + 2 * (y * z - w * x) * v[2];
+    out[2] = 2 * (x * z - w * y) * v[0] + 2 * (y * z + w * x) * v[1] + (1 - 2 * (x * x + y * y)) * v[2];
+}
+
+static void rotateToBody(const double *q, const double *v, double *out)
+{
+    const double conjugate[4] = { q[0], -q[1], -q[2], -q[3] };
+    rotateToEarth(conjugate, v, out);
+}
+
+void simQuadStep(simQuad_t *quad, double dt)
+{
+    const simQuadConfig_t *config = &quad->config;
+
+    double thrust = 0;
+    double torque[3] = { 0, 0, 0 };
+    const double arm = config->armLength * M_SQRT1_2;
+
+    for (int i = 0; i < SIM_QUAD_MOTOR_COUNT; i++) {
+        quad->motorSpeed[i] += (quad->motorCommand[i] - quad->motorSpeed[i]) * MIN(dt / config->motorTimeConstant, 1.0);
+        quad->motorPhase[i] = fmod(quad->motorPhase[i] + 2 * M_PI * config->maxMotorHz * quad->motorSpeed[i] * dt, 2 * M_PI);
+
+        // thrust grows with the square of the speed and pushes up, along -z
+        const double motorThrust = config->maxThrust * quad->motorSpeed[i] * quad->motorSpeed[i];
+        thrust += motorThrust;
+        torque[0] -= motorY[i] * arm * motorThrust;
+        torque[1] += motorX[i] * arm * motorThrust;
+        torque[2] += motorYaw[i] * config->yawTorqueRatio * motorThrust;
+    }
+
+    // rotation, I * dw/dt = torque - w x (I * w)
+    const double *w = quad->rate;
+    const double iw[3] = { config->inertia[0] * w[0], config->inertia[1] * w[1], config->inertia[2] * w[2] };
+    const double gyroscopic[3] = { w[1] * iw[2] - w[2] * iw[1], w[2] * iw[0] - w[0] * iw[2], w[0] * iw[1] - w[1] * iw[0] };
+    for (int axis = 0; axis < 3; axis++) {
+        torque[axis] -= config->angularDrag * w[axis] + gyroscopic[axis];
+    }
+
+    // translation, thrust and drag, in the earth frame
+    const double thrustBody[3] = { 0, 0, -thrust };
+    double force[3];
+    rotateToEarth(quad->quat, thrustBody, force);
+    const double speed = sqrt(quad->velocity[0] * quad->velocity[0] + quad->velocity[1] * quad->velocity[1] + quad->velocity[2] * quad->velocity[2]);
+    for (int axis = 0; axis < 3; axis++) {
+        force[axis] -= config->linearDrag * speed * quad->velocity[axis];
+    }
+
+    const bool onGround = quad->position[2] >= 0 && force[2] + config->mass * GRAVITY >= 0;
+    if (onGround) {
+        // resting on the ground, which carries the weight and stops any motion
+        memset(quad->velocity, 0, sizeof(quad->velocity));
+        memset(quad->rate, 0, sizeof(quad->rate));
+        quad->position[2] = 0;
+        const double normal[3] = { 0, 0, -GRAVITY };
+        rotateToBody(quad->quat, normal, quad->specificForce);
+    } else {
+        double acceleration[3];
+        for (int axis = 0; axis < 3; axis++) {
+            acceleration[axis] = force[axis] / config->mass;
+            quad->velocity[axis] += acceleration[axis] * dt;
+            quad->position[axis] += quad->velocity[axis] * dt;
+        }
+        rotateToBody(quad->quat, acceleration, quad->specificForce);
+
+        for (int axis = 0; axis < 3; axis++) {
+            quad->rate[axis] += torque[axis] / config->inertia[axis] * dt;
+        }
+
+        // dq/dt = q * (0, w) / 2
+        double *q = quad->quat;
+        const double dq[4] = {
+            0.5 * (-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]),
+            0.5 * ( q[0] * w[0] + q[2] * w[2] - q[3] * w[1]),
+            0.5 * ( q[0] * w[1] - q[1] * w[2] + q[3] * w[0]),
+            0.5 * ( q[0] * w[2] + q[1] * w[1] - q[2] * w[0]),
+        };
+        double norm = 0;
+        for (int i = 0; i < 4; i++) {
+            q[i] += dq[i] * dt;
+            norm += q[i] * q[i];
+        }
+        norm = 1 / sqrt(norm);
+        for (int i = 0; i < 4; i++) {
+            q[i] *= norm;
+        }
+    }
+
+    quad->time += dt;
+}
+
+void simQuadGetState(simQuad_t *quad, fdm_packet *pkt)
+{
+    const simQuadConfig_t *config = &quad->config;
+
+    // each motor shakes the frame at its rotation frequency and twice that
+    double gyroVibration[3] = { 0, 0, 0 };
+    double accVibration[3] = { 0, 0, 0 };
+    for (int i = 0; i < SIM_QUAD_MOTOR_COUNT; i++) {
+        const double amplitude = quad->motorSpeed[i] * quad->motorSpeed[i];
+        const double phase = quad->motorPhase[i];
+        const double harmonics = sin(phase) + 0.5 * sin(2 * phase + 1.0);
+        gyroVibration[0] += config->gyroVibration * amplitude * harmonics * motorY[i];
+        gyroVibration[1] += config->gyroVibration * amplitude * harmonics * motorX[i];
+        gyroVibration[2] += 0.3 * config->gyroVibration * amplitude * harmonics * motorYaw[i];
+        accVibration[0] += 0.5 * config->accVibration * amplitude * cos(phase) * motorX[i];
+        accVibration[1] += 0.5 * config->accVibration * amplitude * cos(phase) * motorY[i];
+        accVibration[2] += config->accVibration * amplitude * harmonics;
+    }
+
+    pkt->timestamp = quad->time;
+    for (int axis = 0; axis < 3; axis++) {
+        pkt->imu_angular_velocity_rpy[axis] = quad->rate[axis] + gyroVibration[axis] + config->gyroNoise * simQuadNoise(quad);
+        pkt->imu_linear_acceleration_xyz[axis] = quad->specificForce[axis] + accVibration[axis] + config->accNoise * simQuadNoise(quad);
+        pkt->velocity_xyz[axis] = quad->velocity[axis];
+        pkt->position_xyz[axis] = quad->position[axis];
+    }
+    for (int i = 0; i < 4; i++) {
+        pkt->imu_orientation_quat[i] = quad->quat[i];
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// In-process rigid body model of an X quad, used instead of an external simulator.
+// Uses the conventions of the gazebo ArduCopter plugin: body frame forward-right-down,
+// earth frame north-east-down, motors in ArduCopter order (front right, rear left,
+// front left, rear right), the first two spinning counter-clockwise seen from above.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SIM_QUAD_MOTOR_COUNT 4
+
+typedef struct simQuadConfig_s {
+    double mass;                 // kg
+    double armLength;            // m, centre to motor axis
+    double inertia[3];           // kg*m^2, about the body axes
+    double maxThrust;            // N per motor at full command
+    double yawTorqueRatio;       // Nm of reaction torque per N of thrust
+    double motorTimeConstant;    // s, first order lag of the motor speed
+    double maxMotorHz;           // rotation frequency at full speed
+    double linearDrag;           // N per (m/s)^2
+    double angularDrag;          // Nm per rad/s
+    double gyroNoise;            // rad/s, standard deviation of the gyro noise
+    double accNoise;             // m/s^2, standard deviation of the accelerometer noise
+    double gyroVibration;        // rad/s at full motor speed, amplitude of the motor harmonics on the gyro
+    double accVibration;         // m/s^2 at full motor speed, the same on the accelerometer
+} simQuadConfig_t;
+
+typedef struct simQuad_s {
+    simQuadConfig_t config;
+
+    double time;                // s
+    double quat[4];             // w, x, y, z, body to earth
+    double rate[3];             // rad/s, body frame
+    double velocity[3];         // m/s, earth frame
+    double position[3];         // m, earth frame, z = 0 is the ground
+    double motorCommand[SIM_QUAD_MOTOR_COUNT];   // 0 to 1
+    double motorSpeed[SIM_QUAD_MOTOR_COUNT];     // 0 to 1
+    double motorPhase[SIM_QUAD_MOTOR_COUNT];     // rad
+    double specificForce[3];    // m/s^2, body frame, what an accelerometer measures
+    uint32_t noiseSeed;
+} simQuad_t;
+
+void simQuadConfigDefaults(simQuadConfig_t *config);
+void simQuadInit(simQuad_t *quad, const simQuadConfig_t *config, uint32_t noiseSeed);
+void simQuadSetMotors(simQuad_t *quad, const servo_packet *pkt);
+void simQuadStep(simQuad_t *quad, double dt);
+void simQuadGetState(simQuad_t *quad, fdm_packet *pkt);
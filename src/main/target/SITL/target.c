@@ -53,9 +53,12 @@ const timerHardware_t timerHardware[1]; // unused
 #include "pg/motor.h"
 
 #include "rx/rx.h"
+#include "rx/msp.h"
 
 #include "dyad.h"
 #include "target/SITL/udplink.h"
+#include "target/SITL/shmlink.h"
+#include "target/SITL/sim_quad.h"
 
 uint32_t SystemCoreClock;
 
@@ -64,12 +67,54 @@ static servo_packet pwmPkt;
 
 static struct timespec start_time;
 static double simRate = 1.0;
-static pthread_t tcpWorker, udpWorker;
+static pthread_t tcpWorker, linkWorker;
 static bool workerRunning = true;
+static bool linkWorkerStarted = false;
 static udpLink_t stateLink, pwmLink;
+static shmLink_t shmLink;
 static pthread_mutex_t updateLock;
 static pthread_mutex_t mainLoopLock;
 
+typedef enum {
+    SIM_LINK_UDP = 0,
+    SIM_LINK_SHM,
+    SIM_LINK_QUAD       // built in quad model, always in lockstep
+} simLinkType_e;
+
+static simLinkType_e simLinkType = SIM_LINK_UDP;
+
+static simQuad_t simQuad;
+static double simQuadStepS = 125e-6;
+
+// Lockstep: the main loop waits for each simulator state, runs a fixed number of scheduler
+// passes at the simulator's time, then replies with exactly one motor update.
+#define LOCKSTEP_SCHEDULER_PASSES   4
+#define LOCKSTEP_RECV_TIMEOUT_MS    10  // keeps the CLI and MSP alive while no simulator is connected
+
+static bool lockstep = false;
+static bool lockstepRunning = false;    // set by the first simulator state, time is frozen between states after that
+static bool lockstepReplyPending = false;
+static int lockstepPasses = 0;
+static double lockstepStartTimestamp;   // simulator time of the first state, in seconds
+static uint64_t lockstepStartUs;        // micros64() when the first state arrived
+static uint64_t lockstepStartRealUs;
+static uint64_t lockstepTimeUs;
+
+// Batch runs: RC channels from a script, interpolated linearly between rows, the run ends after the last row
+#define SCRIPT_CHANNEL_COUNT    8   // in us and receiver order, with the default map roll, pitch, throttle, yaw, aux 1 to 4
+#define SCRIPT_FRAME_INTERVAL_US 4000   // like a 250Hz receiver, RC smoothing derives its cutoffs from the frame rate
+
+typedef struct scriptRow_s {
+    double time;                    // s since the first simulator state
+    double channels[SCRIPT_CHANNEL_COUNT];
+} scriptRow_t;
+
+static scriptRow_t *scriptRows = NULL;
+static int scriptRowCount = 0;
+static int scriptRowIdx = 0;
+static uint64_t scriptStepCount = 0;
+static uint64_t scriptNextFrameUs = 0;
+
 int timeval_sub(struct timespec *result, struct timespec *x, struct timespec *y);
 
 int lockMainPID(void) {
@@ -79,8 +124,30 @@ int lockMainPID(void) {
 #define RAD2DEG (180.0 / M_PI)
 #define ACC_SCALE (256 / 9.80665)
 #define GYRO_SCALE (16.4)
+static int simLinkRecv(fdm_packet *pkt, uint32_t timeout_ms) {
+    if (simLinkType == SIM_LINK_QUAD) {
+        simQuadStep(&simQuad, simQuadStepS);
+        simQuadGetState(&simQuad, pkt);
+        return sizeof(fdm_packet);
+    }
+    if (simLinkType == SIM_LINK_SHM) {
+        return shmRecv(&shmLink, pkt, sizeof(fdm_packet), timeout_ms);
+    }
+    return udpRecv(&stateLink, pkt, sizeof(fdm_packet), timeout_ms);
+}
+
+static void simLinkSend(const servo_packet *pkt) {
+    if (simLinkType == SIM_LINK_QUAD) {
+        simQuadSetMotors(&simQuad, pkt);
+    } else if (simLinkType == SIM_LINK_SHM) {
+        shmSend(&shmLink, pkt, sizeof(servo_packet));
+    } else {
+        udpSend(&pwmLink, pkt, sizeof(servo_packet));
+    }
+}
+
 void sendMotorUpdate() {
-    udpSend(&pwmLink, &pwmPkt, sizeof(servo_packet));
+    simLinkSend(&pwmPkt);
 }
 void updateState(const fdm_packet* pkt) {
     static double last_timestamp = 0; // in seconds
@@ -91,7 +158,17 @@ void updateState(const fdm_packet* pkt) {
     clock_gettime(CLOCK_MONOTONIC, &now_ts);
 
     const uint64_t realtime_now = micros64_real();
-    if (realtime_now > last_realtime + 500*1e3) { // 500ms timeout
+    if (lockstep) {
+        if (!lockstepRunning) {
+            // carry on from the current time, the simulator clock can start anywhere
+            lockstepStartTimestamp = pkt->timestamp;
+            lockstepStartUs = micros64();
+            lockstepStartRealUs = micros64_real();
+            lockstepTimeUs = lockstepStartUs;
+            last_timestamp = pkt->timestamp;
+            lockstepRunning = true;
+        }
+    } else if (realtime_now > last_realtime + 500*1e3) { // 500ms timeout
         last_timestamp = pkt->timestamp;
         last_realtime = realtime_now;
         sendMotorUpdate();
@@ -103,6 +180,11 @@ void updateState(const fdm_packet* pkt) {
         return;
     }
 
+    if (lockstep) {
+        // computed from the start rather than accumulated, so rounding can't drift
+        lockstepTimeUs = lockstepStartUs + llround((pkt->timestamp - lockstepStartTimestamp) * 1e6);
+    }
+
     int16_t x,y,z;
     x = constrain(-pkt->imu_linear_acceleration_xyz[0] * ACC_SCALE, -32767, 32767);
     y = constrain(-pkt->imu_linear_acceleration_xyz[1] * ACC_SCALE, -32767, 32767);
@@ -152,6 +234,12 @@ void updateState(const fdm_packet* pkt) {
     imuUpdateAttitude(micros());
 #endif
 
+    last_timestamp = pkt->timestamp;
+
+    if (lockstep) {
+        // nobody waits on the locks, the main loop itself replies once the step has run
+        return;
+    }
 
     if (deltaSim < 0.02 && deltaSim > 0) { // simulator should run faster than 50Hz
 //        simRate = simRate * 0.5 + (1e6 * deltaSim / (realtime_now - last_realtime)) * 0.5;
@@ -161,7 +249,6 @@ void updateState(const fdm_packet* pkt) {
     }
 //    printf("simRate = %lf, millis64 = %lu, millis64_real = %lu, deltaSim = %lf\n", simRate, millis64(), millis64_real(), deltaSim*1e6);
 
-    last_timestamp = pkt->timestamp;
     last_realtime = micros64_real();
 
     last_ts.tv_sec = now_ts.tv_sec;
@@ -174,22 +261,136 @@ void updateState(const fdm_packet* pkt) {
 #endif
 }
 
-static void* udpThread(void* data) {
+static void* linkThread(void* data) {
     UNUSED(data);
     int n = 0;
 
     while (workerRunning) {
-        n = udpRecv(&stateLink, &fdmPkt, sizeof(fdm_packet), 100);
+        n = simLinkRecv(&fdmPkt, 100);
         if (n == sizeof(fdm_packet)) {
 //            printf("[data]new fdm %d\n", n);
             updateState(&fdmPkt);
         }
     }
 
-    printf("udpThread end!!\n");
+    printf("linkThread end!!\n");
     return NULL;
 }
 
+static void scriptLoad(const char *filename) {
+    FILE *fd = fopen(filename, "r");
+    if (fd == NULL) {
+        fprintf(stderr, "[script] failed to open '%s'\n", filename);
+        exit(1);
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), fd)) {
+        scriptRow_t row = { .channels = { 1500, 1500, 1000, 1500, 1000, 1000, 1000, 1000 } };
+        char *pos = line;
+        char *end;
+        row.time = strtod(pos, &end);
+        if (end == pos) {
+            continue; // comment or empty line
+        }
+        for (int i = 0; i < SCRIPT_CHANNEL_COUNT; i++) {
+            pos = end;
+            const double value = strtod(pos, &end);
+            if (end == pos) {
+                break;
+            }
+            row.channels[i] = value;
+        }
+
+        scriptRows = realloc(scriptRows, (scriptRowCount + 1) * sizeof(scriptRow_t));
+        scriptRows[scriptRowCount++] = row;
+    }
+    fclose(fd);
+
+    printf("[script] %d rows, %.3fs from '%s'\n", scriptRowCount, scriptRowCount ? scriptRows[scriptRowCount - 1].time : 0, filename);
+}
+
+// Feeds the RC channels of the current simulator time, false once the script is over
+static bool scriptUpdate(void) {
+    const double time = (lockstepTimeUs - lockstepStartUs) * 1e-6;
+
+    while (scriptRowIdx < scriptRowCount && scriptRows[scriptRowIdx].time <= time) {
+        scriptRowIdx++;
+    }
+    if (scriptRowIdx >= scriptRowCount) {
+        return false;
+    }
+
+    scriptStepCount++;
+    if (lockstepTimeUs < scriptNextFrameUs) {
+        return true;
+    }
+    scriptNextFrameUs = lockstepTimeUs + SCRIPT_FRAME_INTERVAL_US;
+
+    const scriptRow_t *next = &scriptRows[scriptRowIdx];
+    const scriptRow_t *prev = scriptRowIdx > 0 ? &scriptRows[scriptRowIdx - 1] : next;
+    const double span = next->time - prev->time;
+    const double k = span > 0 ? (time - prev->time) / span : 1;
+
+    uint16_t frame[SCRIPT_CHANNEL_COUNT];
+    for (int i = 0; i < SCRIPT_CHANNEL_COUNT; i++) {
+        frame[i] = lrint(prev->channels[i] + (next->channels[i] - prev->channels[i]) * k);
+    }
+    rxMspFrameReceive(frame, SCRIPT_CHANNEL_COUNT);
+
+    return true;
+}
+
+static void stopWorkers(void);
+
+static void scriptFinish(void) {
+    const double simSeconds = (lockstepTimeUs - lockstepStartUs) * 1e-6;
+    const double realSeconds = (micros64_real() - lockstepStartRealUs) * 1e-6;
+    printf("[script] done, %llu steps, %.3fs simulated in %.3fs, %.1fx realtime\n",
+        (unsigned long long)scriptStepCount, simSeconds, realSeconds, realSeconds > 0 ? simSeconds / realSeconds : 0);
+    stopWorkers();
+    exit(0);
+}
+
+// Called by the main loop after every scheduler pass
+void simulatorLoopWait(void) {
+    if (!lockstep) {
+        delayMicroseconds_real(50); // max rate 20kHz
+        return;
+    }
+
+    if (lockstepRunning && ++lockstepPasses < LOCKSTEP_SCHEDULER_PASSES) {
+        return;
+    }
+
+    // step complete, one reply per state, with the motor outputs of the last PID loop
+    if (lockstepReplyPending) {
+        sendMotorUpdate();
+        lockstepReplyPending = false;
+    }
+
+    if (simLinkRecv(&fdmPkt, LOCKSTEP_RECV_TIMEOUT_MS) == sizeof(fdm_packet)) {
+        updateState(&fdmPkt);
+        lockstepReplyPending = true;
+        lockstepPasses = 0;
+
+        if (scriptRows && !scriptUpdate()) {
+            scriptFinish();
+        }
+    }
+}
+
+static void stopWorkers(void) {
+    workerRunning = false;
+    pthread_join(tcpWorker, NULL);
+    if (linkWorkerStarted) {
+        pthread_join(linkWorker, NULL);
+    }
+    if (simLinkType == SIM_LINK_SHM) {
+        shmClose(&shmLink);
+    }
+}
+
 static void* tcpThread(void* data) {
     UNUSED(data);
 
@@ -231,16 +432,61 @@ void systemInit(void) {
         exit(1);
     }
 
-    ret = udpInit(&pwmLink, "127.0.0.1", 9002, false);
-    printf("init PwmOut UDP link...%d\n", ret);
+    // the simulator link is chosen at startup: SITL_LINK=udp|shm|quad, SITL_SHM_NAME, SITL_LOCKSTEP=1
+    const char *linkType = getenv("SITL_LINK");
+    if (linkType && strcmp(linkType, "shm") == 0) {
+        simLinkType = SIM_LINK_SHM;
+    } else if (linkType && strcmp(linkType, "quad") == 0) {
+        simLinkType = SIM_LINK_QUAD;
+    }
+    const char *lockstepEnv = getenv("SITL_LOCKSTEP");
+    lockstep = (lockstepEnv && atoi(lockstepEnv) != 0) || simLinkType == SIM_LINK_QUAD;
+
+    const char *scriptFilename = getenv("SITL_SCRIPT");
+    if (scriptFilename) {
+        if (!lockstep) {
+            fprintf(stderr, "[script] needs lockstep\n");
+            exit(1);
+        }
+        scriptLoad(scriptFilename);
+    }
 
-    ret = udpInit(&stateLink, NULL, 9003, true);
-    printf("start UDP server...%d\n", ret);
+    if (simLinkType == SIM_LINK_QUAD) {
+        // SITL_STEP_US should match the gyro loop time, SITL_SEED varies the noise between runs
+        const char *stepEnv = getenv("SITL_STEP_US");
+        if (stepEnv && atoi(stepEnv) > 0) {
+            simQuadStepS = atoi(stepEnv) * 1e-6;
+        }
+        const char *seedEnv = getenv("SITL_SEED");
+        simQuadConfig_t config;
+        simQuadConfigDefaults(&config);
+        simQuadInit(&simQuad, &config, seedEnv ? strtoul(seedEnv, NULL, 0) : 1);
+        printf("built in quad model, %.0fus steps\n", simQuadStepS * 1e6);
+    } else if (simLinkType == SIM_LINK_SHM) {
+        const char *shmName = getenv("SITL_SHM_NAME");
+        ret = shmInit(&shmLink, shmName ? shmName : "/betaflight_sitl", true);
+        printf("start shared memory link %s...%d\n", shmLink.name, ret);
+        if (ret != 0) {
+            exit(1);
+        }
+    } else {
+        ret = udpInit(&pwmLink, "127.0.0.1", 9002, false);
+        printf("init PwmOut UDP link...%d\n", ret);
 
-    ret = pthread_create(&udpWorker, NULL, udpThread, NULL);
-    if (ret != 0) {
-        printf("Create udpWorker error!\n");
-        exit(1);
+        ret = udpInit(&stateLink, NULL, 9003, true);
+        printf("start UDP server...%d\n", ret);
+    }
+
+    if (lockstep) {
+        // states are received by the main loop, see simulatorLoopWait()
+        printf("lockstep with simulator time\n");
+    } else {
+        ret = pthread_create(&linkWorker, NULL, linkThread, NULL);
+        if (ret != 0) {
+            printf("Create linkWorker error!\n");
+            exit(1);
+        }
+        linkWorkerStarted = true;
     }
 
     // serial can't been slow down
@@ -249,18 +495,14 @@ void systemInit(void) {
 
 void systemReset(void){
     printf("[system]Reset!\n");
-    workerRunning = false;
-    pthread_join(tcpWorker, NULL);
-    pthread_join(udpWorker, NULL);
+    stopWorkers();
     exit(0);
 }
 void systemResetToBootloader(bootloaderRequestType_e requestType) {
     UNUSED(requestType);
 
     printf("[system]ResetToBootloader!\n");
-    workerRunning = false;
-    pthread_join(tcpWorker, NULL);
-    pthread_join(udpWorker, NULL);
+    stopWorkers();
     exit(0);
 }
 
@@ -305,6 +547,11 @@ uint64_t millis64_real() {
 uint64_t micros64() {
     static uint64_t last = 0;
     static uint64_t out = 0;
+
+    if (lockstepRunning) {
+        return lockstepTimeUs;
+    }
+
     uint64_t now = nanos64_real();
 
     out += (now - last) * simRate;
@@ -317,6 +564,11 @@ uint64_t micros64() {
 uint64_t millis64() {
     static uint64_t last = 0;
     static uint64_t out = 0;
+
+    if (lockstepRunning) {
+        return lockstepTimeUs / 1000;
+    }
+
     uint64_t now = nanos64_real();
 
     out += (now - last) * simRate;
@@ -341,7 +593,11 @@ void microsleep(uint32_t usec) {
     while (nanosleep(&ts, &ts) == -1 && errno == EINTR) ;
 }
 
+// no simulator time passes inside a step in lockstep, so delays return at once
 void delayMicroseconds(uint32_t us) {
+    if (lockstepRunning) {
+        return;
+    }
     microsleep(us / simRate);
 }
 
@@ -350,6 +606,10 @@ void delayMicroseconds_real(uint32_t us) {
 }
 
 void delay(uint32_t ms) {
+    if (lockstepRunning) {
+        return;
+    }
+
     uint64_t start = millis64();
 
     while ((millis64() - start) < ms) {
@@ -458,9 +718,12 @@ static void pwmCompleteMotorUpdate(void)
     pwmPkt.motor_speed[1] = motorsPwm[2] / outScale;
     pwmPkt.motor_speed[2] = motorsPwm[3] / outScale;
 
+    // in lockstep the reply is sent once the step is complete
+    if (lockstep) return;
+
     // get one "fdm_packet" can only send one "servo_packet"!!
     if (pthread_mutex_trylock(&updateLock) != 0) return;
-    udpSend(&pwmLink, &pwmPkt, sizeof(servo_packet));
+    sendMotorUpdate();
 //    printf("[pwm]%u:%u,%u,%u,%u\n", idlePulse, motorsPwm[0], motorsPwm[1], motorsPwm[2], motorsPwm[3]);
 }
 
@@ -31,6 +31,9 @@
 
 #define SIMULATOR_MULTITHREAD
 
+// run the gyro filter bank stages as host vector operations
+#define USE_FILTER_BANK_SIMD
+
 // use simulatior's attitude directly
 // disable this if wants to test AHRS algorithm
 #undef USE_IMU_CALC
@@ -256,5 +259,6 @@ uint64_t micros64(void);
 uint64_t millis64(void);
 
 int lockMainPID(void);
+void simulatorLoopWait(void);
 
 
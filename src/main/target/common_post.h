@@ -36,6 +36,10 @@
 #undef USE_ESC_SENSOR_TELEMETRY
 #endif
 
+#ifndef USE_TASK_STATISTICS
+#undef USE_TASK_LATENCY_HISTOGRAM
+#endif
+
 // XXX Followup implicit dependencies among DASHBOARD, display_xxx and USE_I2C.
 // XXX This should eventually be cleaned up.
 #ifndef USE_I2C
@@ -395,4 +395,6 @@
 #define USE_CUSTOM_BOX_NAMES
 #define USE_BATTERY_VOLTAGE_SAG_COMPENSATION
 #define USE_RX_MSP_OVERRIDE
+#define USE_TASK_LATENCY_HISTOGRAM
+#define USE_MSP_SETTINGS
 #endif
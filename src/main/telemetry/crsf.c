@@ -68,6 +68,10 @@
 
 
 #define CRSF_CYCLETIME_US                   100000 // 100ms, 10 Hz
+#define CRSF_LINK_RATE_DEFAULT_HZ           150    // until the link statistics tell otherwise
+#define CRSF_TELEMETRY_BYTES_PER_LINK_FRAME 8      // conservative share of the downlink per link packet
+#define CRSF_TELEMETRY_MIN_BYTES_PER_SECOND 200
+#define CRSF_FRAME_CREDIT_PERIODS           2      // how far a frame may fall behind its rate and still catch up
 #define CRSF_DEVICEINFO_VERSION             0x01
 #define CRSF_DEVICEINFO_PARAMETER_COUNT     0
 
@@ -104,27 +108,25 @@ bool bufferCrsfMspFrame(uint8_t *frameStart, int frameLength)
     }
 }
 
-bool handleCrsfMspFrameBuffer(uint8_t payloadSize, mspResponseFnPtr responseFn)
+// Hands the buffered request chunks to the MSP layer, returns true while a reply is waiting to be sent
+static bool handleCrsfMspFrameBuffer(bool replyPending)
 {
-    bool requestHandled = false;
     if (!mspRxBuffer.len) {
-        return false;
+        return replyPending;
     }
     int pos = 0;
     while (true) {
         const int mspFrameLength = mspRxBuffer.bytes[pos];
-        if (handleMspFrame(&mspRxBuffer.bytes[CRSF_MSP_LENGTH_OFFSET + pos], mspFrameLength, NULL)) {
-            requestHandled |= sendMspReply(payloadSize, responseFn);
-        }
+        replyPending = handleMspFrame(&mspRxBuffer.bytes[CRSF_MSP_LENGTH_OFFSET + pos], mspFrameLength, NULL);
         pos += CRSF_MSP_LENGTH_OFFSET + mspFrameLength;
         ATOMIC_BLOCK(NVIC_PRIO_SERIALUART1) {
             if (pos >= mspRxBuffer.len) {
                 mspRxBuffer.len = 0;
-                return requestHandled;
+                return replyPending;
             }
         }
     }
-    return requestHandled;
+    return replyPending;
 }
 #endif
 
@@ -416,26 +418,55 @@ static void crsfFrameDisplayPortClear(sbuf_t *dst)
 
 #define BV(x)  (1 << (x)) // bit value
 
-// schedule array to decide how often each type of frame is sent
+// frames the telemetry scheduler sends
 typedef enum {
     CRSF_FRAME_START_INDEX = 0,
     CRSF_FRAME_ATTITUDE_INDEX = CRSF_FRAME_START_INDEX,
     CRSF_FRAME_BATTERY_SENSOR_INDEX,
     CRSF_FRAME_FLIGHT_MODE_INDEX,
     CRSF_FRAME_GPS_INDEX,
+    CRSF_FRAME_DEVICE_INFO_INDEX,
+    CRSF_FRAME_MSP_INDEX,
+    CRSF_FRAME_DISPLAYPORT_INDEX,
     CRSF_SCHEDULE_COUNT_MAX
 } crsfFrameTypeIndex_e;
 
-static uint8_t crsfScheduleCount;
-static uint8_t crsfSchedule[CRSF_SCHEDULE_COUNT_MAX];
+typedef struct crsfFrameSchedule_s {
+    uint8_t rateHz;         // target rate while the frame has something to send
+    uint8_t priority;       // the lowest is sent first when several frames are due
+    uint8_t budgetShare;    // percentage of the telemetry budget the frame may use at most
+    uint8_t frameBytes;     // worst case length of the frame
+} crsfFrameSchedule_t;
+
+// Attitude goes first so it keeps its rate while MSP is busy, MSP may use most of the
+// budget so tuning traffic still flows on slow links. MSP replies are only limited by
+// that budget.
+static const crsfFrameSchedule_t crsfFrameSchedule[CRSF_SCHEDULE_COUNT_MAX] = {
+    [CRSF_FRAME_ATTITUDE_INDEX] = { 50, 1, 50, CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_NON_PAYLOAD },
+    [CRSF_FRAME_BATTERY_SENSOR_INDEX] = { 10, 4, 100, CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_NON_PAYLOAD },
+    [CRSF_FRAME_FLIGHT_MODE_INDEX] = { 10, 3, 100, 6 + CRSF_FRAME_LENGTH_NON_PAYLOAD },
+    [CRSF_FRAME_GPS_INDEX] = { 10, 5, 100, CRSF_FRAME_GPS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_NON_PAYLOAD },
+    [CRSF_FRAME_DEVICE_INFO_INDEX] = { 10, 0, 100, CRSF_FRAME_SIZE_MAX },
+    [CRSF_FRAME_MSP_INDEX] = { 250, 2, 75, CRSF_FRAME_SIZE_MAX },
+    [CRSF_FRAME_DISPLAYPORT_INDEX] = { 50, 2, 75, CRSF_FRAME_SIZE_MAX },
+};
+
+static uint8_t crsfScheduleMask;    // periodic frames that are enabled
+static uint16_t crsfLinkRateHz;
+static uint32_t crsfUsPerByte;
+static int32_t crsfBudgetUs;        // link time available for telemetry, negative while paying off a frame
+static timeUs_t crsfLastScheduleTimeUs;
+static uint32_t crsfFramePeriodUs[CRSF_SCHEDULE_COUNT_MAX];
+static uint32_t crsfFrameCreditUs[CRSF_SCHEDULE_COUNT_MAX];
 
 #if defined(USE_MSP_OVER_TELEMETRY)
 
+static volatile bool mspRequestPending;    // set by the RX when it buffers a request chunk
 static bool mspReplyPending;
 
 void crsfScheduleMspResponse(void)
 {
-    mspReplyPending = true;
+    mspRequestPending = true;
 }
 
 void crsfSendMspResponse(uint8_t *payload)
@@ -453,44 +484,24 @@ void crsfSendMspResponse(uint8_t *payload)
 }
 #endif
 
-static void processCrsf(void)
+void crsfScheduleDeviceInfoResponse(void)
 {
-    static uint8_t crsfScheduleIndex = 0;
-
-    const uint8_t currentSchedule = crsfSchedule[crsfScheduleIndex];
-
-    sbuf_t crsfPayloadBuf;
-    sbuf_t *dst = &crsfPayloadBuf;
-
-    if (currentSchedule & BV(CRSF_FRAME_ATTITUDE_INDEX)) {
-        crsfInitializeFrame(dst);
-        crsfFrameAttitude(dst);
-        crsfFinalize(dst);
-    }
-    if (currentSchedule & BV(CRSF_FRAME_BATTERY_SENSOR_INDEX)) {
-        crsfInitializeFrame(dst);
-        crsfFrameBatterySensor(dst);
-        crsfFinalize(dst);
-    }
-
-    if (currentSchedule & BV(CRSF_FRAME_FLIGHT_MODE_INDEX)) {
-        crsfInitializeFrame(dst);
-        crsfFrameFlightMode(dst);
-        crsfFinalize(dst);
-    }
-#ifdef USE_GPS
-    if (currentSchedule & BV(CRSF_FRAME_GPS_INDEX)) {
-        crsfInitializeFrame(dst);
-        crsfFrameGps(dst);
-        crsfFinalize(dst);
-    }
-#endif
-    crsfScheduleIndex = (crsfScheduleIndex + 1) % crsfScheduleCount;
+    deviceInfoReplyPending = true;
 }
 
-void crsfScheduleDeviceInfoResponse(void)
+// Spreads the telemetry budget of the link over the frames, at most at their target rates
+static void crsfUpdateSchedule(void)
 {
-    deviceInfoReplyPending = true;
+    const uint32_t linkRateHz = crsfLinkRateHz ? crsfLinkRateHz : CRSF_LINK_RATE_DEFAULT_HZ;
+    const uint32_t bytesPerSecond = MAX(linkRateHz * CRSF_TELEMETRY_BYTES_PER_LINK_FRAME, (uint32_t)CRSF_TELEMETRY_MIN_BYTES_PER_SECOND);
+    crsfUsPerByte = 1000000 / bytesPerSecond;
+
+    for (int i = CRSF_FRAME_START_INDEX; i < CRSF_SCHEDULE_COUNT_MAX; i++) {
+        const crsfFrameSchedule_t *schedule = &crsfFrameSchedule[i];
+        const uint32_t budgetPeriodUs = schedule->frameBytes * crsfUsPerByte * 100 / schedule->budgetShare;
+        crsfFramePeriodUs[i] = MAX(1000000U / schedule->rateHz, budgetPeriodUs);
+        crsfFrameCreditUs[i] = MIN(crsfFrameCreditUs[i], CRSF_FRAME_CREDIT_PERIODS * crsfFramePeriodUs[i]);
+    }
 }
 
 
@@ -506,26 +517,31 @@ void initCrsfTelemetry(void)
 
     deviceInfoReplyPending = false;
 #if defined(USE_MSP_OVER_TELEMETRY)
+    mspRequestPending = false;
     mspReplyPending = false;
 #endif
 
-    int index = 0;
+    crsfScheduleMask = 0;
     if (sensors(SENSOR_ACC) && telemetryIsSensorEnabled(SENSOR_PITCH | SENSOR_ROLL | SENSOR_HEADING)) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_ATTITUDE_INDEX);
+        crsfScheduleMask |= BV(CRSF_FRAME_ATTITUDE_INDEX);
     }
     if ((isBatteryVoltageConfigured() && telemetryIsSensorEnabled(SENSOR_VOLTAGE))
         || (isAmperageConfigured() && telemetryIsSensorEnabled(SENSOR_CURRENT | SENSOR_FUEL))) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_BATTERY_SENSOR_INDEX);
+        crsfScheduleMask |= BV(CRSF_FRAME_BATTERY_SENSOR_INDEX);
     }
-    crsfSchedule[index++] = BV(CRSF_FRAME_FLIGHT_MODE_INDEX);
+    crsfScheduleMask |= BV(CRSF_FRAME_FLIGHT_MODE_INDEX);
 #ifdef USE_GPS
     if (featureIsEnabled(FEATURE_GPS)
        && telemetryIsSensorEnabled(SENSOR_ALTITUDE | SENSOR_LAT_LONG | SENSOR_GROUND_SPEED | SENSOR_HEADING)) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_GPS_INDEX);
+        crsfScheduleMask |= BV(CRSF_FRAME_GPS_INDEX);
     }
 #endif
-    crsfScheduleCount = (uint8_t)index;
- }
+
+    crsfLinkRateHz = 0;
+    crsfUpdateSchedule();
+    crsfBudgetUs = 0;
+    memset(crsfFrameCreditUs, 0, sizeof(crsfFrameCreditUs));
+}
 
 bool checkCrsfTelemetryState(void)
 {
@@ -557,13 +573,110 @@ void crsfProcessDisplayPortCmd(uint8_t *frameStart)
 
 #endif
 
+#if defined(USE_CRSF_CMS_TELEMETRY)
+// a screen is sent in chunks, one per call like every other frame
+static sbuf_t displayPortSrc;
+static uint8_t displayPortBatchId;
+static uint8_t displayPortChunkIndex;
+static bool displayPortBatchPending;
+
+static void crsfSendDisplayPort(sbuf_t *dst)
+{
+    if (crsfDisplayPortScreen()->reset) {
+        crsfDisplayPortScreen()->reset = false;
+        displayPortBatchPending = false;
+        crsfFrameDisplayPortClear(dst);
+        return;
+    }
+    if (!displayPortBatchPending) {
+        crsfDisplayPortScreen()->updated = false;
+        const uint16_t screenSize = crsfDisplayPortScreen()->rows * crsfDisplayPortScreen()->cols;
+        uint8_t *srcStart = (uint8_t*)crsfDisplayPortScreen()->buffer;
+        uint8_t *srcEnd = (uint8_t*)(crsfDisplayPortScreen()->buffer + screenSize);
+        sbufInit(&displayPortSrc, srcStart, srcEnd);
+        displayPortBatchId = (displayPortBatchId + 1) % CRSF_DISPLAYPORT_BATCH_MAX;
+        displayPortChunkIndex = 0;
+        displayPortBatchPending = true;
+    }
+    crsfFrameDisplayPortChunk(dst, &displayPortSrc, displayPortBatchId, displayPortChunkIndex++);
+    displayPortBatchPending = sbufBytesRemaining(&displayPortSrc);
+}
+#endif
+
+static bool crsfFramePending(crsfFrameTypeIndex_e index)
+{
+    switch (index) {
+    case CRSF_FRAME_DEVICE_INFO_INDEX:
+        return deviceInfoReplyPending;
+    case CRSF_FRAME_MSP_INDEX:
+#if defined(USE_MSP_OVER_TELEMETRY)
+        return mspReplyPending;
+#else
+        return false;
+#endif
+    case CRSF_FRAME_DISPLAYPORT_INDEX:
+#if defined(USE_CRSF_CMS_TELEMETRY)
+        return crsfDisplayPortScreen()->reset || displayPortBatchPending
+            || (crsfDisplayPortIsReady() && crsfDisplayPortScreen()->updated);
+#else
+        return false;
+#endif
+    default:
+        return crsfScheduleMask & BV(index);
+    }
+}
+
+// Returns the number of bytes handed to the receiver
+static int crsfSendFrame(crsfFrameTypeIndex_e index)
+{
+    sbuf_t crsfPayloadBuf;
+    sbuf_t *dst = &crsfPayloadBuf;
+
+#if defined(USE_MSP_OVER_TELEMETRY)
+    if (index == CRSF_FRAME_MSP_INDEX) {
+        // sent by the MSP layer through crsfSendMspResponse()
+        mspReplyPending = sendMspReply(CRSF_FRAME_TX_MSP_FRAME_SIZE, &crsfSendMspResponse, NULL);
+        return crsfFrameSchedule[index].frameBytes;
+    }
+#endif
+
+    crsfInitializeFrame(dst);
+    switch (index) {
+    case CRSF_FRAME_ATTITUDE_INDEX:
+        crsfFrameAttitude(dst);
+        break;
+    case CRSF_FRAME_BATTERY_SENSOR_INDEX:
+        crsfFrameBatterySensor(dst);
+        break;
+    case CRSF_FRAME_FLIGHT_MODE_INDEX:
+        crsfFrameFlightMode(dst);
+        break;
+#if defined(USE_GPS)
+    case CRSF_FRAME_GPS_INDEX:
+        crsfFrameGps(dst);
+        break;
+#endif
+    case CRSF_FRAME_DEVICE_INFO_INDEX:
+        crsfFrameDeviceInfo(dst);
+        deviceInfoReplyPending = false;
+        break;
+#if defined(USE_CRSF_CMS_TELEMETRY)
+    case CRSF_FRAME_DISPLAYPORT_INDEX:
+        crsfSendDisplayPort(dst);
+        break;
+#endif
+    default:
+        return 0;
+    }
+    crsfFinalize(dst);
+    return sbufBytesRemaining(dst);
+}
+
 /*
  * Called periodically by the scheduler
  */
 void handleCrsfTelemetry(timeUs_t currentTimeUs)
 {
-    static uint32_t crsfLastCycleTime;
-
     if (!crsfTelemetryEnabled) {
         return;
     }
@@ -572,67 +685,51 @@ void handleCrsfTelemetry(timeUs_t currentTimeUs)
     // in between the RX frames.
     crsfRxSendTelemetryData();
 
-    // Send ad-hoc response frames as soon as possible
 #if defined(USE_MSP_OVER_TELEMETRY)
-    if (mspReplyPending) {
-        mspReplyPending = handleCrsfMspFrameBuffer(CRSF_FRAME_TX_MSP_FRAME_SIZE, &crsfSendMspResponse);
-        crsfLastCycleTime = currentTimeUs; // reset telemetry timing due to ad-hoc request
-        return;
+    // requests are taken in as they come, so a pipelining client has its replies streamed
+    // back to back
+    if (mspRequestPending) {
+        mspRequestPending = false;
+        mspReplyPending = handleCrsfMspFrameBuffer(mspReplyPending);
     }
 #endif
 
-    if (deviceInfoReplyPending) {
-        sbuf_t crsfPayloadBuf;
-        sbuf_t *dst = &crsfPayloadBuf;
-        crsfInitializeFrame(dst);
-        crsfFrameDeviceInfo(dst);
-        crsfFinalize(dst);
-        deviceInfoReplyPending = false;
-        crsfLastCycleTime = currentTimeUs; // reset telemetry timing due to ad-hoc request
-        return;
+    const uint16_t linkRateHz = crsfRxGetLinkRateHz();
+    if (linkRateHz != crsfLinkRateHz) {
+        crsfLinkRateHz = linkRateHz;
+        crsfUpdateSchedule();
     }
 
-#if defined(USE_CRSF_CMS_TELEMETRY)
-    if (crsfDisplayPortScreen()->reset) {
-        crsfDisplayPortScreen()->reset = false;
-        sbuf_t crsfDisplayPortBuf;
-        sbuf_t *dst = &crsfDisplayPortBuf;
-        crsfInitializeFrame(dst);
-        crsfFrameDisplayPortClear(dst);
-        crsfFinalize(dst);
-        crsfLastCycleTime = currentTimeUs;
+    // Every frame earns credit with time, so a frame held back by others catches up once, and
+    // the link earns the time it needs to carry its share of telemetry bytes, at most a full
+    // frame ahead.
+    const uint32_t elapsedUs = constrain(cmpTimeUs(currentTimeUs, crsfLastScheduleTimeUs), 0, CRSF_CYCLETIME_US);
+    crsfLastScheduleTimeUs = currentTimeUs;
+    crsfBudgetUs = MIN(crsfBudgetUs + (int32_t)elapsedUs, (int32_t)(CRSF_FRAME_SIZE_MAX * crsfUsPerByte));
+    for (int i = CRSF_FRAME_START_INDEX; i < CRSF_SCHEDULE_COUNT_MAX; i++) {
+        crsfFrameCreditUs[i] = MIN(crsfFrameCreditUs[i] + elapsedUs, CRSF_FRAME_CREDIT_PERIODS * crsfFramePeriodUs[i]);
+    }
+
+    if (crsfBudgetUs < 0) {
+        // the link is still busy with what was sent before
         return;
     }
-    static uint8_t displayPortBatchId = 0;
-    if (crsfDisplayPortIsReady() && crsfDisplayPortScreen()->updated) {
-        crsfDisplayPortScreen()->updated = false;
-        uint16_t screenSize = crsfDisplayPortScreen()->rows * crsfDisplayPortScreen()->cols;
-        uint8_t *srcStart = (uint8_t*)crsfDisplayPortScreen()->buffer;
-        uint8_t *srcEnd = (uint8_t*)(crsfDisplayPortScreen()->buffer + screenSize);
-        sbuf_t displayPortSbuf;
-        sbuf_t *src = sbufInit(&displayPortSbuf, srcStart, srcEnd);
-        sbuf_t crsfDisplayPortBuf;
-        sbuf_t *dst = &crsfDisplayPortBuf;
-        displayPortBatchId = (displayPortBatchId  + 1) % CRSF_DISPLAYPORT_BATCH_MAX;
-        uint8_t i = 0;
-        while(sbufBytesRemaining(src)) {
-            crsfInitializeFrame(dst);
-            crsfFrameDisplayPortChunk(dst, src, displayPortBatchId, i);
-            crsfFinalize(dst);
-            crsfRxSendTelemetryData();
-            i++;
+
+    // send the frame with the highest priority of those that are due
+    int next = CRSF_SCHEDULE_COUNT_MAX;
+    for (int i = CRSF_FRAME_START_INDEX; i < CRSF_SCHEDULE_COUNT_MAX; i++) {
+        if (crsfFrameCreditUs[i] >= crsfFramePeriodUs[i] && crsfFramePending(i)
+            && (next == CRSF_SCHEDULE_COUNT_MAX || crsfFrameSchedule[i].priority < crsfFrameSchedule[next].priority)) {
+            next = i;
         }
-        crsfLastCycleTime = currentTimeUs;
+    }
+    if (next == CRSF_SCHEDULE_COUNT_MAX) {
         return;
     }
-#endif
 
-    // Actual telemetry data only needs to be sent at a low frequency, ie 10Hz
-    // Spread out scheduled frames evenly so each frame is sent at the same frequency.
-    if (currentTimeUs >= crsfLastCycleTime + (CRSF_CYCLETIME_US / crsfScheduleCount)) {
-        crsfLastCycleTime = currentTimeUs;
-        processCrsf();
-    }
+    const int frameBytes = crsfSendFrame(next);
+    crsfFrameCreditUs[next] -= crsfFramePeriodUs[next];
+    crsfBudgetUs -= (int32_t)(frameBytes * crsfUsPerByte);
 }
 
 #if defined(UNIT_TEST)
@@ -38,6 +38,7 @@
 #include "telemetry/smartport.h"
 
 #define TELEMETRY_MSP_VERSION    1
+#define TELEMETRY_MSP_VERSION_PIPELINED 2
 #define TELEMETRY_MSP_VER_SHIFT  5
 #define TELEMETRY_MSP_VER_MASK   (0x7 << TELEMETRY_MSP_VER_SHIFT)
 #define TELEMETRY_MSP_ERROR_FLAG (1 << 5)
@@ -45,14 +46,43 @@
 #define TELEMETRY_MSP_SEQ_MASK   0x0F
 #define TELEMETRY_MSP_RES_ERROR (-10)
 
+#define TELEMETRY_MSP_NO_ERROR   0xFF
+
+#define TELEMETRY_MSP_QUEUE_DEPTH 4     // requests a pipelining client may have in flight
+#define TELEMETRY_MSP_QUEUE_SIZE  128   // bytes of queued request payload
+
 #define TELEMETRY_REQUEST_SKIPS_AFTER_EEPROMWRITE 5
 
 enum {
     TELEMETRY_MSP_VER_MISMATCH=0,
     TELEMETRY_MSP_CRC_ERROR=1,
-    TELEMETRY_MSP_ERROR=2
+    TELEMETRY_MSP_ERROR=2,
+    TELEMETRY_MSP_QUEUE_FULL=3
 };
 
+/*
+ * Version 2 pipelines requests. Chunks are sequence numbered as in version 1, and the
+ * first chunk of a request and of its reply carries a tag chosen by the client:
+ *
+ *   request: [header][tag][size][cmd][payload...][checksum]
+ *   reply:   [header][tag][size][payload...][checksum]
+ *
+ * A client may send up to TELEMETRY_MSP_QUEUE_DEPTH requests without waiting for their
+ * replies. They are processed in order, and the replies are sent back to back in whatever
+ * telemetry slots the link offers. Reply headers have bit 6 set, bit 5 is still the error
+ * flag. A request whose payload finds no room in the queue is answered with
+ * TELEMETRY_MSP_QUEUE_FULL. Requests beyond TELEMETRY_MSP_QUEUE_DEPTH are dropped without
+ * a reply, the client resends them once it stops waiting for their replies.
+ * Firmware without version 2 answers TELEMETRY_MSP_VER_MISMATCH, clients then fall back
+ * to version 1, which still handles one request at a time.
+ */
+typedef struct mspQueuedRequest_s {
+    uint8_t tag;
+    uint8_t cmd;
+    uint8_t size;
+    uint8_t error;      // answered with this error instead, TELEMETRY_MSP_NO_ERROR if none
+} mspQueuedRequest_t;
+
 STATIC_UNIT_TESTED uint8_t checksum = 0;
 STATIC_UNIT_TESTED mspPackage_t mspPackage;
 static mspRxBuffer_t mspRxBuffer;
@@ -61,6 +91,15 @@ static mspPacket_t mspRxPacket;
 static mspPacket_t mspTxPacket;
 static mspDescriptor_t mspSharedDescriptor;
 
+static mspQueuedRequest_t mspRequestQueue[TELEMETRY_MSP_QUEUE_DEPTH];
+static uint8_t mspRequestQueueCount;
+static uint8_t mspRequestQueueData[TELEMETRY_MSP_QUEUE_SIZE];
+static uint8_t mspRequestQueueDataLen;
+
+static bool mspReplyPending;        // until the last chunk of the reply is sent
+static uint8_t mspReplyVersion;
+static uint8_t mspReplyTag;
+
 void initSharedMsp(void)
 {
     mspPackage.requestBuffer = (uint8_t *)&mspRxBuffer;
@@ -74,16 +113,26 @@ void initSharedMsp(void)
     mspPackage.responsePacket->buf.end = mspPackage.responseBuffer;
 
     mspSharedDescriptor = mspDescriptorAlloc();
+
+    mspRequestQueueCount = 0;
+    mspRequestQueueDataLen = 0;
+    mspReplyPending = false;
+    mspReplyVersion = TELEMETRY_MSP_VERSION;
 }
 
-static void processMspPacket(void)
+static void processMspPacket(mspPacket_t *requestPacket, uint8_t *skipsBeforeResponse)
 {
+    // Skip a few telemetry requests if command is MSP_EEPROM_WRITE
+    if (requestPacket->cmd == MSP_EEPROM_WRITE && skipsBeforeResponse) {
+        *skipsBeforeResponse = TELEMETRY_REQUEST_SKIPS_AFTER_EEPROMWRITE;
+    }
+
     mspPackage.responsePacket->cmd = 0;
     mspPackage.responsePacket->result = 0;
-    mspPackage.responsePacket->buf.end = mspPackage.responseBuffer;
+    sbufInit(&mspPackage.responsePacket->buf, mspPackage.responseBuffer, mspPackage.responseBuffer + sizeof(mspTxBuffer));
 
     mspPostProcessFnPtr mspPostProcessFn = NULL;
-    if (mspFcProcessCommand(mspSharedDescriptor, mspPackage.requestPacket, mspPackage.responsePacket, &mspPostProcessFn) == MSP_RESULT_ERROR) {
+    if (mspFcProcessCommand(mspSharedDescriptor, requestPacket, mspPackage.responsePacket, &mspPostProcessFn) == MSP_RESULT_ERROR) {
         sbufWriteU8(&mspPackage.responsePacket->buf, TELEMETRY_MSP_ERROR);
     }
     if (mspPostProcessFn) {
@@ -91,31 +140,93 @@ static void processMspPacket(void)
     }
 
     sbufSwitchToReader(&mspPackage.responsePacket->buf, mspPackage.responseBuffer);
+    mspReplyPending = true;
 }
 
 void sendMspErrorResponse(uint8_t error, int16_t cmd)
 {
     mspPackage.responsePacket->cmd = cmd;
     mspPackage.responsePacket->result = 0;
-    mspPackage.responsePacket->buf.end = mspPackage.responseBuffer;
+    sbufInit(&mspPackage.responsePacket->buf, mspPackage.responseBuffer, mspPackage.responseBuffer + sizeof(mspTxBuffer));
 
     sbufWriteU8(&mspPackage.responsePacket->buf, error);
     mspPackage.responsePacket->result = TELEMETRY_MSP_RES_ERROR;
     sbufSwitchToReader(&mspPackage.responsePacket->buf, mspPackage.responseBuffer);
+    mspReplyPending = true;
 }
 
-bool handleMspFrame(uint8_t *frameStart, int frameLength, uint8_t *skipsBeforeResponse)
+static void queueMspRequest(uint8_t tag, mspPacket_t *packet, uint8_t error)
 {
-    static uint8_t mspStarted = 0;
-    static uint8_t lastSeq = 0;
+    if (mspRequestQueueCount == TELEMETRY_MSP_QUEUE_DEPTH) {
+        // more requests in flight than the client may have, it resends what isn't answered
+        return;
+    }
 
-    if (sbufBytesRemaining(&mspPackage.responsePacket->buf) > 0) {
-        mspStarted = 0;
+    mspQueuedRequest_t *request = &mspRequestQueue[mspRequestQueueCount++];
+    request->tag = tag;
+    request->cmd = packet->cmd;
+    request->size = 0;
+    request->error = error;
+    if (error == TELEMETRY_MSP_NO_ERROR) {
+        const int size = sbufBytesRemaining(&packet->buf);
+        if (mspRequestQueueDataLen + size > TELEMETRY_MSP_QUEUE_SIZE) {
+            request->error = TELEMETRY_MSP_QUEUE_FULL;
+        } else {
+            sbufReadData(&packet->buf, &mspRequestQueueData[mspRequestQueueDataLen], size);
+            mspRequestQueueDataLen += size;
+            request->size = size;
+        }
     }
+}
+
+// Prepares the reply to the oldest queued request, false if there is none
+static bool processNextMspRequest(uint8_t *skipsBeforeResponse)
+{
+    if (!mspRequestQueueCount) {
+        return false;
+    }
+
+    const mspQueuedRequest_t request = mspRequestQueue[0];
+    mspReplyVersion = TELEMETRY_MSP_VERSION_PIPELINED;
+    mspReplyTag = request.tag;
+    if (request.error != TELEMETRY_MSP_NO_ERROR) {
+        sendMspErrorResponse(request.error, request.cmd);
+    } else {
+        mspPacket_t packet = {
+            .buf = { .ptr = mspRequestQueueData, .end = mspRequestQueueData + request.size },
+            .cmd = request.cmd,
+        };
+        processMspPacket(&packet, skipsBeforeResponse);
+    }
+
+    mspRequestQueueDataLen -= request.size;
+    memmove(mspRequestQueueData, &mspRequestQueueData[request.size], mspRequestQueueDataLen);
+    mspRequestQueueCount--;
+    memmove(&mspRequestQueue[0], &mspRequestQueue[1], mspRequestQueueCount * sizeof(mspRequestQueue[0]));
+    return true;
+}
 
-    if (mspStarted == 0) {
-        initSharedMsp();
+// Version 2 requests are queued behind the replies still being sent
+static void handleMspRequest(uint8_t version, uint8_t tag, mspPacket_t *packet, uint8_t error, uint8_t *skipsBeforeResponse)
+{
+    if (version == TELEMETRY_MSP_VERSION_PIPELINED) {
+        queueMspRequest(tag, packet, error);
+        if (!mspReplyPending) {
+            processNextMspRequest(skipsBeforeResponse);
+        }
+    } else if (error != TELEMETRY_MSP_NO_ERROR) {
+        sendMspErrorResponse(error, packet->cmd);
+    } else {
+        processMspPacket(packet, skipsBeforeResponse);
     }
+}
+
+bool handleMspFrame(uint8_t *frameStart, int frameLength, uint8_t *skipsBeforeResponse)
+{
+    static uint8_t mspStarted = 0;
+    static uint8_t lastSeq = 0;
+    static uint8_t requestVersion = 0;
+    static uint8_t requestTag = 0;
 
     mspPacket_t *packet = mspPackage.requestPacket;
     sbuf_t *frameBuf = sbufInit(&mspPackage.requestFrame, frameStart, frameStart + (uint8_t)frameLength);
@@ -124,13 +235,27 @@ bool handleMspFrame(uint8_t *frameStart, int frameLength, uint8_t *skipsBeforeRe
     const uint8_t seqNumber = header & TELEMETRY_MSP_SEQ_MASK;
     const uint8_t version = (header & TELEMETRY_MSP_VER_MASK) >> TELEMETRY_MSP_VER_SHIFT;
 
-    if (version != TELEMETRY_MSP_VERSION) {
-        sendMspErrorResponse(TELEMETRY_MSP_VER_MISMATCH, 0);
-        return true;
+    if (version != TELEMETRY_MSP_VERSION_PIPELINED) {
+        // one request at a time, a new one drops what is left of the last reply
+        if (sbufBytesRemaining(&mspPackage.responsePacket->buf) > 0) {
+            mspStarted = 0;
+        }
+
+        if (mspStarted == 0) {
+            initSharedMsp();
+        }
+
+        if (version != TELEMETRY_MSP_VERSION) {
+            sendMspErrorResponse(TELEMETRY_MSP_VER_MISMATCH, 0);
+            return true;
+        }
     }
 
     if (header & TELEMETRY_MSP_START_FLAG) {
         // first packet in sequence
+        if (version == TELEMETRY_MSP_VERSION_PIPELINED) {
+            requestTag = sbufReadU8(frameBuf);
+        }
         uint8_t mspPayloadSize = sbufReadU8(frameBuf);
 
         packet->cmd = sbufReadU8(frameBuf);
@@ -140,13 +265,14 @@ bool handleMspFrame(uint8_t *frameStart, int frameLength, uint8_t *skipsBeforeRe
 
         checksum = mspPayloadSize ^ packet->cmd;
         mspStarted = 1;
+        requestVersion = version;
     } else if (!mspStarted) {
         // no start packet yet, throw this one away
-        return false;
-    } else if (((lastSeq + 1) & TELEMETRY_MSP_SEQ_MASK) != seqNumber) {
+        return mspReplyPending;
+    } else if (((lastSeq + 1) & TELEMETRY_MSP_SEQ_MASK) != seqNumber || version != requestVersion) {
         // packet loss detected!
         mspStarted = 0;
-        return false;
+        return mspReplyPending;
     }
 
     const uint8_t bufferBytesRemaining = sbufBytesRemaining(rxBuf);
@@ -159,7 +285,7 @@ bool handleMspFrame(uint8_t *frameStart, int frameLength, uint8_t *skipsBeforeRe
         sbufWriteData(rxBuf, payload, frameBytesRemaining);
         lastSeq = seqNumber;
 
-        return false;
+        return mspReplyPending;
     } else {
         sbufReadData(frameBuf, payload, bufferBytesRemaining);
         sbufAdvance(frameBuf, bufferBytesRemaining);
@@ -171,23 +297,18 @@ bool handleMspFrame(uint8_t *frameStart, int frameLength, uint8_t *skipsBeforeRe
 
         if (checksum != *frameBuf->ptr) {
             mspStarted = 0;
-            sendMspErrorResponse(TELEMETRY_MSP_CRC_ERROR, packet->cmd);
+            handleMspRequest(version, requestTag, packet, TELEMETRY_MSP_CRC_ERROR, skipsBeforeResponse);
             return true;
         }
     }
 
-    // Skip a few telemetry requests if command is MSP_EEPROM_WRITE
-    if (packet->cmd == MSP_EEPROM_WRITE && skipsBeforeResponse) {
-        *skipsBeforeResponse = TELEMETRY_REQUEST_SKIPS_AFTER_EEPROMWRITE;
-    }
-
     mspStarted = 0;
     sbufSwitchToReader(rxBuf, mspPackage.requestBuffer);
-    processMspPacket();
+    handleMspRequest(version, requestTag, packet, TELEMETRY_MSP_NO_ERROR, skipsBeforeResponse);
     return true;
 }
 
-bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn)
+bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn, uint8_t *skipsBeforeResponse)
 {
     static uint8_t checksum = 0;
     static uint8_t seq = 0;
@@ -205,13 +326,23 @@ bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn)
         if (mspPackage.responsePacket->result < 0) {
             head |= TELEMETRY_MSP_ERROR_FLAG;
         }
+        if (mspReplyVersion == TELEMETRY_MSP_VERSION_PIPELINED) {
+            head |= TELEMETRY_MSP_VERSION_PIPELINED << TELEMETRY_MSP_VER_SHIFT;
+        }
         sbufWriteU8(payloadBuf, head);
+        if (mspReplyVersion == TELEMETRY_MSP_VERSION_PIPELINED) {
+            sbufWriteU8(payloadBuf, mspReplyTag);
+        }
 
         uint8_t size = sbufBytesRemaining(txBuf);
         sbufWriteU8(payloadBuf, size);
     } else {
         // header
-        sbufWriteU8(payloadBuf, (seq++ & TELEMETRY_MSP_SEQ_MASK));
+        uint8_t head = seq++ & TELEMETRY_MSP_SEQ_MASK;
+        if (mspReplyVersion == TELEMETRY_MSP_VERSION_PIPELINED) {
+            head |= TELEMETRY_MSP_VERSION_PIPELINED << TELEMETRY_MSP_VER_SHIFT;
+        }
+        sbufWriteU8(payloadBuf, head);
     }
 
     const uint8_t bufferBytesRemaining = sbufBytesRemaining(txBuf);
@@ -248,7 +379,9 @@ bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn)
     }
 
     responseFn(payloadOut);
-    return false;
+    // the next queued request is answered straight away, a queued MSP_EEPROM_WRITE runs here
+    mspReplyPending = processNextMspRequest(skipsBeforeResponse);
+    return mspReplyPending;
 }
 
 #endif
@@ -47,4 +47,4 @@ typedef union mspTxBuffer_u {
 
 void initSharedMsp(void);
 bool handleMspFrame(uint8_t *frameStart, int frameLength, uint8_t *skipsBeforeResponse);
-bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn);
+bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn, uint8_t *skipsBeforeResponse);
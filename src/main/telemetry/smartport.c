@@ -557,7 +557,7 @@ void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *clear
 
 #if defined(USE_MSP_OVER_TELEMETRY)
         if (smartPortMspReplyPending) {
-            smartPortMspReplyPending = sendMspReply(SMARTPORT_MSP_PAYLOAD_SIZE, &smartPortSendMspResponse);
+            smartPortMspReplyPending = sendMspReply(SMARTPORT_MSP_PAYLOAD_SIZE, &smartPortSendMspResponse, &skipRequests);
             *clearToSend = false;
 
             return;
@@ -0,0 +1,170 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Plain C versions of the CMSIS DSP functions flight/gyroanalyse.c calls, for host unit tests.
+// The CMSIS sources need the Cortex-M DSP intrinsics and 32 bit pointers, so they are not built here.
+// The split steps keep the CMSIS contract: the complex FFT leaves its output in bit reversed order,
+// arm_bitreversal_32() puts it in order and stage_rfft_f32() packs the real FFT as DC, Nyquist, bin 1...
+// Like CMSIS the complex FFT is O(N log N) on precomputed twiddles, so its host timing is a fair
+// reference for the SDFT (radix 2 here, radix 8 in CMSIS).
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "arm_math.h"
+
+#define HOST_CFFT_MAX_LEN 64
+
+static uint16_t bitRevTable[HOST_CFFT_MAX_LEN];
+static float32_t cfftTwiddle[HOST_CFFT_MAX_LEN];         // cos, sin of 2 pi k / N for k < N / 2
+static float32_t rfftTwiddle[2 * HOST_CFFT_MAX_LEN];     // cos, sin of pi k / N for k < N
+
+static unsigned bitReverse(unsigned index, unsigned length)
+{
+    unsigned reversed = 0;
+    for (unsigned bit = 1; bit < length; bit <<= 1) {
+        reversed = (reversed << 1) | ((index & bit) ? 1 : 0);
+    }
+    return reversed;
+}
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen)
+{
+    const uint16_t cfftLen = fftLen / 2;
+    if (cfftLen < 2 || cfftLen > HOST_CFFT_MAX_LEN || (cfftLen & (cfftLen - 1))) {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    // swap pairs as byte offsets of the complex samples, like the CMSIS tables
+    uint16_t bitRevLength = 0;
+    for (unsigned i = 0; i < cfftLen; i++) {
+        const unsigned j = bitReverse(i, cfftLen);
+        if (i < j) {
+            bitRevTable[bitRevLength++] = i * 2 * sizeof(float32_t);
+            bitRevTable[bitRevLength++] = j * 2 * sizeof(float32_t);
+        }
+    }
+
+    for (unsigned k = 0; k < cfftLen; k++) {
+        if (k < cfftLen / 2) {
+            cfftTwiddle[2 * k] = cos(2 * M_PI * k / cfftLen);
+            cfftTwiddle[2 * k + 1] = sin(2 * M_PI * k / cfftLen);
+        }
+        rfftTwiddle[2 * k] = cos(M_PI * k / cfftLen);
+        rfftTwiddle[2 * k + 1] = sin(M_PI * k / cfftLen);
+    }
+
+    S->Sint.fftLen = cfftLen;
+    S->Sint.pTwiddle = cfftTwiddle;
+    S->Sint.pBitRevTable = bitRevTable;
+    S->Sint.bitRevLength = bitRevLength;
+    S->fftLenRFFT = fftLen;
+    S->pTwiddleRFFT = rfftTwiddle;
+
+    return ARM_MATH_SUCCESS;
+}
+
+// radix 2 decimation in frequency, in place, which leaves the output in bit reversed order
+static void cfftBitReversedOut(float32_t *p, uint16_t fftLen, const float32_t *pTwiddle)
+{
+    for (unsigned span = fftLen / 2, twiddleStep = 1; span; span >>= 1, twiddleStep <<= 1) {
+        for (unsigned start = 0; start < fftLen; start += 2 * span) {
+            for (unsigned k = 0; k < span; k++) {
+                float32_t *a = &p[2 * (start + k)];
+                float32_t *b = &p[2 * (start + k + span)];
+                const float32_t c = pTwiddle[2 * k * twiddleStep];
+                const float32_t s = pTwiddle[2 * k * twiddleStep + 1];
+                const float32_t dRe = a[0] - b[0];
+                const float32_t dIm = a[1] - b[1];
+                a[0] += b[0];
+                a[1] += b[1];
+                b[0] = dRe * c + dIm * s;
+                b[1] = dIm * c - dRe * s;
+            }
+        }
+    }
+}
+
+void arm_cfft_radix8by2_f32(arm_cfft_instance_f32 *S, float32_t *p1)
+{
+    cfftBitReversedOut(p1, S->fftLen, S->pTwiddle);
+}
+
+void arm_cfft_radix8by4_f32(arm_cfft_instance_f32 *S, float32_t *p1)
+{
+    cfftBitReversedOut(p1, S->fftLen, S->pTwiddle);
+}
+
+void arm_radix8_butterfly_f32(float32_t *pSrc, uint16_t fftLen, const float32_t *pCoef, uint16_t twidCoefModifier)
+{
+    (void)twidCoefModifier;
+
+    cfftBitReversedOut(pSrc, fftLen, pCoef);
+}
+
+void arm_bitreversal_32(uint32_t *pSrc, const uint16_t bitRevLen, const uint16_t *pBitRevTable)
+{
+    for (unsigned i = 0; i < bitRevLen; i += 2) {
+        const unsigned a = pBitRevTable[i] >> 2;
+        const unsigned b = pBitRevTable[i + 1] >> 2;
+        uint32_t tmp = pSrc[a];
+        pSrc[a] = pSrc[b];
+        pSrc[b] = tmp;
+        tmp = pSrc[a + 1];
+        pSrc[a + 1] = pSrc[b + 1];
+        pSrc[b + 1] = tmp;
+    }
+}
+
+void stage_rfft_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut)
+{
+    const unsigned cfftLen = S->Sint.fftLen;
+
+    // DC and Nyquist are both real, packed into the first complex slot
+    pOut[0] = p[0] + p[1];
+    pOut[1] = p[0] - p[1];
+
+    for (unsigned k = 1; k < cfftLen; k++) {
+        // X[k] = (Z[k] + conj(Z[N-k])) / 2 - i * W^k * (Z[k] - conj(Z[N-k])) / 2
+        const float32_t aRe = 0.5f * (p[2 * k] + p[2 * (cfftLen - k)]);
+        const float32_t aIm = 0.5f * (p[2 * k + 1] - p[2 * (cfftLen - k) + 1]);
+        const float32_t bRe = 0.5f * (p[2 * k] - p[2 * (cfftLen - k)]);
+        const float32_t bIm = 0.5f * (p[2 * k + 1] + p[2 * (cfftLen - k) + 1]);
+        const float32_t c = S->pTwiddleRFFT[2 * k];
+        const float32_t s = S->pTwiddleRFFT[2 * k + 1];
+        pOut[2 * k] = aRe - (s * bRe - c * bIm);
+        pOut[2 * k + 1] = aIm - (c * bRe + s * bIm);
+    }
+}
+
+void arm_mult_f32(float32_t *pSrcA, float32_t *pSrcB, float32_t *pDst, uint32_t blockSize)
+{
+    for (uint32_t i = 0; i < blockSize; i++) {
+        pDst[i] = pSrcA[i] * pSrcB[i];
+    }
+}
+
+void arm_cmplx_mag_f32(float32_t *pSrc, float32_t *pDst, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++) {
+        pDst[i] = sqrtf(pSrc[2 * i] * pSrc[2 * i] + pSrc[2 * i + 1] * pSrc[2 * i + 1]);
+    }
+}
@@ -0,0 +1,508 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// asyncfatfs against a simulated SD card.
+//
+// The card is a RAM image behind the sdcard_* API with a timing model for the bus and the card's programming
+// time. Operations finish in sdcard_poll() once the simulated clock has passed their end, and the clock moves
+// one main task period per afatfs_poll(), so throughput is in simulated time while the worst case cost of a
+// call is measured on the host.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "drivers/sdcard.h"
+
+    #include "io/asyncfatfs/asyncfatfs.h"
+    #include "io/asyncfatfs/fat_standard.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define SIM_SECTOR_SIZE         512
+#define SIM_CARD_SECTORS        (16 * 1024 * 1024 / SIM_SECTOR_SIZE)
+
+// A FAT16 volume, the smallest asyncfatfs accepts, with the freefile spanning most of it
+#define SIM_PARTITION_START     64
+#define SIM_RESERVED_SECTORS    4
+#define SIM_SECTORS_PER_CLUSTER 4
+#define SIM_FAT_SECTORS         32
+#define SIM_ROOT_ENTRIES        512
+
+#define SIM_TICK_US             1000    // afatfs_poll() runs from the 1kHz main task
+
+typedef struct simCardTiming_s {
+    const char *name;
+    uint32_t commandUs;         // command and response ahead of a read, a single block write or a multi-block write
+    uint32_t transferUs;        // one block over the bus
+    uint32_t readAccessUs;      // card latency before read data is available
+    uint32_t programUs;         // busy after a single block write
+    uint32_t multiProgramUs;    // busy per block inside a pre-erased multi-block write
+    uint32_t stopUs;            // busy after the stop token that ends a multi-block write
+    uint8_t queueDepth;         // blocks the driver gathers into one transfer during a multi-block write, 0 for none
+} simCardTiming_t;
+
+static const simCardTiming_t spiCard = { "spi 21MHz", 20, 200, 100, 700, 50, 300, 0 };
+static const simCardTiming_t sdioCard = { "sdio 4-bit cached", 5, 25, 100, 700, 50, 300, 16 };
+
+static struct {
+    const simCardTiming_t *timing;
+    uint8_t *image;
+    uint64_t now;
+
+    bool busy;
+    uint64_t busyUntil;
+    sdcardBlockOperation_e operation;
+    uint32_t blockIndex;
+    uint8_t *buffer;
+    sdcard_operationCompleteCallback_c callback;
+    uint32_t callbackData;
+
+    bool multiWrite;
+    uint32_t multiWriteNextBlock;
+    uint32_t multiWriteBlocksRemain;
+    uint32_t multiWriteSetupUs;
+    uint8_t queued;
+
+    uint32_t reads;
+    uint32_t singleBlockWrites;
+    uint32_t multiBlockWrites;
+    uint32_t multiWriteBlocks;
+} simCard;
+
+static uint8_t *simCardSector(uint32_t blockIndex)
+{
+    return simCard.image + (size_t)blockIndex * SIM_SECTOR_SIZE;
+}
+
+static void simCardStart(sdcardBlockOperation_e operation, uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData, uint32_t durationUs)
+{
+    simCard.busy = true;
+    simCard.busyUntil = simCard.now + durationUs;
+    simCard.operation = operation;
+    simCard.blockIndex = blockIndex;
+    simCard.buffer = buffer;
+    simCard.callback = callback;
+    simCard.callbackData = callbackData;
+}
+
+static void simCardStopMultiWrite(void)
+{
+    const simCardTiming_t *timing = simCard.timing;
+
+    simCard.multiWrite = false;
+    simCardStart(SDCARD_BLOCK_OPERATION_WRITE, 0, NULL, NULL, 0, simCard.queued * (timing->transferUs + timing->multiProgramUs) + timing->stopUs);
+    simCard.queued = 0;
+}
+
+bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
+{
+    if (simCard.busy) {
+        return false;
+    }
+    if (simCard.multiWrite) {
+        simCardStopMultiWrite();
+        return false;
+    }
+
+    simCard.reads++;
+    simCardStart(SDCARD_BLOCK_OPERATION_READ, blockIndex, buffer, callback, callbackData,
+        simCard.timing->commandUs + simCard.timing->readAccessUs + simCard.timing->transferUs);
+
+    return true;
+}
+
+sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex, uint32_t blockCount)
+{
+    if (simCard.busy) {
+        return SDCARD_OPERATION_BUSY;
+    }
+    if (simCard.multiWrite) {
+        if (blockIndex == simCard.multiWriteNextBlock) {
+            return SDCARD_OPERATION_SUCCESS;
+        }
+        simCardStopMultiWrite();
+        return SDCARD_OPERATION_BUSY;
+    }
+
+    simCard.multiWrite = true;
+    simCard.multiWriteNextBlock = blockIndex;
+    simCard.multiWriteBlocksRemain = blockCount;
+    simCard.multiWriteSetupUs = simCard.timing->commandUs;
+    simCard.multiBlockWrites++;
+
+    return SDCARD_OPERATION_SUCCESS;
+}
+
+sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
+{
+    const simCardTiming_t *timing = simCard.timing;
+
+    if (simCard.busy) {
+        return SDCARD_OPERATION_BUSY;
+    }
+    if (simCard.multiWrite && blockIndex != simCard.multiWriteNextBlock) {
+        simCardStopMultiWrite();
+        return SDCARD_OPERATION_BUSY;
+    }
+
+    memcpy(simCardSector(blockIndex), buffer, SIM_SECTOR_SIZE);
+
+    if (!simCard.multiWrite) {
+        simCard.singleBlockWrites++;
+        simCardStart(SDCARD_BLOCK_OPERATION_WRITE, blockIndex, buffer, callback, callbackData,
+            timing->commandUs + timing->transferUs + timing->programUs);
+
+        return SDCARD_OPERATION_IN_PROGRESS;
+    }
+
+    simCard.multiWriteBlocks++;
+    simCard.multiWriteNextBlock++;
+    simCard.multiWriteBlocksRemain--;
+    simCard.queued++;
+
+    if (simCard.queued < timing->queueDepth && simCard.multiWriteBlocksRemain > 0) {
+        // Gathered for a later transfer, the caller's buffer is free again
+        return SDCARD_OPERATION_SUCCESS;
+    }
+
+    uint32_t durationUs = simCard.multiWriteSetupUs + simCard.queued * (timing->transferUs + timing->multiProgramUs);
+    simCard.multiWriteSetupUs = 0;
+    simCard.queued = 0;
+    if (simCard.multiWriteBlocksRemain == 0) {
+        simCard.multiWrite = false;
+        durationUs += timing->stopUs;
+    }
+    simCardStart(SDCARD_BLOCK_OPERATION_WRITE, blockIndex, buffer, callback, callbackData, durationUs);
+
+    return SDCARD_OPERATION_IN_PROGRESS;
+}
+
+bool sdcard_poll(void)
+{
+    if (simCard.busy && simCard.now >= simCard.busyUntil) {
+        simCard.busy = false;
+
+        sdcard_operationCompleteCallback_c callback = simCard.callback;
+        simCard.callback = NULL;
+        if (simCard.operation == SDCARD_BLOCK_OPERATION_READ) {
+            memcpy(simCard.buffer, simCardSector(simCard.blockIndex), SIM_SECTOR_SIZE);
+        }
+        if (callback) {
+            callback(simCard.operation, simCard.blockIndex, simCard.buffer, simCard.callbackData);
+        }
+    }
+
+    return !simCard.busy;
+}
+
+void sdcard_setProfilerCallback(sdcard_profilerCallback_c callback)
+{
+    UNUSED(callback);
+}
+
+static void simCardFormat(void)
+{
+    memset(simCard.image, 0, (size_t)SIM_CARD_SECTORS * SIM_SECTOR_SIZE);
+
+    uint8_t *mbr = simCardSector(0);
+    mbrPartitionEntry_t *partition = (mbrPartitionEntry_t *)(mbr + 446);
+    partition->type = MBR_PARTITION_TYPE_FAT16_LBA;
+    partition->lbaBegin = SIM_PARTITION_START;
+    partition->numSectors = SIM_CARD_SECTORS - SIM_PARTITION_START;
+    mbr[510] = 0x55;
+    mbr[511] = 0xAA;
+
+    uint8_t *volumeSector = simCardSector(SIM_PARTITION_START);
+    fatVolumeID_t *volume = (fatVolumeID_t *)volumeSector;
+    volume->bytesPerSector = SIM_SECTOR_SIZE;
+    volume->sectorsPerCluster = SIM_SECTORS_PER_CLUSTER;
+    volume->reservedSectorCount = SIM_RESERVED_SECTORS;
+    volume->numFATs = 2;
+    volume->rootEntryCount = SIM_ROOT_ENTRIES;
+    volume->totalSectors32 = SIM_CARD_SECTORS - SIM_PARTITION_START;
+    volume->media = 0xF8;
+    volume->FATSize16 = SIM_FAT_SECTORS;
+    memcpy(volume->fatDescriptor.fat16.fileSystemType, "FAT16   ", 8);
+    volumeSector[510] = FAT_VOLUME_ID_SIGNATURE_1;
+    volumeSector[511] = FAT_VOLUME_ID_SIGNATURE_2;
+
+    for (int i = 0; i < 2; i++) {
+        uint16_t *fat = (uint16_t *)simCardSector(SIM_PARTITION_START + SIM_RESERVED_SECTORS + i * SIM_FAT_SECTORS);
+        fat[0] = 0xFFF8;
+        fat[1] = 0xFFFF;
+    }
+}
+
+static void simTick(void)
+{
+    afatfs_poll();
+    simCard.now += SIM_TICK_US;
+}
+
+static void simCardMount(const simCardTiming_t *timing)
+{
+    uint8_t *image = simCard.image;
+    memset(&simCard, 0, sizeof(simCard));
+    simCard.image = image ? image : (uint8_t *)malloc((size_t)SIM_CARD_SECTORS * SIM_SECTOR_SIZE);
+    simCard.timing = timing;
+
+    simCardFormat();
+
+    afatfs_init();
+    for (int i = 0; i < 100000 && afatfs_getFilesystemState() == AFATFS_FILESYSTEM_STATE_INITIALIZATION; i++) {
+        simTick();
+    }
+    ASSERT_EQ(AFATFS_FILESYSTEM_STATE_READY, afatfs_getFilesystemState());
+}
+
+static void simCardUnmount(void)
+{
+    for (int i = 0; i < 100000 && !afatfs_destroy(false); i++) {
+        simCard.now += SIM_TICK_US;
+    }
+}
+
+static afatfsFilePtr_t openedFile;
+static bool openComplete;
+static bool closeComplete;
+
+static void fileOpened(afatfsFilePtr_t file)
+{
+    openedFile = file;
+    openComplete = true;
+}
+
+static void fileClosed(void)
+{
+    closeComplete = true;
+}
+
+static afatfsFilePtr_t simOpen(const char *filename, const char *mode)
+{
+    openedFile = NULL;
+    openComplete = false;
+    afatfs_fopen(filename, mode, fileOpened);
+    for (int i = 0; i < 10000 && !openComplete; i++) {
+        simTick();
+    }
+    return openedFile;
+}
+
+static void simClose(afatfsFilePtr_t file)
+{
+    closeComplete = false;
+    afatfs_fclose(file, fileClosed);
+    for (int i = 0; i < 10000 && !(closeComplete && afatfs_flush() && afatfs_sectorCacheInSync()); i++) {
+        simTick();
+    }
+    EXPECT_TRUE(closeComplete);
+}
+
+static uint8_t patternByte(uint32_t position)
+{
+    return (uint8_t)(position ^ (position >> 9) ^ (position >> 17));
+}
+
+static uint64_t benchmarkNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#define LOG_BYTES           (2 * 1024 * 1024)
+#define LOG_CHUNK_BYTES     256                 // the blackbox writes a frame or a header line at a time
+#define LOG_BYTES_PER_TICK  (16 * 1024)         // more than any card here takes, so the filesystem sets the pace
+
+typedef struct benchmarkResult_s {
+    double megabytesPerSecond;
+    double worstCallUs;         // host time of the slowest afatfs_fwrite() or afatfs_fread()
+    double worstPollUs;
+    uint32_t stalledTicks;
+} benchmarkResult_t;
+
+// Log LOG_BYTES to a new contiguous append file the way the blackbox does and close it
+static benchmarkResult_t appendLog(const char *filename)
+{
+    benchmarkResult_t result = {};
+    uint8_t chunk[LOG_CHUNK_BYTES];
+
+    afatfsFilePtr_t file = simOpen(filename, "as");
+    EXPECT_TRUE(file != NULL);
+    if (!file) {
+        return result;
+    }
+
+    const uint64_t startUs = simCard.now;
+    uint32_t written = 0;
+    while (written < LOG_BYTES) {
+        const uint32_t tickEnd = MIN(written + LOG_BYTES_PER_TICK, (uint32_t)LOG_BYTES);
+
+        while (written < tickEnd) {
+            const uint32_t length = MIN(tickEnd - written, (uint32_t)LOG_CHUNK_BYTES);
+            for (uint32_t i = 0; i < length; i++) {
+                chunk[i] = patternByte(written + i);
+            }
+
+            const uint64_t start = benchmarkNanos();
+            const uint32_t accepted = afatfs_fwrite(file, chunk, length);
+            result.worstCallUs = MAX(result.worstCallUs, (benchmarkNanos() - start) / 1000.0);
+
+            written += accepted;
+            if (accepted < length) {
+                break;
+            }
+        }
+
+        const uint64_t start = benchmarkNanos();
+        simTick();
+        result.worstPollUs = MAX(result.worstPollUs, (benchmarkNanos() - start) / 1000.0);
+    }
+    simClose(file);
+
+    result.megabytesPerSecond = (double)LOG_BYTES / (simCard.now - startUs);
+
+    return result;
+}
+
+// Read the whole file back readBytes at a time, one read per main task period like an MSP download
+static benchmarkResult_t readLog(const char *filename, uint32_t readBytes, uint32_t *mismatches)
+{
+    benchmarkResult_t result = {};
+    uint8_t chunk[SIM_SECTOR_SIZE * 4];
+
+    *mismatches = 0;
+
+    afatfsFilePtr_t file = simOpen(filename, "r");
+    EXPECT_TRUE(file != NULL);
+    if (!file) {
+        return result;
+    }
+
+    const uint64_t startUs = simCard.now;
+    uint32_t position = 0;
+    for (int tick = 0; tick < 1000000 && !afatfs_feof(file); tick++) {
+        const uint64_t start = benchmarkNanos();
+        const uint32_t length = afatfs_fread(file, chunk, readBytes);
+        result.worstCallUs = MAX(result.worstCallUs, (benchmarkNanos() - start) / 1000.0);
+
+        for (uint32_t i = 0; i < length; i++) {
+            if (chunk[i] != patternByte(position + i)) {
+                (*mismatches)++;
+            }
+        }
+        position += length;
+        if (length < readBytes && !afatfs_feof(file)) {
+            result.stalledTicks++;
+        }
+
+        const uint64_t pollStart = benchmarkNanos();
+        simTick();
+        result.worstPollUs = MAX(result.worstPollUs, (benchmarkNanos() - pollStart) / 1000.0);
+    }
+    EXPECT_EQ((uint32_t)LOG_BYTES, position);
+
+    result.megabytesPerSecond = (double)position / (simCard.now - startUs);
+
+    simClose(file);
+
+    return result;
+}
+
+TEST(AsyncFatfsTest, AppendAndReadBack)
+{
+    simCardMount(&spiCard);
+
+    appendLog("LOG00001.BFL");
+
+    uint32_t mismatches;
+    readLog("LOG00001.BFL", 1000, &mismatches);
+    EXPECT_EQ(0U, mismatches);
+
+    EXPECT_EQ(AFATFS_FILESYSTEM_STATE_READY, afatfs_getFilesystemState());
+    simCardUnmount();
+}
+
+TEST(AsyncFatfsBenchmark, StreamingAppend)
+{
+    const simCardTiming_t *cards[] = { &spiCard, &sdioCard };
+
+    printf("%-20s %10s %10s %10s %12s %12s\n", "card", "MB/s", "single", "multi", "worst fwrite", "worst poll");
+    for (unsigned c = 0; c < ARRAYLEN(cards); c++) {
+        simCardMount(cards[c]);
+
+        const benchmarkResult_t result = appendLog("LOG00001.BFL");
+
+        printf("%-20s %10.2f %10u %10u %10.1fus %10.1fus\n", cards[c]->name, result.megabytesPerSecond,
+            simCard.singleBlockWrites, simCard.multiWriteBlocks, result.worstCallUs, result.worstPollUs);
+
+        // Log data goes out in multi-block writes, only the FAT and directory sectors are written on their own
+        EXPECT_GT(simCard.multiWriteBlocks, (uint32_t)LOG_BYTES / SIM_SECTOR_SIZE);
+        EXPECT_LT(simCard.singleBlockWrites, simCard.multiWriteBlocks / 64);
+        if (cards[c]->queueDepth) {
+            // A driver that gathers blocks gets more than one sector per poll
+            EXPECT_GT(result.megabytesPerSecond, 2.0 * SIM_SECTOR_SIZE / SIM_TICK_US);
+        }
+
+        uint32_t mismatches;
+        readLog("LOG00001.BFL", SIM_SECTOR_SIZE, &mismatches);
+        EXPECT_EQ(0U, mismatches);
+
+        simCardUnmount();
+    }
+}
+
+TEST(AsyncFatfsBenchmark, SequentialRead)
+{
+    const uint32_t readSizes[] = { 128, 512, 2048 };
+
+    simCardMount(&spiCard);
+    appendLog("LOG00001.BFL");
+
+    printf("%-10s %10s %10s %10s %12s %12s\n", "read size", "MB/s", "reads", "stalls", "worst fread", "worst poll");
+    for (unsigned r = 0; r < ARRAYLEN(readSizes); r++) {
+        const uint32_t readsBefore = simCard.reads;
+
+        uint32_t mismatches;
+        const benchmarkResult_t result = readLog("LOG00001.BFL", readSizes[r], &mismatches);
+
+        printf("%-10u %10.3f %10u %10u %10.1fus %10.1fus\n", readSizes[r], result.megabytesPerSecond,
+            simCard.reads - readsBefore, result.stalledTicks, result.worstCallUs, result.worstPollUs);
+
+        EXPECT_EQ(0U, mismatches);
+        if (readSizes[r] <= SIM_SECTOR_SIZE) {
+            // Read-ahead has the next sector waiting, apart from the first one after opening the file
+            EXPECT_LE(result.stalledTicks, 4U);
+        }
+    }
+
+    simCardUnmount();
+}
@@ -0,0 +1,449 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Logging throughput of the blackbox against simulated flash, SD card and serial devices.
+//
+// Each device is a buffer drained at a fixed byte rate, writes that don't fit are lost the way the real
+// drivers lose them. The benchmark runs the blackbox state machine through the headers, then logs
+// synthetic flight data and reports bytes per frame, encoding time per frame and dropped frames.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "blackbox/blackbox.h"
+    #include "blackbox/blackbox_fielddefs.h"
+    #include "blackbox/blackbox_io.h"
+    #include "common/utils.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+    #include "pg/rx.h"
+    #include "pg/motor.h"
+
+    #include "drivers/accgyro/accgyro.h"
+    #include "drivers/accgyro/gyro_sync.h"
+    #include "drivers/sdcard.h"
+    #include "drivers/serial.h"
+
+    #include "fc/rc_controls.h"
+    #include "fc/rc_modes.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/failsafe.h"
+    #include "flight/mixer.h"
+    #include "flight/pid.h"
+    #include "flight/servos.h"
+
+    #include "io/asyncfatfs/asyncfatfs.h"
+    #include "io/flashfs.h"
+    #include "io/beeper.h"
+    #include "io/gps.h"
+    #include "io/serial.h"
+
+    #include "rx/rx.h"
+
+    #include "sensors/acceleration.h"
+    #include "sensors/barometer.h"
+    #include "sensors/battery.h"
+    #include "sensors/compass.h"
+    #include "sensors/gyro.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define BENCHMARK_LOOPTIME_US   125     // 8kHz PID loop
+#define BENCHMARK_DURATION_S    1
+
+typedef struct simDevice_s {
+    const char *name;
+    uint8_t device;             // BLACKBOX_DEVICE_*
+    uint32_t bufferSize;        // bytes the driver can hold
+    uint32_t bytesPerSecond;    // rate at which the medium takes them
+} simDevice_t;
+
+static const simDevice_t simDevices[] = {
+    { "serial 115200",  BLACKBOX_DEVICE_SERIAL, 256,  11520 },
+    { "serial 2000000", BLACKBOX_DEVICE_SERIAL, 256,  200000 },
+    { "flash",          BLACKBOX_DEVICE_FLASH,  128,  300000 },     // SPI NOR, page program bound
+    { "sdcard",         BLACKBOX_DEVICE_SDCARD, 4096, 1000000 },    // afatfs sector cache
+};
+
+static const uint8_t sampleRates[] = { 0, 1, 3 };  // 1:1, 1/2, 1/8 of the PID loop
+
+typedef struct fieldMask_s {
+    const char *name;
+    uint32_t fieldsDisabledMask;
+} fieldMask_t;
+
+static const fieldMask_t fieldMasks[] = {
+    { "all fields", 0 },
+    { "no debug/motors", (1 << FLIGHT_LOG_FIELD_SELECT_DEBUG_LOG) | (1 << FLIGHT_LOG_FIELD_SELECT_MOTOR) },
+};
+
+static struct {
+    const simDevice_t *config;
+    uint32_t fill;              // bytes waiting in the driver
+    double drainCredit;
+    uint32_t offset;            // flashfs logical offset
+    uint64_t acceptedBytes;
+    uint64_t lostBytes;
+    bool sawDroppedFramesEvent;
+} sim;
+
+static timeUs_t simTimeUs;
+static pidProfile_t benchmarkPidProfile;
+
+static void simDeviceReset(const simDevice_t *config)
+{
+    memset(&sim, 0, sizeof(sim));
+    sim.config = config;
+}
+
+static void simDeviceDrain(timeUs_t deltaUs)
+{
+    sim.drainCredit += (double)sim.config->bytesPerSecond * deltaUs * 1e-6;
+    const uint32_t drained = MIN(sim.fill, (uint32_t)sim.drainCredit);
+    sim.fill -= drained;
+    sim.drainCredit -= drained;
+    if (sim.fill == 0) {
+        sim.drainCredit = 0;    // an idle device doesn't bank bandwidth
+    }
+}
+
+static uint32_t simDeviceFree(void)
+{
+    return sim.config->bufferSize - sim.fill;
+}
+
+static void simDeviceAccept(const uint8_t *data, uint32_t length)
+{
+    // frames arrive in one write each, an event frame starts with 'E' and its type
+    if (length >= 2 && data[0] == 'E' && data[1] == FLIGHT_LOG_EVENT_DROPPED_FRAMES) {
+        sim.sawDroppedFramesEvent = true;
+    }
+    sim.fill += length;
+    sim.acceptedBytes += length;
+}
+
+// Something to log that changes like flight data does, a few hundred Hz of movement plus noise
+static void loadSyntheticState(uint32_t iteration)
+{
+    const float t = iteration * BENCHMARK_LOOPTIME_US * 1e-6f;
+    static uint32_t seed = 1;
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        seed = seed * 1664525 + 1013904223;
+        const float noise = (int)(seed >> 24) - 128;
+        const float movement = 300 * sinf(2 * M_PIf * (3 + axis) * t);
+
+        gyro.gyroADCf[axis] = movement + noise * 0.2f;
+        acc.accADC[axis] = 100 * sinf(2 * M_PIf * 5 * t) + noise * 0.5f;
+        mag.magADC[axis] = 200 + axis;
+        pidData[axis].P = movement * 0.1f + noise * 0.1f;
+        pidData[axis].I = 20 * sinf(2 * M_PIf * t);
+        pidData[axis].D = noise * 0.3f;
+        pidData[axis].F = movement * 0.05f;
+        rcCommand[axis] = 100 * sinf(2 * M_PIf * 0.5f * t);
+    }
+    rcCommand[THROTTLE] = 1400;
+
+    for (int i = 0; i < 4; i++) {
+        motor[i] = 1400 + gyro.gyroADCf[i % XYZ_AXIS_COUNT] * 0.5f;
+    }
+    for (int i = 0; i < DEBUG16_VALUE_COUNT; i++) {
+        debug[i] = lrintf(gyro.gyroADCf[i % XYZ_AXIS_COUNT]);
+    }
+}
+
+static uint64_t benchmarkNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+typedef struct benchmarkResult_s {
+    uint32_t frames;
+    double bytesPerFrame;
+    double nsPerFrame;
+    uint32_t droppedFrames;
+} benchmarkResult_t;
+
+// Returns the time spent in blackboxUpdate()
+static uint64_t runBlackbox(uint32_t iterations, uint32_t *iteration)
+{
+    uint64_t elapsed = 0;
+    for (uint32_t i = 0; i < iterations; i++, (*iteration)++) {
+        simTimeUs += BENCHMARK_LOOPTIME_US;
+        simDeviceDrain(BENCHMARK_LOOPTIME_US);
+        loadSyntheticState(*iteration);
+
+        const uint64_t start = benchmarkNanos();
+        blackboxUpdate(simTimeUs);
+        elapsed += benchmarkNanos() - start;
+    }
+    return elapsed;
+}
+
+static benchmarkResult_t runBenchmark(const simDevice_t *device, uint8_t sampleRate, uint32_t fieldsDisabledMask)
+{
+    simDeviceReset(device);
+    simTimeUs = 0;
+
+    targetPidLooptime = BENCHMARK_LOOPTIME_US;
+    benchmarkPidProfile.pid[FD_ROLL].D = 40;    // D on roll and pitch only, like the defaults
+    benchmarkPidProfile.pid[FD_PITCH].D = 46;
+    blackboxConfigMutable()->device = device->device;
+    blackboxConfigMutable()->sample_rate = sampleRate;
+    blackboxConfigMutable()->fields_disabled_mask = fieldsDisabledMask;
+    blackboxConfigMutable()->mode = BLACKBOX_MODE_NORMAL;
+    blackboxInit();
+
+    // arm and get through the headers, a second is plenty even at 115200 baud
+    ENABLE_ARMING_FLAG(ARMED);
+    uint32_t iteration = 0;
+    runBlackbox(1000000 / BENCHMARK_LOOPTIME_US, &iteration);
+
+    const uint64_t acceptedBefore = sim.acceptedBytes;
+    const uint64_t lostBefore = sim.lostBytes;
+    const uint32_t droppedBytesBefore = blackboxGetDroppedByteCount();
+    const uint32_t droppedBefore = blackboxGetDroppedFrameCount();
+
+    const uint32_t iterations = BENCHMARK_DURATION_S * 1000000 / BENCHMARK_LOOPTIME_US;
+    const uint64_t elapsed = runBlackbox(iterations, &iteration);
+
+    // serial frames that don't fit are dropped before the driver sees them, only the blackbox counts those
+    const uint64_t lostBytes = device->device == BLACKBOX_DEVICE_SERIAL ? blackboxGetDroppedByteCount() - droppedBytesBefore : sim.lostBytes - lostBefore;
+
+    benchmarkResult_t result;
+    result.frames = iterations / blackboxGetRateDenom();
+    result.bytesPerFrame = (double)(sim.acceptedBytes - acceptedBefore + lostBytes) / result.frames;
+    result.nsPerFrame = (double)elapsed / result.frames;
+    result.droppedFrames = blackboxGetDroppedFrameCount() - droppedBefore;
+
+    blackboxFinish();
+    DISABLE_ARMING_FLAG(ARMED);
+    runBlackbox(1000000 / BENCHMARK_LOOPTIME_US, &iteration);
+
+    return result;
+}
+
+TEST(BlackboxBenchmark, Throughput)
+{
+    printf("%-16s %-6s %-16s %10s %10s %10s %12s\n", "device", "rate", "fields", "frames", "bytes/fr", "ns/fr", "dropped");
+
+    for (unsigned d = 0; d < ARRAYLEN(simDevices); d++) {
+        for (unsigned r = 0; r < ARRAYLEN(sampleRates); r++) {
+            for (unsigned f = 0; f < ARRAYLEN(fieldMasks); f++) {
+                const benchmarkResult_t result = runBenchmark(&simDevices[d], sampleRates[r], fieldMasks[f].fieldsDisabledMask);
+
+                printf("%-16s 1/%-4d %-16s %10u %10.1f %10.1f %12u\n", simDevices[d].name, 1 << sampleRates[r], fieldMasks[f].name,
+                    result.frames, result.bytesPerFrame, result.nsPerFrame, result.droppedFrames);
+
+                EXPECT_GT(result.bytesPerFrame, 2);
+            }
+        }
+    }
+}
+
+TEST(BlackboxBenchmark, DroppedFramesAreLogged)
+{
+    // 1:1 logging at 115200 baud can't keep up
+    const benchmarkResult_t result = runBenchmark(&simDevices[0], 0, 0);
+
+    EXPECT_GT(result.droppedFrames, 0U);
+    EXPECT_TRUE(sim.sawDroppedFramesEvent);
+}
+
+TEST(BlackboxBenchmark, NoDropsWithinBandwidth)
+{
+    // 1/8 with the big fields off fits through 2000000 baud with room to spare
+    const benchmarkResult_t result = runBenchmark(&simDevices[1], 3, fieldMasks[1].fieldsDisabledMask);
+
+    EXPECT_EQ(0U, result.droppedFrames);
+    EXPECT_FALSE(sim.sawDroppedFramesEvent);
+}
+
+// STUBS
+extern "C" {
+
+PG_REGISTER(flight3DConfig_t, flight3DConfig, PG_MOTOR_3D_CONFIG, 0);
+PG_REGISTER(mixerConfig_t, mixerConfig, PG_MIXER_CONFIG, 0);
+PG_REGISTER(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 0);
+PG_REGISTER(batteryConfig_t, batteryConfig, PG_BATTERY_CONFIG, 0);
+PG_REGISTER(rxConfig_t, rxConfig, PG_RX_CONFIG, 0);
+PG_REGISTER_ARRAY(modeActivationCondition_t, MAX_MODE_ACTIVATION_CONDITION_COUNT, modeActivationConditions, PG_MODE_ACTIVATION_PROFILE, 0);
+
+uint8_t armingFlags;
+uint8_t stateFlags;
+const uint32_t baudRates[] = {0, 9600, 19200, 38400, 57600, 115200, 230400, 250000,
+        400000, 460800, 500000, 921600, 1000000, 1500000, 2000000, 2470000}; // see baudRate_e
+uint8_t debugMode = DEBUG_GYRO_SCALED;
+int16_t debug[DEBUG16_VALUE_COUNT];
+gpsSolutionData_t gpsSol;
+int32_t GPS_home[2];
+
+gyro_t gyro;
+acc_t acc;
+mag_t mag;
+baro_t baro;
+pidAxisData_t pidData[XYZ_AXIS_COUNT];
+float rcCommand[4];
+float motor[MAX_SUPPORTED_MOTORS];
+int16_t servo[MAX_SUPPORTED_SERVOS];
+
+float motor_disarmed[MAX_SUPPORTED_MOTORS];
+pidProfile_t *currentPidProfile = &benchmarkPidProfile;
+uint32_t targetPidLooptime;
+
+boxBitmask_t rcModeActivationMask;
+
+void beeper(beeperMode_e) {}
+void mspSerialAllocatePorts(void) {}
+uint32_t getArmingBeepTimeMicros(void) {return 0;}
+uint16_t getBatteryVoltageLatest(void) {return 1680;}
+int32_t getAmperageLatest(void) {return 1200;}
+uint16_t getRssi(void) {return 1023;}
+float pidGetPreviousSetpoint(int axis) {return rcCommand[axis] * 2;}
+float mixerGetThrottle(void) {return 0.4f;}
+uint8_t getMotorCount(void) {return 4;}
+bool areMotorsRunning(void) { return false; }
+bool IS_RC_MODE_ACTIVE(boxId_e) {return false;}
+bool isModeActivationConditionPresent(boxId_e) {return false;}
+uint32_t millis(void) {return simTimeUs / 1000;}
+bool sensors(uint32_t) {return true;}
+bool featureIsEnabled(uint32_t) {return false;}
+failsafePhase_e failsafePhase(void) {return FAILSAFE_IDLE;}
+bool rxAreFlightChannelsValid(void) {return true;}
+bool rxIsReceivingSignal(void) {return true;}
+bool isRssiConfigured(void) {return false;}
+float getMotorOutputLow(void) {return 1000.0;}
+float getMotorOutputHigh(void) {return 2000.0;}
+
+// serial
+static serialPort_t simSerialPort;
+static serialPortConfig_t simSerialPortConfig;
+
+void serialWrite(serialPort_t *, uint8_t ch)
+{
+    simDeviceAccept(&ch, 1);
+}
+void serialWriteBuf(serialPort_t *, const uint8_t *data, int count)
+{
+    simDeviceAccept(data, count);
+}
+uint32_t serialTxBytesFree(const serialPort_t *) {return simDeviceFree();}
+bool isSerialTransmitBufferEmpty(const serialPort_t *) {return sim.fill == 0;}
+void mspSerialReleasePortIfAllocated(serialPort_t *) {}
+const serialPortConfig_t *findSerialPortConfig(serialPortFunction_e )
+{
+    simSerialPortConfig.blackbox_baudrateIndex = BAUD_2000000;
+    return &simSerialPortConfig;
+}
+serialPort_t *findSharedSerialPort(uint16_t , serialPortFunction_e ) {return NULL;}
+serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) {return &simSerialPort;}
+void closeSerialPort(serialPort_t *) {}
+portSharing_e determinePortSharing(const serialPortConfig_t *, serialPortFunction_e ) {return PORTSHARING_UNUSED;}
+
+// flash, an asynchronous write that doesn't fit is discarded
+void flashfsWrite(const uint8_t *data, unsigned int len, bool)
+{
+    if (len > simDeviceFree()) {
+        sim.lostBytes += len;
+        return;
+    }
+    simDeviceAccept(data, len);
+    sim.offset += len;
+}
+void flashfsWriteByte(uint8_t byte) {flashfsWrite(&byte, 1, false);}
+uint32_t flashfsGetOffset(void) {return sim.offset;}
+bool flashfsFlushAsync(bool) {return sim.fill == 0;}
+bool flashfsIsSupported(void) {return true;}
+bool flashfsIsReady(void) {return true;}
+bool flashfsIsEOF(void) {return false;}
+void flashfsEraseCompletely(void) {}
+void flashfsClose(void) {}
+uint32_t flashfsGetSize(void) {return 16 * 1024 * 1024;}
+uint32_t flashfsGetWriteBufferFreeSpace(void) {return simDeviceFree();}
+uint32_t flashfsGetWriteBufferSize(void) {return sim.config->bufferSize;}
+
+// SD card, writes what fits
+static afatfsFile_t *simLogFile = (afatfsFile_t *)&sim;
+static fatDirectoryEntry_t *simDirectoryEntry;
+
+uint32_t afatfs_fwrite(afatfsFilePtr_t, const uint8_t *buffer, uint32_t len)
+{
+    const uint32_t written = MIN(len, simDeviceFree());
+    simDeviceAccept(buffer, written);
+    sim.lostBytes += len - written;
+    return written;
+}
+void afatfs_fputc(afatfsFilePtr_t file, uint8_t c) {afatfs_fwrite(file, &c, 1);}
+afatfsFilesystemState_e afatfs_getFilesystemState(void) {return AFATFS_FILESYSTEM_STATE_READY;}
+bool afatfs_isFull(void) {return false;}
+bool afatfs_flush(void) {return sim.fill == 0;}
+bool afatfs_sectorCacheInSync(void) {return sim.fill == 0;}
+bool afatfs_fclose(afatfsFilePtr_t, afatfsCallback_t callback)
+{
+    if (callback) {
+        callback();
+    }
+    return true;
+}
+bool afatfs_mkdir(const char *, afatfsFileCallback_t complete)
+{
+    complete(simLogFile);
+    return true;
+}
+bool afatfs_chdir(afatfsFilePtr_t) {return true;}
+bool afatfs_fopen(const char *, const char *, afatfsFileCallback_t complete)
+{
+    complete(simLogFile);
+    return true;
+}
+void afatfs_findFirst(afatfsFilePtr_t, afatfsFinder_t *) {}
+afatfsOperationStatus_e afatfs_findNext(afatfsFilePtr_t, afatfsFinder_t *, fatDirectoryEntry_t **dirEntry)
+{
+    *dirEntry = simDirectoryEntry;
+    return AFATFS_OPERATION_SUCCESS;
+}
+void afatfs_findLast(afatfsFilePtr_t) {}
+bool afatfs_funlink(afatfsFilePtr_t, afatfsCallback_t callback)
+{
+    if (callback) {
+        callback();
+    }
+    return true;
+}
+uint32_t afatfs_getFreeBufferSpace(void) {return simDeviceFree();}
+bool sdcard_isInserted(void) {return true;}
+bool sdcard_isFunctional(void) {return true;}
+uint32_t afatfs_getContiguousFreeSpace(void) {return 1024 * 1024 * 1024;}
+bool fat_isDirectoryEntryTerminator(fatDirectoryEntry_t *) {return true;}
+}
@@ -0,0 +1,411 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Cost of a full configuration backup and restore through the CLI.
+//
+// A value table about the size of a full featured target is dumped with 'diff all', every 'set' line of
+// the output is then typed back into the CLI the way a configurator restores a backup. Reports the time
+// of both and how the output reached the serial port.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+    #include "target.h"
+    #include "build/version.h"
+    #include "cli/cli.h"
+    #include "cli/settings.h"
+    #include "cli/settings_index.h"
+    #include "common/printf.h"
+    #include "config/feature.h"
+    #include "drivers/buf_writer.h"
+    #include "drivers/serial.h"
+    #include "drivers/vtx_common.h"
+    #include "config/config.h"
+    #include "fc/rc_adjustments.h"
+    #include "fc/runtime_config.h"
+    #include "flight/mixer.h"
+    #include "flight/pid.h"
+    #include "flight/servos.h"
+    #include "io/beeper.h"
+    #include "io/ledstrip.h"
+    #include "io/serial.h"
+    #include "io/vtx.h"
+    #include "msp/msp.h"
+    #include "msp/msp_box.h"
+    #include "osd/osd.h"
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+    #include "pg/beeper.h"
+    #include "pg/rx.h"
+    #include "rx/rx.h"
+    #include "scheduler/scheduler.h"
+    #include "sensors/battery.h"
+    #include "sensors/gyro.h"
+
+    uint16_t cliGetSettingIndex(char *name, uint8_t length);
+    void *cliGetValuePointer(const clivalue_t *value);
+
+    #define BENCH_GROUP_COUNT       10
+    #define BENCH_GROUP_SIZE        64
+    #define BENCH_PGN(group)        (1000 + (group))
+    #define BENCH_SETTING_COUNT     (BENCH_GROUP_COUNT * BENCH_GROUP_SIZE)
+
+    typedef struct benchConfig_s {
+        uint16_t value[BENCH_GROUP_SIZE];
+    } benchConfig_t;
+
+    PG_REGISTER(benchConfig_t, benchConfig0, BENCH_PGN(0), 0);
+    PG_REGISTER(benchConfig_t, benchConfig1, BENCH_PGN(1), 0);
+    PG_REGISTER(benchConfig_t, benchConfig2, BENCH_PGN(2), 0);
+    PG_REGISTER(benchConfig_t, benchConfig3, BENCH_PGN(3), 0);
+    PG_REGISTER(benchConfig_t, benchConfig4, BENCH_PGN(4), 0);
+    PG_REGISTER(benchConfig_t, benchConfig5, BENCH_PGN(5), 0);
+    PG_REGISTER(benchConfig_t, benchConfig6, BENCH_PGN(6), 0);
+    PG_REGISTER(benchConfig_t, benchConfig7, BENCH_PGN(7), 0);
+    PG_REGISTER(benchConfig_t, benchConfig8, BENCH_PGN(8), 0);
+    PG_REGISTER(benchConfig_t, benchConfig9, BENCH_PGN(9), 0);
+
+    #define BENCH_SETTING(g, i, j) \
+        { "bench_group" #g "_setting_" #i #j, VAR_UINT16 | MODE_DIRECT | MASTER_VALUE, .config.minmaxUnsigned = { 0, 60000 }, BENCH_PGN(g), offsetof(benchConfig_t, value[i * 8 + j]) }
+    #define BENCH_SETTING_ROW(g, i) \
+        BENCH_SETTING(g, i, 0), BENCH_SETTING(g, i, 1), BENCH_SETTING(g, i, 2), BENCH_SETTING(g, i, 3), \
+        BENCH_SETTING(g, i, 4), BENCH_SETTING(g, i, 5), BENCH_SETTING(g, i, 6), BENCH_SETTING(g, i, 7)
+    #define BENCH_SETTING_GROUP(g) \
+        BENCH_SETTING_ROW(g, 0), BENCH_SETTING_ROW(g, 1), BENCH_SETTING_ROW(g, 2), BENCH_SETTING_ROW(g, 3), \
+        BENCH_SETTING_ROW(g, 4), BENCH_SETTING_ROW(g, 5), BENCH_SETTING_ROW(g, 6), BENCH_SETTING_ROW(g, 7)
+
+    const clivalue_t valueTable[] = {
+        BENCH_SETTING_GROUP(0), BENCH_SETTING_GROUP(1), BENCH_SETTING_GROUP(2), BENCH_SETTING_GROUP(3), BENCH_SETTING_GROUP(4),
+        BENCH_SETTING_GROUP(5), BENCH_SETTING_GROUP(6), BENCH_SETTING_GROUP(7), BENCH_SETTING_GROUP(8), BENCH_SETTING_GROUP(9),
+    };
+    const uint16_t valueTableEntryCount = ARRAYLEN(valueTable);
+    uint16_t settingIndex[SETTING_INDEX_SIZE(ARRAYLEN(valueTable))];
+    const uint16_t settingIndexSize = ARRAYLEN(settingIndex);
+    const lookupTableEntry_t lookupTables[] = {};
+    const char * const lookupTableOsdDisplayPortDevice[] = {};
+
+    PG_REGISTER(osdConfig_t, osdConfig, PG_OSD_CONFIG, 0);
+    PG_REGISTER(batteryConfig_t, batteryConfig, PG_BATTERY_CONFIG, 0);
+    PG_REGISTER(ledStripConfig_t, ledStripConfig, PG_LED_STRIP_CONFIG, 0);
+    PG_REGISTER(ledStripStatusModeConfig_t, ledStripStatusModeConfig, PG_LED_STRIP_STATUS_MODE_CONFIG, 0);
+    PG_REGISTER(systemConfig_t, systemConfig, PG_SYSTEM_CONFIG, 0);
+    PG_REGISTER(pilotConfig_t, pilotConfig, PG_PILOT_CONFIG, 0);
+    PG_REGISTER_ARRAY(adjustmentRange_t, MAX_ADJUSTMENT_RANGE_COUNT, adjustmentRanges, PG_ADJUSTMENT_RANGE_CONFIG, 0);
+    PG_REGISTER_ARRAY(modeActivationCondition_t, MAX_MODE_ACTIVATION_CONDITION_COUNT, modeActivationConditions, PG_MODE_ACTIVATION_PROFILE, 0);
+    PG_REGISTER_WITH_RESET_TEMPLATE(mixerConfig_t, mixerConfig, PG_MIXER_CONFIG, 0);
+    PG_RESET_TEMPLATE(mixerConfig_t, mixerConfig, .mixerMode = MIXER_QUADX);
+    PG_REGISTER_ARRAY(motorMixer_t, MAX_SUPPORTED_MOTORS, customMotorMixer, PG_MOTOR_MIXER, 0);
+    PG_REGISTER_ARRAY(servoParam_t, MAX_SUPPORTED_SERVOS, servoParams, PG_SERVO_PARAMS, 0);
+    PG_REGISTER_ARRAY(servoMixer_t, MAX_SERVO_RULES, customServoMixers, PG_SERVO_MIXER, 0);
+    PG_REGISTER(beeperConfig_t, beeperConfig, PG_BEEPER_CONFIG, 0);
+    PG_REGISTER(rxConfig_t, rxConfig, PG_RX_CONFIG, 0);
+    PG_REGISTER(serialConfig_t, serialConfig, PG_SERIAL_CONFIG, 0);
+    PG_REGISTER_ARRAY(rxChannelRangeConfig_t, NON_AUX_CHANNEL_COUNT, rxChannelRangeConfigs, PG_RX_CHANNEL_RANGE_CONFIG, 0);
+    PG_REGISTER_ARRAY(rxFailsafeChannelConfig_t, MAX_SUPPORTED_RC_CHANNEL_COUNT, rxFailsafeChannelConfigs, PG_RX_FAILSAFE_CHANNEL_CONFIG, 0);
+    PG_REGISTER(pidConfig_t, pidConfig, PG_PID_CONFIG, 0);
+    PG_REGISTER(gyroConfig_t, gyroConfig, PG_GYRO_CONFIG, 0);
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static serialPort_t cliTestPort;
+
+// what the CLI reads, and everything it wrote to the serial port
+static std::string serialInput;
+static size_t serialInputIndex;
+static std::string serialOutput;
+static int serialWriteCount;
+
+static uint64_t benchmarkNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint16_t *benchValue(int setting)
+{
+    return (uint16_t *)cliGetValuePointer(&valueTable[setting]);
+}
+
+// Runs the input through the CLI, returns the time it took
+static uint64_t cliType(const std::string &input)
+{
+    serialInput = input;
+    serialInputIndex = 0;
+    serialOutput.clear();
+    serialWriteCount = 0;
+
+    const uint64_t start = benchmarkNanos();
+    cliProcess();
+    return benchmarkNanos() - start;
+}
+
+TEST(CliBenchmarkTest, SettingIndex)
+{
+    for (int i = 0; i < valueTableEntryCount; i++) {
+        char name[40];
+        strcpy(name, valueTable[i].name);
+        EXPECT_EQ(i, cliGetSettingIndex(name, strlen(name)));
+
+        // names are case insensitive, and must match completely
+        name[0] = 'B';
+        EXPECT_EQ(i, cliGetSettingIndex(name, strlen(name)));
+        EXPECT_EQ(valueTableEntryCount, cliGetSettingIndex(name, strlen(name) - 1));
+        strcat(name, "0");
+        EXPECT_EQ(valueTableEntryCount, cliGetSettingIndex(name, strlen(name)));
+    }
+
+    char unknown[] = "not_a_setting = 1";
+    EXPECT_EQ(valueTableEntryCount, cliGetSettingIndex(unknown, 13));
+}
+
+TEST(CliBenchmarkTest, DiffAllRestore)
+{
+    pgResetAll();
+    cliEnter(&cliTestPort);
+
+    for (int i = 0; i < BENCH_SETTING_COUNT; i++) {
+        *benchValue(i) = i * 7 + 1;
+    }
+
+    const uint64_t diffNanos = cliType("diff all\r");
+    const std::string diff = serialOutput;
+    const int diffWriteCount = serialWriteCount;
+
+    std::vector<std::string> setLines;
+    for (size_t start = 0, end; (end = diff.find("\r\n", start)) != std::string::npos; start = end + 2) {
+        if (diff.compare(start, 4, "set ") == 0) {
+            setLines.push_back(diff.substr(start, end - start));
+        }
+    }
+    EXPECT_EQ(BENCH_SETTING_COUNT, (int)setLines.size());
+
+    // the dump goes out in whole buffers, not a write per line
+    EXPECT_LE(diffWriteCount, (int)diff.size() / 64 + 3);
+
+    for (int i = 0; i < BENCH_SETTING_COUNT; i++) {
+        *benchValue(i) = 0;
+    }
+
+    std::string restore;
+    for (const std::string &line : setLines) {
+        restore += line + "\r";
+    }
+    const uint64_t restoreNanos = cliType(restore);
+
+    for (int i = 0; i < BENCH_SETTING_COUNT; i++) {
+        EXPECT_EQ(i * 7 + 1, *benchValue(i));
+    }
+
+    printf("%d settings\n", BENCH_SETTING_COUNT);
+    printf("diff all:    %8u bytes in %5d writes, %8.1f us\n", (unsigned)diff.size(), diffWriteCount, diffNanos / 1000.0);
+    printf("restore:     %8u lines, %8.1f us, %6.2f us per set\n", (unsigned)setLines.size(), restoreNanos / 1000.0, restoreNanos / 1000.0 / setLines.size());
+}
+
+// STUBS
+extern "C" {
+
+uint32_t serialRxBytesWaiting(const serialPort_t *)
+{
+    return serialInput.size() - serialInputIndex;
+}
+
+uint8_t serialRead(serialPort_t *)
+{
+    return serialInput[serialInputIndex++];
+}
+
+void serialWriteBufShim(void *, const uint8_t *data, int count)
+{
+    serialOutput.append((const char *)data, count);
+    serialWriteCount++;
+}
+
+
+float motor_disarmed[MAX_SUPPORTED_MOTORS];
+
+uint16_t batteryWarningVoltage;
+uint8_t useHottAlarmSoundPeriod (void) { return 0; }
+const uint32_t baudRates[] = {0, 9600, 19200, 38400, 57600, 115200, 230400, 250000, 400000}; // see baudRate_e
+
+uint32_t micros(void) {return 0;}
+
+int32_t getAmperage(void) {
+    return 100;
+}
+
+uint16_t getBatteryVoltage(void) {
+    return 42;
+}
+
+batteryState_e getBatteryState(void) {
+    return BATTERY_OK;
+}
+
+uint8_t calculateBatteryPercentageRemaining(void) {
+    return 67;
+}
+
+uint8_t getMotorCount() {
+    return 4;
+}
+
+size_t getEEPROMStorageSize() {
+    return 0;
+}
+
+
+void setPrintfSerialPort(struct serialPort_s) {}
+
+static const box_t boxes[] = { { 0, "DUMMYBOX", 0 } };
+const box_t *findBoxByPermanentId(uint8_t) { return &boxes[0]; }
+const box_t *findBoxByBoxId(boxId_e) { return &boxes[0]; }
+
+uint32_t getBeeperOffMask(void) { return 0; }
+uint32_t getPreferredBeeperOffMask(void) { return 0; }
+
+void beeper(beeperMode_e) {}
+void beeperSilence(void) {}
+void beeperConfirmationBeeps(uint8_t) {}
+void beeperWarningBeeps(uint8_t) {}
+void beeperUpdate(timeUs_t) {}
+uint32_t getArmingBeepTimeMicros(void) {return 0;}
+beeperMode_e beeperModeForTableIndex(int) {return BEEPER_SILENCE;}
+uint32_t beeperModeMaskForTableIndex(int idx) {UNUSED(idx); return 0;}
+const char *beeperNameForTableIndex(int) {return NULL;}
+int beeperTableEntryCount(void) {return 0;}
+bool isBeeperOn(void) {return false;}
+void beeperOffSetAll(uint8_t) {}
+void setBeeperOffMask(uint32_t) {}
+void setPreferredBeeperOffMask(uint32_t) {}
+
+void beeperOffSet(uint32_t) {}
+void beeperOffClear(uint32_t) {}
+void beeperOffClearAll(void) {}
+bool parseColor(int, const char *) {return false; }
+bool resetEEPROM(bool) { return true; }
+void mixerResetDisarmedMotors(void) {}
+void gpsEnablePassthrough(struct serialPort_s *) {}
+bool parseLedStripConfig(int, const char *){return false; }
+const char rcChannelLetters[] = "AERT12345678abcdefgh";
+
+void parseRcChannels(const char *, rxConfig_t *){}
+void mixerLoadMix(int, motorMixer_t *) {}
+bool setModeColor(ledModeIndex_e, int, int) { return false; }
+float motorConvertFromExternal(uint16_t) { return 1.0; }
+void motorShutdown(void) { }
+uint8_t getCurrentPidProfileIndex(void){ return 1; }
+uint8_t getCurrentControlRateProfileIndex(void){ return 1; }
+void changeControlRateProfile(uint8_t) {}
+void resetAllRxChannelRangeConfigurations(rxChannelRangeConfig_t *) {}
+void writeEEPROM() {}
+serialPortConfig_t *serialFindPortConfigurationMutable(serialPortIdentifier_e) {return NULL; }
+baudRate_e lookupBaudRateIndex(uint32_t){return BAUD_9600; }
+serialPortUsage_t *findSerialPortUsageByIdentifier(serialPortIdentifier_e){ return NULL; }
+serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) { return NULL; }
+void serialSetBaudRate(serialPort_t *, uint32_t) {}
+void serialSetMode(serialPort_t *, portMode_e) {}
+void serialPassthrough(serialPort_t *, serialPort_t *, serialConsumer *, serialConsumer *) {}
+uint32_t millis(void) { return 0; }
+uint8_t getBatteryCellCount(void) { return 1; }
+void servoMixerLoadMix(int) {}
+const char * getBatteryStateString(void){ return "_getBatteryStateString_"; }
+
+uint32_t stackTotalSize(void) { return 0x4000; }
+uint32_t stackHighMem(void) { return 0x80000000; }
+uint16_t getEEPROMConfigSize(void) { return 1024; }
+
+uint8_t __config_start = 0x00;
+uint8_t __config_end = 0x10;
+uint16_t averageSystemLoadPercent = 0;
+
+timeDelta_t getTaskDeltaTimeUs(taskId_e){ return 0; }
+uint16_t currentRxRefreshRate = 9000;
+armingDisableFlags_e getArmingDisableFlags(void) { return ARMING_DISABLED_NO_GYRO; }
+
+const char *armingDisableFlagNames[]= {
+"DUMMYDISABLEFLAGNAME"
+};
+
+void getTaskInfo(taskId_e, taskInfo_t *) {}
+void getCheckFuncInfo(cfCheckFuncInfo_t *) {}
+void schedulerResetTaskMaxExecutionTime(taskId_e) {}
+void schedulerResetCheckFunctionMaxExecutionTime(void) {}
+void getTaskHistograms(taskId_e, taskHistogram_t *, taskHistogram_t *) {}
+uint32_t taskHistogramPercentileUs(const taskHistogram_t *, unsigned) { return 0; }
+uint32_t taskHistogramTotalCount(const taskHistogram_t *) { return 0; }
+uint32_t taskHistogramBucketLowerBoundUs(unsigned) { return 0; }
+void getGyroLateStartInfo(gyroLateStartInfo_t *) {}
+void osdGetDrawSliceInfo(osdDrawSliceInfo_t *) {}
+
+const char * const targetName = "UNITTEST";
+const char* const buildDate = "Jan 01 2017";
+const char * const buildTime = "00:00:00";
+const char * const shortGitRevision = "MASTER";
+
+
+void schedulerSetCalulateTaskStatistics(bool) {}
+void setArmingDisabled(armingDisableFlags_e) {}
+
+void waitForSerialPortToFinishTransmitting(serialPort_t *) {}
+void systemResetToBootloader(void) {}
+void resetConfig(void) { pgResetAll(); }
+void systemReset(void) {}
+void writeUnmodifiedConfigToEEPROM(void) {}
+
+void changePidProfile(uint8_t) {}
+bool serialIsPortAvailable(serialPortIdentifier_e) { return false; }
+void generateLedConfig(ledConfig_t *, char *, size_t) {}
+bool isSerialTransmitBufferEmpty(const serialPort_t *) {return true; }
+void serialWrite(serialPort_t *, uint8_t) {}
+
+void serialSetCtrlLineStateCb(serialPort_t *, void (*)(void *, uint16_t ), void *) {}
+void serialSetCtrlLineStateDtrPin(serialPort_t *, ioTag_t ) {}
+void serialSetCtrlLineState(serialPort_t *, uint16_t ) {}
+
+void serialSetBaudRateCb(serialPort_t *, void (*)(serialPort_t *context, uint32_t baud), serialPort_t *) {}
+
+char *getBoardName(void) { return NULL; }
+char *getManufacturerId(void) { return NULL; }
+bool boardInformationIsSet(void) { return true; }
+
+bool setBoardName(char *newBoardName) { UNUSED(newBoardName); return true; };
+bool setManufacturerId(char *newManufacturerId) { UNUSED(newManufacturerId); return true; };
+bool persistBoardInformation(void) { return true; };
+
+void activeAdjustmentRangeReset(void) {}
+void analyzeModeActivationConditions(void) {}
+bool isModeActivationConditionConfigured(const modeActivationCondition_t *, const modeActivationCondition_t *) { return false; }
+
+void delay(uint32_t) {}
+displayPort_t *osdGetDisplayPort(osdDisplayPortDevice_e *) { return NULL; }
+mcuTypeId_e getMcuTypeId(void) { return MCU_TYPE_UNKNOWN; }
+uint16_t getCurrentRxRefreshRate(void) { return 0; }
+uint16_t getAverageSystemLoadPercent(void) { return 0; }
+}
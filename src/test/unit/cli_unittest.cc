@@ -28,6 +28,7 @@ extern "C" {
     #include "build/version.h"
     #include "cli/cli.h"
     #include "cli/settings.h"
+    #include "cli/settings_index.h"
     #include "common/printf.h"
     #include "config/feature.h"
     #include "drivers/buf_writer.h"
@@ -64,6 +65,8 @@ extern "C" {
         { "wos_unit_test",     VAR_UINT8 | MODE_STRING | MASTER_VALUE, .config.string = { 0, 16, STRING_FLAGS_WRITEONCE }, PG_RESERVED_FOR_TESTING_1, 0 },
     };
     const uint16_t valueTableEntryCount = ARRAYLEN(valueTable);
+    uint16_t settingIndex[SETTING_INDEX_SIZE(ARRAYLEN(valueTable))];
+    const uint16_t settingIndexSize = ARRAYLEN(settingIndex);
     const lookupTableEntry_t lookupTables[] = {};
     const char * const lookupTableOsdDisplayPortDevice[] = {};
 
@@ -312,6 +315,12 @@ void getTaskInfo(taskId_e, taskInfo_t *) {}
 void getCheckFuncInfo(cfCheckFuncInfo_t *) {}
 void schedulerResetTaskMaxExecutionTime(taskId_e) {}
 void schedulerResetCheckFunctionMaxExecutionTime(void) {}
+void getTaskHistograms(taskId_e, taskHistogram_t *, taskHistogram_t *) {}
+uint32_t taskHistogramPercentileUs(const taskHistogram_t *, unsigned) { return 0; }
+uint32_t taskHistogramTotalCount(const taskHistogram_t *) { return 0; }
+uint32_t taskHistogramBucketLowerBoundUs(unsigned) { return 0; }
+void getGyroLateStartInfo(gyroLateStartInfo_t *) {}
+void osdGetDrawSliceInfo(osdDrawSliceInfo_t *) {}
 
 const char * const targetName = "UNITTEST";
 const char* const buildDate = "Jan 01 2017";
@@ -21,6 +21,13 @@
 #include <limits.h>
 
 #include <math.h>
+#include <string.h>
+
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 extern "C" {
     #include "common/filter.h"
@@ -114,3 +121,185 @@ TEST(FilterUnittest, TestSlewFilter)
     slewFilterApply(&filter, 200.0f);
     EXPECT_EQ(200, filter.state);
 }
+
+#define GYRO_LOOPTIME_US 125
+
+// deterministic gyro-like test signal: a few tones plus noise
+static float testSignal(int sample, int axis)
+{
+    static uint32_t seed = 12345;
+    seed = seed * 1664525 + 1013904223;
+    const float noise = (float)(seed >> 8) / (1 << 24) - 0.5f;
+    const float t = sample * GYRO_LOOPTIME_US * 1e-6f;
+    return 300.0f * sinf(2 * M_PI * (3 + axis) * t) + 40.0f * sinf(2 * M_PI * 210 * t) + 25.0f * sinf(2 * M_PI * 330 * t) + 10.0f * noise;
+}
+
+TEST(FilterUnittest, TestFilterBankMatchesBiquadFilterApply)
+{
+    // notch 1, notch 2, lowpass, as configured by the gyro
+    const float notch1Q = filterGetNotchQ(260, 160);
+    const float notch2Q = filterGetNotchQ(330, 250);
+
+    biquadFilter_t notch1[3], notch2[3], lowpass[3];
+    for (int axis = 0; axis < 3; axis++) {
+        biquadFilterInit(&notch1[axis], 260, GYRO_LOOPTIME_US, notch1Q, FILTER_NOTCH);
+        biquadFilterInit(&notch2[axis], 330, GYRO_LOOPTIME_US, notch2Q, FILTER_NOTCH);
+        biquadFilterInitLPF(&lowpass[axis], 200, GYRO_LOOPTIME_US);
+    }
+
+    filterBank_t bank;
+    filterBankInit(&bank);
+    EXPECT_EQ(0, filterBankAddBiquad(&bank, FILTER_BANK_BIQUAD, 260, GYRO_LOOPTIME_US, notch1Q, FILTER_NOTCH));
+    EXPECT_EQ(1, filterBankAddBiquad(&bank, FILTER_BANK_BIQUAD, 330, GYRO_LOOPTIME_US, notch2Q, FILTER_NOTCH));
+    EXPECT_EQ(2, filterBankAddBiquad(&bank, FILTER_BANK_BIQUAD, 200, GYRO_LOOPTIME_US, BIQUAD_Q, FILTER_LPF));
+
+    for (int i = 0; i < 10000; i++) {
+        float values[FILTER_BANK_LANES] = { 0 };
+        float expected[3];
+        for (int axis = 0; axis < 3; axis++) {
+            values[axis] = testSignal(i, axis);
+            expected[axis] = biquadFilterApply(&notch1[axis], values[axis]);
+            expected[axis] = biquadFilterApply(&notch2[axis], expected[axis]);
+            expected[axis] = biquadFilterApply(&lowpass[axis], expected[axis]);
+        }
+        filterBankApply(&bank, values);
+        for (int axis = 0; axis < 3; axis++) {
+            // bit exact, not just close
+            ASSERT_EQ(0, memcmp(&expected[axis], &values[axis], sizeof(float))) << "sample " << i << " axis " << axis;
+        }
+    }
+}
+
+TEST(FilterUnittest, TestFilterBankMatchesDF1AndPt1)
+{
+    biquadFilter_t notch[3];
+    pt1Filter_t pt1[3];
+    const float notchQ = filterGetNotchQ(350, 300);
+    const float k = pt1FilterGain(150, GYRO_LOOPTIME_US * 1e-6f);
+    for (int axis = 0; axis < 3; axis++) {
+        pt1FilterInit(&pt1[axis], k);
+        biquadFilterInit(&notch[axis], 350, GYRO_LOOPTIME_US, notchQ, FILTER_NOTCH);
+    }
+
+    filterBank_t bank;
+    filterBankInit(&bank);
+    EXPECT_EQ(0, filterBankAddPt1(&bank, k));
+    EXPECT_EQ(1, filterBankAddBiquad(&bank, FILTER_BANK_BIQUAD_DF1, 350, GYRO_LOOPTIME_US, notchQ, FILTER_NOTCH));
+
+    for (int i = 0; i < 10000; i++) {
+        if (i % 100 == 0) {
+            // retune per axis as the dynamic notch and dynamic lowpass do
+            const int axis = (i / 100) % 3;
+            const float centerFreq = 200 + (i / 100) % 17 * 15;
+            biquadFilterUpdate(&notch[axis], centerFreq, GYRO_LOOPTIME_US, notchQ, FILTER_NOTCH);
+            filterBankUpdateBiquad(&bank, 1, axis, centerFreq, GYRO_LOOPTIME_US, notchQ, FILTER_NOTCH);
+
+            const float newK = pt1FilterGain(100 + (i / 100) % 7 * 20, GYRO_LOOPTIME_US * 1e-6f);
+            for (int n = 0; n < 3; n++) {
+                pt1FilterUpdateCutoff(&pt1[n], newK);
+            }
+            filterBankUpdatePt1(&bank, 0, newK);
+        }
+
+        float values[FILTER_BANK_LANES] = { 0 };
+        float expected[3];
+        for (int axis = 0; axis < 3; axis++) {
+            values[axis] = testSignal(i, axis);
+            expected[axis] = pt1FilterApply(&pt1[axis], values[axis]);
+            expected[axis] = biquadFilterApplyDF1(&notch[axis], expected[axis]);
+        }
+        filterBankApply(&bank, values);
+        for (int axis = 0; axis < 3; axis++) {
+            ASSERT_EQ(0, memcmp(&expected[axis], &values[axis], sizeof(float))) << "sample " << i << " axis " << axis;
+        }
+    }
+}
+
+TEST(FilterUnittest, TestFilterBankFull)
+{
+    filterBank_t bank;
+    filterBankInit(&bank);
+    for (int i = 0; i < FILTER_BANK_MAX_STAGES; i++) {
+        EXPECT_EQ(i, filterBankAddPt1(&bank, 0.5f));
+    }
+    EXPECT_EQ(-1, filterBankAddPt1(&bank, 0.5f));
+    EXPECT_EQ(-1, filterBankAddBiquad(&bank, FILTER_BANK_BIQUAD, 100, GYRO_LOOPTIME_US, BIQUAD_Q, FILTER_LPF));
+    EXPECT_EQ(FILTER_BANK_MAX_STAGES, bank.stageCount);
+}
+
+static uint64_t benchmarkTicks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+TEST(FilterUnittest, TestFilterBankBenchmark)
+{
+    // full gyro chain: notch 1, notch 2, lowpass (DF2) then dynamic notch 1 and 2 (DF1)
+    enum { SAMPLES = 200000 };
+    static float input[SAMPLES][3];
+    for (int i = 0; i < SAMPLES; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            input[i][axis] = testSignal(i, axis);
+        }
+    }
+
+    // current path: one filterApplyFnPtr call per filter per axis
+    filterApplyFnPtr staticApplyFn = (filterApplyFnPtr)biquadFilterApply;
+    filterApplyFnPtr dynApplyFn = (filterApplyFnPtr)biquadFilterApplyDF1;
+    biquadFilter_t notch1[3], notch2[3], lowpass[3], dyn1[3], dyn2[3];
+    filterBank_t staticBank, dynBank;
+    filterBankInit(&staticBank);
+    filterBankInit(&dynBank);
+    for (int axis = 0; axis < 3; axis++) {
+        biquadFilterInit(&notch1[axis], 260, GYRO_LOOPTIME_US, 1.5f, FILTER_NOTCH);
+        biquadFilterInit(&notch2[axis], 330, GYRO_LOOPTIME_US, 2.0f, FILTER_NOTCH);
+        biquadFilterInitLPF(&lowpass[axis], 200, GYRO_LOOPTIME_US);
+        biquadFilterInit(&dyn1[axis], 210, GYRO_LOOPTIME_US, 3.5f, FILTER_NOTCH);
+        biquadFilterInit(&dyn2[axis], 240, GYRO_LOOPTIME_US, 3.5f, FILTER_NOTCH);
+    }
+    filterBankAddBiquad(&staticBank, FILTER_BANK_BIQUAD, 260, GYRO_LOOPTIME_US, 1.5f, FILTER_NOTCH);
+    filterBankAddBiquad(&staticBank, FILTER_BANK_BIQUAD, 330, GYRO_LOOPTIME_US, 2.0f, FILTER_NOTCH);
+    filterBankAddBiquad(&staticBank, FILTER_BANK_BIQUAD, 200, GYRO_LOOPTIME_US, BIQUAD_Q, FILTER_LPF);
+    filterBankAddBiquad(&dynBank, FILTER_BANK_BIQUAD_DF1, 210, GYRO_LOOPTIME_US, 3.5f, FILTER_NOTCH);
+    filterBankAddBiquad(&dynBank, FILTER_BANK_BIQUAD_DF1, 240, GYRO_LOOPTIME_US, 3.5f, FILTER_NOTCH);
+
+    float checksumScalar = 0;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t ticks = benchmarkTicks();
+    for (int i = 0; i < SAMPLES; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            float value = input[i][axis];
+            value = staticApplyFn((filter_t *)&notch1[axis], value);
+            value = staticApplyFn((filter_t *)&notch2[axis], value);
+            value = staticApplyFn((filter_t *)&lowpass[axis], value);
+            value = dynApplyFn((filter_t *)&dyn1[axis], value);
+            value = dynApplyFn((filter_t *)&dyn2[axis], value);
+            checksumScalar += value;
+        }
+    }
+    const uint64_t scalarTicks = benchmarkTicks() - ticks;
+    const double scalarNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    float checksumBank = 0;
+    start = std::chrono::steady_clock::now();
+    ticks = benchmarkTicks();
+    for (int i = 0; i < SAMPLES; i++) {
+        float values[FILTER_BANK_LANES] = { input[i][0], input[i][1], input[i][2] };
+        filterBankApply(&staticBank, values);
+        filterBankApply(&dynBank, values);
+        for (int axis = 0; axis < 3; axis++) {
+            checksumBank += values[axis];
+        }
+    }
+    const uint64_t bankTicks = benchmarkTicks() - ticks;
+    const double bankNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("gyro filter chain per gyro sample (3 axes, 5 stages): per-axis function pointers %.1f ns %.0f cycles, filter bank %.1f ns %.0f cycles\n",
+        scalarNs / SAMPLES, (double)scalarTicks / SAMPLES, bankNs / SAMPLES, (double)bankTicks / SAMPLES);
+
+    EXPECT_FLOAT_EQ(checksumScalar, checksumBank);
+}
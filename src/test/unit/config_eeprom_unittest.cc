@@ -0,0 +1,512 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/crc.h"
+    #include "common/utils.h"
+
+    #include "config/config_eeprom.h"
+    #include "config/config_streamer.h"
+
+    #include "drivers/system.h"
+
+    #include "pg/pg.h"
+
+    typedef struct testConfig_s {
+        uint32_t value;
+        uint8_t data[12];
+    } testConfig_t;
+
+    // enough groups for the cost of finding records to show up
+    #define PG_TEST_BASE 1000
+    #define TEST_PG(h, t, d) PG_REGISTER(testConfig_t, testConfig_ ## h ## t ## d, (PG_TEST_BASE + h * 100 + t * 10 + d), 0);
+    #define TEST_PG_10(h, t) \
+        TEST_PG(h, t, 0) TEST_PG(h, t, 1) TEST_PG(h, t, 2) TEST_PG(h, t, 3) TEST_PG(h, t, 4) \
+        TEST_PG(h, t, 5) TEST_PG(h, t, 6) TEST_PG(h, t, 7) TEST_PG(h, t, 8) TEST_PG(h, t, 9)
+    #define TEST_PG_100(h) \
+        TEST_PG_10(h, 0) TEST_PG_10(h, 1) TEST_PG_10(h, 2) TEST_PG_10(h, 3) TEST_PG_10(h, 4) \
+        TEST_PG_10(h, 5) TEST_PG_10(h, 6) TEST_PG_10(h, 7) TEST_PG_10(h, 8) TEST_PG_10(h, 9)
+
+    TEST_PG_100(0)
+    TEST_PG_100(1)
+
+    uint16_t getEEPROMCopyOffset(void);
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_PG_COUNT 200
+
+// same layout as the records written by writeSettingsToEEPROM()
+typedef struct {
+    uint16_t size;
+    uint16_t pgn;
+    uint8_t version;
+    uint8_t flags;
+} __attribute__((packed)) testRecordHeader_t;
+
+static uint32_t testValue(const pgRegistry_t *reg)
+{
+    return 0x5a000000 | pgN(reg);
+}
+
+static void setTestValues(void)
+{
+    PG_FOREACH(reg) {
+        memset(reg->address, pgN(reg) & 0xff, pgSize(reg));
+        ((testConfig_t *)reg->address)->value = testValue(reg);
+    }
+}
+
+static void clearTestValues(void)
+{
+    PG_FOREACH(reg) {
+        memset(reg->address, 0xee, pgSize(reg));
+    }
+}
+
+static int countLoadedGroups(void)
+{
+    int loaded = 0;
+    PG_FOREACH(reg) {
+        if (((testConfig_t *)reg->address)->value == testValue(reg)) {
+            loaded++;
+        }
+    }
+    return loaded;
+}
+
+// Write a config image by hand, with the records in the order given, leaving out the group skip
+static void buildImage(const int *order, int count, int skip)
+{
+    uint8_t *p = eepromData;
+    memset(eepromData, 0, sizeof(eepromData));
+
+    *p++ = EEPROM_CONF_VERSION;
+    *p++ = 0xBE;
+
+    for (int i = 0; i < count; i++) {
+        if (order[i] == skip) {
+            continue;
+        }
+        const pgRegistry_t *reg = &__pg_registry_start[order[i]];
+        const testRecordHeader_t header = {
+            .size = (uint16_t)(sizeof(header) + pgSize(reg)),
+            .pgn = pgN(reg),
+            .version = pgVersion(reg),
+            .flags = 0,
+        };
+        memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        memcpy(p, reg->address, pgSize(reg));
+        p += pgSize(reg);
+    }
+
+    // footer
+    *p++ = 0;
+    *p++ = 0;
+
+    const uint16_t crc = crc16_ccitt_update(0xFFFF, eepromData, p - eepromData);
+    const uint16_t invertedBigEndianCrc = ~(((crc & 0xFF) << 8) | (crc >> 8));
+    memcpy(p, &invertedBigEndianCrc, sizeof(invertedBigEndianCrc));
+}
+
+static void shuffledOrder(int *order, int count)
+{
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    uint32_t seed = 12345;
+    for (int i = count - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        const int j = (seed >> 8) % (i + 1);
+        const int swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+}
+
+// What loadEEPROM() used to do, walk the records from the start for every group
+static const uint8_t *findRecordByScan(const pgRegistry_t *reg)
+{
+    const uint8_t *p = eepromData + 2;
+    for (;;) {
+        testRecordHeader_t header;
+        memcpy(&header, p, sizeof(header));
+        if (header.size == 0) {
+            return NULL;
+        }
+        if (header.pgn == pgN(reg)) {
+            return p;
+        }
+        p += header.size;
+    }
+}
+
+static uint64_t testNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+TEST(ConfigEepromTest, WriteAndLoad)
+{
+    ASSERT_EQ(TEST_PG_COUNT, PG_REGISTRY_SIZE);
+
+    setTestValues();
+    writeConfigToEEPROM();
+    EXPECT_TRUE(isEEPROMVersionValid());
+    EXPECT_TRUE(isEEPROMStructureValid());
+
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(TEST_PG_COUNT, countLoadedGroups());
+
+    // the remaining bytes of each group too
+    EXPECT_EQ(PG_TEST_BASE & 0xff, testConfig_000_System.data[0]);
+    EXPECT_EQ((PG_TEST_BASE + 199) & 0xff, testConfig_199_System.data[11]);
+}
+
+TEST(ConfigEepromTest, LoadWithoutValidating)
+{
+    // loadEEPROM() must not use an index from before the last write
+    setTestValues();
+    writeConfigToEEPROM();
+    testConfig_042_System.value = 0;
+    writeConfigToEEPROM();
+
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(TEST_PG_COUNT - 1, countLoadedGroups());
+    EXPECT_EQ(0U, testConfig_042_System.value);
+}
+
+TEST(ConfigEepromTest, RecordsInAnyOrder)
+{
+    int order[TEST_PG_COUNT];
+    shuffledOrder(order, TEST_PG_COUNT);
+
+    setTestValues();
+    buildImage(order, TEST_PG_COUNT, -1);
+    EXPECT_TRUE(isEEPROMStructureValid());
+
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(TEST_PG_COUNT, countLoadedGroups());
+}
+
+TEST(ConfigEepromTest, MissingRecordIsReset)
+{
+    int order[TEST_PG_COUNT];
+    shuffledOrder(order, TEST_PG_COUNT);
+
+    setTestValues();
+    buildImage(order, TEST_PG_COUNT, 17);
+    EXPECT_TRUE(isEEPROMStructureValid());
+
+    clearTestValues();
+    EXPECT_FALSE(loadEEPROM());
+    EXPECT_EQ(TEST_PG_COUNT - 1, countLoadedGroups());
+    // no reset template or function, so reset to zero
+    EXPECT_EQ(0U, ((testConfig_t *)__pg_registry_start[17].address)->value);
+}
+
+TEST(ConfigEepromTest, CorruptImageIsInvalid)
+{
+    setTestValues();
+    writeConfigToEEPROM();
+    EXPECT_TRUE(isEEPROMStructureValid());
+    const uint16_t offset = getEEPROMCopyOffset();
+
+    eepromData[offset + 100] ^= 0x01;
+    EXPECT_FALSE(isEEPROMStructureValid());
+    eepromData[offset + 100] ^= 0x01;
+
+    // a record running past the end of the storage
+    const uint16_t size = sizeof(eepromData);
+    memcpy(&eepromData[offset + 2], &size, sizeof(size));
+    EXPECT_FALSE(isEEPROMStructureValid());
+}
+
+static testConfig_t *testConfig(int index)
+{
+    return (testConfig_t *)__pg_registry_start[index].address;
+}
+
+static uint16_t journalBlockSize(int records)
+{
+    const int size = 4 + records * (sizeof(testRecordHeader_t) + sizeof(testConfig_t)) + 2;
+    return (size + CONFIG_STREAMER_BUFFER_SIZE - 1) & ~(CONFIG_STREAMER_BUFFER_SIZE - 1);
+}
+
+TEST(ConfigEepromTest, SaveAppendsChangedGroups)
+{
+    setTestValues();
+    writeConfigToEEPROM();
+
+    static uint8_t saved[EEPROM_SIZE];
+    const uint16_t offset = getEEPROMCopyOffset();
+    const uint16_t size = getEEPROMConfigSize();
+    memcpy(saved, &eepromData[offset], size);
+
+    testConfig_123_System.value = 7;
+    testConfig_124_System.data[3] = 0;
+    writeConfigToEEPROM();
+
+    // nothing written over, one block with two records added
+    EXPECT_EQ(offset, getEEPROMCopyOffset());
+    EXPECT_EQ(0, memcmp(saved, &eepromData[offset], size));
+    EXPECT_EQ(size + journalBlockSize(2), getEEPROMConfigSize());
+
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(TEST_PG_COUNT - 1, countLoadedGroups());
+    EXPECT_EQ(7U, testConfig_123_System.value);
+    EXPECT_EQ(0, testConfig_124_System.data[3]);
+    EXPECT_EQ((PG_TEST_BASE + 124) & 0xff, testConfig_124_System.data[2]);
+}
+
+TEST(ConfigEepromTest, UnchangedSaveWritesNothing)
+{
+    setTestValues();
+    writeConfigToEEPROM();
+
+    static uint8_t saved[EEPROM_SIZE];
+    memcpy(saved, eepromData, sizeof(saved));
+    const uint16_t size = getEEPROMConfigSize();
+
+    writeConfigToEEPROM();
+
+    EXPECT_EQ(0, memcmp(saved, eepromData, sizeof(saved)));
+    EXPECT_EQ(size, getEEPROMConfigSize());
+}
+
+TEST(ConfigEepromTest, FullJournalIsCompacted)
+{
+    setTestValues();
+    writeConfigToEEPROM();
+
+    int compactions = 0;
+    uint16_t size = getEEPROMConfigSize();
+    uint16_t offset = getEEPROMCopyOffset();
+    for (int i = 0; i < 1000; i++) {
+        testConfig(i % TEST_PG_COUNT)->value = i;
+        writeConfigToEEPROM();
+
+        if (getEEPROMConfigSize() < size) {
+            // the new copy goes in the other half
+            compactions++;
+            EXPECT_NE(offset, getEEPROMCopyOffset());
+            offset = getEEPROMCopyOffset();
+        } else {
+            EXPECT_EQ(size + journalBlockSize(1), getEEPROMConfigSize());
+        }
+        size = getEEPROMConfigSize();
+
+        testConfig(i % TEST_PG_COUNT)->value = 0;
+        EXPECT_TRUE(loadEEPROM());
+        EXPECT_EQ((uint32_t)i, testConfig(i % TEST_PG_COUNT)->value);
+    }
+
+    // each half has room for the copy and about 130 blocks
+    EXPECT_EQ(7, compactions);
+
+    // the last change of each group
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    for (int i = 0; i < TEST_PG_COUNT; i++) {
+        EXPECT_EQ((uint32_t)(800 + i), testConfig(i)->value);
+    }
+}
+
+TEST(ConfigEepromTest, InterruptedSaveIsIgnored)
+{
+    setTestValues();
+    writeConfigToEEPROM();
+
+    testConfig_010_System.value = 1;
+    writeConfigToEEPROM();
+    const uint16_t size = getEEPROMConfigSize();
+
+    testConfig_020_System.value = 2;
+    writeConfigToEEPROM();
+
+    // power lost half way through writing the second block
+    const uint16_t offset = getEEPROMCopyOffset();
+    const uint16_t blockSize = getEEPROMConfigSize() - size;
+    memset(&eepromData[offset + size + blockSize / 2], 0, blockSize - blockSize / 2);
+
+    EXPECT_TRUE(isEEPROMStructureValid());
+    EXPECT_EQ(size, getEEPROMConfigSize());
+
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(1U, testConfig_010_System.value);
+    EXPECT_EQ(testValue(&__pg_registry_start[20]), testConfig_020_System.value);
+
+    // the next save goes where the lost block was
+    testConfig_020_System.value = 3;
+    writeConfigToEEPROM();
+    EXPECT_EQ(size + blockSize, getEEPROMConfigSize());
+
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(1U, testConfig_010_System.value);
+    EXPECT_EQ(3U, testConfig_020_System.value);
+}
+
+TEST(ConfigEepromTest, InterruptedCompactionIsIgnored)
+{
+    setTestValues();
+    writeConfigToEEPROM();
+    const uint16_t offset = getEEPROMCopyOffset();
+
+    // save until the journal is full and the next save writes a new copy
+    static uint8_t before[EEPROM_SIZE];
+    uint32_t value = 0;
+    do {
+        memcpy(before, eepromData, sizeof(before));
+        testConfig_030_System.value = ++value;
+        writeConfigToEEPROM();
+    } while (getEEPROMCopyOffset() == offset);
+
+    static uint8_t after[EEPROM_SIZE];
+    memcpy(after, eepromData, sizeof(after));
+    const uint16_t newOffset = getEEPROMCopyOffset();
+    const uint16_t newSize = getEEPROMConfigSize();
+    EXPECT_NE(offset, newOffset);
+
+    // power lost half way through writing the new copy
+    memcpy(eepromData, before, sizeof(eepromData));
+    memcpy(&eepromData[newOffset], &after[newOffset], newSize / 2);
+
+    EXPECT_TRUE(isEEPROMStructureValid());
+    EXPECT_TRUE(isEEPROMVersionValid());
+    EXPECT_EQ(offset, getEEPROMCopyOffset());
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(value - 1, testConfig_030_System.value);
+    EXPECT_EQ(TEST_PG_COUNT - 1, countLoadedGroups());
+
+    // power lost after writing the new copy, before the old one was made invalid
+    memcpy(&eepromData[newOffset], &after[newOffset], newSize);
+
+    EXPECT_TRUE(isEEPROMStructureValid());
+    EXPECT_EQ(newOffset, getEEPROMCopyOffset());
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(value, testConfig_030_System.value);
+
+    // the next save appends to the new copy
+    testConfig_030_System.value = 0;
+    writeConfigToEEPROM();
+    EXPECT_EQ(newOffset, getEEPROMCopyOffset());
+    EXPECT_EQ(newSize + journalBlockSize(1), getEEPROMConfigSize());
+
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(0U, testConfig_030_System.value);
+}
+
+TEST(ConfigEepromTest, JournalOfReplacedCopyIsIgnored)
+{
+    setTestValues();
+    writeConfigToEEPROM();
+    const uint16_t size = getEEPROMConfigSize();
+
+    testConfig_050_System.value = 5;
+    writeConfigToEEPROM();
+    uint8_t block[64];
+    const uint16_t blockSize = getEEPROMConfigSize() - size;
+    ASSERT_LE(blockSize, sizeof(block));
+    memcpy(block, &eepromData[getEEPROMCopyOffset() + size], blockSize);
+
+    // anything that isn't valid gets rewritten as a whole
+    eepromData[getEEPROMCopyOffset()] = 0;
+    testConfig_050_System.value = 9;
+    writeConfigToEEPROM();
+
+    // storage that isn't erased by a rewrite can still hold the old block after the new copy
+    const uint16_t journalStart = getEEPROMCopyOffset() + ((getEEPROMConfigSize() + CONFIG_STREAMER_BUFFER_SIZE - 1) & ~(CONFIG_STREAMER_BUFFER_SIZE - 1));
+    memcpy(&eepromData[journalStart], block, blockSize);
+
+    EXPECT_TRUE(isEEPROMStructureValid());
+    clearTestValues();
+    EXPECT_TRUE(loadEEPROM());
+    EXPECT_EQ(9U, testConfig_050_System.value);
+}
+
+TEST(ConfigEepromTest, LoadTime)
+{
+    int order[TEST_PG_COUNT];
+    shuffledOrder(order, TEST_PG_COUNT);
+
+    setTestValues();
+    buildImage(order, TEST_PG_COUNT, -1);
+
+    const int repeats = 200;
+
+    uint64_t start = testNanos();
+    for (int i = 0; i < repeats; i++) {
+        isEEPROMStructureValid();
+        loadEEPROM();
+    }
+    const uint64_t indexedNs = (testNanos() - start) / repeats;
+
+    start = testNanos();
+    int found = 0;
+    for (int i = 0; i < repeats; i++) {
+        isEEPROMStructureValid();
+        PG_FOREACH(reg) {
+            found += findRecordByScan(reg) != NULL;
+        }
+    }
+    const uint64_t scanNs = (testNanos() - start) / repeats;
+
+    EXPECT_EQ(TEST_PG_COUNT * repeats, found);
+    EXPECT_EQ(TEST_PG_COUNT, countLoadedGroups());
+
+    printf("validate and load %d records: %llu ns indexed, %llu ns finding each record by scanning\n",
+        TEST_PG_COUNT, (unsigned long long)indexedNs, (unsigned long long)scanNs);
+
+    EXPECT_LT(indexedNs, scanNs);
+}
+
+// STUBS
+
+extern "C" {
+
+void failureMode(failureMode_e mode)
+{
+    UNUSED(mode);
+    FAIL();
+}
+
+}
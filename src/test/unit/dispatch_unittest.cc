@@ -0,0 +1,291 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/utils.h"
+
+    #include "drivers/time.h"
+
+    #include "fc/dispatch.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_PROCESS_PERIOD_US  1000    // TASK_DISPATCH runs at 1kHz
+#define TEST_TICK_US            256
+#define TEST_ENTRY_COUNT        64
+
+static uint32_t simulationTime;
+
+static int dispatchOrder[TEST_ENTRY_COUNT * 4];
+static int dispatchOrderCount;
+static uint32_t dispatchTime[TEST_ENTRY_COUNT];
+
+static dispatchEntry_t entries[TEST_ENTRY_COUNT];
+
+static void recordDispatch(dispatchEntry_t *self)
+{
+    const int index = self - entries;
+    dispatchOrder[dispatchOrderCount++] = index;
+    dispatchTime[index] = simulationTime;
+}
+
+static void runUntil(uint32_t endTime)
+{
+    while (cmp32(endTime, simulationTime) > 0) {
+        simulationTime += TEST_PROCESS_PERIOD_US;
+        dispatchProcess(simulationTime);
+    }
+}
+
+class DispatchTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        for (int i = 0; i < TEST_ENTRY_COUNT; i++) {
+            dispatchCancel(&entries[i]);
+        }
+        memset(entries, 0, sizeof(entries));
+        for (int i = 0; i < TEST_ENTRY_COUNT; i++) {
+            entries[i].dispatch = recordDispatch;
+        }
+        memset(dispatchTime, 0, sizeof(dispatchTime));
+        dispatchOrderCount = 0;
+        simulationTime = 5000000;
+        dispatchProcess(simulationTime);
+    }
+};
+
+TEST_F(DispatchTest, TestDispatchedInOrderAndNeverEarly)
+{
+    // delays spread across every level of the wheel
+    static const int delays[] = { 0, 1, 255, 256, 300, 999, 1000, 5000, 16383, 16384, 20000,
+        100000, 1048575, 1048576, 2000000, 30000000, 70000000, 500000000 };
+    const uint32_t startTime = simulationTime;
+
+    for (unsigned i = 0; i < ARRAYLEN(delays); i++) {
+        dispatchAdd(&entries[i], delays[i]);
+    }
+
+    runUntil(startTime + 500000000 + TEST_PROCESS_PERIOD_US * 2);
+
+    ASSERT_EQ((int)ARRAYLEN(delays), dispatchOrderCount);
+    for (unsigned i = 0; i < ARRAYLEN(delays); i++) {
+        const uint32_t dueTime = startTime + delays[i];
+        EXPECT_GE(cmp32(dispatchTime[i], dueTime), 0) << "entry " << i;
+        // the wheel adds at most a tick to the period of dispatchProcess() calls
+        EXPECT_LT(cmp32(dispatchTime[i], dueTime), TEST_PROCESS_PERIOD_US + TEST_TICK_US) << "entry " << i;
+        EXPECT_EQ(entries[i].lastLatenessUs, (uint32_t)cmp32(dispatchTime[i], dueTime));
+        EXPECT_EQ(1U, entries[i].dispatchCount);
+        EXPECT_FALSE(entries[i].inQue);
+    }
+    for (int i = 1; i < dispatchOrderCount; i++) {
+        EXPECT_LE(dispatchTime[dispatchOrder[i - 1]], dispatchTime[dispatchOrder[i]]);
+    }
+}
+
+TEST_F(DispatchTest, TestRandomDelays)
+{
+    srand(42);
+    const uint32_t startTime = simulationTime;
+    uint32_t lastDue = startTime;
+
+    for (int i = 0; i < TEST_ENTRY_COUNT; i++) {
+        const int delay = rand() % 20000000;
+        dispatchAdd(&entries[i], delay);
+        if (cmp32(startTime + delay, lastDue) > 0) {
+            lastDue = startTime + delay;
+        }
+    }
+
+    runUntil(lastDue + TEST_PROCESS_PERIOD_US * 2);
+
+    ASSERT_EQ(TEST_ENTRY_COUNT, dispatchOrderCount);
+    for (int i = 0; i < TEST_ENTRY_COUNT; i++) {
+        EXPECT_GE(cmp32(dispatchTime[i], entries[i].delayedUntil), 0);
+        EXPECT_LT(entries[i].maxLatenessUs, (uint32_t)(TEST_PROCESS_PERIOD_US + TEST_TICK_US));
+    }
+}
+
+TEST_F(DispatchTest, TestTimerWrap)
+{
+    simulationTime = 0xffffffff - 10000;
+    dispatchProcess(simulationTime);
+
+    dispatchAdd(&entries[0], 5000);
+    dispatchAdd(&entries[1], 20000);
+    dispatchAdd(&entries[2], 3000000);
+
+    runUntil(simulationTime + 4000000);
+
+    ASSERT_EQ(3, dispatchOrderCount);
+    EXPECT_EQ(0, dispatchOrder[0]);
+    EXPECT_EQ(1, dispatchOrder[1]);
+    EXPECT_EQ(2, dispatchOrder[2]);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_LT(entries[i].lastLatenessUs, (uint32_t)(TEST_PROCESS_PERIOD_US + TEST_TICK_US));
+    }
+}
+
+TEST_F(DispatchTest, TestAddWhileQueuedIsIgnored)
+{
+    const uint32_t startTime = simulationTime;
+
+    dispatchAdd(&entries[0], 10000);
+    dispatchAdd(&entries[0], 2000);
+
+    runUntil(startTime + 5000);
+    EXPECT_EQ(0, dispatchOrderCount);
+
+    runUntil(startTime + 12000);
+    EXPECT_EQ(1, dispatchOrderCount);
+    EXPECT_EQ(startTime + 10000, entries[0].delayedUntil);
+}
+
+TEST_F(DispatchTest, TestCancel)
+{
+    const uint32_t startTime = simulationTime;
+
+    for (int i = 0; i < 8; i++) {
+        dispatchAdd(&entries[i], 1000 * (i + 1) * (i + 1) * (i + 1));
+    }
+    // from the head, middle and tail of slots on different levels
+    dispatchCancel(&entries[0]);
+    dispatchCancel(&entries[4]);
+    dispatchCancel(&entries[7]);
+    dispatchCancel(&entries[7]);
+    EXPECT_FALSE(entries[4].inQue);
+
+    runUntil(startTime + 1000000);
+
+    EXPECT_EQ(5, dispatchOrderCount);
+    EXPECT_EQ(0U, entries[0].dispatchCount);
+    EXPECT_EQ(0U, entries[4].dispatchCount);
+    EXPECT_EQ(0U, entries[7].dispatchCount);
+    EXPECT_EQ(1U, entries[6].dispatchCount);
+}
+
+static int replanCount;
+
+static void replanSelf(dispatchEntry_t *self)
+{
+    recordDispatch(self);
+    if (++replanCount < 3) {
+        dispatchAdd(self, 0);
+    }
+}
+
+TEST_F(DispatchTest, TestHandlerCanReplanSelf)
+{
+    replanCount = 0;
+    entries[0].dispatch = replanSelf;
+
+    dispatchAdd(&entries[0], 2000);
+    runUntil(simulationTime + 10000);
+
+    EXPECT_EQ(3, dispatchOrderCount);
+    EXPECT_FALSE(entries[0].inQue);
+}
+
+static void cancelOther(dispatchEntry_t *self)
+{
+    recordDispatch(self);
+    dispatchCancel(self == &entries[0] ? &entries[1] : &entries[0]);
+}
+
+TEST_F(DispatchTest, TestHandlerCanCancelEntryDueOnSameTick)
+{
+    entries[0].dispatch = cancelOther;
+    entries[1].dispatch = cancelOther;
+
+    dispatchAdd(&entries[1], 2000);
+    dispatchAdd(&entries[0], 2000);
+    runUntil(simulationTime + 10000);
+
+    // whichever runs first cancels the other
+    EXPECT_EQ(1, dispatchOrderCount);
+    EXPECT_EQ(1U, entries[0].dispatchCount + entries[1].dispatchCount);
+    EXPECT_FALSE(entries[0].inQue || entries[1].inQue);
+}
+
+TEST_F(DispatchTest, TestPeriodic)
+{
+    const uint32_t startTime = simulationTime;
+
+    dispatchAddPeriodic(&entries[0], 10000, 20000);
+    runUntil(startTime + 10000 + 20000 * 9 + 500);
+
+    EXPECT_EQ(10U, entries[0].dispatchCount);
+    EXPECT_TRUE(entries[0].inQue);
+    // re-armed from the due time, so the period doesn't drift with lateness
+    EXPECT_EQ(startTime + 10000 + 20000 * 10, entries[0].delayedUntil);
+    EXPECT_LT(entries[0].maxLatenessUs, (uint32_t)(TEST_PROCESS_PERIOD_US + TEST_TICK_US));
+
+    dispatchCancel(&entries[0]);
+    runUntil(simulationTime + 100000);
+    EXPECT_EQ(10U, entries[0].dispatchCount);
+}
+
+TEST_F(DispatchTest, TestPeriodicSkipsMissedPeriods)
+{
+    const uint32_t startTime = simulationTime;
+
+    dispatchAddPeriodic(&entries[0], 1000, 1000);
+
+    // the dispatch task stalls for a while
+    simulationTime += 10500;
+    dispatchProcess(simulationTime);
+
+    EXPECT_EQ(1U, entries[0].dispatchCount);
+    EXPECT_EQ(9500U, entries[0].lastLatenessUs);
+    EXPECT_EQ(startTime + 11000, entries[0].delayedUntil);
+}
+
+static void stopPeriodic(dispatchEntry_t *self)
+{
+    recordDispatch(self);
+    if (self->dispatchCount == 2) {
+        dispatchCancel(self);
+    }
+}
+
+TEST_F(DispatchTest, TestPeriodicCancelFromHandler)
+{
+    entries[0].dispatch = stopPeriodic;
+
+    dispatchAddPeriodic(&entries[0], 0, 5000);
+    runUntil(simulationTime + 100000);
+
+    EXPECT_EQ(2U, entries[0].dispatchCount);
+    EXPECT_FALSE(entries[0].inQue);
+}
+
+// STUBS
+
+extern "C" {
+    timeUs_t micros(void) { return simulationTime; }
+}
@@ -0,0 +1,326 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Bidirectional DShot telemetry decoding of bit-banged port captures, one pin at a time with decode_bb() and all
+// pins of a port at once with decode_bb_port().
+//
+// The port buffers are laid out the way the input DMA leaves them: one 16 bit GPIO sample per entry, 3 samples per
+// GCR bit. Each motor answers with its own eRPM frame after its own turnaround delay, with the ESC clock off by a
+// few percent, edge jitter and single sample glitches. replayPort() takes any such buffer, so captures from a
+// DEBUG_BBDECODE build can be replayed the same way. The benchmark reports the decode time per motor and how
+// many frames each decoder got right, rejected or got wrong. The unit tests build at -O0 with coverage
+// instrumentation, so the times only mean something when built with the optimisation of the firmware.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "drivers/dshot.h"
+    #include "drivers/dshot_bitbang_decode.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define PORT_BUFFER_LENGTH      140     // DSHOT_BB_PORT_IP_BUF_LENGTH
+#define SAMPLES_PER_BIT         3
+#define GCR_FRAME_BITS          21
+#define PORT_PIN_COUNT          16
+
+static const uint8_t gcrEncode[16] = {
+    0x19, 0x1b, 0x12, 0x13, 0x1d, 0x15, 0x16, 0x17, 0x1a, 0x09, 0x0a, 0x0b, 0x1e, 0x0d, 0x0e, 0x0f
+};
+
+typedef struct channelModel_s {
+    const char *name;
+    float clockError;           // worst case ESC clock error, fraction
+    float jitter;               // worst case edge displacement, samples
+    float glitchProbability;    // per sample, of a single inverted sample during the frame
+} channelModel_t;
+
+typedef struct portCapture_s {
+    uint16_t samples[PORT_BUFFER_LENGTH];
+    uint16_t pinMask;
+    uint32_t expected[PORT_PIN_COUNT];
+} portCapture_t;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * rand() / (float)RAND_MAX;
+}
+
+// What decode_bb_value() returns for a telemetry value
+static uint32_t expectedErpm(uint16_t telemetry)
+{
+    if (telemetry == 0x0fff) {
+        return 0;
+    }
+    const uint32_t period = (telemetry & 0x1ff) << (telemetry >> 9);
+    return (1000000 * 60 / 100 + period / 2) / period;
+}
+
+// The 21 bit frame, a set bit is a level change. The first one is the start of the frame.
+static uint32_t gcrFrame(uint16_t telemetry)
+{
+    const uint16_t checksum = ~(telemetry ^ (telemetry >> 4) ^ (telemetry >> 8)) & 0xf;
+    const uint16_t value = (telemetry << 4) | checksum;
+
+    uint32_t frame = 1;
+    for (int nibble = 3; nibble >= 0; nibble--) {
+        frame = (frame << 5) | gcrEncode[(value >> (nibble * 4)) & 0xf];
+    }
+    return frame;
+}
+
+static void addPinFrame(portCapture_t *capture, int pin, uint16_t telemetry, const channelModel_t *model)
+{
+    const uint32_t frame = gcrFrame(telemetry);
+    const float samplesPerBit = SAMPLES_PER_BIT * (1.0f + randomFloat(-model->clockError, model->clockError));
+    const float start = randomFloat(15, 40);
+    const uint16_t mask = 1 << pin;
+
+    float edges[GCR_FRAME_BITS + 1];
+    int edgeCount = 0;
+    bool low = false;
+    for (int bit = 0; bit < GCR_FRAME_BITS; bit++) {
+        if (frame & (1 << (GCR_FRAME_BITS - 1 - bit))) {
+            edges[edgeCount++] = start + bit * samplesPerBit + randomFloat(-model->jitter, model->jitter);
+            low = !low;
+        }
+    }
+    if (low) {
+        // back to idle after the last bit
+        edges[edgeCount++] = start + GCR_FRAME_BITS * samplesPerBit + randomFloat(-model->jitter, model->jitter);
+    }
+
+    int edge = 0;
+    low = false;
+    const int frameEnd = MIN(PORT_BUFFER_LENGTH, (int)(start + (GCR_FRAME_BITS + 1) * samplesPerBit));
+    for (int i = 0; i < PORT_BUFFER_LENGTH; i++) {
+        while (edge < edgeCount && edges[edge] <= i) {
+            low = !low;
+            edge++;
+        }
+        bool level = !low;
+        if (i >= start && i < frameEnd && randomFloat(0, 1) < model->glitchProbability) {
+            level = !level;
+        }
+        if (level) {
+            capture->samples[i] |= mask;
+        } else {
+            capture->samples[i] &= ~mask;
+        }
+    }
+
+    capture->pinMask |= mask;
+    capture->expected[pin] = expectedErpm(telemetry);
+}
+
+static uint16_t randomTelemetry(void)
+{
+    if (rand() % 16 == 0) {
+        return 0x0fff;  // motor stopped
+    }
+    return ((rand() % 8) << 9) | (1 + rand() % 511);
+}
+
+static void makeCapture(portCapture_t *capture, const int *pins, int pinCount, const channelModel_t *model)
+{
+    memset(capture, 0, sizeof(*capture));
+    for (int i = 0; i < PORT_BUFFER_LENGTH; i++) {
+        capture->samples[i] = 0xffff;
+    }
+    for (int i = 0; i < pinCount; i++) {
+        addPinFrame(capture, pins[i], randomTelemetry(), model);
+    }
+}
+
+typedef struct decodeCounts_s {
+    uint32_t correct;
+    uint32_t rejected;      // BB_INVALID or BB_NOEDGE
+    uint32_t wrong;         // a valid looking value that isn't what was sent
+} decodeCounts_t;
+
+static void countResult(decodeCounts_t *counts, uint32_t value, uint32_t expected)
+{
+    if (value == expected) {
+        counts->correct++;
+    } else if (value == BB_INVALID || value == BB_NOEDGE) {
+        counts->rejected++;
+    } else {
+        counts->wrong++;
+    }
+}
+
+static void replayPort(portCapture_t *capture, uint32_t *singlePin, uint32_t *port)
+{
+    for (int pin = 0; pin < PORT_PIN_COUNT; pin++) {
+        if (capture->pinMask & (1 << pin)) {
+            singlePin[pin] = decode_bb(capture->samples, PORT_BUFFER_LENGTH, pin);
+        }
+    }
+    decode_bb_port(capture->samples, PORT_BUFFER_LENGTH, capture->pinMask, port);
+}
+
+static uint64_t benchmarkNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static const channelModel_t cleanChannel = { "clean", 0.0f, 0.0f, 0.0f };
+static const channelModel_t typicalChannel = { "typical", 0.03f, 0.4f, 0.0f };
+static const channelModel_t jitterChannel = { "jitter", 0.05f, 0.9f, 0.0f };
+static const channelModel_t noisyChannel = { "noisy", 0.03f, 0.4f, 0.01f };
+
+static const int eightMotorPins[] = { 0, 1, 2, 3, 6, 7, 8, 9 };
+
+TEST(DshotBitbangDecodeTest, TestPortDecodeMatchesSinglePin)
+{
+    srand(1);
+    const channelModel_t *models[] = { &cleanChannel, &typicalChannel };
+
+    for (unsigned m = 0; m < ARRAYLEN(models); m++) {
+        for (int i = 0; i < 2000; i++) {
+            portCapture_t capture;
+            makeCapture(&capture, eightMotorPins, ARRAYLEN(eightMotorPins), models[m]);
+
+            uint32_t singlePin[PORT_PIN_COUNT];
+            uint32_t port[PORT_PIN_COUNT];
+            replayPort(&capture, singlePin, port);
+
+            for (unsigned p = 0; p < ARRAYLEN(eightMotorPins); p++) {
+                const int pin = eightMotorPins[p];
+                EXPECT_EQ(capture.expected[pin], port[pin]) << models[m]->name << " pin " << pin;
+                EXPECT_EQ(singlePin[pin], port[pin]) << models[m]->name << " pin " << pin;
+            }
+        }
+    }
+}
+
+TEST(DshotBitbangDecodeTest, TestSilentAndLatePins)
+{
+    portCapture_t capture;
+    srand(2);
+    makeCapture(&capture, eightMotorPins, 1, &cleanChannel);
+
+    // pin 5 never answers, pin 12 answers too late for the whole frame to fit in the buffer
+    capture.pinMask |= 1 << 5;
+    for (int i = PORT_BUFFER_LENGTH - 40; i < PORT_BUFFER_LENGTH; i++) {
+        capture.samples[i] &= ~(1 << 12);
+    }
+    capture.pinMask |= 1 << 12;
+
+    uint32_t singlePin[PORT_PIN_COUNT];
+    uint32_t port[PORT_PIN_COUNT];
+    replayPort(&capture, singlePin, port);
+
+    EXPECT_EQ(capture.expected[0], port[0]);
+    EXPECT_EQ((uint32_t)BB_NOEDGE, port[5]);
+    EXPECT_EQ((uint32_t)BB_NOEDGE, port[12]);
+    EXPECT_EQ(singlePin[5], port[5]);
+    EXPECT_EQ(singlePin[12], port[12]);
+}
+
+TEST(DshotBitbangDecodeTest, TestCorruptFramesRejected)
+{
+    portCapture_t capture;
+    srand(3);
+    makeCapture(&capture, eightMotorPins, 2, &cleanChannel);
+
+    // stretch a low level of pin 1 to five bits, GCR never has more than two zeros in a row
+    int start = 0;
+    while (capture.samples[start] & (1 << 1)) {
+        start++;
+    }
+    for (int i = start; i < start + 5 * SAMPLES_PER_BIT; i++) {
+        capture.samples[i] &= ~(1 << 1);
+    }
+
+    uint32_t singlePin[PORT_PIN_COUNT];
+    uint32_t port[PORT_PIN_COUNT];
+    replayPort(&capture, singlePin, port);
+
+    EXPECT_EQ(capture.expected[0], port[0]);
+    EXPECT_EQ((uint32_t)BB_INVALID, port[1]);
+}
+
+TEST(DshotBitbangDecodeTest, Benchmark)
+{
+    const channelModel_t *models[] = { &cleanChannel, &typicalChannel, &jitterChannel, &noisyChannel };
+    const int captureCount = 20000;
+    portCapture_t *captures = (portCapture_t *)malloc(captureCount * sizeof(portCapture_t));
+    static uint32_t results[PORT_PIN_COUNT];
+
+    printf("\n%-8s %6s %12s %12s %10s %10s %10s\n", "channel", "motors", "decoder", "ns/motor", "correct%", "rejected%", "wrong%");
+
+    for (unsigned m = 0; m < ARRAYLEN(models); m++) {
+        for (int motors = 4; motors <= 8; motors += 4) {
+            srand(100 + m);
+            for (int i = 0; i < captureCount; i++) {
+                makeCapture(&captures[i], eightMotorPins, motors, models[m]);
+            }
+
+            decodeCounts_t single = { 0, 0, 0 };
+            uint64_t start = benchmarkNanos();
+            for (int i = 0; i < captureCount; i++) {
+                for (int p = 0; p < motors; p++) {
+                    const int pin = eightMotorPins[p];
+                    results[pin] = decode_bb(captures[i].samples, PORT_BUFFER_LENGTH, pin);
+                }
+                for (int p = 0; p < motors; p++) {
+                    countResult(&single, results[eightMotorPins[p]], captures[i].expected[eightMotorPins[p]]);
+                }
+            }
+            const double singleNs = (double)(benchmarkNanos() - start) / captureCount / motors;
+
+            decodeCounts_t port = { 0, 0, 0 };
+            start = benchmarkNanos();
+            for (int i = 0; i < captureCount; i++) {
+                decode_bb_port(captures[i].samples, PORT_BUFFER_LENGTH, captures[i].pinMask, results);
+                for (int p = 0; p < motors; p++) {
+                    countResult(&port, results[eightMotorPins[p]], captures[i].expected[eightMotorPins[p]]);
+                }
+            }
+            const double portNs = (double)(benchmarkNanos() - start) / captureCount / motors;
+
+            const double frames = (double)captureCount * motors / 100;
+            printf("%-8s %6d %12s %12.1f %10.2f %10.2f %10.3f\n", models[m]->name, motors, "decode_bb",
+                singleNs, single.correct / frames, single.rejected / frames, single.wrong / frames);
+            printf("%-8s %6d %12s %12.1f %10.2f %10.2f %10.3f\n", models[m]->name, motors, "port",
+                portNs, port.correct / frames, port.rejected / frames, port.wrong / frames);
+
+            EXPECT_GE(port.correct, single.correct);
+            EXPECT_LE(port.wrong, single.wrong);
+        }
+    }
+
+    free(captures);
+}
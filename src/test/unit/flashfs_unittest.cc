@@ -0,0 +1,460 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// flashfs against a simulated flash chip.
+//
+// The chip is a RAM image behind the flash.h API with a timing model after the M25P16 and W25N01G drivers: SPI
+// transfers are synchronous, and a driver call that finds the chip busy waits for it. The simulated clock moves by
+// the time spent in those calls, so what a flashfs call costs the task that made it is measured in simulated time,
+// as is the throughput.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "drivers/flash.h"
+
+    #include "io/flashfs.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define SIM_FLASH_SIZE          (2 * 1024 * 1024)
+
+typedef struct simFlashTiming_s {
+    const char *name;
+    flashType_e flashType;
+    uint16_t pageSize;
+    uint32_t sectorSize;
+    uint32_t commandUs;         // command and address ahead of every transfer
+    double busUsPerByte;        // data over the bus
+    uint32_t programUs;         // busy after a page program
+    double programUsPerByte;    // NOR programs only the bytes sent, which adds this much per byte
+    uint32_t eraseUs;           // busy after a sector erase
+} simFlashTiming_t;
+
+// 20MHz SPI. The M25P16 datasheet gives 0.8ms for a 256 byte program, the W25N01G 250us for a 2KB page
+static const simFlashTiming_t m25p16Flash = { "m25p16", FLASH_TYPE_NOR, 256, 64 * 1024, 2, 0.4, 50, 2.9, 150000 };
+static const simFlashTiming_t w25n01gFlash = { "w25n01g", FLASH_TYPE_NAND, 2048, 128 * 1024, 2, 0.4, 250, 0, 2000 };
+
+static struct {
+    const simFlashTiming_t *timing;
+    uint8_t image[SIM_FLASH_SIZE];
+    flashGeometry_t geometry;
+    flashPartition_t partition;
+
+    double now;
+    double busyUntil;
+    double waitUs;              // time drivers spent waiting for the chip to become ready
+
+    // The W25N01G loads data into its page buffer and programs the page once the load reaches the end of it
+    bool pageBufferDirty;
+    uint32_t loadAddress;
+
+    uint32_t pagePrograms;
+} sim;
+
+static void simWaitForReady(void)
+{
+    if (sim.now < sim.busyUntil) {
+        sim.waitUs += sim.busyUntil - sim.now;
+        sim.now = sim.busyUntil;
+    }
+}
+
+static void simTransfer(int length)
+{
+    sim.now += sim.timing->commandUs + length * sim.timing->busUsPerByte;
+}
+
+static void simProgramExecute(void)
+{
+    simWaitForReady();
+    simTransfer(0);
+    sim.busyUntil = sim.now + sim.timing->programUs;
+    sim.pageBufferDirty = false;
+    sim.pagePrograms++;
+}
+
+bool flashIsReady(void)
+{
+    return sim.now >= sim.busyUntil;
+}
+
+bool flashWaitForReady(void)
+{
+    simWaitForReady();
+    return true;
+}
+
+void flashEraseSector(uint32_t address)
+{
+    simWaitForReady();
+    simTransfer(0);
+    memset(sim.image + address / sim.geometry.sectorSize * sim.geometry.sectorSize, 0xFF, sim.geometry.sectorSize);
+    sim.busyUntil = sim.now + sim.timing->eraseUs;
+}
+
+void flashEraseCompletely(void)
+{
+    simWaitForReady();
+    simTransfer(0);
+    memset(sim.image, 0xFF, sizeof(sim.image));
+    sim.busyUntil = sim.now + sim.timing->eraseUs * sim.geometry.sectors;
+}
+
+void flashPageProgramBegin(uint32_t address)
+{
+    if (sim.pageBufferDirty && address != sim.loadAddress) {
+        simProgramExecute();
+    }
+    sim.loadAddress = address;
+}
+
+void flashPageProgramContinue(const uint8_t *data, int length)
+{
+    simWaitForReady();
+    simTransfer(length);
+
+    EXPECT_LE(sim.loadAddress % sim.geometry.pageSize + length, sim.geometry.pageSize);
+    for (int i = 0; i < length; i++) {
+        sim.image[sim.loadAddress + i] &= data[i];
+    }
+    sim.loadAddress += length;
+
+    if (sim.timing->flashType == FLASH_TYPE_NOR) {
+        // Every transfer is a program operation of its own
+        sim.busyUntil = sim.now + sim.timing->programUs + length * sim.timing->programUsPerByte;
+        sim.pagePrograms++;
+    } else {
+        sim.pageBufferDirty = true;
+    }
+}
+
+void flashPageProgramFinish(void)
+{
+    if (sim.pageBufferDirty && sim.loadAddress % sim.geometry.pageSize == 0) {
+        simProgramExecute();
+    }
+}
+
+void flashPageProgram(uint32_t address, const uint8_t *data, int length)
+{
+    flashPageProgramBegin(address);
+    flashPageProgramContinue(data, length);
+    flashPageProgramFinish();
+}
+
+int flashReadBytes(uint32_t address, uint8_t *buffer, int length)
+{
+    simWaitForReady();
+    simTransfer(length);
+    memcpy(buffer, sim.image + address, length);
+    return length;
+}
+
+void flashFlush(void)
+{
+    if (sim.pageBufferDirty) {
+        simProgramExecute();
+    }
+}
+
+const flashGeometry_t *flashGetGeometry(void)
+{
+    return &sim.geometry;
+}
+
+flashPartition_t *flashPartitionFindByType(flashPartitionType_e type)
+{
+    return type == FLASH_PARTITION_TYPE_FLASHFS ? &sim.partition : NULL;
+}
+
+int flashPartitionCount(void)
+{
+    return 1;
+}
+
+static void simInit(const simFlashTiming_t *timing)
+{
+    memset(&sim, 0, sizeof(sim));
+    memset(sim.image, 0xFF, sizeof(sim.image));
+
+    sim.timing = timing;
+    sim.geometry.pageSize = timing->pageSize;
+    sim.geometry.sectorSize = timing->sectorSize;
+    sim.geometry.pagesPerSector = timing->sectorSize / timing->pageSize;
+    sim.geometry.sectors = SIM_FLASH_SIZE / timing->sectorSize;
+    sim.geometry.totalSize = SIM_FLASH_SIZE;
+    sim.geometry.flashType = timing->flashType;
+    sim.partition.type = FLASH_PARTITION_TYPE_FLASHFS;
+    sim.partition.startSector = 0;
+    sim.partition.endSector = sim.geometry.sectors - 1;
+
+    flashfsInit();
+}
+
+static uint8_t patternByte(uint32_t frame, uint32_t i)
+{
+    return (uint8_t)(frame * 7 + i * 13 + (frame >> 8));
+}
+
+typedef struct logFrame_s {
+    uint32_t index;
+    uint32_t address;
+    uint8_t length;
+} logFrame_t;
+
+// Check that every frame flashfs accepted is on the flash where it said it would be
+static uint32_t verifyFrames(const std::vector<logFrame_t> &frames)
+{
+    uint32_t mismatches = 0;
+
+    for (const logFrame_t &frame : frames) {
+        for (uint32_t i = 0; i < frame.length; i++) {
+            if (sim.image[frame.address + i] != patternByte(frame.index, i)) {
+                mismatches++;
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+// Drain the buffer the way the blackbox does when it ends a log
+static void closeLog(void)
+{
+    for (int i = 0; i < 1000 && !flashfsFlushAsync(true); i++) {
+        sim.now += 125;
+    }
+    flashfsClose();
+    flashWaitForReady();
+}
+
+TEST(FlashfsTest, StartsAtFreeSpace)
+{
+    simInit(&m25p16Flash);
+    EXPECT_EQ(0u, flashfsGetOffset());
+
+    memset(sim.image, 0, 5000);
+    flashfsInit();
+
+    // Free space is found a 2KB block at a time
+    EXPECT_EQ(6144u, flashfsGetOffset());
+}
+
+TEST(FlashfsTest, SyncWriteLargerThanBuffer)
+{
+    simInit(&m25p16Flash);
+
+    uint8_t data[1000];
+
+    for (uint32_t frame = 0; frame < 4; frame++) {
+        const uint32_t length = frame == 2 ? sizeof(data) : 100;
+        for (uint32_t i = 0; i < length; i++) {
+            data[i] = patternByte(frame, i);
+        }
+
+        const uint32_t address = flashfsGetOffset();
+        flashfsWrite(data, length, true);
+        EXPECT_EQ(address + length, flashfsGetOffset());
+    }
+    flashfsFlushSync();
+    closeLog();
+
+    uint32_t address = 0;
+    for (uint32_t frame = 0; frame < 4; frame++) {
+        const uint32_t length = frame == 2 ? sizeof(data) : 100;
+        for (uint32_t i = 0; i < length; i++) {
+            EXPECT_EQ(patternByte(frame, i), sim.image[address + i]);
+        }
+        address += length;
+    }
+    EXPECT_EQ(address, flashfsGetOffset());
+    EXPECT_EQ(0u, flashfsGetStats()->droppedBytes);
+}
+
+TEST(FlashfsTest, FlushAsyncNeverWaits)
+{
+    simInit(&m25p16Flash);
+
+    uint8_t data[FLASHFS_WRITE_BUFFER_SLOT_SIZE];
+    memset(data, 0x55, sizeof(data));
+
+    // A full slot goes straight out as one page program
+    flashfsWrite(data, sizeof(data), false);
+    EXPECT_EQ(1u, sim.pagePrograms);
+    EXPECT_FALSE(flashIsReady());
+
+    // The next one fills while the flash is busy and has to wait its turn
+    flashfsWrite(data, sizeof(data), false);
+    EXPECT_EQ(1u, sim.pagePrograms);
+
+    const double before = sim.now;
+    for (int i = 0; i < 10; i++) {
+        EXPECT_FALSE(flashfsFlushAsync(true));
+    }
+    EXPECT_EQ(before, sim.now);
+    EXPECT_EQ(0, sim.waitUs);
+
+    // However many times we look, that's one stall
+    EXPECT_EQ(1u, flashfsGetStats()->stalls);
+
+    // With both slots taken, more data doesn't fit and is dropped
+    flashfsWrite(data, sizeof(data), false);
+    EXPECT_EQ(sizeof(data), flashfsGetStats()->droppedBytes);
+    EXPECT_EQ(2 * sizeof(data), flashfsGetOffset());
+    EXPECT_EQ(sizeof(data), flashfsGetStats()->bufferHighWater);
+
+    sim.now = sim.busyUntil;
+    EXPECT_TRUE(flashfsFlushAsync(false));
+    EXPECT_EQ(2u, sim.pagePrograms);
+    EXPECT_EQ(0, sim.waitUs);
+}
+
+TEST(FlashfsTest, PartialSlotWaitsForForce)
+{
+    simInit(&w25n01gFlash);
+
+    uint8_t data[100];
+    memset(data, 0xAA, sizeof(data));
+
+    flashfsWrite(data, sizeof(data), false);
+    EXPECT_FALSE(flashfsFlushAsync(false));
+    EXPECT_EQ(sizeof(data), flashfsGetWriteBufferSize() - flashfsGetWriteBufferFreeSpace());
+
+    EXPECT_TRUE(flashfsFlushAsync(true));
+    EXPECT_EQ(flashfsGetWriteBufferSize(), flashfsGetWriteBufferFreeSpace());
+
+    // NAND only programs the page once it is closed
+    EXPECT_EQ(0u, sim.pagePrograms);
+    flashfsClose();
+    EXPECT_EQ(1u, sim.pagePrograms);
+    EXPECT_EQ(0xAA, sim.image[99]);
+    EXPECT_EQ(2048u, flashfsGetOffset());
+}
+
+#define LOOP_US             125     // 8kHz pid loop, which runs the blackbox
+#define LOG_SECONDS         2
+
+typedef struct benchmarkResult_s {
+    double kilobytesPerSecond;  // stored on the flash
+    double droppedPercent;
+    double worstCallUs;         // simulated time of the slowest flashfsWrite() and flashfsFlushAsync() in one loop
+    double blockedUsPerSecond;
+    uint32_t stalls;
+    uint32_t highWater;
+    uint32_t mismatches;
+} benchmarkResult_t;
+
+// Log frames of 20 to 60 bytes at frameHz with a flush every loop, like blackboxUpdate()
+static benchmarkResult_t logAtRate(const simFlashTiming_t *timing, uint32_t frameHz)
+{
+    benchmarkResult_t result = {};
+    std::vector<logFrame_t> frames;
+    uint8_t data[64];
+    uint32_t offered = 0;
+    uint32_t dropped = 0;
+
+    simInit(timing);
+
+    const uint32_t loops = LOG_SECONDS * 1000000 / LOOP_US;
+    const uint32_t loopsPerFrame = 1000000 / LOOP_US / frameHz;
+    const uint32_t startAddress = flashfsGetOffset();
+    double busyUs = 0;
+
+    for (uint32_t loop = 0; loop < loops; loop++) {
+        const double loopStart = loop * (double)LOOP_US;
+        sim.now = MAX(sim.now, loopStart);
+        const double callStart = sim.now;
+
+        if (loop % loopsPerFrame == 0) {
+            const uint32_t index = frames.size() + dropped;
+            const uint8_t length = 20 + (index * 37) % 41;
+            for (uint32_t i = 0; i < length; i++) {
+                data[i] = patternByte(index, i);
+            }
+
+            const uint32_t address = flashfsGetOffset();
+            flashfsWrite(data, length, false);
+            const uint32_t accepted = flashfsGetOffset() - address;
+
+            offered += length;
+            if (accepted == length) {
+                frames.push_back({ index, address, length });
+            } else {
+                dropped++;
+            }
+            result.droppedPercent += length - accepted;
+        }
+
+        flashfsFlushAsync(false);
+
+        result.worstCallUs = MAX(result.worstCallUs, sim.now - callStart);
+        busyUs += sim.now - callStart;
+    }
+    closeLog();
+
+    result.kilobytesPerSecond = (flashfsGetOffset() - startAddress) / 1024.0 / LOG_SECONDS;
+    result.droppedPercent = 100.0 * result.droppedPercent / offered;
+    result.blockedUsPerSecond = busyUs / LOG_SECONDS;
+    result.stalls = flashfsGetStats()->stalls;
+    result.highWater = flashfsGetStats()->bufferHighWater;
+    result.mismatches = verifyFrames(frames);
+
+    return result;
+}
+
+TEST(FlashfsBenchmark, SustainedBlackbox)
+{
+    const simFlashTiming_t *flashes[] = { &m25p16Flash, &w25n01gFlash };
+    const uint32_t frameRates[] = { 1000, 2000, 4000, 8000 };
+
+    printf("%-10s %8s %10s %10s %12s %12s %8s %10s\n", "flash", "frame Hz", "KB/s", "dropped", "worst call", "busy/s", "stalls", "high water");
+    for (unsigned f = 0; f < ARRAYLEN(flashes); f++) {
+        for (unsigned r = 0; r < ARRAYLEN(frameRates); r++) {
+            const benchmarkResult_t result = logAtRate(flashes[f], frameRates[r]);
+
+            printf("%-10s %8u %10.1f %9.1f%% %10.1fus %10.0fus %8u %10u\n", flashes[f]->name, frameRates[r],
+                result.kilobytesPerSecond, result.droppedPercent, result.worstCallUs, result.blockedUsPerSecond,
+                result.stalls, result.highWater);
+
+            EXPECT_EQ(0u, result.mismatches);
+
+            // Programming a slot costs the loop no more than sending it over the bus, the flash is never waited for
+            EXPECT_LT(result.worstCallUs, FLASHFS_WRITE_BUFFER_SLOT_SIZE * flashes[f]->busUsPerByte + 2 * flashes[f]->commandUs + 1);
+
+            if (frameRates[r] <= 4000) {
+                // Up to 160KB/s is within what either chip sustains
+                EXPECT_EQ(0, result.droppedPercent);
+            }
+        }
+    }
+}
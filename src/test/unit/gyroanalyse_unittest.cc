@@ -0,0 +1,233 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <math.h>
+
+#include <chrono>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+    #include "common/sdft.h"
+
+    void gyroAnalyseTestInit(int analyser, int notchCount, uint32_t looptimeUs);
+    void gyroAnalyseTestPush(const float *samples);
+    void gyroAnalyseTestAnalyse(void);
+    float gyroAnalyseTestCenterFreq(int axis);
+    float gyroAnalyseTestPeakFreq(int axis, int peak);
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define LOOPTIME_US     125
+#define LOOP_RATE_HZ    (1000000 / LOOPTIME_US)
+
+// dynNotchAnalyser_e, sensors/gyro.h can't be included from C++ here
+enum {
+    ANALYSER_FFT = 0,
+    ANALYSER_SDFT
+};
+
+typedef struct trackingResult_s {
+    float meanError;        // mean absolute error of the tracked frequency, Hz
+    float lagMs;            // mean delay of the tracked frequency behind the sweep
+    float meanNs;           // time per gyroDataAnalyse call
+    float maxNs;
+} trackingResult_t;
+
+// a motor noise tone with a little broadband noise, sweeping linearly from startHz to endHz
+static trackingResult_t trackSweep(int analyser, float startHz, float endHz, float seconds)
+{
+    gyroAnalyseTestInit(analyser, 1, LOOPTIME_US);
+
+    const int settleSamples = LOOP_RATE_HZ / 2;
+    const int sweepSamples = seconds * LOOP_RATE_HZ;
+    float phase = 0;
+    uint32_t noise = 1;
+    double errorSum = 0;
+    double signedErrorSum = 0;
+    double totalNs = 0;
+    double maxNs = 0;
+
+    for (int i = 0; i < settleSamples + sweepSamples; i++) {
+        const float frequency = i < settleSamples ? startHz : startHz + (endHz - startHz) * (i - settleSamples) / sweepSamples;
+        phase += 2 * M_PIf * frequency / LOOP_RATE_HZ;
+        if (phase > 2 * M_PIf) {
+            phase -= 2 * M_PIf;
+        }
+        float samples[3];
+        for (int axis = 0; axis < 3; axis++) {
+            noise = noise * 1664525 + 1013904223;
+            samples[axis] = 100.0f * sinf(phase + axis) + 5.0f * ((int32_t)noise / 2147483648.0f);
+        }
+        gyroAnalyseTestPush(samples);
+
+        const auto start = std::chrono::steady_clock::now();
+        gyroAnalyseTestAnalyse();
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        if (i >= settleSamples) {
+            errorSum += fabsf(gyroAnalyseTestCenterFreq(0) - frequency);
+            signedErrorSum += gyroAnalyseTestCenterFreq(0) - frequency;
+            totalNs += ns;
+            maxNs = fmax(maxNs, ns);
+        }
+    }
+
+    trackingResult_t result;
+    result.meanError = errorSum / sweepSamples;
+    result.lagMs = endHz != startHz ? -1000 * signedErrorSum / sweepSamples / ((endHz - startHz) / seconds) : 0;
+    result.meanNs = totalNs / sweepSamples;
+    result.maxNs = maxNs;
+    return result;
+}
+
+TEST(GyroAnalyseUnittest, TestSdftPeakBin)
+{
+    sdft_t sdft;
+    sdftInit(&sdft, 2, 29, 1);
+
+    float output[SDFT_BIN_COUNT] = { 0 };
+    for (int i = 0; i < 4 * SDFT_SAMPLE_SIZE; i++) {
+        sdftPush(&sdft, 10.0f * sinf(2 * M_PIf * 12 * i / SDFT_SAMPLE_SIZE));
+    }
+    sdftWindowedMagSq(&sdft, output);
+
+    int peakBin = 2;
+    for (int bin = 2; bin <= 29; bin++) {
+        if (output[bin] > output[peakBin]) {
+            peakBin = bin;
+        }
+    }
+    EXPECT_EQ(12, peakBin);
+    // the Hann window spreads a tone over its neighbours only
+    EXPECT_GT(output[11], 0.1f * output[12]);
+    EXPECT_LT(output[15], 1e-3f * output[12]);
+}
+
+TEST(GyroAnalyseUnittest, TestSdftBatchMatchesPush)
+{
+    sdft_t whole;
+    sdft_t batched;
+    sdftInit(&whole, 4, 20, 1);
+    sdftInit(&batched, 4, 20, 6);
+
+    for (int i = 0; i < 200; i++) {
+        const float sample = 50.0f * sinf(0.7f * i) + 20.0f * cosf(1.9f * i);
+        sdftPush(&whole, sample);
+        for (int batch = 0; batch < 6; batch++) {
+            sdftPushBatch(&batched, sample, batch);
+        }
+    }
+
+    for (int bin = 3; bin <= 21; bin++) {
+        EXPECT_FLOAT_EQ(whole.re[bin], batched.re[bin]);
+        EXPECT_FLOAT_EQ(whole.im[bin], batched.im[bin]);
+    }
+}
+
+TEST(GyroAnalyseUnittest, TestSteadyTone)
+{
+    for (float frequency = 170; frequency < 450; frequency += 37) {
+        EXPECT_LT(trackSweep(ANALYSER_FFT, frequency, frequency, 0.3f).meanError, 5.0f);
+        // interpolation between the narrower bins is exact for a single tone
+        EXPECT_LT(trackSweep(ANALYSER_SDFT, frequency, frequency, 0.3f).meanError, 1.0f);
+    }
+}
+
+TEST(GyroAnalyseUnittest, TestSweepTracking)
+{
+    // 150Hz to 450Hz in one second, a fast throttle punch
+    const trackingResult_t fft = trackSweep(ANALYSER_FFT, 150, 450, 1.0f);
+    const trackingResult_t sdft = trackSweep(ANALYSER_SDFT, 150, 450, 1.0f);
+
+    // the host FFT (arm_math_host.c) is O(N log N) like CMSIS, its timing is the reference for the SDFT
+    printf("dynamic notch sweep 150-450Hz at 8kHz: FFT error %.1f Hz lag %.1f ms, %.0f ns mean %.0f ns max per call; SDFT error %.1f Hz lag %.1f ms, %.0f ns mean %.0f ns max per call\n",
+        fft.meanError, fft.lagMs, fft.meanNs, fft.maxNs, sdft.meanError, sdft.lagMs, sdft.meanNs, sdft.maxNs);
+
+    // the 64 sample SDFT window is twice as long as the FFT window, so it lags more on a sweep
+    EXPECT_LT(fft.lagMs, 25.0f);
+    EXPECT_LT(sdft.lagMs, 35.0f);
+    EXPECT_LT(sdft.meanError, 12.0f);
+}
+
+static void feedTwoTones(float frequency1, float amplitude1, float frequency2, float amplitude2)
+{
+    for (int i = 0; i < LOOP_RATE_HZ / 2; i++) {
+        const float t = (float)i / LOOP_RATE_HZ;
+        const float sample = amplitude1 * sinf(2 * M_PIf * frequency1 * t) + amplitude2 * sinf(2 * M_PIf * frequency2 * t);
+        const float samples[3] = { sample, sample, sample };
+        gyroAnalyseTestPush(samples);
+        gyroAnalyseTestAnalyse();
+    }
+}
+
+TEST(GyroAnalyseUnittest, TestSdftTwoPeaks)
+{
+    gyroAnalyseTestInit(ANALYSER_SDFT, 3, LOOPTIME_US);
+
+    // a weaker frame resonance below a strong motor tone, less than two FFT bins apart
+    feedTwoTones(300, 100, 240, 40);
+
+    // notches are ordered by frequency, centerFreq follows the largest peak
+    EXPECT_NEAR(240.0f, gyroAnalyseTestPeakFreq(0, 0), 10.0f);
+    EXPECT_NEAR(300.0f, gyroAnalyseTestPeakFreq(0, 1), 5.0f);
+    EXPECT_NEAR(300.0f, gyroAnalyseTestCenterFreq(2), 5.0f);
+}
+
+TEST(GyroAnalyseUnittest, TestFftTwoPeaks)
+{
+    gyroAnalyseTestInit(ANALYSER_FFT, 2, LOOPTIME_US);
+
+    feedTwoTones(420, 100, 200, 60);
+
+    EXPECT_NEAR(200.0f, gyroAnalyseTestPeakFreq(1, 0), 10.0f);
+    EXPECT_NEAR(420.0f, gyroAnalyseTestPeakFreq(1, 1), 10.0f);
+    EXPECT_NEAR(420.0f, gyroAnalyseTestCenterFreq(1), 10.0f);
+}
+
+TEST(GyroAnalyseUnittest, TestSingleNotchFollowsLargestPeak)
+{
+    for (int analyser = ANALYSER_FFT; analyser <= ANALYSER_SDFT; analyser++) {
+        gyroAnalyseTestInit(analyser, 1, LOOPTIME_US);
+
+        feedTwoTones(200, 40, 420, 100);
+
+        EXPECT_NEAR(420.0f, gyroAnalyseTestPeakFreq(0, 0), 10.0f);
+        EXPECT_NEAR(420.0f, gyroAnalyseTestCenterFreq(0), 10.0f);
+    }
+}
+
+// STUBS
+
+extern "C" {
+    uint32_t micros(void)
+    {
+        return 0;
+    }
+
+    uint8_t calculateThrottlePercentAbs(void)
+    {
+        return 50;
+    }
+
+}
@@ -0,0 +1,66 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "build/debug.h"
+
+#include "common/filter.h"
+#include "common/utils.h"
+
+#include "pg/pg.h"
+#include "pg/pg_ids.h"
+
+#include "sensors/gyro.h"
+
+// the analyser state holds arm_math.h types, so it lives on the C side
+
+PG_REGISTER(gyroConfig_t, gyroConfig, PG_GYRO_CONFIG, 0);
+
+uint8_t debugMode;
+int16_t debug[DEBUG16_VALUE_COUNT];
+gyro_t gyro;
+
+static gyroAnalyseState_t state;
+static filterBank_t notchBank;
+
+void gyroAnalyseTestInit(int analyser, int notchCount, uint32_t looptimeUs)
+{
+    gyro.targetLooptime = looptimeUs;
+    gyroConfigMutable()->dyn_notch_max_hz = 600;
+    gyroConfigMutable()->dyn_notch_min_hz = 150;
+    gyroConfigMutable()->dyn_notch_width_percent = 0;
+    gyroConfigMutable()->dyn_notch_q = 120;
+    gyroConfigMutable()->dyn_notch_analyser = analyser;
+    gyroConfigMutable()->dyn_notch_count = notchCount;
+
+    filterBankInit(&notchBank);
+    for (int i = 0; i < notchCount; i++) {
+        filterBankAddBiquad(&notchBank, FILTER_BANK_BIQUAD_DF1, 400, looptimeUs, 1.2f, FILTER_NOTCH);
+    }
+
+    memset(&state, 0, sizeof(state));
+    gyroDataAnalyseStateInit(&state, looptimeUs);
+}
+
+void gyroAnalyseTestPush(const float *samples)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroDataAnalysePush(&state, axis, samples[axis]);
+    }
+}
+
+void gyroAnalyseTestAnalyse(void)
+{
+    gyroDataAnalyse(&state, &notchBank);
+}
+
+float gyroAnalyseTestCenterFreq(int axis)
+{
+    return state.centerFreq[axis];
+}
+
+float gyroAnalyseTestPeakFreq(int axis, int peak)
+{
+    return state.peakFreq[axis][peak];
+}
@@ -0,0 +1,475 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Huffman tables built from the flash before a dataflash read, checked with a decoder that rebuilds them, and
+// compared with the static table on blackbox logs.
+//
+// The logs are made with the blackbox encoders from simulated flights. The benchmark reports the compression ratio,
+// the host speed of each table and the time to download a 16MB log with MSP_DATAFLASH_READ, from a model of the
+// serial task, the link and the host's turnaround.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox_encoding.h"
+
+    #include "common/huffman.h"
+    #include "common/maths.h"
+    #include "common/utils.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// Decode bits with a table the way a host does, one bit at a time until they make a code. Returns the decoded size.
+static int huffmanDecode(const uint8_t *in, int inLen, uint8_t *out, int outLen, const huffmanTable_t *table)
+{
+    int outPos = 0;
+    uint16_t code = 0;
+    int codeLen = 0;
+
+    for (int bit = 0; bit < inLen * 8 && outPos < outLen; bit++) {
+        code = (code << 1) | ((in[bit / 8] >> (7 - bit % 8)) & 1);
+        codeLen++;
+        for (int symbol = 0; symbol < HUFFMAN_TABLE_SIZE; symbol++) {
+            if (table[symbol].codeLen == codeLen && table[symbol].code >> (HUFFMAN_MAX_CODE_LEN - codeLen) == code) {
+                out[outPos++] = symbol;
+                code = 0;
+                codeLen = 0;
+                break;
+            }
+        }
+        if (codeLen > HUFFMAN_MAX_CODE_LEN) {
+            return -1;
+        }
+    }
+
+    return outPos;
+}
+
+// Kraft sum of a complete prefix code is exactly 1, scaled here by 2^HUFFMAN_MAX_CODE_LEN
+static void expectCompleteCanonicalCode(const huffmanTable_t *table)
+{
+    uint32_t kraftSum = 0;
+    for (int symbol = 0; symbol < HUFFMAN_TABLE_SIZE; symbol++) {
+        ASSERT_GE(table[symbol].codeLen, 1);
+        ASSERT_LE(table[symbol].codeLen, HUFFMAN_MAX_CODE_LEN);
+        kraftSum += 1 << (HUFFMAN_MAX_CODE_LEN - table[symbol].codeLen);
+    }
+    EXPECT_EQ(1u << HUFFMAN_MAX_CODE_LEN, kraftSum);
+
+    // Canonical: codes count up in order of length then symbol
+    uint16_t lastCode = 0;
+    bool first = true;
+    for (int len = 1; len <= HUFFMAN_MAX_CODE_LEN; len++) {
+        for (int symbol = 0; symbol < HUFFMAN_TABLE_SIZE; symbol++) {
+            if (table[symbol].codeLen == len) {
+                if (!first) {
+                    EXPECT_GT(table[symbol].code, lastCode);
+                }
+                EXPECT_EQ(0, table[symbol].code & ((1 << (HUFFMAN_MAX_CODE_LEN - len)) - 1));
+                lastCode = table[symbol].code;
+                first = false;
+            }
+        }
+    }
+}
+
+static uint32_t randomState = 1;
+
+static uint32_t randomNext(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+TEST(HuffmanBuildTableTest, EqualCounts)
+{
+    huffmanTable_t table[HUFFMAN_TABLE_SIZE];
+    uint16_t symbolCount[HUFFMAN_TABLE_SIZE] = { 0 };
+
+    huffmanBuildTable(table, symbolCount);
+    expectCompleteCanonicalCode(table);
+
+    // 257 equal weights: the first two symbols in order share one 8 bit code between them, the rest have their own
+    EXPECT_EQ(9, table[0].codeLen);
+    EXPECT_EQ(9, table[1].codeLen);
+    EXPECT_EQ(0xFF00, table[0].code);
+    EXPECT_EQ(0xFF80, table[1].code);
+    for (int symbol = 2; symbol < HUFFMAN_TABLE_SIZE; symbol++) {
+        EXPECT_EQ(8, table[symbol].codeLen);
+        EXPECT_EQ((symbol - 2) << 8, table[symbol].code);
+    }
+}
+
+TEST(HuffmanBuildTableTest, SkewedCountsAreLengthLimited)
+{
+    huffmanTable_t table[HUFFMAN_TABLE_SIZE];
+    uint16_t symbolCount[HUFFMAN_TABLE_SIZE] = { 0 };
+
+    // Fibonacci counts make the deepest possible tree
+    uint32_t a = 1, b = 1;
+    for (int symbol = 0; symbol < 24; symbol++) {
+        symbolCount[symbol] = MIN(a, (uint32_t)UINT16_MAX);
+        const uint32_t next = a + b;
+        a = b;
+        b = next;
+    }
+
+    huffmanBuildTable(table, symbolCount);
+    expectCompleteCanonicalCode(table);
+
+    // The most frequent symbol still has the shortest code
+    for (int symbol = 0; symbol < HUFFMAN_TABLE_SIZE; symbol++) {
+        EXPECT_LE(table[23].codeLen, table[symbol].codeLen);
+    }
+
+    // Erased flash, as the window before the end of a log can be
+    memset(symbolCount, 0, sizeof(symbolCount));
+    symbolCount[0xFF] = 4096;
+    huffmanBuildTable(table, symbolCount);
+    expectCompleteCanonicalCode(table);
+    EXPECT_EQ(1, table[0xFF].codeLen);
+}
+
+TEST(HuffmanBuildTableTest, RoundTrip)
+{
+    huffmanTable_t table[HUFFMAN_TABLE_SIZE];
+    uint16_t symbolCount[HUFFMAN_TABLE_SIZE] = { 0 };
+    uint8_t data[4096];
+
+    // Mostly small values, as VB encoded deltas are
+    for (unsigned i = 0; i < sizeof(data); i++) {
+        const uint32_t r = randomNext();
+        data[i] = (r & 0x300) ? r & 0x07 : r;
+        symbolCount[data[i]]++;
+    }
+
+    huffmanBuildTable(table, symbolCount);
+    expectCompleteCanonicalCode(table);
+
+    uint8_t compressed[sizeof(data)];
+    const int compressedLen = huffmanEncodeBuf(compressed, sizeof(compressed), data, sizeof(data), table);
+    ASSERT_GT(compressedLen, 0);
+    EXPECT_LT(compressedLen, (int)sizeof(data) * 3 / 4);
+
+    uint8_t decompressed[sizeof(data)];
+    EXPECT_EQ((int)sizeof(data), huffmanDecode(compressed, compressedLen, decompressed, sizeof(decompressed), table));
+    EXPECT_EQ(0, memcmp(data, decompressed, sizeof(data)));
+}
+
+/*
+ * Blackbox logs from a simulated flight, framed the way blackbox.c does: header lines, then an intra frame of
+ * absolute values every 32 frames and inter frames of deltas from the previous frame in between.
+ */
+
+static std::vector<uint8_t> blackboxLog;
+
+extern "C" {
+int32_t blackboxHeaderBudget;
+
+void blackboxWrite(uint8_t value)
+{
+    blackboxLog.push_back(value);
+}
+
+int blackboxWriteString(const char *s)
+{
+    const int length = strlen(s);
+    blackboxLog.insert(blackboxLog.end(), s, s + length);
+    return length;
+}
+}
+
+typedef struct flightProfile_s {
+    const char *name;
+    double stickAmplitude;  // deg/s of setpoint
+    double stickHz;
+    double gyroNoise;       // deg/s after filtering
+    double motorNoise;
+} flightProfile_t;
+
+static const flightProfile_t hoverFlight = { "hover", 20, 0.3, 0.5, 2 };
+static const flightProfile_t freestyleFlight = { "freestyle", 600, 1.5, 2, 8 };
+static const flightProfile_t noisyFlight = { "noisy", 300, 1.0, 8, 30 };
+
+#define LOG_FIELDS 26
+
+static double noise(double amplitude)
+{
+    return amplitude * ((randomNext() % 2001) / 1000.0 - 1.0);
+}
+
+// Noise through the gyro and motor lowpass filters
+static double filteredNoise(double *state, double amplitude)
+{
+    *state += 0.3 * (noise(amplitude * 2) - *state);
+    return *state;
+}
+
+static void makeBlackboxLog(const flightProfile_t *flight, int frames)
+{
+    blackboxLog.clear();
+    randomState = 1;
+
+    for (int i = 0; i < 150; i++) {
+        blackboxPrintfHeaderLine("Field I name", "loopIteration,time,axisP[%d],axisI[%d],axisD[%d],rcCommand[%d],gyroADC[%d],motor[%d]", i, i, i, i, i, i);
+    }
+
+    int32_t previous[LOG_FIELDS] = { 0 };
+    double gyro[3] = { 0 };
+    double gyroNoise[3] = { 0 };
+    double motorNoise[4] = { 0 };
+    double rc[4] = { 0 };
+    const double loopUs = 500;  // 2kHz logging
+
+    for (int frame = 0; frame < frames; frame++) {
+        const double t = frame * loopUs / 1e6;
+        int32_t values[LOG_FIELDS];
+
+        // The receiver updates the sticks at 250Hz
+        if (frame % 8 == 0) {
+            for (int axis = 0; axis < 3; axis++) {
+                rc[axis] = flight->stickAmplitude * sin(2 * M_PI * flight->stickHz * t + axis * 2.1) * (axis == 2 ? 0.4 : 1);
+            }
+            rc[3] = 1300 + flight->stickAmplitude / 3 * sin(2 * M_PI * 0.2 * t);
+        }
+
+        values[0] = frame;
+        values[1] = (int32_t)(frame * loopUs + noise(1.5));
+        for (int axis = 0; axis < 3; axis++) {
+            const double lastGyro = gyro[axis];
+            gyro[axis] += 0.05 * (rc[axis] - gyro[axis]);
+            const double measured = gyro[axis] + filteredNoise(&gyroNoise[axis], flight->gyroNoise);
+            values[2 + axis] = (int32_t)((rc[axis] - measured) * 0.5);             // axisP
+            values[5 + axis] = (int32_t)(rc[axis] * 0.1);                          // axisI
+            values[8 + axis] = (int32_t)((lastGyro - gyro[axis]) * 4);             // axisD
+            values[11 + axis] = (int32_t)(rc[axis] / 2);                           // rcCommand
+            values[14 + axis] = (int32_t)measured;                                 // gyroADC
+            values[17 + axis] = (int32_t)(2048 * (axis == 2) + gyro[axis] / 8);   // accSmooth
+        }
+        values[20] = (int32_t)rc[3];
+        for (int motor = 0; motor < 4; motor++) {
+            values[21 + motor] = values[20] + (int32_t)(values[2 + motor % 3] + filteredNoise(&motorNoise[motor], flight->motorNoise));
+        }
+        values[25] = 1600 - frame / 2000;      // vbat
+
+        if (frame % 32 == 0) {
+            blackboxWrite('I');
+            blackboxWriteUnsignedVB(values[0]);
+            blackboxWriteUnsignedVB(values[1]);
+            blackboxWriteSignedVBArray(values + 2, 9);
+            blackboxWriteSignedVBArray(values + 11, 3);
+            blackboxWriteUnsignedVB(values[20]);
+            blackboxWriteSignedVBArray(values + 14, 6);
+            blackboxWriteUnsignedVB(values[21] - 1000);
+            blackboxWriteSignedVBArray(values + 22, 3);
+            blackboxWriteUnsignedVB(values[25]);
+        } else {
+            int32_t deltas[LOG_FIELDS];
+            for (int i = 0; i < LOG_FIELDS; i++) {
+                deltas[i] = values[i] - previous[i];
+            }
+            blackboxWrite('P');
+            blackboxWriteSignedVB(deltas[1] - (int32_t)loopUs);
+            blackboxWriteSignedVBArray(values + 2, 3);
+            blackboxWriteTag2_3S32(deltas + 5);
+            blackboxWriteSignedVBArray(values + 8, 3);
+            int32_t rcDeltas[4] = { deltas[11], deltas[12], deltas[13], deltas[20] };
+            blackboxWriteTag8_4S16(rcDeltas);
+            blackboxWriteSignedVBArray(deltas + 14, 6);
+            blackboxWriteSignedVBArray(deltas + 21, 4);
+            blackboxWriteTag8_8SVB(deltas + 25, 1);
+        }
+
+        memcpy(previous, values, sizeof(previous));
+    }
+}
+
+static uint64_t benchmarkNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#define DATAFLASH_HUFFMAN_WINDOW_SIZE 4096
+#define DATAFLASH_READ_REPLY_INFO 9    // address, size, compression method and uncompressed size
+
+// Payload bytes of the replies that MSP_DATAFLASH_READ makes for the whole log, as serializeDataflashReadReply()
+// makes them. The first few replies are decoded to check them.
+static uint32_t compressDataflashReplies(const std::vector<uint8_t> &log, int payloadSize, bool adaptive)
+{
+    std::vector<uint8_t> out(payloadSize + 1);
+    std::vector<uint8_t> check(UINT16_MAX);
+    huffmanTable_t adaptiveTable[HUFFMAN_TABLE_SIZE];
+    uint32_t payloadTotal = 0;
+
+    for (size_t address = 0; address < log.size(); ) {
+        const huffmanTable_t *table = huffmanTable;
+        if (adaptive && address >= DATAFLASH_HUFFMAN_WINDOW_SIZE) {
+            uint16_t symbolCount[HUFFMAN_TABLE_SIZE] = { 0 };
+            for (size_t i = address - DATAFLASH_HUFFMAN_WINDOW_SIZE; i < address; i++) {
+                symbolCount[log[i]]++;
+            }
+            huffmanBuildTable(adaptiveTable, symbolCount);
+            table = adaptiveTable;
+        }
+
+        huffmanState_t state = {
+            .bytesWritten = 0,
+            .outByte = out.data(),
+            .outBufLen = (uint16_t)payloadSize,
+            .outBit = 0x80,
+        };
+        *state.outByte = 0;
+
+        uint16_t bytesReadTotal = 0;
+        while (state.bytesWritten < state.outBufLen && address + bytesReadTotal < log.size()
+            && bytesReadTotal <= UINT16_MAX - 256) {
+            const int bytesRead = MIN(256, (int)(log.size() - address - bytesReadTotal));
+            if (huffmanEncodeBufStreaming(&state, log.data() + address + bytesReadTotal, bytesRead, table) == -1) {
+                break;
+            }
+            bytesReadTotal += bytesRead;
+        }
+        if (state.outBit != 0x80) {
+            ++state.bytesWritten;
+        }
+
+        if (address < 64 * 1024) {
+            EXPECT_EQ(bytesReadTotal, huffmanDecode(out.data(), state.bytesWritten, check.data(), bytesReadTotal, table));
+            EXPECT_EQ(0, memcmp(check.data(), log.data() + address, bytesReadTotal));
+        }
+
+        payloadTotal += DATAFLASH_READ_REPLY_INFO + state.bytesWritten;
+        address += bytesReadTotal;
+    }
+
+    return payloadTotal;
+}
+
+typedef struct downloadLink_s {
+    const char *name;
+    double bytesPerUs;
+    double latencyUs;       // one way, including the host noticing the reply
+} downloadLink_t;
+
+static const downloadLink_t vcpLink = { "usb vcp", 0.8, 1000 };
+static const downloadLink_t uartLink = { "uart 921600", 0.092, 200 };
+
+#define DOWNLOAD_BYTES      (16 * 1024 * 1024)
+#define SERIAL_TASK_US      10000       // TASK_SERIAL runs at 100Hz, and answers one command per run
+#define MSP_REPLY_PAYLOAD   4096
+#define FLASH_READ_US_PER_BYTE 0.4      // 20MHz SPI
+
+/*
+ * Seconds to download the log, with replies covering ratio times their payload in flash. The serial task either
+ * only runs at its rate, or also runs as soon as a command is waiting and the last large reply has gone, as it does
+ * when disarmed.
+ */
+static double downloadSeconds(const downloadLink_t *link, double ratio, bool adaptive, int outstanding, bool eventDriven)
+{
+    const double flashPerReply = MSP_REPLY_PAYLOAD * ratio;
+    const double flashReadUs = (flashPerReply + (adaptive ? DATAFLASH_HUFFMAN_WINDOW_SIZE : 0)) * FLASH_READ_US_PER_BYTE;
+    const double frameUs = (MSP_REPLY_PAYLOAD + 20) / link->bytesPerUs;
+    double txFreeUs = 0;            // when the last reply has left the transmit buffer
+    double requestArrivesUs = link->latencyUs;
+    std::vector<double> replyReceivedUs;
+
+    for (double downloaded = 0; downloaded < DOWNLOAD_BYTES; downloaded += flashPerReply) {
+        // The serial task takes the next command once it has arrived and the last large reply has gone
+        const double readyUs = MAX(requestArrivesUs, txFreeUs);
+        const double taskRunsUs = eventDriven ? readyUs : ceil(readyUs / SERIAL_TASK_US) * SERIAL_TASK_US;
+        txFreeUs = taskRunsUs + flashReadUs + frameUs;
+        replyReceivedUs.push_back(txFreeUs + link->latencyUs);
+
+        // With several requests outstanding the next one was sent when the reply to one a few back arrived
+        const size_t replies = replyReceivedUs.size();
+        requestArrivesUs = (replies >= (size_t)outstanding ? replyReceivedUs[replies - outstanding] : 0) + link->latencyUs;
+    }
+
+    return replyReceivedUs.back() / 1e6;
+}
+
+TEST(HuffmanBenchmark, BlackboxLogs)
+{
+    const flightProfile_t *flights[] = { &hoverFlight, &freestyleFlight, &noisyFlight };
+    const downloadLink_t *links[] = { &vcpLink, &uartLink };
+    const char *tables[] = { "static", "adaptive" };
+
+    printf("%-10s %10s %10s %8s %10s\n", "log", "bytes", "table", "ratio", "host MB/s");
+    double ratio[ARRAYLEN(flights)][2];
+    for (unsigned f = 0; f < ARRAYLEN(flights); f++) {
+        makeBlackboxLog(flights[f], 60000);
+
+        for (int adaptive = 0; adaptive < 2; adaptive++) {
+            const uint64_t start = benchmarkNanos();
+            const uint32_t payloadBytes = compressDataflashReplies(blackboxLog, MSP_REPLY_PAYLOAD, adaptive);
+            const double seconds = (benchmarkNanos() - start) / 1e9;
+
+            ratio[f][adaptive] = (double)blackboxLog.size() / payloadBytes;
+            printf("%-10s %10u %10s %8.2f %10.1f\n", flights[f]->name, (unsigned)blackboxLog.size(), tables[adaptive],
+                ratio[f][adaptive], blackboxLog.size() / seconds / 1e6);
+        }
+
+        EXPECT_GT(ratio[f][1], ratio[f][0]);
+    }
+
+    // Download time of 16MB of each log
+    printf("\n%-12s %10s %10s %12s %12s %12s\n", "link", "log", "table", "periodic", "1 request", "4 requests");
+    for (unsigned l = 0; l < ARRAYLEN(links); l++) {
+        for (unsigned f = 0; f < ARRAYLEN(flights); f++) {
+            double pipelined[2];
+            double before = 0;
+            for (int adaptive = 0; adaptive < 2; adaptive++) {
+                const double periodic = downloadSeconds(links[l], ratio[f][adaptive], adaptive, 1, false);
+                const double single = downloadSeconds(links[l], ratio[f][adaptive], adaptive, 1, true);
+                pipelined[adaptive] = downloadSeconds(links[l], ratio[f][adaptive], adaptive, 4, true);
+                printf("%-12s %10s %10s %11.1fs %11.1fs %11.1fs\n", links[l]->name, flights[f]->name, tables[adaptive],
+                    periodic, single, pipelined[adaptive]);
+
+                EXPECT_LE(single, periodic);
+                EXPECT_LE(pipelined[adaptive], single);
+                if (!adaptive) {
+                    // one request at a time answered at the task rate, as downloads were made before
+                    before = periodic;
+                }
+            }
+
+            // The table costs a read of the window before each reply, which the better ratio has to make up for
+            if (f == 0) {
+                EXPECT_LT(pipelined[1], pipelined[0]);
+            }
+            EXPECT_LT(MIN(pipelined[0], pipelined[1]), before);
+        }
+    }
+}
@@ -61,6 +61,8 @@ extern "C" {
 
     #include "rx/rx.h"
 
+    #include "scheduler/scheduler.h"
+
     #include "sensors/battery.h"
 
     attitudeEulerAngles_t attitude;
@@ -406,6 +408,10 @@ extern "C" {
         return simulationTime;
     }
 
+    timeDelta_t getTaskTimeBudgetUs(void) {
+        return TASK_TIME_BUDGET_UNLIMITED_US;
+    }
+
     uint32_t microsISR() {
         return micros();
     }
@@ -0,0 +1,437 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "cli/settings.h"
+    #include "cli/settings_index.h"
+
+    #include "common/streambuf.h"
+    #include "common/utils.h"
+
+    #include "config/config.h"
+
+    #include "fc/controlrate_profile.h"
+    #include "fc/rc_controls.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/pid.h"
+
+    #include "msp/msp.h"
+    #include "msp/msp_settings.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+
+    typedef struct testSettings_s {
+        uint8_t u8;
+        int16_t i16;
+        uint32_t u32;
+        uint8_t lookup;
+        uint16_t bits;
+        int16_t array[3];
+        char name[9];
+        char serial[9];
+    } testSettings_t;
+
+    PG_DECLARE(testSettings_t, testSettings);
+    PG_REGISTER(testSettings_t, testSettings, PG_RESERVED_FOR_TESTING_1, 0);
+    PG_REGISTER_ARRAY(pidProfile_t, PID_PROFILE_COUNT, pidProfiles, PG_PID_PROFILE, 0);
+    PG_REGISTER_ARRAY(controlRateConfig_t, CONTROL_RATE_PROFILE_COUNT, controlRateProfiles, PG_CONTROL_RATE_PROFILES, 0);
+
+    const clivalue_t valueTable[] = {
+        { "test_u8",        VAR_UINT8  | MASTER_VALUE, .config.minmaxUnsigned = { 10, 200 }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, u8) },
+        { "test_i16",       VAR_INT16  | MASTER_VALUE, .config.minmax = { -500, 500 }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, i16) },
+        { "test_u32",       VAR_UINT32 | MASTER_VALUE, .config.u32Max = 100000, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, u32) },
+        { "test_lookup",    VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, lookup) },
+        { "test_bit",       VAR_UINT16 | MASTER_VALUE | MODE_BITSET, .config.bitpos = 9, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, bits) },
+        { "test_array",     VAR_INT16  | MASTER_VALUE | MODE_ARRAY, .config.array.length = 3, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, array) },
+        { "test_name",      VAR_UINT8  | MASTER_VALUE | MODE_STRING, .config.string = { 1, 8, STRING_FLAGS_NONE }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, name) },
+        { "test_serial",    VAR_UINT8  | MASTER_VALUE | MODE_STRING, .config.string = { 1, 8, STRING_FLAGS_WRITEONCE }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, serial) },
+        { "pidsum_limit",   VAR_UINT16 | PROFILE_VALUE, .config.minmaxUnsigned = { 100, 1000 }, PG_PID_PROFILE, offsetof(pidProfile_t, pidSumLimit) },
+        { "roll_rc_rate",   VAR_UINT8  | PROFILE_RATE_VALUE, .config.minmaxUnsigned = { 1, CONTROL_RATE_CONFIG_RC_RATES_MAX }, PG_CONTROL_RATE_PROFILES, offsetof(controlRateConfig_t, rcRates[FD_ROLL]) },
+    };
+    const uint16_t valueTableEntryCount = ARRAYLEN(valueTable);
+    uint16_t settingIndex[SETTING_INDEX_SIZE(ARRAYLEN(valueTable))];
+    const uint16_t settingIndexSize = ARRAYLEN(settingIndex);
+
+    static const char * const lookupTableOffOn[] = { "OFF", "ON" };
+    const lookupTableEntry_t lookupTables[LOOKUP_TABLE_COUNT] = {
+        { lookupTableOffOn, ARRAYLEN(lookupTableOffOn) },
+    };
+
+    static uint8_t currentPidProfileIndex;
+    static int initRcProcessingCount;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define SETTING_U8      0
+#define SETTING_I16     1
+#define SETTING_U32     2
+#define SETTING_LOOKUP  3
+#define SETTING_BIT     4
+#define SETTING_ARRAY   5
+#define SETTING_NAME    6
+#define SETTING_SERIAL  7
+#define SETTING_PIDSUM  8
+#define SETTING_RC_RATE 9
+
+static uint8_t requestBuffer[256];
+static uint8_t replyBuffer[256];
+static sbuf_t request;
+static sbuf_t reply;
+
+static void startRequest(uint32_t schemaHash, uint8_t addressing)
+{
+    sbufInit(&request, requestBuffer, requestBuffer + sizeof(requestBuffer));
+    sbufWriteU32(&request, schemaHash);
+    sbufWriteU8(&request, addressing);
+}
+
+static void addValue(int index, const void *data, uint8_t size)
+{
+    sbufWriteU16(&request, index);
+    sbufWriteU8(&request, size);
+    sbufWriteData(&request, data, size);
+}
+
+// turns the written request around for reading, and gives the reply the given room
+static void finishRequest(int replySize)
+{
+    sbufSwitchToReader(&request, requestBuffer);
+    sbufInit(&reply, replyBuffer, replyBuffer + replySize);
+}
+
+static void startReading(void)
+{
+    sbufSwitchToReader(&reply, replyBuffer);
+}
+
+static void resetSettings(void)
+{
+    memset(testSettingsMutable(), 0, sizeof(testSettings_t));
+    memset(pidProfilesMutable(0), 0, sizeof(pidProfile_t) * PID_PROFILE_COUNT);
+    memset(controlRateProfilesMutable(0), 0, sizeof(controlRateConfig_t) * CONTROL_RATE_PROFILE_COUNT);
+    currentPidProfileIndex = 0;
+    armingFlags = 0;
+    initRcProcessingCount = 0;
+}
+
+TEST(MspSettingsTest, InfoDescribesTable)
+{
+    sbufInit(&request, requestBuffer, requestBuffer);
+    sbufInit(&reply, replyBuffer, replyBuffer + sizeof(replyBuffer));
+    mspSettingsInfo(&request, &reply);
+    startReading();
+
+    EXPECT_EQ(settingsSchemaHash(), sbufReadU32(&reply));
+    EXPECT_EQ(valueTableEntryCount, sbufReadU16(&reply));
+    EXPECT_EQ(0, sbufReadU16(&reply));
+    EXPECT_EQ(valueTableEntryCount, sbufReadU8(&reply));
+
+    const uint8_t expectedSizes[] = { 1, 2, 4, 1, 1, 6, 8, 8, 2, 1 };
+    for (int i = 0; i < valueTableEntryCount; i++) {
+        EXPECT_EQ(valueTable[i].type, sbufReadU8(&reply));
+        EXPECT_EQ(expectedSizes[i], sbufReadU8(&reply));
+        const uint8_t nameLength = sbufReadU8(&reply);
+        char name[32] = "";
+        sbufReadData(&reply, name, nameLength);
+        sbufAdvance(&reply, nameLength);
+        EXPECT_STREQ(valueTable[i].name, name);
+    }
+    EXPECT_EQ(0, sbufBytesRemaining(&reply));
+}
+
+TEST(MspSettingsTest, InfoContinuesFromIndex)
+{
+    // room for the header and two entries of 10 character names
+    sbufInit(&request, requestBuffer, requestBuffer + sizeof(requestBuffer));
+    sbufWriteU16(&request, SETTING_I16);
+    sbufSwitchToReader(&request, requestBuffer);
+    sbufInit(&reply, replyBuffer, replyBuffer + 9 + 2 * 11 + 5);
+    mspSettingsInfo(&request, &reply);
+    startReading();
+
+    sbufReadU32(&reply);
+    sbufReadU16(&reply);
+    EXPECT_EQ(SETTING_I16, sbufReadU16(&reply));
+    EXPECT_EQ(2, sbufReadU8(&reply));
+}
+
+TEST(MspSettingsTest, GetByIndex)
+{
+    resetSettings();
+    testSettingsMutable()->u8 = 42;
+    testSettingsMutable()->i16 = -321;
+    testSettingsMutable()->bits = 1 << 9;
+    strcpy(testSettingsMutable()->name, "quad");
+
+    startRequest(settingsSchemaHash(), MSP_SETTINGS_BY_INDEX);
+    sbufWriteU16(&request, SETTING_U8);
+    sbufWriteU16(&request, SETTING_I16);
+    sbufWriteU16(&request, 500);
+    sbufWriteU16(&request, SETTING_BIT);
+    sbufWriteU16(&request, SETTING_NAME);
+    finishRequest(sizeof(replyBuffer));
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsGet(&request, &reply));
+    startReading();
+
+    EXPECT_EQ(settingsSchemaHash(), sbufReadU32(&reply));
+    EXPECT_EQ(5, sbufReadU8(&reply));
+
+    EXPECT_EQ(SETTING_U8, sbufReadU16(&reply));
+    EXPECT_EQ(1, sbufReadU8(&reply));
+    EXPECT_EQ(42, sbufReadU8(&reply));
+
+    EXPECT_EQ(SETTING_I16, sbufReadU16(&reply));
+    EXPECT_EQ(2, sbufReadU8(&reply));
+    EXPECT_EQ(-321, (int16_t)sbufReadU16(&reply));
+
+    EXPECT_EQ(MSP_SETTING_UNKNOWN, sbufReadU16(&reply));
+    EXPECT_EQ(0, sbufReadU8(&reply));
+
+    EXPECT_EQ(SETTING_BIT, sbufReadU16(&reply));
+    EXPECT_EQ(1, sbufReadU8(&reply));
+    EXPECT_EQ(1, sbufReadU8(&reply));
+
+    EXPECT_EQ(SETTING_NAME, sbufReadU16(&reply));
+    EXPECT_EQ(8, sbufReadU8(&reply));
+    char name[8];
+    sbufReadData(&reply, name, sizeof(name));
+    sbufAdvance(&reply, sizeof(name));
+    EXPECT_EQ(0, memcmp("quad\0\0\0\0", name, sizeof(name)));
+
+    EXPECT_EQ(0, sbufBytesRemaining(&reply));
+}
+
+TEST(MspSettingsTest, GetByHash)
+{
+    resetSettings();
+    testSettingsMutable()->u32 = 99999;
+
+    startRequest(0, MSP_SETTINGS_BY_HASH);
+    sbufWriteU32(&request, settingNameHash("TEST_U32", 8));
+    sbufWriteU32(&request, settingNameHash("test_u3", 7));
+    finishRequest(sizeof(replyBuffer));
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsGet(&request, &reply));
+    startReading();
+
+    sbufReadU32(&reply);
+    EXPECT_EQ(2, sbufReadU8(&reply));
+    EXPECT_EQ(SETTING_U32, sbufReadU16(&reply));
+    EXPECT_EQ(4, sbufReadU8(&reply));
+    EXPECT_EQ(99999u, sbufReadU32(&reply));
+    EXPECT_EQ(MSP_SETTING_UNKNOWN, sbufReadU16(&reply));
+}
+
+TEST(MspSettingsTest, GetStopsWhenReplyIsFull)
+{
+    resetSettings();
+
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    for (int i = 0; i < 6; i++) {
+        sbufWriteU16(&request, SETTING_U8);
+    }
+    // schema hash and count, then three settings of 4 bytes
+    finishRequest(5 + 3 * 4 + 3);
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsGet(&request, &reply));
+    startReading();
+
+    sbufReadU32(&reply);
+    EXPECT_EQ(3, sbufReadU8(&reply));
+    EXPECT_EQ(3 * 2, sbufBytesRemaining(&request));
+}
+
+TEST(MspSettingsTest, SetAppliesAll)
+{
+    resetSettings();
+    testSettingsMutable()->bits = 0x0003;
+
+    const uint8_t u8 = 150;
+    const int16_t i16 = -500;
+    const uint32_t u32 = 100000;
+    const uint8_t on = 1;
+    const int16_t array[3] = { 1, -2, 3 };
+    const char name[8] = "quad";
+
+    startRequest(settingsSchemaHash(), MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_U8, &u8, sizeof(u8));
+    addValue(SETTING_I16, &i16, sizeof(i16));
+    addValue(SETTING_U32, &u32, sizeof(u32));
+    addValue(SETTING_LOOKUP, &on, sizeof(on));
+    addValue(SETTING_BIT, &on, sizeof(on));
+    addValue(SETTING_ARRAY, array, sizeof(array));
+    addValue(SETTING_NAME, name, sizeof(name));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSet(&request));
+
+    EXPECT_EQ(150, testSettings()->u8);
+    EXPECT_EQ(-500, testSettings()->i16);
+    EXPECT_EQ(100000u, testSettings()->u32);
+    EXPECT_EQ(1, testSettings()->lookup);
+    EXPECT_EQ(0x0203, testSettings()->bits);
+    EXPECT_EQ(-2, testSettings()->array[1]);
+    EXPECT_STREQ("quad", testSettings()->name);
+}
+
+TEST(MspSettingsTest, SetRejectsWholeFrame)
+{
+    resetSettings();
+
+    const uint8_t u8 = 150;
+    const uint8_t badLookup = 2;
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_U8, &u8, sizeof(u8));
+    addValue(SETTING_LOOKUP, &badLookup, sizeof(badLookup));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ERROR, mspSettingsSet(&request));
+    EXPECT_EQ(0, testSettings()->u8);
+
+    const uint8_t tooSmall = 9;
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_U8, &tooSmall, sizeof(tooSmall));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ERROR, mspSettingsSet(&request));
+
+    // wrong size for the setting
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_I16, &u8, sizeof(u8));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ERROR, mspSettingsSet(&request));
+
+    // cut short
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_U8, &u8, sizeof(u8));
+    sbufWriteU16(&request, SETTING_I16);
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ERROR, mspSettingsSet(&request));
+    EXPECT_EQ(0, testSettings()->u8);
+}
+
+TEST(MspSettingsTest, SetFailsWhenArmed)
+{
+    resetSettings();
+    ENABLE_ARMING_FLAG(ARMED);
+
+    const uint8_t u8 = 150;
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_U8, &u8, sizeof(u8));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ERROR, mspSettingsSet(&request));
+    EXPECT_EQ(0, testSettings()->u8);
+}
+
+TEST(MspSettingsTest, SetChecksSchema)
+{
+    resetSettings();
+
+    const uint8_t u8 = 150;
+    startRequest(settingsSchemaHash() + 1, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_U8, &u8, sizeof(u8));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ERROR, mspSettingsSet(&request));
+    EXPECT_EQ(0, testSettings()->u8);
+
+    startRequest(0, MSP_SETTINGS_BY_HASH);
+    sbufWriteU32(&request, settingNameHash("test_u8", 7));
+    sbufWriteU8(&request, sizeof(u8));
+    sbufWriteU8(&request, u8);
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSet(&request));
+    EXPECT_EQ(150, testSettings()->u8);
+}
+
+TEST(MspSettingsTest, WriteOnceString)
+{
+    resetSettings();
+
+    const char first[8] = "abc";
+    const char second[8] = "xyz";
+
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_SERIAL, first, sizeof(first));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSet(&request));
+
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_SERIAL, second, sizeof(second));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ERROR, mspSettingsSet(&request));
+
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_SERIAL, first, sizeof(first));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSet(&request));
+
+    EXPECT_STREQ("abc", testSettings()->serial);
+}
+
+TEST(MspSettingsTest, ProfileSettingsUseCurrentProfile)
+{
+    resetSettings();
+    currentPidProfileIndex = 1;
+
+    const uint16_t limit = 700;
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_PIDSUM, &limit, sizeof(limit));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSet(&request));
+
+    EXPECT_EQ(0, pidProfiles(0)->pidSumLimit);
+    EXPECT_EQ(700, pidProfiles(1)->pidSumLimit);
+}
+
+TEST(MspSettingsTest, RateProfileSettingsUpdateRates)
+{
+    resetSettings();
+
+    const uint16_t limit = 700;
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_PIDSUM, &limit, sizeof(limit));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSet(&request));
+    EXPECT_EQ(0, initRcProcessingCount);
+
+    // the rates curves are tabulated, the table has to be rebuilt for the new rate to fly
+    const uint8_t rcRate = 120;
+    startRequest(0, MSP_SETTINGS_BY_INDEX);
+    addValue(SETTING_RC_RATE, &rcRate, sizeof(rcRate));
+    finishRequest(0);
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSet(&request));
+
+    EXPECT_EQ(120, controlRateProfiles(0)->rcRates[FD_ROLL]);
+    EXPECT_EQ(1, initRcProcessingCount);
+}
+
+// STUBS
+
+extern "C" {
+uint8_t armingFlags;
+uint8_t getCurrentPidProfileIndex(void) { return currentPidProfileIndex; }
+uint8_t getCurrentControlRateProfileIndex(void) { return 0; }
+void initRcProcessing(void) { initRcProcessingCount++; }
+}
@@ -60,9 +60,12 @@ extern "C" {
     #include "sensors/battery.h"
 
     #include "rx/rx.h"
+
+    #include "scheduler/scheduler.h"
     #include "flight/mixer.h"
 
     void osdRefresh(timeUs_t currentTimeUs);
+    extern osdDrawState_e osdDrawState;
     void osdFormatTime(char * buff, osd_timer_precision_e precision, timeUs_t time);
     int osdConvertTemperatureToSelectedUnit(int tempInDegreesCelcius);
 
@@ -93,6 +96,7 @@ extern "C" {
     PG_REGISTER(gpsConfig_t, gpsConfig, PG_GPS_CONFIG, 0);
     
     timeUs_t simulationTime = 0;
+    timeDelta_t simulationTaskTimeBudgetUs = TASK_TIME_BUDGET_UNLIMITED_US;
     batteryState_e simulationBatteryState;
     uint8_t simulationBatteryCellCount;
     uint16_t simulationBatteryVoltage;
@@ -721,6 +725,186 @@ TEST_F(OsdTest, TestElementRssi)
     displayPortTestBufferSubstring(8, 1, "%c50", SYM_RSSI);
 }
 
+/*
+ * Tests that a refresh only writes the characters that changed.
+ */
+TEST_F(OsdTest, TestElementsOnlyWriteChanges)
+{
+    // given
+    osdElementConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(8, 1) | OSD_PROFILE_1_FLAG;
+    osdConfigMutable()->rssi_alarm = 0;
+
+    osdAnalyzeActiveElements();
+
+    rssi = 1024;
+    displayClearScreen(&testDisplayPort);
+    osdRefresh(simulationTime);
+
+    // when
+    testDisplayPortWriteCount = 0;
+    osdRefresh(simulationTime);
+
+    // then
+    EXPECT_EQ(0, testDisplayPortWriteCount);
+    displayPortTestBufferSubstring(8, 1, "%c99", SYM_RSSI);
+
+    // when
+    rssi = 512;
+    osdRefresh(simulationTime);
+
+    // then
+    EXPECT_EQ(1, testDisplayPortWriteCount);
+    displayPortTestBufferSubstring(8, 1, "%c50", SYM_RSSI);
+
+    // when
+    osdElementConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(8, 2) | OSD_PROFILE_1_FLAG;
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(8, 1, "   ");
+    displayPortTestBufferSubstring(8, 2, "%c50", SYM_RSSI);
+}
+
+/*
+ * Tests that a grid larger than the OSD screen buffer is drawn directly rather than clipped.
+ */
+TEST_F(OsdTest, TestElementsLargeGridDrawnDirectly)
+{
+    // given
+    osdElementConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(8, 1) | OSD_PROFILE_1_FLAG;
+    osdConfigMutable()->rssi_alarm = 0;
+    testDisplayPort.rows = UNITTEST_DISPLAYPORT_ROWS + 1;
+
+    osdAnalyzeActiveElements();
+
+    rssi = 1024;
+    displayClearScreen(&testDisplayPort);
+    osdRefresh(simulationTime);
+
+    // when
+    testDisplayPortWriteCount = 0;
+    osdRefresh(simulationTime);
+
+    // then
+    EXPECT_LT(0, testDisplayPortWriteCount);
+    displayPortTestBufferSubstring(8, 1, "%c99", SYM_RSSI);
+
+    testDisplayPort.rows = UNITTEST_DISPLAYPORT_ROWS;
+}
+
+/*
+ * Tests that the elements are drawn over several calls when the scheduler gives the OSD too little time.
+ */
+TEST_F(OsdTest, TestElementsDrawnOverSeveralCalls)
+{
+    // given
+    osdElementConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(8, 1) | OSD_PROFILE_1_FLAG;
+    osdElementConfigMutable()->item_pos[OSD_CRAFT_NAME] = OSD_POS(1, 2) | OSD_PROFILE_1_FLAG;
+    osdConfigMutable()->rssi_alarm = 0;
+    strcpy(pilotConfigMutable()->name, "SLICES");
+
+    osdAnalyzeActiveElements();
+
+    rssi = 1024;
+    displayClearScreen(&testDisplayPort);
+    simulationTaskTimeBudgetUs = 0;
+
+    osdDrawSliceInfo_t sliceInfoBefore;
+    osdGetDrawSliceInfo(&sliceInfoBefore);
+
+    // when
+    osdRefresh(simulationTime);
+
+    // then
+    // nothing is written until all the elements have been drawn
+    displayPortTestBufferSubstring(8, 1, "   ");
+
+    // when
+    for (int i = 0; i < OSD_ITEM_COUNT; i++) {
+        osdUpdate(simulationTime);
+    }
+
+    // then
+    displayPortTestBufferSubstring(8, 1, "%c99", SYM_RSSI);
+    displayPortTestBufferSubstring(1, 2, "SLICES");
+
+    osdDrawSliceInfo_t sliceInfo;
+    osdGetDrawSliceInfo(&sliceInfo);
+    EXPECT_EQ(0, sliceInfo.budgetUs);
+    EXPECT_LT(sliceInfoBefore.sliceCount + 2, sliceInfo.sliceCount);
+
+    simulationTaskTimeBudgetUs = TASK_TIME_BUDGET_UNLIMITED_US;
+    osdElementConfigMutable()->item_pos[OSD_CRAFT_NAME] = 0;
+    osdAnalyzeActiveElements();
+}
+
+/*
+ * Tests that the stats are counted and drawn over several calls when the scheduler gives the OSD too little time.
+ */
+TEST_F(OsdTest, TestStatsDrawnOverSeveralCalls)
+{
+    // given
+    setupStats();
+    osdStatSetState(OSD_STAT_RTC_DATE_TIME, false);
+    osdConfigMutable()->units = UNIT_METRIC;
+
+    doTestArm(false);
+    simulateFlight();
+
+    simulationTaskTimeBudgetUs = 0;
+
+    // when
+    // the craft is disarmed
+    DISABLE_ARMING_FLAG(ARMED);
+    osdRefresh(simulationTime);
+
+    // then
+    // the pass counting the rows stops after the first one
+    EXPECT_EQ(OSD_DRAW_STATS, osdDrawState);
+
+    // when
+    int calls = 0;
+    while (osdDrawState != OSD_DRAW_IDLE && calls < 2 * OSD_STAT_COUNT) {
+        osdUpdate(simulationTime);
+        calls++;
+    }
+
+    // then
+    // one row per call, seven calls counting the rows and seven more drawing them centred
+    EXPECT_EQ(OSD_DRAW_IDLE, osdDrawState);
+    EXPECT_EQ(2 * 7, calls);
+
+    int row = 4;
+    displayPortTestBufferSubstring(2, row++, "  --- STATS ---");
+    displayPortTestBufferSubstring(2, row++, "MAX ALTITUDE      : 2.0%c", SYM_M);
+    displayPortTestBufferSubstring(2, row++, "MAX SPEED         : 28");
+    displayPortTestBufferSubstring(2, row++, "MAX DISTANCE      : 1.15%c", SYM_KM);
+    displayPortTestBufferSubstring(2, row++, "FLIGHT DISTANCE   : 10.5%c", SYM_KM);
+    displayPortTestBufferSubstring(2, row++, "MIN BATTERY       : 14.70%c", SYM_VOLT);
+    displayPortTestBufferSubstring(2, row++, "END BATTERY       : 15.20%c", SYM_VOLT);
+    displayPortTestBufferSubstring(2, row++, "MIN RSSI          : 25%%");
+
+    char slicedScreen[UNITTEST_DISPLAYPORT_BUFFER_LEN];
+    memcpy(slicedScreen, testDisplayPortBuffer, sizeof(slicedScreen));
+
+    // when
+    // the stats are refreshed in a single pass
+    simulationTaskTimeBudgetUs = TASK_TIME_BUDGET_UNLIMITED_US;
+    simulationTime += 1e6;
+    osdRefresh(simulationTime);
+
+    // then
+    EXPECT_EQ(OSD_DRAW_IDLE, osdDrawState);
+    EXPECT_EQ(0, memcmp(slicedScreen, testDisplayPortBuffer, sizeof(slicedScreen)));
+
+    // dismiss the stats so the elements are drawn again
+    rcData[PITCH] = 1800;
+    osdRefresh(simulationTime);
+    rcData[PITCH] = 1500;
+    osdRefresh(simulationTime);
+    osdStatSetState(OSD_STAT_RTC_DATE_TIME, true);
+}
+
 /*
  * Tests the instantaneous battery current OSD element.
  */
@@ -1148,6 +1332,10 @@ extern "C" {
         return simulationTime;
     }
 
+    timeDelta_t getTaskTimeBudgetUs(void) {
+        return simulationTaskTimeBudgetUs;
+    }
+
     uint32_t millis() {
         return micros() / 1000;
     }
@@ -112,6 +112,15 @@ typedef struct
 #define MCU_TYPE_ID   99
 #define MCU_TYPE_NAME "UNIT_TEST"
 
+#if defined(CONFIG_IN_RAM)
+#ifndef EEPROM_SIZE
+#define EEPROM_SIZE     4096
+#endif
+extern uint8_t eepromData[EEPROM_SIZE];
+#define __config_start (*eepromData)
+#define __config_end (*ARRAYEND(eepromData))
+#endif
+
 #include "target.h"
 
 #include "target/common_defaults_post.h"
@@ -193,9 +193,10 @@ TEST_F(RcControlsModesTest, updateActivatedModesUsingValidAuxConfigurationAndRXV
 
 enum {
     COUNTER_QUEUE_CONFIRMATION_BEEP,
-    COUNTER_CHANGE_CONTROL_RATE_PROFILE
+    COUNTER_CHANGE_CONTROL_RATE_PROFILE,
+    COUNTER_RC_RATES_TABLE_UPDATE
 };
-#define CALL_COUNT_ITEM_COUNT 2
+#define CALL_COUNT_ITEM_COUNT 3
 
 static int callCounts[CALL_COUNT_ITEM_COUNT];
 
@@ -214,6 +215,10 @@ void changeControlRateProfile(uint8_t) {
     callCounts[COUNTER_CHANGE_CONTROL_RATE_PROFILE]++;
 }
 
+void rcRatesTableUpdate(void) {
+    callCounts[COUNTER_RC_RATES_TABLE_UPDATE]++;
+}
+
 }
 
 void resetCallCounters(void) {
@@ -401,6 +406,7 @@ TEST_F(RcControlsAdjustmentsTest, processRcAdjustmentsWithRcRateFunctionSwitchUp
     EXPECT_EQ(91, controlRateConfig.rcRates[FD_ROLL]);
     EXPECT_EQ(91, controlRateConfig.rcRates[FD_PITCH]);
     EXPECT_EQ(1, CALL_COUNTER(COUNTER_QUEUE_CONFIRMATION_BEEP));
+    EXPECT_EQ(1, CALL_COUNTER(COUNTER_RC_RATES_TABLE_UPDATE));
     EXPECT_FALSE(adjustmentState->ready);
 
     //
@@ -585,6 +591,7 @@ TEST_F(RcControlsAdjustmentsTest, processPIDIncreasePidController0)
 
     // then
     EXPECT_EQ(6, CALL_COUNTER(COUNTER_QUEUE_CONFIRMATION_BEEP));
+    EXPECT_EQ(0, CALL_COUNTER(COUNTER_RC_RATES_TABLE_UPDATE));
     EXPECT_FALSE(adjustmentState1->ready);
     EXPECT_FALSE(adjustmentState2->ready);
     EXPECT_FALSE(adjustmentState3->ready);
@@ -0,0 +1,271 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cmath>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+    #include "pg/rx.h"
+
+    #include "fc/controlrate_profile.h"
+    #include "fc/rc.h"
+    #include "fc/rc_controls.h"
+    #include "fc/rc_modes.h"
+
+    #include "flight/imu.h"
+    #include "flight/pid.h"
+
+    #include "rx/rx.h"
+
+    #include "sensors/battery.h"
+
+    typedef float (applyRatesFn)(const int axis, float rcCommandf, const float rcCommandfAbs);
+
+    float applyBetaflightRates(const int axis, float rcCommandf, const float rcCommandfAbs);
+    float applyRaceFlightRates(const int axis, float rcCommandf, const float rcCommandfAbs);
+    float applyKissRates(const int axis, float rcCommandf, const float rcCommandfAbs);
+    float applyActualRates(const int axis, float rcCommandf, const float rcCommandfAbs);
+    float applyQuickRates(const int axis, float rcCommandf, const float rcCommandfAbs);
+    float applyRatesTable(const int axis, float rcCommandf, const float rcCommandfAbs);
+    uint32_t rcRatesTableExactSegments(int axis);
+
+    PG_REGISTER(rxConfig_t, rxConfig, PG_RX_CONFIG, 0);
+    PG_REGISTER(rcControlsConfig_t, rcControlsConfig, PG_RC_CONTROLS_CONFIG, 0);
+    PG_REGISTER(flight3DConfig_t, flight3DConfig, PG_MOTOR_3D_CONFIG, 0);
+
+    controlRateConfig_t testControlRateProfile;
+    controlRateConfig_t *currentControlRateProfile = &testControlRateProfile;
+
+    int16_t debug[DEBUG16_VALUE_COUNT];
+    uint8_t debugMode;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_VALUE_TOLERANCE    0.5f    // deg/s
+#define TEST_SLOPE_TOLERANCE    0.03f   // relative
+#define TEST_SLOPE_MIN          10.0f   // deg/s per full deflection
+#define TEST_SLOPE_STEP         0.001f
+#define TEST_DEFLECTION_STEPS   1000
+
+static const struct {
+    ratesType_e type;
+    applyRatesFn *curve;
+} ratesTypes[] = {
+    { RATES_TYPE_BETAFLIGHT, applyBetaflightRates },
+    { RATES_TYPE_RACEFLIGHT, applyRaceFlightRates },
+    { RATES_TYPE_KISS, applyKissRates },
+    { RATES_TYPE_ACTUAL, applyActualRates },
+    { RATES_TYPE_QUICK, applyQuickRates },
+};
+
+static float exactCurve(applyRatesFn *curve, float deflection)
+{
+    return curve(FD_ROLL, deflection, fabsf(deflection));
+}
+
+static void setRates(ratesType_e type, uint8_t rcRate, uint8_t rcExpo, uint8_t rate, bool quickRatesRcExpo)
+{
+    memset(&testControlRateProfile, 0, sizeof(testControlRateProfile));
+    testControlRateProfile.rates_type = type;
+    testControlRateProfile.quickRatesRcExpo = quickRatesRcExpo;
+    for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+        testControlRateProfile.rcRates[axis] = rcRate;
+        testControlRateProfile.rcExpo[axis] = rcExpo;
+        testControlRateProfile.rates[axis] = rate;
+        testControlRateProfile.rate_limit[axis] = CONTROL_RATE_CONFIG_RATE_LIMIT_MAX;
+    }
+    initRcProcessing();
+}
+
+class RcRatesTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        pgResetAll();
+    }
+};
+
+TEST_F(RcRatesTest, TestTableMatchesCurves)
+{
+    // sweep every rates type across the whole configurable range, including the
+    // settings that drive the curves into their constrainf() limits mid-stick
+    for (unsigned i = 0; i < ARRAYLEN(ratesTypes); i++) {
+        float worstError = 0;
+        for (int rcRate = 5; rcRate <= CONTROL_RATE_CONFIG_RC_RATES_MAX; rcRate += 50) {
+            for (int rcExpo = 0; rcExpo <= CONTROL_RATE_CONFIG_RC_EXPO_MAX; rcExpo += 25) {
+                for (int rate = 0; rate <= CONTROL_RATE_CONFIG_RATE_MAX; rate += 30) {
+                    for (int quickRatesRcExpo = 0; quickRatesRcExpo <= 1; quickRatesRcExpo++) {
+                        setRates(ratesTypes[i].type, rcRate, rcExpo, rate, quickRatesRcExpo);
+
+                        for (int step = -TEST_DEFLECTION_STEPS; step <= TEST_DEFLECTION_STEPS; step++) {
+                            const float deflection = (float)step / TEST_DEFLECTION_STEPS;
+                            const float error = fabsf(applyRatesTable(FD_ROLL, deflection, fabsf(deflection)) - exactCurve(ratesTypes[i].curve, deflection));
+                            worstError = MAX(worstError, error);
+                        }
+                    }
+                }
+            }
+        }
+        EXPECT_LE(worstError, TEST_VALUE_TOLERANCE) << "rates type " << ratesTypes[i].type;
+    }
+}
+
+TEST_F(RcRatesTest, TestTableSlopeMatchesCurves)
+{
+    for (unsigned i = 0; i < ARRAYLEN(ratesTypes); i++) {
+        float worstError = 0;
+        for (int rcRate = 5; rcRate <= CONTROL_RATE_CONFIG_RC_RATES_MAX; rcRate += 50) {
+            for (int rcExpo = 0; rcExpo <= CONTROL_RATE_CONFIG_RC_EXPO_MAX; rcExpo += 25) {
+                for (int rate = 0; rate <= CONTROL_RATE_CONFIG_RATE_MAX; rate += 30) {
+                    for (int quickRatesRcExpo = 0; quickRatesRcExpo <= 1; quickRatesRcExpo++) {
+                        setRates(ratesTypes[i].type, rcRate, rcExpo, rate, quickRatesRcExpo);
+
+                        for (int step = 1 - TEST_DEFLECTION_STEPS; step < TEST_DEFLECTION_STEPS; step++) {
+                            const float deflection = (float)step / TEST_DEFLECTION_STEPS;
+                            const float value = exactCurve(ratesTypes[i].curve, deflection);
+                            const float left = (value - exactCurve(ratesTypes[i].curve, deflection - TEST_SLOPE_STEP)) / TEST_SLOPE_STEP;
+                            const float right = (exactCurve(ratesTypes[i].curve, deflection + TEST_SLOPE_STEP) - value) / TEST_SLOPE_STEP;
+                            if (fabsf(right - left) > MAX(fabsf(right + left) * 0.5f * TEST_SLOPE_TOLERANCE, TEST_SLOPE_MIN)) {
+                                // a kink in the curve, the slope isn't defined here
+                                continue;
+                            }
+                            const float slope = (left + right) * 0.5f;
+                            const float error = fabsf(getRcCurveSlope(FD_ROLL, deflection) - slope) / MAX(fabsf(slope), TEST_SLOPE_MIN / TEST_SLOPE_TOLERANCE);
+                            worstError = MAX(worstError, error);
+                        }
+                    }
+                }
+            }
+        }
+        EXPECT_LE(worstError, TEST_SLOPE_TOLERANCE) << "rates type " << ratesTypes[i].type;
+    }
+}
+
+TEST_F(RcRatesTest, TestTableIsMonotone)
+{
+    for (unsigned i = 0; i < ARRAYLEN(ratesTypes); i++) {
+        setRates(ratesTypes[i].type, 100, 50, 70, false);
+
+        float previous = applyRatesTable(FD_ROLL, -1.0f, 1.0f);
+        for (int step = 1 - TEST_DEFLECTION_STEPS; step <= TEST_DEFLECTION_STEPS; step++) {
+            const float deflection = (float)step / TEST_DEFLECTION_STEPS;
+            const float value = applyRatesTable(FD_ROLL, deflection, fabsf(deflection));
+            EXPECT_GE(value, previous);
+            previous = value;
+        }
+        EXPECT_FLOAT_EQ(exactCurve(ratesTypes[i].curve, 1.0f), applyRatesTable(FD_ROLL, 1.0f, 1.0f));
+        EXPECT_FLOAT_EQ(0.0f, applyRatesTable(FD_ROLL, 0.0f, 0.0f));
+    }
+}
+
+TEST_F(RcRatesTest, TestTableServesTypicalRates)
+{
+    // the exact curve is only a fallback for the segments holding a constrainf() kink
+    static const struct {
+        ratesType_e type;
+        uint8_t rcRate;
+        uint8_t rcExpo;
+        uint8_t rate;
+    } typicalRates[] = {
+        { RATES_TYPE_BETAFLIGHT, 100, 0, 70 },
+        { RATES_TYPE_BETAFLIGHT, 120, 30, 75 },
+        { RATES_TYPE_RACEFLIGHT, 37, 50, 80 },
+        { RATES_TYPE_KISS, 100, 0, 70 },
+        { RATES_TYPE_ACTUAL, 7, 0, 67 },
+        { RATES_TYPE_ACTUAL, 7, 50, 67 },
+        { RATES_TYPE_QUICK, 100, 0, 67 },
+    };
+    for (unsigned i = 0; i < ARRAYLEN(typicalRates); i++) {
+        setRates(typicalRates[i].type, typicalRates[i].rcRate, typicalRates[i].rcExpo, typicalRates[i].rate, false);
+        for (int axis = FD_ROLL; axis <= FD_YAW; axis++) {
+            EXPECT_LE(__builtin_popcount(rcRatesTableExactSegments(axis)), 1) << "rates type " << typicalRates[i].type;
+        }
+    }
+
+    // and across the configurable range nearly all of the segments are tabulated
+    int segments = 0;
+    int exactSegments = 0;
+    for (unsigned i = 0; i < ARRAYLEN(ratesTypes); i++) {
+        for (int rcRate = 5; rcRate <= CONTROL_RATE_CONFIG_RC_RATES_MAX; rcRate += 50) {
+            for (int rcExpo = 0; rcExpo <= CONTROL_RATE_CONFIG_RC_EXPO_MAX; rcExpo += 25) {
+                for (int rate = 0; rate <= CONTROL_RATE_CONFIG_RATE_MAX; rate += 30) {
+                    setRates(ratesTypes[i].type, rcRate, rcExpo, rate, false);
+                    segments += 32;
+                    exactSegments += __builtin_popcount(rcRatesTableExactSegments(FD_ROLL));
+                }
+            }
+        }
+    }
+    EXPECT_LE(exactSegments, segments / 20);
+}
+
+TEST_F(RcRatesTest, TestSetpointFollowsRateChange)
+{
+    for (unsigned i = 0; i < ARRAYLEN(ratesTypes); i++) {
+        setRates(ratesTypes[i].type, 20, 20, 70, false);
+        const float before = applyRatesTable(FD_ROLL, 0.8f, 0.8f);
+
+        // as an in-flight adjustment, CMS or MSP write changes the current rate profile
+        testControlRateProfile.rcExpo[FD_ROLL] = 40;
+        testControlRateProfile.rates[FD_ROLL] = 90;
+        rcRatesTableUpdate();
+
+        EXPECT_NE(before, applyRatesTable(FD_ROLL, 0.8f, 0.8f)) << "rates type " << ratesTypes[i].type;
+        for (int step = -TEST_DEFLECTION_STEPS; step <= TEST_DEFLECTION_STEPS; step += 10) {
+            const float deflection = (float)step / TEST_DEFLECTION_STEPS;
+            EXPECT_NEAR(exactCurve(ratesTypes[i].curve, deflection), applyRatesTable(FD_ROLL, deflection, fabsf(deflection)), TEST_VALUE_TOLERANCE);
+        }
+    }
+}
+
+// STUBS
+
+extern "C" {
+    uint8_t armingFlags;
+    uint16_t flightModeFlags;
+    float rcCommand[4];
+    int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
+    pidProfile_t *currentPidProfile;
+    uint32_t targetPidLooptime;
+
+    bool featureIsEnabled(uint32_t) { return false; }
+    bool IS_RC_MODE_ACTIVE(boxId_e) { return false; }
+    bool failsafeIsActive(void) { return false; }
+    const lowVoltageCutoff_t *getLowVoltageCutoff(void) { return NULL; }
+    void imuQuaternionHeadfreeTransformVectorEarthToBody(t_fp_vector_def *) {}
+    uint16_t rxGetRefreshRate(void) { return 0; }
+    timeDelta_t rxGetFrameDelta(timeDelta_t *) { return 0; }
+    float gpsRescueGetYawRate(void) { return 0; }
+    void checkForThrottleErrorResetState(uint16_t) {}
+    bool pidAntiGravityEnabled(void) { return false; }
+    void pidSetItermAccelerator(float) {}
+}
@@ -0,0 +1,268 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <math.h>
+
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/filter.h"
+    #include "common/maths.h"
+
+    #include "drivers/dshot.h"
+
+    #include "flight/mixer.h"
+    #include "flight/rpm_filter.h"
+
+    #include "pg/motor.h"
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+
+    #include "sensors/gyro.h"
+
+    PG_REGISTER(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 0);
+
+    uint8_t debugMode;
+    int16_t debug[DEBUG16_VALUE_COUNT];
+    gyro_t gyro;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define LOOPTIME_US     125
+#define MOTOR_POLES     14
+#define HARMONICS       3
+
+static uint8_t motorCount = 8;
+static uint16_t dshotTelemetry[MAX_SUPPORTED_MOTORS];
+
+static void setupRpmFilter(void)
+{
+    gyro.targetLooptime = LOOPTIME_US;
+    pgResetAll();
+    motorConfigMutable()->dev.useDshotTelemetry = true;
+    motorConfigMutable()->motorPoleCount = MOTOR_POLES;
+    rpmFilterInit(rpmFilterConfig());
+}
+
+static float telemetryToHz(uint16_t telemetry)
+{
+    return telemetry * 100.0f / 60.0f / (MOTOR_POLES / 2.0f);
+}
+
+static float testSignal(int sample, int axis)
+{
+    const float t = sample * LOOPTIME_US * 1e-6f;
+    return 200.0f * sinf(2 * M_PIf * (2 + axis) * t) + 30.0f * sinf(2 * M_PIf * 333 * t) + 20.0f * sinf(2 * M_PIf * 1000 * t);
+}
+
+TEST(RpmFilterUnittest, TestMatchesBiquadCascade)
+{
+    // a spread of motor speeds, including stopped and one whose upper harmonics are constrained to nyquist
+    const uint16_t telemetry[8] = { 1400, 0, 7000, 4200, 1500, 2800, 3000, 1450 };
+    for (int i = 0; i < 8; i++) {
+        dshotTelemetry[i] = telemetry[i];
+    }
+    setupRpmFilter();
+    ASSERT_TRUE(isRpmFilterEnabled());
+
+    // let the rpm lowpass settle and every motor get updated
+    for (int i = 0; i < 1000; i++) {
+        rpmFilterUpdate();
+    }
+
+    // reference: one biquadFilter_t per axis, motor and harmonic, applied as rpm_filter.c used to
+    const float q = rpmFilterConfig()->gyro_rpm_notch_q / 100.0f;
+    const float minHz = rpmFilterConfig()->gyro_rpm_notch_min;
+    const float maxHz = 0.48f / (LOOPTIME_US * 1e-6f);
+    biquadFilter_t notch[3][8][HARMONICS];
+    for (int axis = 0; axis < 3; axis++) {
+        for (int motor = 0; motor < 8; motor++) {
+            for (int harmonic = 0; harmonic < HARMONICS; harmonic++) {
+                const float frequency = constrainf((harmonic + 1) * telemetryToHz(telemetry[motor]), minHz, maxHz);
+                biquadFilterInit(&notch[axis][motor][harmonic], frequency, LOOPTIME_US, q, FILTER_NOTCH);
+            }
+        }
+    }
+
+    float maxError = 0;
+    for (int i = 0; i < 4000; i++) {
+        float values[FILTER_BANK_LANES] = { 0 };
+        float expected[3];
+        for (int axis = 0; axis < 3; axis++) {
+            values[axis] = testSignal(i, axis);
+            expected[axis] = values[axis];
+            for (int motor = 0; motor < 8; motor++) {
+                for (int harmonic = 0; harmonic < HARMONICS; harmonic++) {
+                    expected[axis] = biquadFilterApplyDF1(&notch[axis][motor][harmonic], expected[axis]);
+                }
+            }
+        }
+        rpmFilterGyro(values);
+        for (int axis = 0; axis < 3; axis++) {
+            maxError = fmaxf(maxError, fabsf(expected[axis] - values[axis]));
+        }
+    }
+    // the signal amplitude is 250, the harmonics derived by angle addition and the
+    // factored notch expression only differ in rounding
+    EXPECT_LT(maxError, 0.05f);
+}
+
+TEST(RpmFilterUnittest, TestDisabledWithoutTelemetry)
+{
+    setupRpmFilter();
+    motorConfigMutable()->dev.useDshotTelemetry = false;
+    rpmFilterInit(rpmFilterConfig());
+    EXPECT_FALSE(isRpmFilterEnabled());
+
+    float values[FILTER_BANK_LANES] = { 1.0f, 2.0f, 3.0f };
+    rpmFilterGyro(values);
+    EXPECT_EQ(1.0f, values[0]);
+    EXPECT_EQ(2.0f, values[1]);
+    EXPECT_EQ(3.0f, values[2]);
+}
+
+static uint64_t benchmarkTicks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+TEST(RpmFilterUnittest, TestBenchmark)
+{
+    // 8 motors, 3 harmonics, 8kHz
+    const uint16_t telemetry[8] = { 1400, 1420, 1440, 1460, 1480, 1500, 1520, 1540 };
+    for (int i = 0; i < 8; i++) {
+        dshotTelemetry[i] = telemetry[i];
+    }
+    setupRpmFilter();
+
+    enum { ITERATIONS = 20000 };
+    const float q = rpmFilterConfig()->gyro_rpm_notch_q / 100.0f;
+
+    // previous rpmFilterUpdate at 8kHz: rpm lowpass for every motor, then biquadFilterUpdate for
+    // the three notches of one motor, each copied to the other axes
+    pt1Filter_t rpmLowpass[8];
+    for (int motor = 0; motor < 8; motor++) {
+        pt1FilterInit(&rpmLowpass[motor], pt1FilterGain(rpmFilterConfig()->rpm_lpf, LOOPTIME_US * 1e-6f));
+    }
+    biquadFilter_t notch[3][8][HARMONICS];
+    for (int axis = 0; axis < 3; axis++) {
+        for (int motor = 0; motor < 8; motor++) {
+            for (int harmonic = 0; harmonic < HARMONICS; harmonic++) {
+                biquadFilterInit(&notch[axis][motor][harmonic], 100, LOOPTIME_US, q, FILTER_NOTCH);
+            }
+        }
+    }
+    uint64_t ticks = benchmarkTicks();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        float motorHz[8];
+        for (int motor = 0; motor < 8; motor++) {
+            motorHz[motor] = telemetryToHz(pt1FilterApply(&rpmLowpass[motor], getDshotTelemetry(motor)));
+        }
+        const int motor = i % 8;
+        for (int harmonic = 0; harmonic < HARMONICS; harmonic++) {
+            const float frequency = (harmonic + 1) * motorHz[motor];
+            biquadFilter_t *notchTemplate = &notch[0][motor][harmonic];
+            biquadFilterUpdate(notchTemplate, frequency, LOOPTIME_US, q, FILTER_NOTCH);
+            for (int axis = 1; axis < 3; axis++) {
+                biquadFilter_t *clone = &notch[axis][motor][harmonic];
+                clone->b0 = notchTemplate->b0;
+                clone->b1 = notchTemplate->b1;
+                clone->b2 = notchTemplate->b2;
+                clone->a1 = notchTemplate->a1;
+                clone->a2 = notchTemplate->a2;
+            }
+        }
+    }
+    const double previousUpdateCycles = (double)(benchmarkTicks() - ticks) / ITERATIONS;
+    const double previousUpdateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+    // rpmFilterUpdate at 8kHz now updates all harmonics of one motor in one batch
+    ticks = benchmarkTicks();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        rpmFilterUpdate();
+    }
+    const double updateCycles = (double)(benchmarkTicks() - ticks) / ITERATIONS;
+    const double updateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+    // previous apply: 3 axes, each through 24 notches one at a time
+    float checksum = 0;
+    ticks = benchmarkTicks();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            float value = testSignal(i & 1023, axis);
+            for (int motor = 0; motor < 8; motor++) {
+                for (int harmonic = 0; harmonic < HARMONICS; harmonic++) {
+                    value = biquadFilterApplyDF1(&notch[axis][motor][harmonic], value);
+                }
+            }
+            checksum += value;
+        }
+    }
+    const double previousApplyCycles = (double)(benchmarkTicks() - ticks) / ITERATIONS;
+    const double previousApplyNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+    ticks = benchmarkTicks();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        float values[FILTER_BANK_LANES] = { testSignal(i & 1023, 0), testSignal(i & 1023, 1), testSignal(i & 1023, 2) };
+        rpmFilterGyro(values);
+        checksum += values[0] + values[1] + values[2];
+    }
+    const double applyCycles = (double)(benchmarkTicks() - ticks) / ITERATIONS;
+    const double applyNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+
+    printf("rpmFilterUpdate at 8kHz (8 motors, %d harmonics): per-notch biquadFilterUpdate %.1f ns %.0f cycles, batched %.1f ns %.0f cycles\n",
+        HARMONICS, previousUpdateNs, previousUpdateCycles, updateNs, updateCycles);
+    printf("rpm filter apply per gyro sample (3 axes, %d notches): per-axis %.1f ns %.0f cycles, all axes %.1f ns %.0f cycles\n",
+        8 * HARMONICS, previousApplyNs, previousApplyCycles, applyNs, applyCycles);
+
+    EXPECT_TRUE(isfinite(checksum));
+}
+
+// STUBS
+
+extern "C" {
+    uint8_t getMotorCount(void)
+    {
+        return motorCount;
+    }
+
+    uint16_t getDshotTelemetry(uint8_t index)
+    {
+        return dshotTelemetry[index];
+    }
+}
@@ -43,7 +43,7 @@ extern "C" {
 
     rssiSource_e rssiSource;
 
-    void crsfDataReceive(uint16_t c);
+    void crsfFrameReceive(const uint8_t *data, int count, void *callbackData);
     uint8_t crsfFrameCRC(void);
     uint8_t crsfFrameStatus(void);
     uint16_t crsfReadRawRC(const rxRuntimeState_t *rxRuntimeState, uint8_t chan);
@@ -265,13 +265,8 @@ TEST(CrossFireTest, TestCapturedData)
 }
 
 
-TEST(CrossFireTest, TestCrsfDataReceive)
+static void checkCapturedFrame(void)
 {
-    crsfFrameDone = false;
-    const uint8_t *pData = capturedData;
-    for (unsigned int ii = 0; ii < sizeof(crsfRcChannelsFrame_t); ++ii) {
-        crsfDataReceive(*pData++);
-    }
     EXPECT_FALSE(crsfFrameDone); // data is not a valid rc channels frame so don't expect crsfFrameDone to be true
     EXPECT_EQ(CRSF_ADDRESS_BROADCAST, crsfFrame.frame.deviceAddress);
     EXPECT_EQ(CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC, crsfFrame.frame.frameLength);
@@ -283,6 +278,34 @@ TEST(CrossFireTest, TestCrsfDataReceive)
     EXPECT_EQ(crc, crsfFrame.frame.payload[CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE]);
 }
 
+TEST(CrossFireTest, TestCrsfDataReceive)
+{
+    crsfFrameDone = false;
+    dummyTimeUs += 100000; // start a new frame
+    const uint8_t *pData = capturedData;
+    for (unsigned int ii = 0; ii < sizeof(crsfRcChannelsFrame_t); ++ii) {
+        crsfFrameReceive(pData++, 1, NULL);
+    }
+    checkCapturedFrame();
+}
+
+TEST(CrossFireTest, TestCrsfFrameReceive)
+{
+    // whole frame at once, as delivered at an idle line
+    memset(&crsfFrame, 0, sizeof(crsfFrame));
+    crsfFrameDone = false;
+    dummyTimeUs += 100000;
+    crsfFrameReceive(capturedData, sizeof(crsfRcChannelsFrame_t), NULL);
+    checkCapturedFrame();
+
+    // frame split part way through the header
+    memset(&crsfFrame, 0, sizeof(crsfFrame));
+    dummyTimeUs += 100000;
+    crsfFrameReceive(capturedData, 2, NULL);
+    crsfFrameReceive(capturedData + 2, sizeof(crsfRcChannelsFrame_t) - 2, NULL);
+    checkCapturedFrame();
+}
+
 // STUBS
 
 extern "C" {
@@ -16,6 +16,10 @@
  */
 
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
 
 extern "C" {
     #include "platform.h"
@@ -88,6 +92,10 @@ extern "C" {
     extern task_t *queueFirst(void);
     extern task_t *queueNext(void);
 
+    extern uint8_t deadlineHeap[];
+    extern int deadlineHeapSize;
+    extern void deadlineQueueRebuild(void);
+
     task_t tasks[TASK_COUNT] = {
         [TASK_SYSTEM] = {
             .taskName = "SYSTEM",
@@ -422,6 +430,85 @@ TEST(SchedulerUnittest, TestTwoTasks)
     EXPECT_EQ(&tasks[TASK_ATTITUDE], unittest_scheduler_selectedTask);
 }
 
+TEST(SchedulerUnittest, TestDeadlineQueueOrder)
+{
+    schedulerUseDeadlineQueue(true);
+
+    // disable all tasks except the time driven TASK_ACCEL, TASK_ATTITUDE, TASK_SERIAL and the event driven TASK_RX
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<taskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_ATTITUDE, true);
+    setTaskEnabled(TASK_SERIAL, true);
+    setTaskEnabled(TASK_RX, true);
+
+    tasks[TASK_ACCEL].lastExecutedAtUs = 10000;      // due at 11000
+    tasks[TASK_ATTITUDE].lastExecutedAtUs = 0;       // due at 10000
+    tasks[TASK_SERIAL].lastExecutedAtUs = 5000;      // due at 15000
+    deadlineQueueRebuild();
+
+    // only the time driven tasks are in the heap, earliest deadline at the root
+    EXPECT_EQ(3, deadlineHeapSize);
+    EXPECT_EQ(&tasks[TASK_ATTITUDE], taskQueueArray[deadlineHeap[0]]);
+    for (int ii = 1; ii < deadlineHeapSize; ++ii) {
+        const task_t *parent = taskQueueArray[deadlineHeap[(ii - 1) / 2]];
+        const task_t *child = taskQueueArray[deadlineHeap[ii]];
+        EXPECT_LE(parent->lastExecutedAtUs + parent->desiredPeriodUs, child->lastExecutedAtUs + child->desiredPeriodUs);
+    }
+
+    schedulerUseDeadlineQueue(false);
+}
+
+TEST(SchedulerUnittest, TestDeadlineQueueTwoTasks)
+{
+    schedulerUseDeadlineQueue(true);
+
+    // same sequence as TestTwoTasks, selected through the deadline queue
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<taskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_ACCEL, true);
+    setTaskEnabled(TASK_ATTITUDE, true);
+
+    static const uint32_t startTime = 4000;
+    simulatedTime = startTime;
+    tasks[TASK_ACCEL].lastExecutedAtUs = simulatedTime;
+    tasks[TASK_ATTITUDE].lastExecutedAtUs = tasks[TASK_ACCEL].lastExecutedAtUs - TEST_UPDATE_ATTITUDE_TIME;
+    deadlineQueueRebuild();
+
+    scheduler();
+    EXPECT_EQ(static_cast<task_t*>(0), unittest_scheduler_selectedTask);
+
+    simulatedTime += 500;
+    scheduler();
+    EXPECT_EQ(static_cast<task_t*>(0), unittest_scheduler_selectedTask);
+    EXPECT_EQ(0, unittest_scheduler_waitingTasks);
+
+    simulatedTime += 500;
+    scheduler();
+    EXPECT_EQ(&tasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    EXPECT_EQ(1, unittest_scheduler_waitingTasks);
+    EXPECT_EQ(5000 + TEST_UPDATE_ACCEL_TIME, simulatedTime);
+
+    simulatedTime += 1000 - TEST_UPDATE_ACCEL_TIME;
+    scheduler();
+    EXPECT_EQ(&tasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+
+    scheduler();
+    EXPECT_EQ(static_cast<task_t*>(0), unittest_scheduler_selectedTask);
+    EXPECT_EQ(0, unittest_scheduler_waitingTasks);
+
+    simulatedTime = startTime + 10500;
+    scheduler();
+    EXPECT_EQ(&tasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    // TASK_ATTITUDE has aged more than TASK_ACCEL, the heap must still hand it over
+    scheduler();
+    EXPECT_EQ(&tasks[TASK_ATTITUDE], unittest_scheduler_selectedTask);
+
+    schedulerUseDeadlineQueue(false);
+}
+
 TEST(SchedulerUnittest, TestGyroTask)
 {
     static const uint32_t startTime = 4000;
@@ -605,3 +692,158 @@ TEST(SchedulerUnittest, TestGyroLookahead)
     // TASK_ACCEL should have run
     EXPECT_EQ(&tasks[TASK_ACCEL], unittest_scheduler_selectedTask);
 }
+
+TEST(SchedulerUnittest, TestTaskHistogramPercentiles)
+{
+    taskHistogram_t histogram;
+    memset(&histogram, 0, sizeof(histogram));
+    EXPECT_EQ(0, taskHistogramPercentileUs(&histogram, 500));
+
+    // 980 samples in [8, 16) us, 19 in [256, 512) us and one open ended outlier
+    histogram.count[4] = 980;
+    histogram.count[9] = 19;
+    histogram.count[TASK_HISTOGRAM_BUCKET_COUNT - 1] = 1;
+    EXPECT_EQ(1000, taskHistogramTotalCount(&histogram));
+
+    const uint32_t p50 = taskHistogramPercentileUs(&histogram, 500);
+    EXPECT_GE(p50, 8);
+    EXPECT_LT(p50, 16);
+    const uint32_t p99 = taskHistogramPercentileUs(&histogram, 990);
+    EXPECT_GE(p99, 256);
+    EXPECT_LT(p99, 512);
+    EXPECT_EQ(taskHistogramBucketLowerBoundUs(9 + 1), taskHistogramPercentileUs(&histogram, 999));
+    EXPECT_EQ(taskHistogramBucketLowerBoundUs(TASK_HISTOGRAM_BUCKET_COUNT - 1), taskHistogramPercentileUs(&histogram, 1000));
+}
+
+TEST(SchedulerUnittest, TestTaskHistograms)
+{
+    schedulerSetCalulateTaskStatistics(true);
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<taskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_ACCEL, true);
+    schedulerResetTaskStatistics(TASK_ACCEL);
+
+    // TASK_ACCEL is run 100us late every time, with the gyro task not due
+    simulatedTime = 100000;
+    resetGyroTaskTestFlags();
+    for (int ii = 0; ii < 10; ++ii) {
+        tasks[TASK_GYRO].lastExecutedAtUs = simulatedTime;
+        tasks[TASK_ACCEL].lastExecutedAtUs = simulatedTime - TASK_PERIOD_HZ(1000) - 100;
+        scheduler();
+        EXPECT_EQ(&tasks[TASK_ACCEL], unittest_scheduler_selectedTask);
+    }
+
+    taskHistogram_t executionTimeHistogram;
+    taskHistogram_t startLatenessHistogram;
+    getTaskHistograms(TASK_ACCEL, &executionTimeHistogram, &startLatenessHistogram);
+    EXPECT_EQ(10, executionTimeHistogram.count[6]);     // TEST_UPDATE_ACCEL_TIME is in [32, 64)
+    EXPECT_EQ(10, startLatenessHistogram.count[7]);     // 100us is in [64, 128)
+    EXPECT_EQ(10, taskHistogramTotalCount(&startLatenessHistogram));
+
+    // a saturating bucket halves the histogram instead of wrapping
+    tasks[TASK_ACCEL].executionTimeHistogram.count[6] = UINT16_MAX;
+    tasks[TASK_GYRO].lastExecutedAtUs = simulatedTime;
+    tasks[TASK_ACCEL].lastExecutedAtUs = simulatedTime - TASK_PERIOD_HZ(1000);
+    scheduler();
+    getTaskHistograms(TASK_ACCEL, &executionTimeHistogram, &startLatenessHistogram);
+    EXPECT_EQ(UINT16_MAX / 2 + 1, executionTimeHistogram.count[6]);
+
+    schedulerResetTaskStatistics(TASK_ACCEL);
+    getTaskHistograms(TASK_ACCEL, &executionTimeHistogram, &startLatenessHistogram);
+    EXPECT_EQ(0, taskHistogramTotalCount(&executionTimeHistogram));
+    EXPECT_EQ(0, taskHistogramTotalCount(&startLatenessHistogram));
+}
+
+TEST(SchedulerUnittest, TestGyroLateStart)
+{
+    schedulerOptimizeRate(false);
+    schedulerEnableGyro();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<taskId_e>(taskId), false);
+    }
+    setTaskEnabled(TASK_GYRO, true);
+    schedulerResetTaskStatistics(TASK_GYRO);
+    resetGyroTaskTestFlags();
+
+    // on time
+    simulatedTime = 200000;
+    tasks[TASK_GYRO].lastExecutedAtUs = simulatedTime - TASK_PERIOD_HZ(TEST_GYRO_SAMPLE_HZ);
+    scheduler();
+    EXPECT_TRUE(taskGyroRan);
+
+    // later than the guard interval
+    simulatedTime += 1000;
+    tasks[TASK_GYRO].lastExecutedAtUs = simulatedTime - TASK_PERIOD_HZ(TEST_GYRO_SAMPLE_HZ) - 3 * GYRO_TASK_GUARD_INTERVAL_US;
+    scheduler();
+
+    gyroLateStartInfo_t gyroLateStartInfo;
+    getGyroLateStartInfo(&gyroLateStartInfo);
+    EXPECT_EQ(2, gyroLateStartInfo.startCount);
+    EXPECT_EQ(1, gyroLateStartInfo.lateStartCount);
+    EXPECT_EQ(3 * GYRO_TASK_GUARD_INTERVAL_US, gyroLateStartInfo.maxLateUs);
+}
+
+// Runs the same simulated workload through both selection modes, checks that they make
+// identical scheduling decisions and reports the host time spent per scheduler pass.
+static double runSchedulerWorkload(bool useDeadlineQueue, bool optimizeRate, task_t **selected, int passes)
+{
+    schedulerUseDeadlineQueue(useDeadlineQueue);
+    schedulerOptimizeRate(optimizeRate);
+    schedulerEnableGyro();
+
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<taskId_e>(taskId), false);
+        tasks[taskId].lastExecutedAtUs = 0;
+        tasks[taskId].lastDesiredAt = 0;
+        tasks[taskId].lastSignaledAtUs = 0;
+        tasks[taskId].dynamicPriority = 0;
+        tasks[taskId].taskAgeCycles = 0;
+    }
+    for (int taskId = 0; taskId < TASK_COUNT_UNITTEST; ++taskId) {
+        setTaskEnabled(static_cast<taskId_e>(taskId), true);
+    }
+
+    simulatedTime = 0;
+    resetGyroTaskTestFlags();
+    taskFilterReady = true;
+    taskPidReady = true;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < passes; ++ii) {
+        scheduler();
+        selected[ii] = unittest_scheduler_selectedTask;
+        simulatedTime += 1;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    schedulerUseDeadlineQueue(false);
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / passes;
+}
+
+TEST(SchedulerUnittest, TestDeadlineQueueMatchesLinearScan)
+{
+    static const int passes = 200000;
+    static task_t *linearSelected[passes];
+    static task_t *deadlineSelected[passes];
+
+    // scheduler_optimize_rate changes when the realtime tasks are due
+    for (int optimizeRate = 0; optimizeRate <= 1; optimizeRate++) {
+        const double linearNsPerPass = runSchedulerWorkload(false, optimizeRate, linearSelected, passes);
+        const double deadlineNsPerPass = runSchedulerWorkload(true, optimizeRate, deadlineSelected, passes);
+
+        int tasksRun = 0;
+        int mismatches = 0;
+        for (int ii = 0; ii < passes; ++ii) {
+            mismatches += linearSelected[ii] != deadlineSelected[ii];
+            tasksRun += linearSelected[ii] != NULL;
+        }
+        EXPECT_EQ(0, mismatches) << "optimize rate " << optimizeRate;
+        EXPECT_GT(tasksRun, 0);
+
+        printf("scheduler overhead per pass, optimize rate %d: linear scan %.1f ns, deadline queue %.1f ns (%d passes, %d tasks run)\n",
+            optimizeRate, linearNsPerPass, deadlineNsPerPass, passes, tasksRun);
+    }
+    schedulerOptimizeRate(false);
+}
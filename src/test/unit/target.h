@@ -62,6 +62,7 @@
 #define USE_SOFTSERIAL1
 #define USE_SOFTSERIAL2
 #define USE_TASK_STATISTICS
+#define USE_TASK_LATENCY_HISTOGRAM
 
 #define SERIAL_PORT_COUNT 8
 
@@ -21,6 +21,8 @@
 
 #include <limits.h>
 #include <algorithm>
+#include <deque>
+#include <vector>
 
 extern "C" {
     #include <platform.h>
@@ -51,6 +53,7 @@ extern "C" {
     #include "io/gps.h"
 
     #include "msp/msp.h"
+    #include "msp/msp_protocol.h"
 
     #include "rx/rx.h"
     #include "rx/crsf.h"
@@ -65,7 +68,7 @@ extern "C" {
 
     rssiSource_e rssiSource;
     bool handleMspFrame(uint8_t *frameStart, int frameLength, uint8_t *skipsBeforeResponse);
-    bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn);
+    bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn, uint8_t *skipsBeforeResponse);
     uint8_t sbufReadU8(sbuf_t *src);
     int sbufBytesRemaining(sbuf_t *buf);
     void initSharedMsp();
@@ -237,7 +240,7 @@ TEST(CrossFireMSPTest, SendMspReply) {
     uint8_t *frameStart = (uint8_t *)&crsfFrame.frame.payload + 2;
     bool handled = handleMspFrame(frameStart, CRSF_FRAME_RX_MSP_FRAME_SIZE, NULL);
     EXPECT_TRUE(handled);
-    bool replyPending = sendMspReply(64, &testSendMspResponse);
+    bool replyPending = sendMspReply(64, &testSendMspResponse, NULL);
     EXPECT_FALSE(replyPending);
     EXPECT_EQ(0x10, sbufReadU8(&payloadOutputBuf));
     EXPECT_EQ(0x1E, sbufReadU8(&payloadOutputBuf));
@@ -247,6 +250,225 @@ TEST(CrossFireMSPTest, SendMspReply) {
     EXPECT_EQ(0x71, sbufReadU8(&payloadOutputBuf)); // CRC
 }
 
+#define TEST_MSP_START_FLAG     (1 << 4)
+#define TEST_MSP_ERROR_FLAG     (1 << 5)
+#define TEST_MSP_PIPELINED_FLAG (1 << 6)
+#define TEST_MSP_SEQ_MASK       0x0F
+
+#define TEST_PID_SIZE           30
+#define TEST_UPLINK_PERIOD_US   10000   // the radio sends an MSP chunk every 10ms at best
+#define TEST_DOWNLINK_PERIOD_US 20000   // the MSP telemetry slot on a 500Hz link
+#define TEST_RUN_US             10000000
+#define TEST_PIPELINE_DEPTH     4
+
+// A tuning client at the other end of the link, speaking version 1 or 2
+typedef struct testMspClient_s {
+    uint8_t version;
+    uint8_t uplinkSeq;
+    uint8_t nextTag;
+    int requestCount;
+    std::deque<std::vector<uint8_t>> uplink;
+    std::deque<std::pair<uint8_t, uint8_t>> inFlight;  // tag and command
+
+    bool replyStarted;
+    bool replyError;
+    int replySize;
+    std::vector<uint8_t> reply;
+
+    int replies;
+    int errors;
+    int payloadBytes;   // of requests and replies
+} testMspClient_t;
+
+static testMspClient_t *testClient;
+
+static void clientSendRequest(testMspClient_t *client, uint8_t cmd, const uint8_t *payload, uint8_t size, bool corrupt)
+{
+    const uint8_t tag = client->nextTag++;
+    std::vector<uint8_t> body;
+    if (client->version == 2) {
+        body.push_back(tag);
+    }
+    body.push_back(size);
+    body.push_back(cmd);
+    uint8_t crc = size ^ cmd;
+    for (int i = 0; i < size; i++) {
+        body.push_back(payload[i]);
+        crc ^= payload[i];
+    }
+    body.push_back(corrupt ? ~crc : crc);
+
+    for (unsigned pos = 0; pos < body.size(); pos += CRSF_FRAME_RX_MSP_FRAME_SIZE - 1) {
+        std::vector<uint8_t> chunk(CRSF_FRAME_RX_MSP_FRAME_SIZE, 0);
+        chunk[0] = (client->version << 5) | (pos ? 0 : TEST_MSP_START_FLAG) | (client->uplinkSeq++ & TEST_MSP_SEQ_MASK);
+        std::copy(body.begin() + pos, body.begin() + std::min(pos + CRSF_FRAME_RX_MSP_FRAME_SIZE - 1, (unsigned)body.size()), chunk.begin() + 1);
+        client->uplink.push_back(chunk);
+    }
+    client->inFlight.push_back(std::make_pair(tag, cmd));
+    client->payloadBytes += size;
+}
+
+// The MSP_PID / MSP_SET_PID round trip of a tuning session
+static void clientSendNextRequest(testMspClient_t *client)
+{
+    uint8_t pids[TEST_PID_SIZE];
+    for (int i = 0; i < TEST_PID_SIZE; i++) {
+        pids[i] = i + 1;
+    }
+    if (client->requestCount++ & 1) {
+        clientSendRequest(client, MSP_SET_PID, pids, TEST_PID_SIZE, false);
+    } else {
+        clientSendRequest(client, MSP_PID, NULL, 0, false);
+    }
+}
+
+static void clientReceive(uint8_t *chunk)
+{
+    testMspClient_t *client = testClient;
+    const uint8_t header = chunk[0];
+    int pos = 1;
+
+    if (header & TEST_MSP_START_FLAG) {
+        ASSERT_FALSE(client->inFlight.empty());
+        EXPECT_EQ(client->version == 2 ? TEST_MSP_PIPELINED_FLAG : 0, header & TEST_MSP_PIPELINED_FLAG);
+        if (client->version == 2) {
+            EXPECT_EQ(client->inFlight.front().first, chunk[pos++]);
+        }
+        client->replyStarted = true;
+        client->replyError = header & TEST_MSP_ERROR_FLAG;
+        client->replySize = chunk[pos++];
+        client->reply.clear();
+    } else if (!client->replyStarted) {
+        return;
+    }
+
+    for (; pos < CRSF_FRAME_TX_MSP_FRAME_SIZE; pos++) {
+        if ((int)client->reply.size() < client->replySize) {
+            client->reply.push_back(chunk[pos]);
+            continue;
+        }
+        const uint8_t cmd = client->inFlight.front().second;
+        uint8_t crc = client->replySize ^ cmd;
+        for (unsigned i = 0; i < client->reply.size(); i++) {
+            crc ^= client->reply[i];
+        }
+        EXPECT_EQ(crc, chunk[pos]);
+        if (client->replyError) {
+            client->errors++;
+        } else if (cmd == MSP_PID) {
+            EXPECT_EQ(TEST_PID_SIZE, client->replySize);
+            for (int i = 0; i < client->replySize; i++) {
+                EXPECT_EQ(i + 1, client->reply[i]);
+            }
+        }
+        client->payloadBytes += client->replySize;
+        client->replies++;
+        client->inFlight.pop_front();
+        client->replyStarted = false;
+        break;
+    }
+}
+
+// Runs the round trips over a link with a slot for an MSP chunk in each direction every so
+// often, returns the MSP payload bytes per second carried both ways.
+static float runLoopback(uint8_t version, int window)
+{
+    testMspClient_t client = {};
+    client.version = version;
+    testClient = &client;
+    initSharedMsp();
+
+    bool replyPending = false;
+    for (uint32_t timeUs = 0; timeUs < TEST_RUN_US; timeUs += 1000) {
+        while ((int)client.inFlight.size() < window) {
+            clientSendNextRequest(&client);
+        }
+        if (timeUs % TEST_UPLINK_PERIOD_US == 0 && !client.uplink.empty()) {
+            replyPending = handleMspFrame(client.uplink.front().data(), CRSF_FRAME_RX_MSP_FRAME_SIZE, NULL);
+            client.uplink.pop_front();
+        }
+        if (timeUs % TEST_DOWNLINK_PERIOD_US == 0 && replyPending) {
+            replyPending = sendMspReply(CRSF_FRAME_TX_MSP_FRAME_SIZE, &clientReceive, NULL);
+        }
+    }
+
+    EXPECT_EQ(0, client.errors);
+    EXPECT_GT(client.replies, 0);
+    return client.payloadBytes * 1e6f / TEST_RUN_US;
+}
+
+TEST(CrossFireMSPTest, PipelinedRepliesInOrder)
+{
+    testMspClient_t client = {};
+    client.version = 2;
+    client.nextTag = 250;   // wraps
+    testClient = &client;
+    initSharedMsp();
+
+    // all requests arrive before the first reply goes out, the one in the middle is corrupt
+    uint8_t pids[TEST_PID_SIZE] = { 0 };
+    clientSendRequest(&client, MSP_PID, NULL, 0, false);
+    clientSendRequest(&client, MSP_SET_PID, pids, TEST_PID_SIZE, true);
+    clientSendRequest(&client, MSP_SET_PID, pids, TEST_PID_SIZE, false);
+    clientSendRequest(&client, MSP_PID, NULL, 0, false);
+    bool replyPending = false;
+    while (!client.uplink.empty()) {
+        replyPending = handleMspFrame(client.uplink.front().data(), CRSF_FRAME_RX_MSP_FRAME_SIZE, NULL);
+        client.uplink.pop_front();
+    }
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(replyPending);
+        replyPending = sendMspReply(CRSF_FRAME_TX_MSP_FRAME_SIZE, &clientReceive, NULL);
+    }
+    EXPECT_FALSE(replyPending);
+    EXPECT_EQ(4, client.replies);
+    EXPECT_EQ(1, client.errors);
+    EXPECT_TRUE(client.inFlight.empty());
+}
+
+TEST(CrossFireMSPTest, PipelinedEepromWriteSkipsWhenItRuns)
+{
+    testMspClient_t client = {};
+    client.version = 2;
+    testClient = &client;
+    initSharedMsp();
+
+    // the EEPROM write is queued behind the MSP_PID reply and only runs once that is sent
+    clientSendRequest(&client, MSP_PID, NULL, 0, false);
+    clientSendRequest(&client, MSP_EEPROM_WRITE, NULL, 0, false);
+    uint8_t skipsBeforeResponse = 0;
+    bool replyPending = false;
+    while (!client.uplink.empty()) {
+        replyPending = handleMspFrame(client.uplink.front().data(), CRSF_FRAME_RX_MSP_FRAME_SIZE, &skipsBeforeResponse);
+        client.uplink.pop_front();
+    }
+    EXPECT_TRUE(replyPending);
+    EXPECT_EQ(0, skipsBeforeResponse);
+
+    replyPending = sendMspReply(CRSF_FRAME_TX_MSP_FRAME_SIZE, &clientReceive, &skipsBeforeResponse);
+    EXPECT_EQ(1, client.replies);
+    EXPECT_TRUE(replyPending);
+    EXPECT_EQ(5, skipsBeforeResponse);
+
+    replyPending = sendMspReply(CRSF_FRAME_TX_MSP_FRAME_SIZE, &clientReceive, &skipsBeforeResponse);
+    EXPECT_FALSE(replyPending);
+    EXPECT_EQ(2, client.replies);
+    EXPECT_EQ(0, client.errors);
+}
+
+TEST(CrossFireMSPTest, PipelinedLoopbackThroughput)
+{
+    const float stopAndWait = runLoopback(1, 1);
+    const float pipelined = runLoopback(2, TEST_PIPELINE_DEPTH);
+
+    printf("MSP_PID/MSP_SET_PID round trips, %dms uplink and %dms downlink slots\n", TEST_UPLINK_PERIOD_US / 1000, TEST_DOWNLINK_PERIOD_US / 1000);
+    printf("version 1, one request at a time:  %6.1f bytes/s\n", stopAndWait);
+    printf("version 2, %d requests in flight:   %6.1f bytes/s\n", TEST_PIPELINE_DEPTH, pipelined);
+
+    EXPECT_GT(pipelined, stopAndWait * 1.2f);
+}
+
 // STUBS
 
 extern "C" {
@@ -71,6 +71,9 @@ extern "C" {
     serialPort_t *telemetrySharedPort;
 
     int getCrsfFrame(uint8_t *frame, crsfFrameType_e frameType);
+    void crsfFrameReceive(const uint8_t *data, int count, void *callbackData);
+
+    uint32_t testTimeUs = 0;
 
     PG_REGISTER(batteryConfig_t, batteryConfig, PG_BATTERY_CONFIG, 0);
     PG_REGISTER(telemetryConfig_t, telemetryConfig, PG_TELEMETRY_CONFIG, 0);
@@ -297,11 +300,133 @@ TEST(TelemetryCrsfTest, TestFlightMode)
     EXPECT_EQ(crfsCrc(frame, frameLen), frame[7]);
 }
 
+#define TEST_TASK_PERIOD_US     2000    // TASK_TELEMETRY runs at 500Hz with CRSF
+#define TEST_RUN_US             2000000
+#define TEST_RUN_SECONDS        (TEST_RUN_US / 1000000)
+#define TEST_LINK_STATS_EVERY   50      // RC frames per link statistics frame
+#define TEST_WARMUP_US          2000000 // long enough for two link statistics frames on a 50Hz link
+
+static int sentFrames[256];             // by frame type
+static int sentBytes;
+static bool mspRequestOutstanding;
+
+static void sendLinkFrame(uint8_t type, const uint8_t *payload, uint8_t payloadSize)
+{
+    uint8_t frame[CRSF_FRAME_SIZE_MAX];
+    frame[0] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+    frame[1] = payloadSize + CRSF_FRAME_LENGTH_TYPE_CRC;
+    frame[2] = type;
+    memcpy(&frame[3], payload, payloadSize);
+    frame[3 + payloadSize] = crfsCrc(frame, payloadSize + FRAME_HEADER_FOOTER_LEN);
+    crsfFrameReceive(frame, payloadSize + FRAME_HEADER_FOOTER_LEN, NULL);
+}
+
+// Runs the telemetry task against a link sending RC frames at linkRateHz, or no frames at
+// all for 0, with a tuning tool that asks for the next MSP reply as soon as it has one.
+static void runSchedule(int linkRateHz, bool mspTraffic)
+{
+    static const uint8_t rcChannels[CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE] = { 0 };
+    static const uint8_t linkStatistics[CRSF_FRAME_LINK_STATISTICS_PAYLOAD_SIZE] = { 0 };
+    static uint8_t mspRequest[CRSF_FRAME_RX_MSP_FRAME_SIZE] = { 0x30, 1, 101 };
+
+    mspRequestOutstanding = false;
+    initCrsfMspBuffer();
+    initCrsfTelemetry();
+
+    const uint32_t startTimeUs = testTimeUs;
+    uint32_t nextRcFrameUs = startTimeUs;
+    int rcFrames = 0;
+    while (testTimeUs - startTimeUs < TEST_WARMUP_US + TEST_RUN_US) {
+        if (testTimeUs - startTimeUs == TEST_WARMUP_US) {
+            // the link rate is known by now
+            memset(sentFrames, 0, sizeof(sentFrames));
+            sentBytes = 0;
+        }
+        while (linkRateHz && (int32_t)(testTimeUs - nextRcFrameUs) >= 0) {
+            sendLinkFrame(CRSF_FRAMETYPE_RC_CHANNELS_PACKED, rcChannels, sizeof(rcChannels));
+            if (++rcFrames % TEST_LINK_STATS_EVERY == 0) {
+                sendLinkFrame(CRSF_FRAMETYPE_LINK_STATISTICS, linkStatistics, sizeof(linkStatistics));
+            }
+            nextRcFrameUs += 1000000 / linkRateHz;
+        }
+        if (mspTraffic && !mspRequestOutstanding) {
+            bufferCrsfMspFrame(mspRequest, sizeof(mspRequest));
+            crsfScheduleMspResponse();
+            mspRequestOutstanding = true;
+        }
+        handleCrsfTelemetry(testTimeUs);
+        testTimeUs += TEST_TASK_PERIOD_US;
+    }
+}
+
+class TelemetryCrsfScheduleTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        sensorsSet(SENSOR_ACC);
+        rxRuntimeState_t rxRuntimeState;
+        crsfRxInit(rxConfig(), &rxRuntimeState);
+        // forget the link rate of the previous test, no RC frames between two link statistics
+        const uint8_t linkStatistics[CRSF_FRAME_LINK_STATISTICS_PAYLOAD_SIZE] = { 0 };
+        for (int i = 0; i < 2; i++) {
+            testTimeUs += 1000000;
+            sendLinkFrame(CRSF_FRAMETYPE_LINK_STATISTICS, linkStatistics, sizeof(linkStatistics));
+        }
+    }
+};
+
+TEST_F(TelemetryCrsfScheduleTest, TestTargetRatesOnDefaultLink)
+{
+    // without link statistics every frame gets its target rate
+    runSchedule(0, false);
+
+    EXPECT_NEAR(50 * TEST_RUN_SECONDS, sentFrames[CRSF_FRAMETYPE_ATTITUDE], 2);
+    EXPECT_NEAR(10 * TEST_RUN_SECONDS, sentFrames[CRSF_FRAMETYPE_BATTERY_SENSOR], 2);
+    EXPECT_NEAR(10 * TEST_RUN_SECONDS, sentFrames[CRSF_FRAMETYPE_FLIGHT_MODE], 2);
+    EXPECT_NEAR(10 * TEST_RUN_SECONDS, sentFrames[CRSF_FRAMETYPE_GPS], 2);
+}
+
+TEST_F(TelemetryCrsfScheduleTest, TestFastLinkKeepsAttitudeRateWithMsp)
+{
+    runSchedule(500, true);
+
+    EXPECT_NEAR(50 * TEST_RUN_SECONDS, sentFrames[CRSF_FRAMETYPE_ATTITUDE], 2);
+    EXPECT_GE(sentFrames[CRSF_FRAMETYPE_MSP_RESP], 25 * TEST_RUN_SECONDS);
+    EXPECT_GT(sentFrames[CRSF_FRAMETYPE_BATTERY_SENSOR], 0);
+    EXPECT_GT(sentFrames[CRSF_FRAMETYPE_FLIGHT_MODE], 0);
+    EXPECT_GT(sentFrames[CRSF_FRAMETYPE_GPS], 0);
+}
+
+TEST_F(TelemetryCrsfScheduleTest, TestSlowLinkStaysWithinBudget)
+{
+    runSchedule(50, true);
+
+    // 8 bytes per link frame, and one frame of slack
+    EXPECT_LE(sentBytes, 50 * 8 * TEST_RUN_SECONDS + CRSF_FRAME_SIZE_MAX);
+    EXPECT_GT(sentFrames[CRSF_FRAMETYPE_ATTITUDE], 10 * TEST_RUN_SECONDS);
+    EXPECT_LT(sentFrames[CRSF_FRAMETYPE_ATTITUDE], 50 * TEST_RUN_SECONDS);
+    // MSP isn't starved by attitude
+    EXPECT_GT(sentFrames[CRSF_FRAMETYPE_MSP_RESP], TEST_RUN_SECONDS);
+}
+
+TEST_F(TelemetryCrsfScheduleTest, TestDeviceInfoGoesFirst)
+{
+    runSchedule(150, false);
+
+    crsfScheduleDeviceInfoResponse();
+    sentFrames[CRSF_FRAMETYPE_DEVICE_INFO] = 0;
+    for (int i = 0; i < 3; i++) {
+        handleCrsfTelemetry(testTimeUs);
+        testTimeUs += TEST_TASK_PERIOD_US;
+    }
+    EXPECT_EQ(1, sentFrames[CRSF_FRAMETYPE_DEVICE_INFO]);
+}
+
 // STUBS
 
 extern "C" {
 
 int16_t debug[DEBUG16_VALUE_COUNT];
+uint8_t debugMode;
 
 const uint32_t baudRates[] = {0, 9600, 19200, 38400, 57600, 115200, 230400, 250000, 400000}; // see baudRate_e
 
@@ -315,7 +440,7 @@ gpsSolutionData_t gpsSol;
 
 void beeperConfirmationBeeps(uint8_t beepCount) {UNUSED(beepCount);}
 
-uint32_t micros(void) {return 0;}
+uint32_t micros(void) {return testTimeUs;}
 uint32_t microsISR(void) {return micros();}
 
 bool featureIsEnabled(uint32_t) {return true;}
@@ -324,13 +449,22 @@ uint32_t serialRxBytesWaiting(const serialPort_t *) {return 0;}
 uint32_t serialTxBytesFree(const serialPort_t *) {return 0;}
 uint8_t serialRead(serialPort_t *) {return 0;}
 void serialWrite(serialPort_t *, uint8_t) {}
-void serialWriteBuf(serialPort_t *, const uint8_t *, int) {}
+void serialWriteBuf(serialPort_t *, const uint8_t *data, int count)
+{
+    sentFrames[data[2]]++;
+    sentBytes += count;
+    if (data[2] == CRSF_FRAMETYPE_MSP_RESP) {
+        mspRequestOutstanding = false;
+    }
+}
 void serialSetMode(serialPort_t *, portMode_e) {}
-serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) {return NULL;}
+static serialPort_t testSerialPort;
+serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) {return &testSerialPort;}
 void closeSerialPort(serialPort_t *) {}
 bool isSerialTransmitBufferEmpty(const serialPort_t *) { return true; }
 
-const serialPortConfig_t *findSerialPortConfig(serialPortFunction_e) {return NULL;}
+static const serialPortConfig_t testPortConfig = { FUNCTION_RX_SERIAL, SERIAL_PORT_USART1, 0, 0, 0, 0 };
+const serialPortConfig_t *findSerialPortConfig(serialPortFunction_e) {return &testPortConfig;}
 
 bool telemetryDetermineEnabledState(portSharing_e) {return true;}
 bool telemetryCheckRxPortShared(const serialPortConfig_t *, SerialRXType) {return true;}
@@ -372,9 +506,17 @@ int32_t getMAhDrawn(void){
   return testmAhDrawn;
 }
 
-bool sendMspReply(uint8_t, mspResponseFnPtr) { return false; }
-bool handleMspFrame(uint8_t *, int, uint8_t *)  { return false; }
-void crsfScheduleMspResponse(void) {};
+bool sendMspReply(uint8_t payloadSize, mspResponseFnPtr responseFn, uint8_t *)
+{
+    uint8_t payload[payloadSize];
+    memset(payload, 0, payloadSize);
+    responseFn(payload);
+    return false;
+}
+bool handleMspFrame(uint8_t *, int, uint8_t *)  { return true; }
+
+void setRssi(uint16_t, rssiSource_e) {}
+void setRssiDirect(uint16_t, rssiSource_e) {}
 bool isBatteryVoltageConfigured(void) { return true; }
 bool isAmperageConfigured(void) { return true; }
 
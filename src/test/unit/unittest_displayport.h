@@ -33,6 +33,7 @@ void displayPortTestBufferSubstring(int x, int y, const char * expectedFormat, .
 #define UNITTEST_DISPLAYPORT_BUFFER_LEN (UNITTEST_DISPLAYPORT_ROWS * UNITTEST_DISPLAYPORT_COLS)
 
 char testDisplayPortBuffer[UNITTEST_DISPLAYPORT_BUFFER_LEN];
+int testDisplayPortWriteCount;
 
 static displayPort_t testDisplayPort;
 
@@ -71,6 +72,7 @@ static int displayPortTestWriteString(displayPort_t *displayPort, uint8_t x, uin
 {
     UNUSED(displayPort);
     UNUSED(attr);
+    testDisplayPortWriteCount++;
     for (unsigned int i = 0; i < strlen(s); i++) {
         testDisplayPortBuffer[(y * UNITTEST_DISPLAYPORT_COLS) + x + i] = s[i];
     }